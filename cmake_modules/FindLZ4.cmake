@@ -0,0 +1,28 @@
+# - Try to find lz4
+# Once done this will define
+#  LZ4_FOUND        - System has lz4
+#  LZ4_INCLUDE_DIRS - The lz4 include directories
+#  LZ4_LIBRARIES    - The libraries needed to use lz4
+#
+# Redistribution and use is allowed according to the terms of the BSD license.
+# For details see the accompanying COPYING-CMAKE-SCRIPTS file.
+
+find_path(LZ4_INCLUDE_DIR
+  NAMES lz4frame.h
+)
+find_library(LZ4_LIBRARY
+  NAMES lz4
+)
+
+include(FindPackageHandleStandardArgs)
+# handle the QUIETLY and REQUIRED arguments and set LZ4_FOUND to TRUE
+# if all listed variables are TRUE
+find_package_handle_standard_args(LZ4 REQUIRED_VARS
+                                  LZ4_LIBRARY LZ4_INCLUDE_DIR)
+
+if(LZ4_FOUND)
+  set(LZ4_LIBRARIES     ${LZ4_LIBRARY})
+  set(LZ4_INCLUDE_DIRS  ${LZ4_INCLUDE_DIR})
+endif()
+
+mark_as_advanced(LZ4_INCLUDE_DIR LZ4_LIBRARY)
@@ -0,0 +1,28 @@
+# - Try to find zstd
+# Once done this will define
+#  ZSTD_FOUND        - System has zstd
+#  ZSTD_INCLUDE_DIRS - The zstd include directories
+#  ZSTD_LIBRARIES    - The libraries needed to use zstd
+#
+# Redistribution and use is allowed according to the terms of the BSD license.
+# For details see the accompanying COPYING-CMAKE-SCRIPTS file.
+
+find_path(ZSTD_INCLUDE_DIR
+  NAMES zstd.h
+)
+find_library(ZSTD_LIBRARY
+  NAMES zstd
+)
+
+include(FindPackageHandleStandardArgs)
+# handle the QUIETLY and REQUIRED arguments and set ZSTD_FOUND to TRUE
+# if all listed variables are TRUE
+find_package_handle_standard_args(ZSTD REQUIRED_VARS
+                                  ZSTD_LIBRARY ZSTD_INCLUDE_DIR)
+
+if(ZSTD_FOUND)
+  set(ZSTD_LIBRARIES     ${ZSTD_LIBRARY})
+  set(ZSTD_INCLUDE_DIRS  ${ZSTD_INCLUDE_DIR})
+endif()
+
+mark_as_advanced(ZSTD_INCLUDE_DIR ZSTD_LIBRARY)
@@ -6,3 +6,9 @@
 
 /* Set when theora is detected */
 #cmakedefine HAVE_THEORA
+
+/* Set when zstd is detected */
+#cmakedefine HAVE_ZSTD
+
+/* Set when lz4 is detected */
+#cmakedefine HAVE_LZ4
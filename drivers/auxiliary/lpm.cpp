@@ -292,26 +292,26 @@ bool LPM::getDeviceInfo()
 
     LOGF_DEBUG("CMD: %s", cmd);
 
-    ssize_t written = write(PortFD, cmd, 2);
+    int written = 0;
+    int rc = tty_write(PortFD, cmd, 2, &written);
 
-    if (written < 2)
+    if (rc != TTY_OK || written < 2)
     {
-        LOGF_ERROR("Error getting device info while writing to device: %s", strerror(errno));
+        char errorMessage[MAXRBUF];
+        tty_error_msg(rc, errorMessage, MAXRBUF);
+        LOGF_ERROR("Error getting device info while writing to device: %s", errorMessage);
         return false;
     }
 
-    ssize_t received = 0;
-
-    while (received < 5)
+    // Read through indicom, it returns bytes read ahead by a previous tty_read_section() first
+    int received = 0;
+    rc = tty_read(PortFD, buffer, 5, 60, &received);
+    if (rc != TTY_OK)
     {
-        ssize_t response = read(PortFD, buffer + received, 5 - received);
-        if (response < 0)
-        {
-            LOGF_ERROR("Error getting device info while reading response: %s", strerror(errno));
-            return false;
-        }
-
-        received += response;
+        char errorMessage[MAXRBUF];
+        tty_error_msg(rc, errorMessage, MAXRBUF);
+        LOGF_ERROR("Error getting device info while reading response: %s", errorMessage);
+        return false;
     }
 
     if (received < 5)
@@ -323,7 +323,7 @@ bool LPM::getDeviceInfo()
     LOGF_DEBUG("RES: %s", buffer);
 
     float calib;
-    int rc = sscanf(buffer, "%f#", &calib);
+    rc = sscanf(buffer, "%f#", &calib);
 
     if (rc < 1)
     {
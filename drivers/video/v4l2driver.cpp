@@ -28,6 +28,7 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110 - 1301  USA
 #include "v4l2driver.h"
 #include "indistandardproperty.h"
 #include "lx/Lx.h"
+#include "webcam/v4l2_colorspace.h"
 
 // Pixel size info for different cameras
 typedef struct PixelSizeInfo
@@ -1345,6 +1346,21 @@ float V4L2_Driver::getRemainingExposure() const
     return (float) remaining.tv_sec + (float) remaining.tv_usec / 1000000.0f;
 }
 
+bool V4L2_Driver::isStreamFormat()
+{
+    if (PrimaryCCD.getBinX() > 1 || v4l_base->fmt.fmt.pix.sizeimage != frameBytes)
+        return false;
+
+    if (CaptureFormatSP[IMAGE_MONO].getState() == ISS_ON)
+    {
+        // Quantization and linearization rewrite the pixels
+        bool quantized = ColorProcessingS[0].s == ISS_ON && getQuantization(&v4l_base->fmt) == QUANTIZATION_LIM_RANGE;
+        return v4l_base->getFormat() == V4L2_PIX_FMT_GREY && !quantized && ColorProcessingS[2].s == ISS_OFF;
+    }
+
+    return v4l_base->getFormat() == V4L2_PIX_FMT_RGB24;
+}
+
 void V4L2_Driver::newFrame()
 {
     struct timeval current_frame_duration = frame_received;
@@ -1356,6 +1372,17 @@ void V4L2_Driver::newFrame()
     {
         non_capture_frames = 0;
 
+        // Frames captured as streamed are passed on in the device buffer, without decoding or copying them
+        if (isStreamFormat())
+        {
+            INDI::FramePool::Frame frame = v4l_base->lendFrame();
+            if (frame)
+            {
+                Streamer->newFrame(std::move(frame), v4l_base->getFrameTimestamp());
+                return;
+            }
+        }
+
         int width             = v4l_base->getWidth();
         int height            = v4l_base->getHeight();
         int bpp               = v4l_base->getBpp();
@@ -1417,12 +1444,12 @@ void V4L2_Driver::newFrame()
             memcpy(PrimaryCCD.getFrameBuffer(), buffer, totalBytes);
             PrimaryCCD.binFrame();
             guard.unlock();
-            Streamer->newFrame(PrimaryCCD.getFrameBuffer(), frameBytes / PrimaryCCD.getBinX());
+            Streamer->newFrame(PrimaryCCD.getFrameBuffer(), frameBytes / PrimaryCCD.getBinX(), v4l_base->getFrameTimestamp());
         }
         else
         {
             guard.unlock();
-            Streamer->newFrame(buffer, frameBytes);
+            Streamer->newFrame(buffer, frameBytes, v4l_base->getFrameTimestamp());
         }
         return;
     }
@@ -165,6 +165,8 @@ public:
         void allocateBuffers();
         void releaseBuffers();
         void updateFrameSize();
+        /** @return True if frames are captured in the pixel format and size of the stream */
+        bool isStreamFormat();
 
         /* Shutter control */
         bool setShutter(double duration);
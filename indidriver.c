@@ -1112,22 +1112,18 @@ int IUSaveDefaultConfig(const char *source_config, const char *dest_config, cons
 {
     char configFileName[MAXRBUF], configDefaultFileName[MAXRBUF];
 
-    if (source_config)
-        strncpy(configFileName, source_config, MAXRBUF);
-    else
-    {
-        if (getenv("INDICONFIG"))
-            strncpy(configFileName, getenv("INDICONFIG"), MAXRBUF);
-        else
-            snprintf(configFileName, MAXRBUF, "%s/.indi/%s_config.xml", getenv("HOME"), dev);
-    }
+    if (IUGetConfigFileName(source_config, dev, configFileName) < 0)
+        return -1;
 
     if (dest_config)
         strncpy(configDefaultFileName, dest_config, MAXRBUF);
-    else if (getenv("INDICONFIG"))
-        snprintf(configDefaultFileName, MAXRBUF, "%s.default", getenv("INDICONFIG"));
     else
-        snprintf(configDefaultFileName, MAXRBUF, "%s/.indi/%s_config.xml.default", getenv("HOME"), dev);
+    {
+        char defaultSource[MAXRBUF];
+        if (IUGetConfigFileName(NULL, dev, defaultSource) < 0)
+            return -1;
+        snprintf(configDefaultFileName, MAXRBUF, "%s.default", defaultSource);
+    }
 
     // If the default doesn't exist, create it.
     if (access(configDefaultFileName, F_OK))
@@ -1560,6 +1556,27 @@ int IUPurgeConfig(const char *filename, const char *dev, char errmsg[])
     return 0;
 }
 
+static void (*configReadHook)(const char *dev) = NULL;
+
+void IUSetConfigReadHook(void (*hook)(const char *dev))
+{
+    configReadHook = hook;
+}
+
+int IUGetConfigFileName(const char *filename, const char *dev, char configFileName[])
+{
+    if (filename)
+        snprintf(configFileName, MAXRBUF, "%s", filename);
+    else if (getenv("INDICONFIG"))
+        snprintf(configFileName, MAXRBUF, "%s", getenv("INDICONFIG"));
+    else if (getenv("HOME") && dev)
+        snprintf(configFileName, MAXRBUF, "%s/.indi/%s_config.xml", getenv("HOME"), dev);
+    else
+        return -1;
+
+    return 0;
+}
+
 FILE *IUGetConfigFP(const char *filename, const char *dev, const char *mode, char errmsg[])
 {
     char configFileName[MAXRBUF];
@@ -1567,24 +1584,27 @@ FILE *IUGetConfigFP(const char *filename, const char *dev, const char *mode, cha
     struct stat st;
     FILE *fp = NULL;
 
-    snprintf(configDir, MAXRBUF, "%s/.indi/", getenv("HOME"));
+    /* Let pending configuration changes reach the disk before reading */
+    if (configReadHook && dev && mode[0] == 'r')
+        configReadHook(dev);
 
-    if (filename)
-        strncpy(configFileName, filename, MAXRBUF);
-    else
+    if (IUGetConfigFileName(filename, dev, configFileName) < 0)
     {
-        if (getenv("INDICONFIG"))
-            strncpy(configFileName, getenv("INDICONFIG"), MAXRBUF);
-        else
-            snprintf(configFileName, MAXRBUF, "%s%s_config.xml", configDir, dev);
+        snprintf(errmsg, MAXRBUF, "Unable to locate config file. Neither INDICONFIG nor HOME is set.");
+        return NULL;
     }
 
-    if (stat(configDir, &st) != 0)
+    if (getenv("HOME"))
     {
-        if (mkdir(configDir, S_IRWXU | S_IRWXG | S_IROTH | S_IXOTH) < 0)
+        snprintf(configDir, MAXRBUF, "%s/.indi/", getenv("HOME"));
+
+        if (stat(configDir, &st) != 0)
         {
-            snprintf(errmsg, MAXRBUF, "Unable to create config directory. Error %s: %s", configDir, strerror(errno));
-            return NULL;
+            if (mkdir(configDir, S_IRWXU | S_IRWXG | S_IROTH | S_IXOTH) < 0)
+            {
+                snprintf(errmsg, MAXRBUF, "Unable to create config directory. Error %s: %s", configDir, strerror(errno));
+                return NULL;
+            }
         }
     }
 
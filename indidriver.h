@@ -80,6 +80,21 @@ be used as the configuration filename</li>
 */
 extern FILE *IUGetConfigFP(const char *filename, const char *dev, const char *mode, char errmsg[]);
 
+/** \brief Get the path of a configuration file.
+    \param filename full path of the configuration file. If set, it is copied to configFileName.
+           If set to NULL, the filename is generated as described in the <b>Detailed Description</b> introduction.
+    \param dev device name. This is used if the filename parameter is NULL, and INDICONFIG environment variable is not set.
+    \param configFileName buffer receiving the path. The size of the buffer must be at least MAXRBUF.
+    \return 0 on success, -1 if the path cannot be generated since neither INDICONFIG nor HOME is set.
+*/
+extern int IUGetConfigFileName(const char *filename, const char *dev, char configFileName[]);
+
+/** \brief Register a function called before a configuration file is opened for reading.
+    This lets drivers keeping configuration changes in memory (e.g. INDI::DefaultDevice) write them to disk before the file is read.
+    \param hook function called with the device name passed to IUGetConfigFP, or NULL to remove the hook.
+*/
+extern void IUSetConfigReadHook(void (*hook)(const char *dev));
+
 /**
     \param filename full path of the configuration file. If set, it will be deleted from disk.
            If set to NULL, it will attempt to generate the filename as described in the <b>Detailed Description</b> introduction and then delete it.
@@ -122,7 +122,7 @@ dsp_triangle dsp_align_calc_triangle(dsp_star* stars)
     int d;
     dsp_triangle triangle;
     triangle.dims = stars[0].center.dims+1;
-    double *delta = (double*)malloc(sizeof(double)*triangle.dims);
+    double *delta = (double*)calloc(triangle.dims, sizeof(double));
     double **diff = (double**)malloc(sizeof(double*)*triangle.dims);
     triangle.sizes = (double*)malloc(sizeof(double)*triangle.dims);
     triangle.ratios = (double*)malloc(sizeof(double)*triangle.dims);
@@ -178,58 +178,90 @@ dsp_triangle dsp_align_calc_triangle(dsp_star* stars)
     return triangle;
 }
 
+static void free_triangle(dsp_triangle *triangle)
+{
+    int d;
+    for(d = 0; d < triangle->dims; d++)
+        free(triangle->stars[d].center.location);
+    free(triangle->stars);
+    free(triangle->sizes);
+    free(triangle->ratios);
+    free(triangle->theta);
+}
+
+static void free_align_info(dsp_align_info *align_info)
+{
+    free(align_info->center);
+    free(align_info->offset);
+    free(align_info->radians);
+    free(align_info->factor);
+}
+
+static void build_triangles(dsp_stream_p stream, dsp_star *stars, int dims, int first)
+{
+    int d, x, y;
+    for(x = 0; x < stream->triangles_count; x++)
+        free_triangle(&stream->triangles[x]);
+    stream->triangles_count = 0;
+    for(x = 0; x < stream->stars_count; x++) {
+        for(y = x+first; y < stream->stars_count-dims+1; y++) {
+            for(d = 0; d < dims; d++) {
+                stars[d] = stream->stars[y+d];
+            }
+            dsp_triangle t = dsp_align_calc_triangle(stars);
+            dsp_stream_add_triangle(stream, t);
+            free_triangle(&t);
+        }
+    }
+}
+
 int dsp_align_get_offset(dsp_stream_p stream1, dsp_stream_p stream2, double tolerance, double target_score)
 {
     dsp_align_info align_info;
     double decimals = pow(10, tolerance);
     double div = 0.0;
-    int d, t1, t2, x, y;
+    int d, t1, t2;
     double phi = 0.0;
     int dims = stream1->dims+1;
     double min_score = 1.0;
-    double ratio = decimals*1600.0/div;
+    int found = 0;
+    if(stream1->stars_count < dims || stream2->stars_count < dims) {
+        stream2->align_info.err = 0xf;
+        return stream2->align_info.err;
+    }
     dsp_star *stars = (dsp_star*)malloc(sizeof(dsp_star)*dims);
     for(d = 0; d < stream1->dims; d++) {
         div += pow(stream2->sizes[d], 2);
     }
     div = pow(div, 0.5);
+    double ratio = decimals*1600.0/div;
     pwarn("decimals: %lf\n", decimals);
     target_score = 1.0-target_score/100.0;
-    stream2->align_info.dims = 2;
-    stream2->align_info.score = 1.0;
-    stream2->align_info.decimals = decimals;
     pgarb("creating triangles for reference frame...\n");
-    stream1->align_info.triangles_count = 0;
-    for(x = 0; x < stream1->stars_count; x++) {
-        for(y = x+1; y < stream1->stars_count-dims+1; y++) {
-            for(d = 0; d < dims; d++) {
-                stars[d] = stream1->stars[y+d];
-            }
-            dsp_triangle t = dsp_align_calc_triangle(stars);
-            dsp_stream_add_triangle(stream1, t);
-        }
-    }
+    build_triangles(stream1, stars, dims, 1);
     pgarb("creating triangles for current frame...\n");
-    stream2->align_info.triangles_count = 0;
-    for(x = 0; x < stream2->stars_count; x++) {
-        for(y = x; y < stream2->stars_count-dims+1; y++) {
-            for(d = 0; d < dims; d++) {
-                stars[d] = stream2->stars[y+d];
-            }
-            dsp_triangle t = dsp_align_calc_triangle(stars);
-            dsp_stream_add_triangle(stream2, t);
-        }
-    }
+    build_triangles(stream2, stars, dims, 0);
     free(stars);
     for(t1 = 0; t1 < stream1->triangles_count; t1++) {
         for(t2 = 0; t2 < stream2->triangles_count; t2++) {
             align_info = dsp_align_fill_info(stream1->triangles[t1], stream2->triangles[t2]);
             if(align_info.score < min_score) {
+                // Only free the previous match if it was found here, it may be shared with a copy of the stream otherwise
+                if(found)
+                    free_align_info(&stream2->align_info);
                 stream2->align_info = align_info;
                 min_score = align_info.score;
+                found = 1;
+            } else {
+                free_align_info(&align_info);
             }
         }
     }
+    if(!found) {
+        stream2->align_info.err = 0xf;
+        return stream2->align_info.err;
+    }
+    stream2->align_info.decimals = decimals;
     double radians = stream2->align_info.radians[0];
     if(radians > M_PI)
         radians -= M_PI*2;
@@ -176,10 +176,23 @@ void dsp_stream_free(dsp_stream_p stream)
         free(stream->location);
     if(stream->target != NULL)
         free(stream->target);
-    if(stream->stars != NULL)
+    int i, d;
+    if(stream->stars != NULL) {
+        for(i = 0; i < stream->stars_count; i++)
+            free(stream->stars[i].center.location);
         free(stream->stars);
-    if(stream->triangles != NULL)
+    }
+    if(stream->triangles != NULL) {
+        for(i = 0; i < stream->triangles_count; i++) {
+            for(d = 0; d < stream->triangles[i].dims; d++)
+                free(stream->triangles[i].stars[d].center.location);
+            free(stream->triangles[i].stars);
+            free(stream->triangles[i].sizes);
+            free(stream->triangles[i].ratios);
+            free(stream->triangles[i].theta);
+        }
         free(stream->triangles);
+    }
     free(stream);
     stream = NULL;
 }
@@ -685,6 +685,12 @@ void BaseClientPrivate::listenINDI()
         cDeviceNames.clear();
         sSocketChanged.notify_all();
     }
+
+    // Wake up any client waiting for a transaction to complete.
+    {
+        std::lock_guard<std::mutex> locker(transactionLock);
+        transactionChanged.notify_all();
+    }
 }
 
 static std::vector<XMLEle *> findBlobElements(XMLEle * root)
@@ -743,6 +749,27 @@ bool BaseClientPrivate::parseAttachedBlobs(XMLEle *root, std::vector<std::string
 }
 
 size_t BaseClientPrivate::sendData(const void *data, size_t size)
+{
+    {
+        std::lock_guard<std::mutex> locker(transactionLock);
+        if (isTransactionOwner())
+        {
+            transactionBuffer.append(static_cast<const char *>(data), size);
+            return size;
+        }
+    }
+
+    int ret = writeData(data, size);
+
+    if (ret < 0)
+    {
+        disconnect(-1);
+    }
+
+    return std::max(ret, 0);
+}
+
+int BaseClientPrivate::writeData(const void *data, size_t size)
 {
     int ret;
 
@@ -755,12 +782,7 @@ size_t BaseClientPrivate::sendData(const void *data, size_t size)
     }
     while(ret == -1 && (errno == EINTR || errno == EAGAIN || errno == EWOULDBLOCK));
 
-    if (ret < 0)
-    {
-        disconnect(-1);
-    }
-
-    return std::max(ret, 0);
+    return ret;
 }
 
 void BaseClientPrivate::sendString(const char *fmt, ...)
@@ -774,6 +796,131 @@ void BaseClientPrivate::sendString(const char *fmt, ...)
     sendData(message, strlen(message));
 }
 
+bool BaseClientPrivate::isTransactionOwner() const
+{
+    return transactionActive && transactionOwner == std::this_thread::get_id();
+}
+
+bool BaseClientPrivate::startTransaction()
+{
+    std::lock_guard<std::mutex> locker(transactionLock);
+
+    // Only one transaction at a time, including one still waiting for completion.
+    if (transactionActive || !transactionProperties.empty())
+        return false;
+
+    transactionActive = true;
+    transactionOwner  = std::this_thread::get_id();
+    transactionBuffer.clear();
+    return true;
+}
+
+void BaseClientPrivate::cancelTransaction()
+{
+    std::lock_guard<std::mutex> locker(transactionLock);
+    if (!isTransactionOwner())
+        return;
+
+    transactionActive = false;
+    transactionBuffer.clear();
+    transactionProperties.clear();
+}
+
+IPState BaseClientPrivate::finishTransaction(uint32_t timeout)
+{
+    std::unique_lock<std::mutex> locker(transactionLock);
+    if (!isTransactionOwner())
+        return IPS_ALERT;
+
+    std::string buffer;
+    buffer.swap(transactionBuffer);
+
+    // All buffered commands go out in a single write. The lock is held until it completes, so replies are
+    // only tracked once the commands are sent.
+    int ret = buffer.empty() ? 0 : writeData(buffer.data(), buffer.size());
+    transactionActive = false;
+
+    if (ret < 0 || static_cast<size_t>(ret) != buffer.size())
+    {
+        transactionProperties.clear();
+        locker.unlock();
+        // A short write leaves a truncated element in the stream, the server cannot parse anything after it
+        disconnect(-1);
+        return IPS_ALERT;
+    }
+
+    if (timeout == 0)
+    {
+        transactionProperties.clear();
+        return IPS_OK;
+    }
+
+    bool completed = transactionChanged.wait_for(locker, std::chrono::milliseconds(timeout), [this]
+    {
+        if (sConnected == false)
+            return true;
+
+        for (const auto &oneProperty : transactionProperties)
+        {
+            if (oneProperty.second != IPS_OK && oneProperty.second != IPS_ALERT)
+                return false;
+        }
+        return true;
+    });
+
+    IPState result = IPS_OK;
+
+    if (sConnected == false)
+        result = IPS_ALERT;
+    else if (!completed)
+        result = IPS_BUSY;
+    else
+    {
+        for (const auto &oneProperty : transactionProperties)
+        {
+            if (oneProperty.second == IPS_ALERT)
+            {
+                result = IPS_ALERT;
+                break;
+            }
+        }
+    }
+
+    transactionProperties.clear();
+    return result;
+}
+
+void BaseClientPrivate::addTransactionProperty(const char *device, const char *name)
+{
+    std::lock_guard<std::mutex> locker(transactionLock);
+    if (isTransactionOwner())
+        transactionProperties[std::make_pair(std::string(device), std::string(name))] = IPS_BUSY;
+}
+
+void BaseClientPrivate::updateTransactionProperty(XMLEle *root)
+{
+    std::lock_guard<std::mutex> locker(transactionLock);
+
+    // Commands of an active transaction are not sent yet, updates are not replies to them.
+    if (transactionActive || transactionProperties.empty())
+        return;
+
+    const char *device = findXMLAttValu(root, "device");
+    const char *name   = findXMLAttValu(root, "name");
+    const char *state  = findXMLAttValu(root, "state");
+
+    auto it = transactionProperties.find(std::make_pair(std::string(device), std::string(name)));
+    if (it == transactionProperties.end() || state[0] == '\0')
+        return;
+
+    IPState newState;
+    if (crackIPState(state, &newState) == 0)
+    {
+        it->second = newState;
+        transactionChanged.notify_all();
+    }
+}
+
 int BaseClientPrivate::dispatchCommand(XMLEle *root, char *errmsg)
 {
     const char *tag = tagXMLEle(root);
@@ -847,7 +994,11 @@ int BaseClientPrivate::dispatchCommand(XMLEle *root, char *errmsg)
     else if (!strcmp(tag, "setTextVector") || !strcmp(tag, "setNumberVector") ||
              !strcmp(tag, "setSwitchVector") || !strcmp(tag, "setLightVector") ||
              !strcmp(tag, "setBLOBVector"))
-        return dp->setValue(root, errmsg);
+    {
+        int ret = dp->setValue(root, errmsg);
+        updateTransactionProperty(root);
+        return ret;
+    }
 
     return INDI_DISPATCH_ERROR;
 }
@@ -1259,6 +1410,7 @@ void INDI::BaseClient::sendNewText(ITextVectorProperty *tvp)
 {
     D_PTR(BaseClient);
     tvp->s = IPS_BUSY;
+    d->addTransactionProperty(tvp->device, tvp->name);
     IUUserIONewText(&io, d, tvp);
 }
 
@@ -1289,6 +1441,7 @@ void INDI::BaseClient::sendNewNumber(INumberVectorProperty *nvp)
 {
     D_PTR(BaseClient);
     nvp->s = IPS_BUSY;
+    d->addTransactionProperty(nvp->device, nvp->name);
     IUUserIONewNumber(&io, d, nvp);
 }
 
@@ -1331,6 +1484,7 @@ void INDI::BaseClient::sendNewSwitch(ISwitchVectorProperty *svp)
 {
     D_PTR(BaseClient);
     svp->s = IPS_BUSY;
+    d->addTransactionProperty(svp->device, svp->name);
     IUUserIONewSwitch(&io, d, svp);
 }
 
@@ -1359,6 +1513,7 @@ void INDI::BaseClient::sendNewSwitch(const char *deviceName, const char *propert
 void INDI::BaseClient::startBlob(const char *devName, const char *propName, const char *timestamp)
 {
     D_PTR(BaseClient);
+    d->addTransactionProperty(devName, propName);
     IUUserIONewBLOBStart(&io, d, devName, propName, timestamp);
 }
 
@@ -1387,6 +1542,24 @@ void INDI::BaseClient::finishBlob()
     IUUserIONewBLOBFinish(&io, d);
 }
 
+bool INDI::BaseClient::startTransaction()
+{
+    D_PTR(BaseClient);
+    return d->startTransaction();
+}
+
+IPState INDI::BaseClient::finishTransaction(uint32_t timeout)
+{
+    D_PTR(BaseClient);
+    return d->finishTransaction(timeout);
+}
+
+void INDI::BaseClient::cancelTransaction()
+{
+    D_PTR(BaseClient);
+    d->cancelTransaction();
+}
+
 void INDI::BaseClient::setBLOBMode(BLOBHandling blobH, const char *dev, const char *prop)
 {
     D_PTR(BaseClient);
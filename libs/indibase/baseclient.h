@@ -215,6 +215,41 @@ class INDI::BaseClient : public INDI::BaseMediator
         /** @brief Send new Switch command to server */
         void sendNewSwitch(const char *deviceName, const char *propertyName, const char *elementName);
 
+        /** @brief Start buffering outgoing commands into a transaction.
+         *
+         *  All subsequent sendNewText, sendNewNumber, sendNewSwitch and BLOB calls issued from the calling thread
+         *  are formatted into a local buffer instead of being written to the server one by one. The buffer is sent
+         *  to the server in a single write by finishTransaction(). This is useful when configuring a device with
+         *  many properties back to back (binning, frame, gain, offset, temperature...etc).
+         *
+         *  @code{.cpp}
+         *  startTransaction();
+         *  sendNewNumber("CCD Simulator", "CCD_BINNING", "HOR_BIN", 2);
+         *  sendNewNumber("CCD Simulator", "CCD_BINNING", "VER_BIN", 2);
+         *  sendNewSwitch("CCD Simulator", "CCD_COOLER", "COOLER_ON");
+         *  if (finishTransaction(5000) != IPS_OK)
+         *      std::cerr << "Camera configuration failed or timed out." << std::endl;
+         *  @endcode
+         *
+         *  @return True if the transaction was started, false if another transaction is already in progress.
+         */
+        bool startTransaction();
+
+        /** @brief Send all commands buffered since startTransaction() in a single write.
+         *  @param timeout If greater than zero, wait up to timeout milliseconds until all properties touched by the
+         *  transaction are reported back by the driver in either IPS_OK or IPS_ALERT state.
+         *  @return If timeout is zero, IPS_OK if the buffer was sent, IPS_ALERT otherwise. The client disconnects from
+         *  the server if the buffer could not be sent completely. If timeout is greater than
+         *  zero, IPS_OK if all touched properties completed successfully, IPS_ALERT if any of them failed or the
+         *  connection was lost, and IPS_BUSY if the timeout expired first.
+         *  @note Like any INDI client, completion is inferred from the next state update of each property. A periodic
+         *  update sent by the driver before it processes the new value may therefore complete the wait early.
+         */
+        IPState finishTransaction(uint32_t timeout = 0);
+
+        /** @brief Discard all commands buffered since startTransaction() without sending them. */
+        void cancelTransaction();
+
         /** @brief Send opening tag for BLOB command to server */
         void startBlob(const char *devName, const char *propName, const char *timestamp);
         /** @brief Send ONE blob content to server. The BLOB data in raw binary format and will be converted to base64 and sent to server */
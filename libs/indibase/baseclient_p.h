@@ -52,6 +52,24 @@ class BaseClientPrivate
         size_t sendData(const void *data, size_t size);
         void sendString(const char *fmt, ...);
 
+    public:
+        bool startTransaction();
+        IPState finishTransaction(uint32_t timeout);
+        void cancelTransaction();
+
+        /** @brief Record a property sent as part of the current transaction, if any, so its completion is tracked */
+        void addTransactionProperty(const char *device, const char *name);
+
+        /** @brief Update the state of properties tracked by the current transaction from an incoming setXXXVector */
+        void updateTransactionProperty(XMLEle *root);
+
+    private:
+        /** @brief Returns true if the calling thread owns the current transaction. Must be called with transactionLock held */
+        bool isTransactionOwner() const;
+
+        /** @brief Write data to the server socket, bypassing any transaction. Returns -1 on error */
+        int writeData(const void *data, size_t size);
+
     public:
         void listenINDI();
         /** @brief clear Clear devices and blob modes */
@@ -118,6 +136,14 @@ class BaseClientPrivate
         int sExitCode;
         bool verbose;
 
+        // Outgoing commands transaction
+        std::mutex transactionLock;
+        std::condition_variable transactionChanged;
+        bool transactionActive {false};
+        std::thread::id transactionOwner;
+        std::string transactionBuffer;
+        std::map<std::pair<std::string, std::string>, IPState> transactionProperties;
+
         // Parse & FILE buffers for IO
 
         uint32_t timeout_sec, timeout_us;
@@ -19,6 +19,7 @@
 *******************************************************************************/
 
 #include "baseclientqt.h"
+#include "baseclientqt_p.h"
 
 #include "base64.h"
 #include "basedevice.h"
@@ -34,8 +35,6 @@
 #include <cstdlib>
 #include <assert.h>
 
-#define MAXINDIBUF 49152
-
 #if defined(_MSC_VER)
 #define snprintf _snprintf
 #pragma warning(push)
@@ -61,13 +60,23 @@ INDI::BaseClientQt::BaseClientQt(QObject *parent) : QObject(parent), cServer("lo
         return self->client_socket.write(message, strlen(message));
     };
 
-    sConnected = false;
-    verbose    = false;
-    lillp      = nullptr;
+    sConnected       = false;
+    verbose          = false;
+    parserGeneration = 0;
+    coalescingRate   = 0;
 
     timeout_sec = 3;
     timeout_us  = 0;
 
+    qRegisterMetaType<INDI::BaseClientQtChunk>("INDI::BaseClientQtChunk");
+
+    // Incoming traffic is parsed on the parser thread and dispatched back on this thread.
+    parser = new BaseClientQtParser();
+    parser->moveToThread(&parserThread);
+    connect(&parserThread, &QThread::finished, parser, &QObject::deleteLater);
+    connect(parser, &BaseClientQtParser::chunkReady, this, &BaseClientQt::dispatchChunk, Qt::QueuedConnection);
+    parserThread.start();
+
     connect(&client_socket, SIGNAL(readyRead()), this, SLOT(listenINDI()));
     connect(&client_socket, SIGNAL(error(QAbstractSocket::SocketError)), this,
             SLOT(processSocketError(QAbstractSocket::SocketError)));
@@ -75,6 +84,8 @@ INDI::BaseClientQt::BaseClientQt(QObject *parent) : QObject(parent), cServer("lo
 
 INDI::BaseClientQt::~BaseClientQt()
 {
+    parserThread.quit();
+    parserThread.wait();
     clear();
 }
 
@@ -128,7 +139,7 @@ bool INDI::BaseClientQt::connectServer()
 
     clear();
 
-    lillp = newLilXML();
+    QMetaObject::invokeMethod(parser, "reset", Qt::QueuedConnection, Q_ARG(int, ++parserGeneration));
 
     sConnected = true;
 
@@ -164,11 +175,7 @@ bool INDI::BaseClientQt::disconnectServer()
     sConnected = false;
 
     client_socket.close();
-    if (lillp)
-    {
-        delLilXML(lillp);
-        lillp = nullptr;
-    }
+    QMetaObject::invokeMethod(parser, "reset", Qt::QueuedConnection, Q_ARG(int, ++parserGeneration));
 
     clear();
 
@@ -252,34 +259,28 @@ void *INDI::BaseClientQt::listenHelper(void *context)
 
 void INDI::BaseClientQt::listenINDI()
 {
-    char buffer[MAXINDIBUF];
+    if (sConnected == false)
+        return;
+
+    // Only read here, parsing is done on the parser thread.
+    QByteArray data = client_socket.readAll();
+    if (data.isEmpty())
+        return;
+
+    QMetaObject::invokeMethod(parser, "parseChunk", Qt::QueuedConnection, Q_ARG(QByteArray, data));
+}
+
+void INDI::BaseClientQt::dispatchChunk(const INDI::BaseClientQtChunk &chunk)
+{
     char errorMsg[MAXRBUF];
     int err_code = 0;
 
-    XMLEle **nodes;
-    int inode = 0;
-
-    if (sConnected == false)
-        return;
+    // Elements parsed for a previous connection are dropped.
+    bool stale = (sConnected == false || chunk.generation != parserGeneration);
 
-    while (client_socket.bytesAvailable() > 0)
+    for (XMLEle *root : chunk.elements)
     {
-        qint64 readBytes = client_socket.read(buffer, MAXINDIBUF - 1);
-        if (readBytes > 0)
-            buffer[readBytes] = '\0';
-
-        nodes = parseXMLChunk(lillp, buffer, readBytes, errorMsg);
-        if (!nodes)
-        {
-            if (errorMsg[0])
-            {
-                fprintf(stderr, "Bad XML from %s/%ud: %s\n%s\n", cServer.c_str(), cPort, errorMsg, buffer);
-                return;
-            }
-            return;
-        }
-        XMLEle *root = nodes[inode];
-        while (root)
+        if (!stale)
         {
             if (verbose)
                 prXMLEle(stderr, root, 0);
@@ -293,16 +294,18 @@ void INDI::BaseClientQt::listenINDI()
                     prXMLEle(stderr, root, 0);
                 }
             }
-
-            delXMLEle(root); // not yet, delete and continue
-            inode++;
-            root = nodes[inode];
         }
-        free(nodes);
-        inode = 0;
+
+        delXMLEle(root);
     }
 }
 
+void INDI::BaseClientQt::setCoalescingRate(double rate)
+{
+    coalescingRate = std::max(0.0, rate);
+    QMetaObject::invokeMethod(parser, "setCoalescingRate", Qt::QueuedConnection, Q_ARG(double, coalescingRate));
+}
+
 int INDI::BaseClientQt::dispatchCommand(XMLEle *root, char *errmsg)
 {
     if (!strcmp(tagXMLEle(root), "message"))
@@ -694,7 +697,7 @@ void INDI::BaseClientQt::processSocketError(QAbstractSocket::SocketError socketE
     INDI_UNUSED(socketError);
     IDLog("Socket Error: %s\n", client_socket.errorString().toLatin1().constData());
     fprintf(stderr, "INDI server %s/%d disconnected.\n", cServer.c_str(), cPort);
-    delLilXML(lillp);
+    QMetaObject::invokeMethod(parser, "reset", Qt::QueuedConnection, Q_ARG(int, ++parserGeneration));
     client_socket.close();
     // Let client handle server disconnection
     serverDisconnected(-1);
@@ -716,6 +719,163 @@ bool INDI::BaseClientQt::isServerConnected() const
     return sConnected;
 }
 
+INDI::BaseClientQtParser::BaseClientQtParser(QObject *parent) : QObject(parent)
+{
+    lillp = newLilXML();
+
+    coalescingTimer = new QTimer(this);
+    connect(coalescingTimer, &QTimer::timeout, this, &BaseClientQtParser::flushPending);
+}
+
+INDI::BaseClientQtParser::~BaseClientQtParser()
+{
+    clearPending();
+    delLilXML(lillp);
+}
+
+void INDI::BaseClientQtParser::parseChunk(const QByteArray &data)
+{
+    char errorMsg[MAXRBUF];
+    BaseClientQtChunk chunk;
+    chunk.generation = generation;
+
+    QByteArray buffer(data);
+    XMLEle **nodes = parseXMLChunk(lillp, buffer.data(), buffer.size(), errorMsg);
+    if (!nodes)
+    {
+        if (errorMsg[0])
+            fprintf(stderr, "Bad XML: %s\n%s\n", errorMsg, buffer.constData());
+        return;
+    }
+
+    for (int inode = 0; nodes[inode]; inode++)
+    {
+        XMLEle *root = nodes[inode];
+
+        if (coalescing && isCoalescable(root))
+        {
+            std::string key = std::string(findXMLAttValu(root, "device")) + "." + findXMLAttValu(root, "name");
+            auto pending = pendingIndex.find(key);
+            if (pending == pendingIndex.end())
+            {
+                pendingIndex[key] = root;
+                pendingOrder.push_back(root);
+            }
+            else
+            {
+                merge(pending->second, root);
+                delXMLEle(root);
+            }
+            continue;
+        }
+
+        // Anything else is delivered in order, after all updates received before it.
+        takePending(chunk.elements);
+        chunk.elements.push_back(root);
+    }
+    free(nodes);
+
+    if (!chunk.elements.empty())
+        emit chunkReady(chunk);
+}
+
+void INDI::BaseClientQtParser::reset(int generation)
+{
+    this->generation = generation;
+    clearPending();
+    delLilXML(lillp);
+    lillp = newLilXML();
+}
+
+void INDI::BaseClientQtParser::setCoalescingRate(double rate)
+{
+    coalescing = rate > 0;
+
+    if (coalescing)
+    {
+        coalescingTimer->start(std::max(1, static_cast<int>(1000.0 / rate)));
+    }
+    else
+    {
+        coalescingTimer->stop();
+        flushPending();
+    }
+}
+
+void INDI::BaseClientQtParser::flushPending()
+{
+    if (pendingOrder.empty())
+        return;
+
+    BaseClientQtChunk chunk;
+    chunk.generation = generation;
+    takePending(chunk.elements);
+    emit chunkReady(chunk);
+}
+
+bool INDI::BaseClientQtParser::isCoalescable(XMLEle *root) const
+{
+    const char *tag = tagXMLEle(root);
+
+    // Updates carrying a message are never merged so that no message is lost.
+    if (findXMLAtt(root, "message") != nullptr)
+        return false;
+
+    return !strcmp(tag, "setNumberVector") || !strcmp(tag, "setTextVector") ||
+           !strcmp(tag, "setSwitchVector") || !strcmp(tag, "setLightVector");
+}
+
+static void setXMLAttValu(XMLEle *ep, const char *name, const char *valu)
+{
+    XMLAtt *ap = findXMLAtt(ep, name);
+    if (ap)
+        editXMLAtt(ap, valu);
+    else
+        addXMLAtt(ep, name, valu);
+}
+
+void INDI::BaseClientQtParser::merge(XMLEle *pending, XMLEle *source)
+{
+    for (XMLAtt *ap = nextXMLAtt(source, 1); ap != nullptr; ap = nextXMLAtt(source, 0))
+        setXMLAttValu(pending, nameXMLAtt(ap), valuXMLAtt(ap));
+
+    for (XMLEle *ep = nextXMLEle(source, 1); ep != nullptr; ep = nextXMLEle(source, 0))
+    {
+        XMLEle *target = nullptr;
+        for (XMLEle *pp = nextXMLEle(pending, 1); pp != nullptr; pp = nextXMLEle(pending, 0))
+        {
+            if (!strcmp(findXMLAttValu(pp, "name"), findXMLAttValu(ep, "name")))
+            {
+                target = pp;
+                break;
+            }
+        }
+
+        if (target == nullptr)
+            target = addXMLEle(pending, tagXMLEle(ep));
+
+        for (XMLAtt *ap = nextXMLAtt(ep, 1); ap != nullptr; ap = nextXMLAtt(ep, 0))
+            setXMLAttValu(target, nameXMLAtt(ap), valuXMLAtt(ap));
+
+        editXMLEle(target, pcdataXMLEle(ep));
+    }
+}
+
+void INDI::BaseClientQtParser::takePending(std::vector<XMLEle *> &elements)
+{
+    elements.insert(elements.end(), pendingOrder.begin(), pendingOrder.end());
+    pendingOrder.clear();
+    pendingIndex.clear();
+}
+
+void INDI::BaseClientQtParser::clearPending()
+{
+    for (XMLEle *root : pendingOrder)
+        delXMLEle(root);
+    pendingOrder.clear();
+    pendingIndex.clear();
+}
+
 #if defined(_MSC_VER)
 #undef snprintf
 #pragma warning(pop)
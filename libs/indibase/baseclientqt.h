@@ -25,6 +25,7 @@
 #include "indibase.h"
 
 #include <QTcpSocket>
+#include <QThread>
 
 #include <vector>
 #include <string>
@@ -38,6 +39,12 @@ typedef SSIZE_T ssize_t;
 
 // #define MAXRBUF 2048 // #PS: defined in indibase.h
 
+namespace INDI
+{
+class BaseClientQtParser;
+struct BaseClientQtChunk;
+}
+
 /**
  * \class INDI::BaseClientQt
    \brief Class to provide basic client functionality based on Qt5 toolkit and is therefore suitable for cross-platform development.
@@ -47,6 +54,9 @@ typedef SSIZE_T ssize_t;
    a set of INDI::BaseDevice devices, and read and write properties seamlessly. Event driven programming is possible due to
    notifications upon reception of new devices or properties.
 
+   Incoming traffic is parsed on a dedicated worker thread so that large BLOBs do not block the thread owning the client.
+   Parsed messages are then dispatched, and all notifications are emitted, on the thread owning the client.
+
    \attention All notifications functions defined in INDI::BaseMediator <b>must</b> be implemented in the client class even if
    they are not used because these are pure virtual functions.
 
@@ -232,7 +242,30 @@ class INDI::BaseClientQt : public QObject, public INDI::BaseMediator
             timeout_us  = microseconds;
         }
 
+        /**
+         * @brief setCoalescingRate Limit the rate of updates delivered for each property.
+         *
+         * When enabled, consecutive updates of the same Number, Text, Switch or Light property received within one
+         * period are merged, and the client is notified at most once per property per period. This is useful for GUI
+         * clients that only need to refresh once per frame while a mount floods coordinate updates. BLOBs, messages,
+         * and updates carrying a message are never coalesced and are always delivered in order.
+         * @param rate Maximum number of updates per second for a single property. Zero disables coalescing (default).
+         */
+        void setCoalescingRate(double rate);
+
+        /**
+         * @brief getCoalescingRate Get the maximum rate of updates for a single property.
+         * @return Rate in Hz, or zero if coalescing is disabled.
+         */
+        double getCoalescingRate() const
+        {
+            return coalescingRate;
+        }
+
     protected:
+        /** \brief Dispatch all elements parsed by the parser thread */
+        void dispatchChunk(const INDI::BaseClientQtChunk &chunk);
+
         /** \brief Dispatch command received from INDI server to respective devices handled by the client */
         int dispatchCommand(XMLEle *root, char *errmsg);
 
@@ -293,9 +326,12 @@ class INDI::BaseClientQt : public QObject, public INDI::BaseMediator
         bool sConnected;
         bool verbose;
 
-        // Parse & FILE buffers for IO
+        // Parser running on a worker thread
+        QThread parserThread;
+        INDI::BaseClientQtParser *parser;
+        int parserGeneration;
+        double coalescingRate;
 
-        LilXML *lillp; /* XML parser context */
         uint32_t timeout_sec, timeout_us;
 
     private slots:
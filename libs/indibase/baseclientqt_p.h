@@ -0,0 +1,101 @@
+/*******************************************************************************
+  Copyright(c) 2016 Jasem Mutlaq. All rights reserved.
+
+ INDI Qt Client
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Library General Public
+ License version 2 as published by the Free Software Foundation.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Library General Public License for more details.
+
+ You should have received a copy of the GNU Library General Public License
+ along with this library; see the file COPYING.LIB.  If not, write to
+ the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ Boston, MA 02110-1301, USA.
+*******************************************************************************/
+
+#pragma once
+
+#include "lilxml.h"
+
+#include <QObject>
+#include <QByteArray>
+#include <QMetaType>
+#include <QTimer>
+
+#include <map>
+#include <string>
+#include <vector>
+
+namespace INDI
+{
+
+/**
+ * @brief The BaseClientQtChunk struct holds root elements parsed by the parser thread.
+ * Ownership of the elements is transferred to the receiver, which must delete them with delXMLEle.
+ */
+struct BaseClientQtChunk
+{
+    std::vector<XMLEle *> elements;
+    /** Connection generation the elements were parsed for, used to drop stale chunks after a reconnect */
+    int generation {0};
+};
+
+/**
+ * @brief The BaseClientQtParser class parses the INDI stream on a worker thread.
+ *
+ * Raw bytes read from the socket are queued to parseChunk(). Fully parsed root elements are handed back to the
+ * owning thread through chunkReady(). When coalescing is enabled, consecutive set vectors of the same
+ * Number, Text, Switch or Light property are merged and delivered at most once per coalescing period.
+ */
+class BaseClientQtParser : public QObject
+{
+        Q_OBJECT
+
+    public:
+        explicit BaseClientQtParser(QObject *parent = nullptr);
+        virtual ~BaseClientQtParser();
+
+    public slots:
+        /** @brief Parse a chunk of the INDI stream */
+        void parseChunk(const QByteArray &data);
+
+        /** @brief Drop the parser state and any pending element, and tag further chunks with generation */
+        void reset(int generation);
+
+        /** @brief Set the maximum delivery rate in Hz of updates for a single property. Zero disables coalescing */
+        void setCoalescingRate(double rate);
+
+    signals:
+        void chunkReady(INDI::BaseClientQtChunk chunk);
+
+    private slots:
+        void flushPending();
+
+    private:
+        /** @brief Returns true if root is a set vector that can be merged with a later one */
+        bool isCoalescable(XMLEle *root) const;
+        /** @brief Merge attributes and elements of source into the pending element */
+        void merge(XMLEle *pending, XMLEle *source);
+        /** @brief Move all pending elements, in order of arrival, to the end of elements */
+        void takePending(std::vector<XMLEle *> &elements);
+        void clearPending();
+
+    private:
+        LilXML *lillp {nullptr};
+        int generation {0};
+
+        QTimer *coalescingTimer {nullptr};
+        bool coalescing {false};
+
+        std::vector<XMLEle *> pendingOrder;
+        std::map<std::string, XMLEle *> pendingIndex;
+};
+
+}
+
+Q_DECLARE_METATYPE(INDI::BaseClientQtChunk)
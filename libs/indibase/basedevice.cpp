@@ -22,6 +22,7 @@
 #include "base64.h"
 #include "config.h"
 #include "indicom.h"
+#include "indicompression.h"
 #include "indistandardproperty.h"
 #include "locale_compat.h"
 
@@ -36,7 +37,6 @@
 #include <cassert>
 #include <cstdlib>
 #include <cstring>
-#include <zlib.h>
 #include <sys/stat.h>
 #include <thread>
 #include <chrono>
@@ -767,10 +767,11 @@ int BaseDevice::setBLOB(IBLOBVectorProperty *bvp, XMLEle *root, char *errmsg)
 
                 strncpy(blobEL->format, valuXMLAtt(fa), MAXINDIFORMAT);
 
-                if (strstr(blobEL->format, ".z"))
+                CompressionCodec codec;
+                if (findCompression(blobEL->format, codec))
                 {
-                    blobEL->format[strlen(blobEL->format) - 2] = '\0';
-                    uLongf dataSize = blobEL->size * sizeof(uint8_t);
+                    blobEL->format[strlen(blobEL->format) - strlen(compressionSuffix(codec))] = '\0';
+                    size_t dataSize = blobEL->size * sizeof(uint8_t);
                     uint8_t *dataBuffer = static_cast<uint8_t *>(malloc(dataSize));
 
                     if (dataBuffer == nullptr)
@@ -779,16 +780,15 @@ int BaseDevice::setBLOB(IBLOBVectorProperty *bvp, XMLEle *root, char *errmsg)
                         return (-1);
                     }
 
-                    int r = uncompress(dataBuffer, &dataSize, static_cast<unsigned char *>(blobEL->blob),
-                                       static_cast<uLong>(blobEL->bloblen));
-                    if (r != Z_OK)
+                    if (decompressBuffer(blobEL->blob, blobEL->bloblen, codec, dataBuffer, dataSize) == false)
                     {
-                        snprintf(errmsg, MAXRBUF, "INDI: %s.%s.%s compression error: %d", blobEL->bvp->device,
-                                 blobEL->bvp->name, blobEL->name, r);
+                        snprintf(errmsg, MAXRBUF, "INDI: %s.%s.%s compression error", blobEL->bvp->device,
+                                 blobEL->bvp->name, blobEL->name);
                         free(dataBuffer);
                         return -1;
                     }
                     blobEL->size = dataSize;
+                    blobEL->bloblen = dataSize;
                     IDSharedBlobFree(blobEL->blob);
                     blobEL->blob = dataBuffer;
                 }
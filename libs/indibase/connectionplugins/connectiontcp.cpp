@@ -19,6 +19,7 @@
 #include "connectiontcp.h"
 
 #include "NetIF.hpp"
+#include "indicom.h"
 #include "indilogger.h"
 #include "indistandardproperty.h"
 
@@ -152,7 +153,10 @@ bool TCP::establishConnection(const std::string &hostname, const std::string &po
     ts.tv_usec = 0;
 
     if (m_SockFD != -1)
+    {
+        tty_clear_read_buffer(m_SockFD);
         close(m_SockFD);
+    }
 
     if (LANSearchS[INDI::DefaultDevice::INDI_ENABLED].s == ISS_OFF)
         LOGF_INFO("Connecting to %s@%s ...", hostname.c_str(), port.c_str());
@@ -346,6 +350,7 @@ bool TCP::Disconnect()
 {
     if (m_SockFD > 0)
     {
+        tty_clear_read_buffer(m_SockFD);
         close(m_SockFD);
         m_SockFD = PortFD = -1;
     }
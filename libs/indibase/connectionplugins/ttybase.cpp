@@ -40,6 +40,8 @@
 #include <string.h>
 #include <time.h>
 
+#include <algorithm>
+
 #ifdef __APPLE__
 #include <sys/param.h>
 #endif
@@ -91,6 +93,10 @@ TTYBase::TTY_RESPONSE TTYBase::checkTimeout(uint8_t timeout)
     if (m_PortFD == -1)
         return TTY_ERRNO;
 
+    /* Bytes read ahead since the last write are available right away, select() does not see them */
+    if (m_ReadCount > 0)
+        return TTY_OK;
+
     struct timeval tv;
     fd_set readout;
     int retval;
@@ -130,6 +136,9 @@ TTYBase::TTY_RESPONSE TTYBase::write(const uint8_t *buffer, uint32_t nbytes, uin
     int bytes_w     = 0;
     *nbytes_written = 0;
 
+    // A new command starts a new exchange, bytes left over from the previous reply are stale.
+    clearReadBuffer();
+
     while (nbytes > 0)
     {
         bytes_w = ::write(m_PortFD, buffer + (*nbytes_written), nbytes);
@@ -175,6 +184,10 @@ TTYBase::TTY_RESPONSE TTYBase::read(uint8_t *buffer, uint32_t nbytes, uint8_t ti
     DEBUGFDEVICE(m_DriverName, m_DebugChannel, "%s: Request to read %d bytes with %d timeout for m_PortFD %d", __FUNCTION__,
                  nbytes, timeout, m_PortFD);
 
+    // Bytes left over by a previous section read come first
+    *nbytes_read = takeReadBuffer(buffer, nbytes);
+    numBytesToRead -= *nbytes_read;
+
     while (numBytesToRead > 0)
     {
         if ((timeoutResponse = checkTimeout(timeout)))
@@ -209,32 +222,53 @@ TTYBase::TTY_RESPONSE TTYBase::readSection(uint8_t *buffer, uint32_t nsize, uint
     if (m_PortFD == -1)
         return TTY_ERRNO;
 
-    int bytesRead = 0;
     TTY_RESPONSE timeoutResponse = TTY_OK;
     *nbytes_read  = 0;
     memset(buffer, 0, nsize);
 
-    uint8_t *read_char = nullptr;
+    if (nsize == 0)
+        return TTY_PARAM_ERROR;
 
     DEBUGFDEVICE(m_DriverName, m_DebugChannel, "%s: Request to read until stop char '%#02X' with %d timeout for m_PortFD %d",
                  __FUNCTION__, stop_byte, timeout, m_PortFD);
 
     for (;;)
     {
-        if ((timeoutResponse = checkTimeout(timeout)))
-            return timeoutResponse;
+        // Read everything available at once and keep what follows the stop byte for the next call.
+        if (m_ReadCount == 0)
+        {
+            if ((timeoutResponse = checkTimeout(timeout)))
+                return timeoutResponse;
 
-        read_char = reinterpret_cast<uint8_t*>(buffer + *nbytes_read);
-        bytesRead = ::read(m_PortFD, read_char, 1);
+            int bytesRead = ::read(m_PortFD, m_ReadBuffer, sizeof(m_ReadBuffer));
 
-        if (bytesRead < 0)
-            return TTY_READ_ERROR;
+            if (bytesRead <= 0)
+                return TTY_READ_ERROR;
 
-        DEBUGFDEVICE(m_DriverName, m_DebugChannel, "%s: buffer[%d]=%#X (%c)", __FUNCTION__, (*nbytes_read), *read_char, *read_char);
+            m_ReadStart = 0;
+            m_ReadCount = bytesRead;
 
-        (*nbytes_read)++;
+            for (int i = 0; i < bytesRead; i++)
+                DEBUGFDEVICE(m_DriverName, m_DebugChannel, "%s: buffer[%d]=%#X (%c)", __FUNCTION__, (*nbytes_read) + i,
+                             m_ReadBuffer[i], m_ReadBuffer[i]);
+        }
 
-        if (*read_char == stop_byte)
+        const uint8_t *begin = m_ReadBuffer + m_ReadStart;
+        auto stop = static_cast<const uint8_t *>(memchr(begin, stop_byte, m_ReadCount));
+        uint32_t length = stop ? static_cast<uint32_t>(stop - begin) + 1 : m_ReadCount;
+
+        if (length > nsize - *nbytes_read)
+        {
+            length = nsize - *nbytes_read;
+            stop = nullptr;
+        }
+
+        memcpy(buffer + *nbytes_read, begin, length);
+        m_ReadStart += length;
+        m_ReadCount -= length;
+        *nbytes_read += length;
+
+        if (stop)
             return TTY_OK;
         else if (*nbytes_read >= nsize)
             return TTY_OVERFLOW;
@@ -482,6 +516,7 @@ TTYBase::TTY_RESPONSE TTYBase::connect(const char *device, uint32_t bit_rate, ui
     }
 #endif
 
+    clearReadBuffer();
     m_PortFD = t_fd;
     /* return success */
     return TTY_OK;
@@ -676,6 +711,7 @@ TTYBase::TTY_RESPONSE TTYBase::connect(const char *device, uint32_t bit_rate, ui
         return TTY_PORT_FAILURE;
     }
 
+    clearReadBuffer();
     m_PortFD = t_fd;
     /* return success */
     return TTY_OK;
@@ -685,6 +721,22 @@ TTYBase::TTY_RESPONSE TTYBase::connect(const char *device, uint32_t bit_rate, ui
 
 #endif
 
+void TTYBase::clearReadBuffer()
+{
+    m_ReadStart = m_ReadCount = 0;
+}
+
+uint32_t TTYBase::takeReadBuffer(uint8_t *buffer, uint32_t nbytes)
+{
+    uint32_t count = std::min(nbytes, m_ReadCount);
+
+    memcpy(buffer, m_ReadBuffer + m_ReadStart, count);
+    m_ReadStart += count;
+    m_ReadCount -= count;
+
+    return count;
+}
+
 TTYBase::TTY_RESPONSE TTYBase::disconnect()
 {
     if (m_PortFD == -1)
@@ -694,6 +746,7 @@ TTYBase::TTY_RESPONSE TTYBase::disconnect()
     return TTY_ERRNO;
 #else
     tcflush(m_PortFD, TCIOFLUSH);
+    clearReadBuffer();
     int err = close(m_PortFD);
 
     if (err != 0)
@@ -112,6 +112,14 @@ class TTYBase
         */
         TTY_RESPONSE disconnect();
 
+        /**
+         * @brief clearReadBuffer Discard bytes read ahead by readSection().
+         * readSection() keeps bytes following the stop byte for the next read. They are returned first by read() and
+         * readSection(), and discarded by write() and disconnect(). Reading the port directly misses them. Call this
+         * function after discarding the port input by other means without writing to it, e.g. tcflush().
+         */
+        void clearReadBuffer();
+
         /**
          * @brief setDebug Enable or Disable debug logging
          * @param enabled If true, TTY traffic will be logged.
@@ -136,7 +144,14 @@ class TTYBase
 
         TTY_RESPONSE checkTimeout(uint8_t timeout);
 
+        /** @brief Copy up to nbytes read ahead bytes to buffer and return their count */
+        uint32_t takeReadBuffer(uint8_t *buffer, uint32_t nbytes);
+
         int m_PortFD { -1 };
+        /// Bytes read from the port but not yet returned by read() or readSection()
+        uint8_t m_ReadBuffer[1024];
+        uint32_t m_ReadStart { 0 };
+        uint32_t m_ReadCount { 0 };
         bool m_Debug { false };
         INDI::Logger::VerbosityLevel m_DebugChannel { INDI::Logger::DBG_IGNORE };
         const char *m_DriverName;
@@ -29,6 +29,13 @@
 #include <cstring>
 #include <assert.h>
 #include <algorithm>
+#include <cerrno>
+#include <fcntl.h>
+#include <libgen.h>
+#include <unistd.h>
+
+// Delay without configuration changes before writing the configuration file
+#define CONFIG_FLUSH_DELAY_MS 1000
 
 const char *COMMUNICATION_TAB = "Communication";
 const char *MAIN_CONTROL_TAB  = "Main Control";
@@ -117,17 +124,193 @@ void timerfunc(void *t)
 namespace INDI
 {
 
+// Write pending configuration changes of the device before its configuration file is read.
+static void flushDeviceConfig(const char *dev)
+{
+    const std::unique_lock<std::recursive_mutex> lock(DefaultDevicePrivate::devicesLock);
+    for(auto &it : DefaultDevicePrivate::devices)
+        if (strcmp(dev, it->defaultDevice->getDeviceName()) == 0)
+            it->flushConfig();
+}
+
+// Write pending configuration changes of all devices when the driver exits.
+static void flushAllConfigs()
+{
+    const std::unique_lock<std::recursive_mutex> lock(DefaultDevicePrivate::devicesLock);
+    for(auto &it : DefaultDevicePrivate::devices)
+        it->flushConfig();
+}
+
 DefaultDevicePrivate::DefaultDevicePrivate(DefaultDevice *defaultDevice)
     : defaultDevice(defaultDevice)
 {
     const std::unique_lock<std::recursive_mutex> lock(DefaultDevicePrivate::devicesLock);
+    static bool isConfigHookRegistered = false;
+    if (!isConfigHookRegistered)
+    {
+        IUSetConfigReadHook(flushDeviceConfig);
+        std::atexit(flushAllConfigs);
+        isConfigHookRegistered = true;
+    }
     devices.push_back(this);
 }
 
 DefaultDevicePrivate::~DefaultDevicePrivate()
 {
-    const std::unique_lock<std::recursive_mutex> lock(DefaultDevicePrivate::devicesLock);
-    devices.remove(this);
+    {
+        const std::unique_lock<std::recursive_mutex> lock(DefaultDevicePrivate::devicesLock);
+        devices.remove(this);
+    }
+
+    // The configuration thread writes any pending change before leaving.
+    {
+        std::lock_guard<std::mutex> locker(configLock);
+        configQuit = true;
+        configCondition.notify_all();
+    }
+
+    if (configThread.joinable())
+        configThread.join();
+
+    flushConfig();
+    delXMLEle(configRoot);
+}
+
+void DefaultDevicePrivate::scheduleConfigFlush(const char *property)
+{
+    // Must be called with configLock held
+    configDirty.insert(property);
+    configDeadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(CONFIG_FLUSH_DELAY_MS);
+
+    if (!configThread.joinable())
+        configThread = std::thread(&DefaultDevicePrivate::configThreadRun, this);
+
+    configCondition.notify_all();
+}
+
+void DefaultDevicePrivate::configThreadRun()
+{
+    std::unique_lock<std::mutex> locker(configLock);
+    for (;;)
+    {
+        configCondition.wait(locker, [this] { return configQuit || !configDirty.empty(); });
+
+        // Debounce: only write once no change occurred during the flush delay.
+        while (!configQuit && !configDirty.empty() && std::chrono::steady_clock::now() < configDeadline)
+            configCondition.wait_until(locker, configDeadline);
+
+        if (!configDirty.empty())
+        {
+            locker.unlock();
+            if (flushConfig() == false)
+            {
+                ConfigProcessSP.setState(IPS_ALERT);
+                ConfigProcessSP.apply();
+            }
+            locker.lock();
+        }
+
+        if (configQuit)
+            break;
+    }
+}
+
+bool DefaultDevicePrivate::flushConfig()
+{
+    std::string content, fileName;
+    uint64_t version;
+
+    {
+        std::lock_guard<std::mutex> locker(configLock);
+        if (configDirty.empty() || configRoot == nullptr)
+            return true;
+
+        content.resize(sprlXMLEle(configRoot, 0));
+        sprXMLEle(&content[0], configRoot, 0);
+        fileName = configFileName;
+        version  = ++configVersion;
+        configDirty.clear();
+    }
+
+    std::lock_guard<std::mutex> locker(configWriteLock);
+
+    // A more recent configuration was already written.
+    if (version <= configWrittenVersion)
+        return true;
+
+    configWrittenVersion = version;
+    if (writeConfigFile(fileName, content))
+        return true;
+
+    // Reported by the next single property save, which writes the whole file again
+    configWriteFailed = true;
+    return false;
+}
+
+void DefaultDevicePrivate::resetConfig()
+{
+    std::lock_guard<std::mutex> locker(configLock);
+    delXMLEle(configRoot);
+    configRoot = nullptr;
+    configDirty.clear();
+    // Any configuration taken before is obsolete
+    configWrittenVersion = ++configVersion;
+}
+
+bool DefaultDevicePrivate::writeConfigFile(const std::string &fileName, const std::string &content)
+{
+    std::string tmpFileName = fileName + ".tmp";
+
+    int fd = open(tmpFileName.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0666);
+    if (fd < 0)
+    {
+        DEBUGFDEVICE(deviceName.c_str(), Logger::DBG_WARNING, "Failed to save configuration. Unable to open %s: %s",
+                     tmpFileName.c_str(), strerror(errno));
+        return false;
+    }
+
+    const char *data = content.data();
+    size_t remaining = content.size();
+    while (remaining > 0)
+    {
+        ssize_t written = write(fd, data, remaining);
+        if (written < 0)
+        {
+            if (errno == EINTR)
+                continue;
+
+            DEBUGFDEVICE(deviceName.c_str(), Logger::DBG_WARNING, "Failed to save configuration. Unable to write %s: %s",
+                         tmpFileName.c_str(), strerror(errno));
+            close(fd);
+            unlink(tmpFileName.c_str());
+            return false;
+        }
+        data      += written;
+        remaining -= written;
+    }
+
+    // Data must be on disk before the rename so that a crash never leaves a truncated file.
+    fsync(fd);
+    close(fd);
+
+    if (rename(tmpFileName.c_str(), fileName.c_str()) != 0)
+    {
+        DEBUGFDEVICE(deviceName.c_str(), Logger::DBG_WARNING, "Failed to save configuration. Unable to rename %s: %s",
+                     tmpFileName.c_str(), strerror(errno));
+        unlink(tmpFileName.c_str());
+        return false;
+    }
+
+    // Persist the rename itself.
+    std::string dirName = fileName;
+    int dirfd = open(dirname(&dirName[0]), O_RDONLY);
+    if (dirfd >= 0)
+    {
+        fsync(dirfd);
+        close(dirfd);
+    }
+
+    return true;
 }
 
 DefaultDevice::DefaultDevice()
@@ -206,7 +389,11 @@ bool DefaultDevice::saveAllConfigItems(FILE *fp)
 
 bool DefaultDevice::purgeConfig()
 {
+    D_PTR(DefaultDevice);
     char errmsg[MAXRBUF];
+
+    std::lock_guard<std::mutex> locker(d->configWriteLock);
+    d->resetConfig();
     if (IUPurgeConfig(nullptr, getDeviceName(), errmsg) == -1)
     {
         LOGF_WARN("%s", errmsg);
@@ -227,6 +414,11 @@ bool DefaultDevice::saveConfig(bool silent, const char *property)
 
     if (property == nullptr)
     {
+        // The whole file is rewritten, pending single property changes are superseded.
+        std::lock_guard<std::mutex> locker(d->configWriteLock);
+        d->resetConfig();
+        d->configWriteFailed = false;
+
         fp = IUGetConfigFP(nullptr, getDeviceName(), "w", errmsg);
 
         if (fp == nullptr)
@@ -254,26 +446,55 @@ bool DefaultDevice::saveConfig(bool silent, const char *property)
     }
     else
     {
-        fp = IUGetConfigFP(nullptr, getDeviceName(), "r", errmsg);
-
-        if (fp == nullptr)
+        // Earlier changes could not be written, write the whole file so that the caller sees any error
+        if (d->configWriteFailed.exchange(false))
         {
-            //if (!silent)
-            //   LOGF_ERROR("Error saving configuration. %s", errmsg);
-            //return false;
-            // If we don't have an existing file pointer, save all properties.
+            LOG_WARN("Saving the whole configuration since earlier changes could not be written.");
             return saveConfig(silent);
         }
 
-        LilXML *lp   = newLilXML();
-        XMLEle *root = readXMLFile(fp, lp, errmsg);
+        std::unique_lock<std::mutex> locker(d->configLock);
 
-        fclose(fp);
-        delLilXML(lp);
+        // Load the configuration file in memory once, it is then kept up to date and written behind.
+        if (d->configRoot == nullptr)
+        {
+            // Reading the file may flush pending changes, which requires configLock.
+            locker.unlock();
 
-        if (root == nullptr)
-            return false;
+            fp = IUGetConfigFP(nullptr, getDeviceName(), "r", errmsg);
+
+            if (fp == nullptr)
+            {
+                //if (!silent)
+                //   LOGF_ERROR("Error saving configuration. %s", errmsg);
+                //return false;
+                // If we don't have an existing file pointer, save all properties.
+                return saveConfig(silent);
+            }
+
+            LilXML *lp   = newLilXML();
+            XMLEle *root = readXMLFile(fp, lp, errmsg);
+
+            fclose(fp);
+            delLilXML(lp);
+
+            if (root == nullptr)
+                return false;
+
+            locker.lock();
+            if (d->configRoot == nullptr)
+            {
+                // The file was just opened, so its name can be generated
+                char configFileName[MAXRBUF];
+                IUGetConfigFileName(nullptr, getDeviceName(), configFileName);
+                d->configRoot = root;
+                d->configFileName = configFileName;
+            }
+            else
+                delXMLEle(root);
+        }
 
+        XMLEle *root       = d->configRoot;
         XMLEle *ep         = nullptr;
         bool propertySaved = false;
 
@@ -289,20 +510,15 @@ bool DefaultDevice::saveConfig(bool silent, const char *property)
             {
                 auto svp = getSwitch(elemName);
                 if (svp == nullptr)
-                {
-                    delXMLEle(root);
                     return false;
-                }
 
                 XMLEle *sw = nullptr;
                 for (sw = nextXMLEle(ep, 1); sw != nullptr; sw = nextXMLEle(ep, 0))
                 {
                     auto oneSwitch = svp->findWidgetByName(findXMLAttValu(sw, "name"));
                     if (oneSwitch == nullptr)
-                    {
-                        delXMLEle(root);
                         return false;
-                    }
+
                     char formatString[MAXRBUF];
                     snprintf(formatString, MAXRBUF, "      %s\n", oneSwitch->getStateAsString());
                     editXMLEle(sw, formatString);
@@ -315,10 +531,7 @@ bool DefaultDevice::saveConfig(bool silent, const char *property)
             {
                 auto nvp = getNumber(elemName);
                 if (nvp == nullptr)
-                {
-                    delXMLEle(root);
                     return false;
-                }
 
                 XMLEle *np = nullptr;
                 for (np = nextXMLEle(ep, 1); np != nullptr; np = nextXMLEle(ep, 0))
@@ -339,10 +552,7 @@ bool DefaultDevice::saveConfig(bool silent, const char *property)
             {
                 auto tvp = getText(elemName);
                 if (tvp == nullptr)
-                {
-                    delXMLEle(root);
                     return false;
-                }
 
                 XMLEle *tp = nullptr;
                 for (tp = nextXMLEle(ep, 1); tp != nullptr; tp = nextXMLEle(ep, 0))
@@ -363,17 +573,14 @@ bool DefaultDevice::saveConfig(bool silent, const char *property)
 
         if (propertySaved)
         {
-            fp = IUGetConfigFP(nullptr, getDeviceName(), "w", errmsg);
-            prXMLEle(fp, root, 0);
-            fflush(fp);
-            fclose(fp);
-            delXMLEle(root);
+            // The file is written on the configuration thread.
+            d->scheduleConfigFlush(property);
             LOGF_DEBUG("Configuration successfully saved for %s.", property);
             return true;
         }
         else
         {
-            delXMLEle(root);
+            locker.unlock();
             // If property does not exist, save the whole thing
             return saveConfig(silent);
         }
@@ -388,10 +595,12 @@ bool DefaultDevice::loadDefaultConfig()
     char errmsg[MAXRBUF];
     bool pResult = false;
 
-    if (getenv("INDICONFIG"))
-        snprintf(configDefaultFileName, MAXRBUF, "%s.default", getenv("INDICONFIG"));
-    else
-        snprintf(configDefaultFileName, MAXRBUF, "%s/.indi/%s_config.xml.default", getenv("HOME"), getDeviceName());
+    if (IUGetConfigFileName(nullptr, getDeviceName(), configDefaultFileName) < 0)
+    {
+        LOG_INFO("Error loading default configuration. Neither INDICONFIG nor HOME is set.");
+        return false;
+    }
+    strncat(configDefaultFileName, ".default", MAXRBUF - strlen(configDefaultFileName) - 1);
 
     LOGF_DEBUG("Requesting to load default config with: %s", configDefaultFileName);
 
@@ -452,6 +661,8 @@ bool DefaultDevice::ISNewSwitch(const char *dev, const char *name, ISState *stat
                 if (isConnected() == true)
                 {
                     rc = Disconnect();
+                    // Make sure configuration changes made while connected are on disk.
+                    d->flushConfig();
                     // Disconnection is successful, set it IDLE and updateProperties.
                     if (rc)
                     {
@@ -21,9 +21,15 @@
 #include "basedevice_p.h"
 #include "defaultdevice.h"
 
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
 #include <cstring>
 #include <list>
 #include <mutex>
+#include <set>
+#include <string>
+#include <thread>
 
 #include "indipropertyswitch.h"
 #include "indipropertynumber.h"
@@ -73,6 +79,41 @@ class DefaultDevicePrivate: public BaseDevicePrivate
         // TimerHit timer
         INDI::Timer m_MainLoopTimer;
 
+    public:
+        // Write-behind configuration store. Single property saves patch the in-memory
+        // configuration and the file is written on the configuration thread once no
+        // change occurred for a while.
+
+        /** @brief Mark property as changed in the in-memory configuration and schedule a write */
+        void scheduleConfigFlush(const char *property);
+
+        /** @brief Write pending configuration changes to disk now.
+         *  @return False if writing the file failed, true otherwise. */
+        bool flushConfig();
+
+        /** @brief Drop the in-memory configuration and any pending change. Must be called with configWriteLock held */
+        void resetConfig();
+
+        /** @brief Atomically replace fileName with content */
+        bool writeConfigFile(const std::string &fileName, const std::string &content);
+
+        void configThreadRun();
+
+        std::mutex configLock;          // protects the in-memory configuration
+        std::mutex configWriteLock;     // serializes writes of the configuration file
+        std::condition_variable configCondition;
+        std::thread configThread;
+        bool configQuit {false};
+
+        XMLEle *configRoot {nullptr};
+        std::string configFileName;
+        std::set<std::string> configDirty;
+        std::chrono::steady_clock::time_point configDeadline;
+        uint64_t configVersion {0};
+        uint64_t configWrittenVersion {0};
+        /// A background write failed, set by flushConfig() and cleared by the next single property save
+        std::atomic<bool> configWriteFailed {false};
+
     public:
         static std::list<DefaultDevicePrivate*> devices;
         static std::recursive_mutex             devicesLock;
@@ -0,0 +1,259 @@
+/*
+    Copyright (C) 2026 by the INDI Library contributors
+
+    Software Binning
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+*/
+
+#include "indibinning.h"
+#include "indiworkerpool.h"
+
+#include <algorithm>
+#include <limits>
+#include <vector>
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace INDI
+{
+
+namespace
+{
+
+// Smaller frames are not worth splitting across the worker pool
+constexpr size_t MIN_PIXELS_PER_THREAD = 1 << 20;
+
+struct BinningPass
+{
+    uint32_t width;
+    uint32_t height;
+    uint32_t binX;
+    uint32_t binY;
+    // Distance between binned pixels, 2 for Bayer frames
+    uint32_t step;
+    bool average;
+    // Sums are divided by it when not averaging
+    uint32_t divisor;
+};
+
+// Row pass: add a row of pixels to the accumulator row
+void accumulateRow(uint32_t *acc, const uint8_t *row, uint32_t count)
+{
+    uint32_t i = 0;
+#if defined(__AVX2__)
+    for (; i + 8 <= count; i += 8)
+    {
+        __m256i pixels = _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(row + i)));
+        __m256i sum    = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(acc + i));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(acc + i), _mm256_add_epi32(sum, pixels));
+    }
+#elif defined(__SSE2__)
+    const __m128i zero = _mm_setzero_si128();
+    for (; i + 8 <= count; i += 8)
+    {
+        __m128i pixels = _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(row + i)), zero);
+        __m128i *sum   = reinterpret_cast<__m128i *>(acc + i);
+        _mm_storeu_si128(sum, _mm_add_epi32(_mm_loadu_si128(sum), _mm_unpacklo_epi16(pixels, zero)));
+        _mm_storeu_si128(sum + 1, _mm_add_epi32(_mm_loadu_si128(sum + 1), _mm_unpackhi_epi16(pixels, zero)));
+    }
+#elif defined(__ARM_NEON)
+    for (; i + 8 <= count; i += 8)
+    {
+        uint16x8_t pixels = vmovl_u8(vld1_u8(row + i));
+        vst1q_u32(acc + i, vaddw_u16(vld1q_u32(acc + i), vget_low_u16(pixels)));
+        vst1q_u32(acc + i + 4, vaddw_u16(vld1q_u32(acc + i + 4), vget_high_u16(pixels)));
+    }
+#endif
+    for (; i < count; i++)
+        acc[i] += row[i];
+}
+
+void accumulateRow(uint32_t *acc, const uint16_t *row, uint32_t count)
+{
+    uint32_t i = 0;
+#if defined(__AVX2__)
+    for (; i + 8 <= count; i += 8)
+    {
+        __m256i pixels = _mm256_cvtepu16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i *>(row + i)));
+        __m256i sum    = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(acc + i));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(acc + i), _mm256_add_epi32(sum, pixels));
+    }
+#elif defined(__SSE2__)
+    const __m128i zero = _mm_setzero_si128();
+    for (; i + 8 <= count; i += 8)
+    {
+        __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i *>(row + i));
+        __m128i *sum   = reinterpret_cast<__m128i *>(acc + i);
+        _mm_storeu_si128(sum, _mm_add_epi32(_mm_loadu_si128(sum), _mm_unpacklo_epi16(pixels, zero)));
+        _mm_storeu_si128(sum + 1, _mm_add_epi32(_mm_loadu_si128(sum + 1), _mm_unpackhi_epi16(pixels, zero)));
+    }
+#elif defined(__ARM_NEON)
+    for (; i + 8 <= count; i += 8)
+    {
+        uint16x8_t pixels = vld1q_u16(row + i);
+        vst1q_u32(acc + i, vaddw_u16(vld1q_u32(acc + i), vget_low_u16(pixels)));
+        vst1q_u32(acc + i + 4, vaddw_u16(vld1q_u32(acc + i + 4), vget_high_u16(pixels)));
+    }
+#endif
+    for (; i < count; i++)
+        acc[i] += row[i];
+}
+
+void accumulateRow(uint64_t *acc, const uint32_t *row, uint32_t count)
+{
+    for (uint32_t i = 0; i < count; i++)
+        acc[i] += row[i];
+}
+
+template <typename T, typename Acc>
+inline T binnedValue(Acc sum, double scale, const BinningPass &pass)
+{
+    if (pass.average)
+        return static_cast<T>(sum * scale + 0.5);
+
+    return static_cast<T>(std::min<Acc>(sum / pass.divisor, std::numeric_limits<T>::max()));
+}
+
+// Column pass: combine groups of binX accumulated columns into output pixels
+template <typename T, typename Acc>
+void reduceColumns(const Acc *acc, T *output, const BinningPass &pass, uint32_t rows)
+{
+    const uint32_t outputWidth = pass.width / pass.binX;
+
+    if (pass.step == 1)
+    {
+        const double scale = 1.0 / (pass.binX * rows);
+
+        if (pass.binX == 2)
+        {
+            for (uint32_t i = 0; i < outputWidth; i++)
+                output[i] = binnedValue<T>(acc[2 * i] + acc[2 * i + 1], scale, pass);
+            return;
+        }
+
+        for (uint32_t i = 0; i < outputWidth; i++)
+        {
+            const Acc *columns = acc + i * pass.binX;
+            Acc sum = 0;
+            for (uint32_t j = 0; j < pass.binX; j++)
+                sum += columns[j];
+            output[i] = binnedValue<T>(sum, scale, pass);
+        }
+        return;
+    }
+
+    // Bayer frames: the last block of a row may be incomplete
+    const uint32_t span = pass.step * pass.binX;
+    for (uint32_t i = 0; i < outputWidth; i++)
+    {
+        Acc sum = 0;
+        uint32_t count = 0;
+        for (uint32_t x = (i / pass.step) * span + i % pass.step; count < pass.binX && x < pass.width; x += pass.step)
+        {
+            sum += acc[x];
+            count++;
+        }
+        output[i] = binnedValue<T>(sum, count ? 1.0 / (count * rows) : 0, pass);
+    }
+}
+
+template <typename T, typename Acc>
+void binRows(const T *input, T *output, const BinningPass &pass, uint32_t firstRow, uint32_t lastRow)
+{
+    const uint32_t outputWidth = pass.width / pass.binX;
+    const uint32_t span = pass.step * pass.binY;
+    std::vector<Acc> acc(pass.width);
+
+    for (uint32_t i = firstRow; i < lastRow; i++)
+    {
+        std::fill(acc.begin(), acc.end(), 0);
+
+        uint32_t rows = 0;
+        for (uint32_t y = (i / pass.step) * span + i % pass.step; rows < pass.binY && y < pass.height; y += pass.step)
+        {
+            accumulateRow(acc.data(), input + static_cast<size_t>(y) * pass.width, pass.width);
+            rows++;
+        }
+
+        T *row = output + static_cast<size_t>(i) * outputWidth;
+        if (rows == 0)
+            std::fill(row, row + outputWidth, 0);
+        else
+            reduceColumns<T, Acc>(acc.data(), row, pass, rows);
+    }
+}
+
+template <typename T, typename Acc>
+void binFrame(const uint8_t *input, uint8_t *output, const BinningPass &pass, unsigned int threads)
+{
+    const uint32_t outputHeight = pass.height / pass.binY;
+    const T *in = reinterpret_cast<const T *>(input);
+    T *out = reinterpret_cast<T *>(output);
+
+    threads = std::max(1u, std::min(threads, outputHeight));
+    const uint32_t chunkSize = (outputHeight + threads - 1) / threads;
+
+    WorkerPool::instance().run(threads, [&](unsigned int i)
+    {
+        uint32_t first = std::min(outputHeight, i * chunkSize);
+        uint32_t last  = std::min(outputHeight, first + chunkSize);
+        binRows<T, Acc>(in, out, pass, first, last);
+    });
+}
+
+}
+
+bool binPixels(const uint8_t *input, uint8_t *output, uint32_t width, uint32_t height, uint32_t binX, uint32_t binY,
+               int bpp, bool average, bool bayer, unsigned int threads, uint32_t divisor)
+{
+    if (input == nullptr || output == nullptr || binX == 0 || binY == 0 || binX > width || binY > height || divisor == 0)
+        return false;
+
+    // 16 bit sums must fit in 32 bit accumulators
+    if (static_cast<uint64_t>(binX) * binY > 65536)
+        return false;
+
+    if (threads == 0)
+    {
+        size_t pixels = static_cast<size_t>(width) * height;
+        threads = WorkerPool::instance().concurrency();
+        threads = static_cast<unsigned int>(std::min<size_t>(threads, std::max<size_t>(1, pixels / MIN_PIXELS_PER_THREAD)));
+    }
+
+    BinningPass pass {width, height, binX, binY, bayer ? 2u : 1u, average, divisor};
+
+    switch (bpp)
+    {
+        case 8:
+            binFrame<uint8_t, uint32_t>(input, output, pass, threads);
+            return true;
+        case 16:
+            binFrame<uint16_t, uint32_t>(input, output, pass, threads);
+            return true;
+        case 32:
+            binFrame<uint32_t, uint64_t>(input, output, pass, threads);
+            return true;
+    }
+
+    return false;
+}
+
+}
@@ -0,0 +1,60 @@
+/*
+    Copyright (C) 2026 by the INDI Library contributors
+
+    Software Binning
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace INDI
+{
+
+/**
+ * @brief binPixels Bin a frame by binX x binY pixels.
+ *
+ * Each output row is built in two separable passes: the binY input rows are first added column-wise
+ * into a wide accumulator row, using SSE2/AVX2 or NEON when available, then groups of binX accumulated
+ * columns are added and either averaged or saturated to the pixel range. Output rows are split across
+ * parallel threads.
+ *
+ * The output frame is (width / binX) x (height / binY) pixels. Remaining input columns and rows are dropped.
+ * For Bayer frames, each output pixel keeps the color of its position in the 2x2 matrix, and is computed from
+ * the binX x binY pixels of the same color in the corresponding 2*binX x 2*binY input block.
+ *
+ * @param input frame pixels, in native byte order.
+ * @param output binned pixels. It must hold the output frame and must not overlap input.
+ * @param width input width in pixels.
+ * @param height input height in pixels.
+ * @param binX horizontal binning.
+ * @param binY vertical binning.
+ * @param bpp bits per pixel, 8, 16 or 32.
+ * @param average If true, output pixels are the rounded average of the binned pixels. If false, they are
+ * their sum divided by divisor, rounded down and saturated to the maximum pixel value.
+ * @param bayer If true, bin each color of a 2x2 Bayer matrix separately.
+ * @param threads number of tasks run on the shared WorkerPool, 0 to pick one based on frame size and available cores.
+ * @param divisor divisor of the sums when average is false.
+ * @return True on success, false if bpp is not supported, divisor is 0, or binning is larger than the frame or than
+ * 65536 pixels.
+ */
+bool binPixels(const uint8_t *input, uint8_t *output, uint32_t width, uint32_t height, uint32_t binX, uint32_t binY,
+               int bpp, bool average, bool bayer = false, unsigned int threads = 0, uint32_t divisor = 1);
+
+}
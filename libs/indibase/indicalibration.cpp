@@ -0,0 +1,492 @@
+/*
+    Copyright (C) 2026 by the INDI Library contributors
+
+    Frame Calibration
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+*/
+
+#include "indicalibration.h"
+#include "indiworkerpool.h"
+
+#include <fitsio.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace INDI
+{
+
+namespace
+{
+
+// Smaller frames are not worth splitting across the worker pool
+constexpr size_t MIN_PIXELS_PER_THREAD = 1 << 20;
+
+std::string fitsError(int status)
+{
+    char message[FLEN_STATUS] = {0};
+    fits_get_errstatus(status, message);
+    return message;
+}
+
+#if defined(__AVX2__)
+// Calibrate 8 pixels held in 16 bits lanes
+inline __m128i calibrate8(__m128i raw, const float *offset, const float *gain, __m256 maxValue)
+{
+    __m256 v = _mm256_cvtepi32_ps(_mm256_cvtepu16_epi32(raw));
+    if (offset)
+        v = _mm256_sub_ps(v, _mm256_loadu_ps(offset));
+    if (gain)
+        v = _mm256_mul_ps(v, _mm256_loadu_ps(gain));
+    v = _mm256_add_ps(v, _mm256_set1_ps(0.5f));
+    v = _mm256_min_ps(_mm256_max_ps(v, _mm256_setzero_ps()), maxValue);
+
+    __m256i result = _mm256_cvttps_epi32(v);
+    return _mm_packus_epi32(_mm256_castsi256_si128(result), _mm256_extracti128_si256(result, 1));
+}
+#elif defined(__SSE2__)
+inline __m128 calibrate4(__m128 v, const float *offset, const float *gain, __m128 maxValue)
+{
+    if (offset)
+        v = _mm_sub_ps(v, _mm_loadu_ps(offset));
+    if (gain)
+        v = _mm_mul_ps(v, _mm_loadu_ps(gain));
+    v = _mm_add_ps(v, _mm_set1_ps(0.5f));
+    return _mm_min_ps(_mm_max_ps(v, _mm_setzero_ps()), maxValue);
+}
+
+inline __m128i calibrate8(__m128i raw, const float *offset, const float *gain, __m128 maxValue)
+{
+    const __m128i zero = _mm_setzero_si128();
+    __m128i low  = _mm_cvttps_epi32(calibrate4(_mm_cvtepi32_ps(_mm_unpacklo_epi16(raw, zero)), offset, gain, maxValue));
+    __m128i high = _mm_cvttps_epi32(calibrate4(_mm_cvtepi32_ps(_mm_unpackhi_epi16(raw, zero)), offset ? offset + 4 : nullptr,
+                                    gain ? gain + 4 : nullptr, maxValue));
+
+    // SSE2 can only pack with signed saturation, values are in range already
+    const __m128i bias32 = _mm_set1_epi32(32768);
+    __m128i packed = _mm_packs_epi32(_mm_sub_epi32(low, bias32), _mm_sub_epi32(high, bias32));
+    return _mm_xor_si128(packed, _mm_set1_epi16(static_cast<short>(0x8000)));
+}
+#elif defined(__ARM_NEON)
+inline uint32x4_t calibrate4(uint32x4_t raw, const float *offset, const float *gain, float32x4_t maxValue)
+{
+    float32x4_t v = vcvtq_f32_u32(raw);
+    if (offset)
+        v = vsubq_f32(v, vld1q_f32(offset));
+    if (gain)
+        v = vmulq_f32(v, vld1q_f32(gain));
+    v = vaddq_f32(v, vdupq_n_f32(0.5f));
+    v = vminq_f32(vmaxq_f32(v, vdupq_n_f32(0)), maxValue);
+    return vcvtq_u32_f32(v);
+}
+
+inline uint16x8_t calibrate8(uint16x8_t raw, const float *offset, const float *gain, float32x4_t maxValue)
+{
+    uint32x4_t low  = calibrate4(vmovl_u16(vget_low_u16(raw)), offset, gain, maxValue);
+    uint32x4_t high = calibrate4(vmovl_u16(vget_high_u16(raw)), offset ? offset + 4 : nullptr, gain ? gain + 4 : nullptr,
+                                 maxValue);
+    return vcombine_u16(vmovn_u32(low), vmovn_u32(high));
+}
+#endif
+
+template <typename T>
+inline T calibratePixel(T raw, const float *offset, const float *gain, uint32_t i)
+{
+    float v = raw;
+    if (offset)
+        v -= offset[i];
+    if (gain)
+        v *= gain[i];
+    v = std::min(std::max(v + 0.5f, 0.0f), static_cast<float>(std::numeric_limits<T>::max()));
+    return static_cast<T>(v);
+}
+
+// 32 bits pixels do not fit in a float
+template <>
+inline uint32_t calibratePixel(uint32_t raw, const float *offset, const float *gain, uint32_t i)
+{
+    double v = raw;
+    if (offset)
+        v -= offset[i];
+    if (gain)
+        v *= gain[i];
+    v = std::min(std::max(v + 0.5, 0.0), static_cast<double>(std::numeric_limits<uint32_t>::max()));
+    return static_cast<uint32_t>(v);
+}
+
+void calibrateRow(uint8_t *row, const float *offset, const float *gain, uint32_t count)
+{
+    uint32_t i = 0;
+#if defined(__AVX2__) || defined(__SSE2__)
+#if defined(__AVX2__)
+    const __m256 maxValue = _mm256_set1_ps(255.0f);
+#else
+    const __m128 maxValue = _mm_set1_ps(255.0f);
+#endif
+    const __m128i zero = _mm_setzero_si128();
+    for (; i + 8 <= count; i += 8)
+    {
+        __m128i raw = _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(row + i)), zero);
+        __m128i result = calibrate8(raw, offset ? offset + i : nullptr, gain ? gain + i : nullptr, maxValue);
+        _mm_storel_epi64(reinterpret_cast<__m128i *>(row + i), _mm_packus_epi16(result, result));
+    }
+#elif defined(__ARM_NEON)
+    const float32x4_t maxValue = vdupq_n_f32(255.0f);
+    for (; i + 8 <= count; i += 8)
+    {
+        uint16x8_t result = calibrate8(vmovl_u8(vld1_u8(row + i)), offset ? offset + i : nullptr, gain ? gain + i : nullptr,
+                                       maxValue);
+        vst1_u8(row + i, vmovn_u16(result));
+    }
+#endif
+    for (; i < count; i++)
+        row[i] = calibratePixel(row[i], offset, gain, i);
+}
+
+void calibrateRow(uint16_t *row, const float *offset, const float *gain, uint32_t count)
+{
+    uint32_t i = 0;
+#if defined(__AVX2__) || defined(__SSE2__)
+#if defined(__AVX2__)
+    const __m256 maxValue = _mm256_set1_ps(65535.0f);
+#else
+    const __m128 maxValue = _mm_set1_ps(65535.0f);
+#endif
+    for (; i + 8 <= count; i += 8)
+    {
+        __m128i *pixels = reinterpret_cast<__m128i *>(row + i);
+        _mm_storeu_si128(pixels, calibrate8(_mm_loadu_si128(pixels), offset ? offset + i : nullptr, gain ? gain + i : nullptr,
+                                            maxValue));
+    }
+#elif defined(__ARM_NEON)
+    const float32x4_t maxValue = vdupq_n_f32(65535.0f);
+    for (; i + 8 <= count; i += 8)
+        vst1q_u16(row + i, calibrate8(vld1q_u16(row + i), offset ? offset + i : nullptr, gain ? gain + i : nullptr, maxValue));
+#endif
+    for (; i < count; i++)
+        row[i] = calibratePixel(row[i], offset, gain, i);
+}
+
+void calibrateRow(uint32_t *row, const float *offset, const float *gain, uint32_t count)
+{
+    for (uint32_t i = 0; i < count; i++)
+        row[i] = calibratePixel(row[i], offset, gain, i);
+}
+
+template <typename T>
+void calibrateRows(T *pixels, uint32_t width, uint32_t firstRow, uint32_t lastRow, const float *offset,
+                   const float *gain, size_t masterWidth, size_t x, size_t y)
+{
+    for (uint32_t row = firstRow; row < lastRow; row++)
+    {
+        size_t masterIndex = (y + row) * masterWidth + x;
+        calibrateRow(pixels + static_cast<size_t>(row) * width, offset ? offset + masterIndex : nullptr,
+                     gain ? gain + masterIndex : nullptr, width);
+    }
+}
+
+template <typename T>
+void calibrateFrame(T *pixels, uint32_t width, uint32_t height, const float *offset, const float *gain,
+                    size_t masterWidth, size_t x, size_t y, unsigned int threads)
+{
+    uint32_t rowsPerThread = (height + threads - 1) / threads;
+    WorkerPool::instance().run(threads, [&](unsigned int i)
+    {
+        uint32_t firstRow = std::min(height, i * rowsPerThread);
+        uint32_t lastRow  = std::min(height, firstRow + rowsPerThread);
+        calibrateRows<T>(pixels, width, firstRow, lastRow, offset, gain, masterWidth, x, y);
+    });
+}
+
+}
+
+bool FrameCalibration::setMaster(MasterType type, const float *pixels, uint32_t width, uint32_t height, uint32_t binX,
+                                 uint32_t binY, double exposure, const std::string &name, std::string &error)
+{
+    if (type >= MASTER_COUNT || pixels == nullptr || width == 0 || height == 0 || binX == 0 || binY == 0)
+    {
+        error = "Invalid master frame";
+        return false;
+    }
+
+    for (int i = 0; i < MASTER_COUNT; i++)
+    {
+        if (i != type && hasMaster(static_cast<MasterType>(i)) && (width != m_Width || height != m_Height))
+        {
+            error = "Master frame is " + std::to_string(width) + "x" + std::to_string(height) + " but other masters are " +
+                    std::to_string(m_Width) + "x" + std::to_string(m_Height);
+            return false;
+        }
+        if (i != type && hasMaster(static_cast<MasterType>(i)) && (binX != m_BinX || binY != m_BinY))
+        {
+            error = "Master frame is binned " + std::to_string(binX) + "x" + std::to_string(binY) + " but other masters are " +
+                    std::to_string(m_BinX) + "x" + std::to_string(m_BinY);
+            return false;
+        }
+    }
+
+    size_t count = static_cast<size_t>(width) * height;
+    if (type == MASTER_FLAT)
+    {
+        double sum = 0;
+        for (size_t i = 0; i < count; i++)
+            sum += pixels[i];
+        if (sum <= 0)
+        {
+            error = "Master flat has no signal";
+            return false;
+        }
+    }
+
+    Master &master = m_Masters[type];
+    master.pixels.assign(pixels, pixels + count);
+    master.width    = width;
+    master.height   = height;
+    master.binX     = binX;
+    master.binY     = binY;
+    master.exposure = exposure;
+    master.name     = name;
+
+    m_Width  = width;
+    m_Height = height;
+    m_BinX   = binX;
+    m_BinY   = binY;
+    prepare();
+    return true;
+}
+
+bool FrameCalibration::loadMaster(MasterType type, const void *fits, size_t size, const std::string &name,
+                                  std::string &error)
+{
+    fitsfile *fptr = nullptr;
+    int status = 0;
+    void *memory = const_cast<void *>(fits);
+    size_t memorySize = size;
+
+    fits_open_memfile(&fptr, name.c_str(), READONLY, &memory, &memorySize, 0, nullptr, &status);
+    if (status)
+    {
+        error = fitsError(status);
+        return false;
+    }
+
+    int bitpix = 0, naxis = 0;
+    long naxes[3] = {1, 1, 1};
+    fits_get_img_param(fptr, 3, &bitpix, &naxis, naxes, &status);
+
+    // Tile compressed images are stored in the first extension
+    if (status == 0 && naxis == 0)
+    {
+        int hduType = 0;
+        fits_movabs_hdu(fptr, 2, &hduType, &status);
+        fits_get_img_param(fptr, 3, &bitpix, &naxis, naxes, &status);
+    }
+
+    if (status == 0 && naxis != 2 && !(naxis == 3 && naxes[2] == 1))
+    {
+        fits_close_file(fptr, &status);
+        error = "Master frame must be a single channel image";
+        return false;
+    }
+
+    std::vector<float> pixels(static_cast<size_t>(naxes[0]) * naxes[1]);
+    float nullValue = 0;
+    int anyNull = 0;
+    if (status == 0)
+        fits_read_img(fptr, TFLOAT, 1, pixels.size(), &nullValue, pixels.data(), &anyNull, &status);
+
+    double exposure = 0;
+    int keyStatus = 0;
+    if (status == 0 && fits_read_key_dbl(fptr, "EXPTIME", &exposure, nullptr, &keyStatus) != 0)
+        exposure = 0;
+
+    long binX = 1, binY = 1;
+    keyStatus = 0;
+    if (status == 0 && fits_read_key_lng(fptr, "XBINNING", &binX, nullptr, &keyStatus) != 0)
+        binX = 1;
+    keyStatus = 0;
+    if (status == 0 && fits_read_key_lng(fptr, "YBINNING", &binY, nullptr, &keyStatus) != 0)
+        binY = 1;
+
+    if (status)
+    {
+        error = fitsError(status);
+        status = 0;
+        fits_close_file(fptr, &status);
+        return false;
+    }
+
+    fits_close_file(fptr, &status);
+
+    if (binX < 1 || binY < 1)
+    {
+        error = "Master frame has an invalid binning";
+        return false;
+    }
+
+    return setMaster(type, pixels.data(), naxes[0], naxes[1], binX, binY, exposure, name, error);
+}
+
+bool FrameCalibration::loadMaster(MasterType type, const std::string &path, std::string &error)
+{
+    FILE *file = fopen(path.c_str(), "rb");
+    if (file == nullptr)
+    {
+        error = path + ": " + strerror(errno);
+        return false;
+    }
+
+    std::vector<uint8_t> fits;
+    uint8_t buffer[65536];
+    size_t n;
+    while ((n = fread(buffer, 1, sizeof(buffer), file)) > 0)
+        fits.insert(fits.end(), buffer, buffer + n);
+    fclose(file);
+
+    size_t separator = path.find_last_of('/');
+    return loadMaster(type, fits.data(), fits.size(), separator == std::string::npos ? path : path.substr(separator + 1),
+                      error);
+}
+
+void FrameCalibration::clearMaster(MasterType type)
+{
+    if (type >= MASTER_COUNT)
+        return;
+
+    m_Masters[type] = Master();
+    if (isEmpty())
+    {
+        m_Width = m_Height = 0;
+        m_BinX = m_BinY = 1;
+    }
+    prepare();
+}
+
+bool FrameCalibration::isEmpty() const
+{
+    for (const auto &master : m_Masters)
+        if (master.pixels.empty() == false)
+            return false;
+    return true;
+}
+
+double FrameCalibration::darkScale(double exposure) const
+{
+    if (hasMaster(MASTER_DARK) == false)
+        return 0;
+
+    const Master &dark = m_Masters[MASTER_DARK];
+    if (hasMaster(MASTER_BIAS) == false || dark.exposure <= 0 || exposure <= 0)
+        return 1;
+
+    return exposure / dark.exposure;
+}
+
+void FrameCalibration::prepare()
+{
+    m_OffsetScale = -1;
+    m_Offset.clear();
+    m_Gain.clear();
+
+    if (hasMaster(MASTER_FLAT))
+    {
+        const std::vector<float> &flat = m_Masters[MASTER_FLAT].pixels;
+        double sum = 0;
+        for (float value : flat)
+            sum += value;
+        float mean = static_cast<float>(sum / flat.size());
+
+        m_Gain.resize(flat.size());
+        for (size_t i = 0; i < flat.size(); i++)
+            m_Gain[i] = flat[i] > 0 ? mean / flat[i] : 1.0f;
+    }
+}
+
+void FrameCalibration::prepareOffset(double k)
+{
+    m_OffsetScale = k;
+    m_Offset.clear();
+
+    bool bias = hasMaster(MASTER_BIAS), dark = hasMaster(MASTER_DARK);
+    if (bias == false && dark == false)
+        return;
+
+    m_Offset.resize(static_cast<size_t>(m_Width) * m_Height);
+    const float *biasPixels = bias ? m_Masters[MASTER_BIAS].pixels.data() : nullptr;
+    const float *darkPixels = dark ? m_Masters[MASTER_DARK].pixels.data() : nullptr;
+    const float scale = static_cast<float>(k);
+
+    for (size_t i = 0; i < m_Offset.size(); i++)
+    {
+        if (bias && dark)
+            m_Offset[i] = biasPixels[i] + scale * (darkPixels[i] - biasPixels[i]);
+        else
+            m_Offset[i] = bias ? biasPixels[i] : darkPixels[i];
+    }
+}
+
+bool FrameCalibration::apply(uint8_t *pixels, uint32_t width, uint32_t height, int bpp, uint32_t x, uint32_t y,
+                             uint32_t binX, uint32_t binY, double exposure, unsigned int threads)
+{
+    if (isEmpty() || pixels == nullptr || (bpp != 8 && bpp != 16 && bpp != 32))
+        return false;
+
+    // Pixels of masters captured with another binning do not match those of the frame
+    if (binX != m_BinX || binY != m_BinY)
+        return false;
+
+    if (width == 0 || height == 0 || static_cast<uint64_t>(x) + width > m_Width || static_cast<uint64_t>(y) + height > m_Height)
+        return false;
+
+    double k = darkScale(exposure);
+    if (k != m_OffsetScale)
+        prepareOffset(k);
+
+    const float *offset = m_Offset.empty() ? nullptr : m_Offset.data();
+    const float *gain   = m_Gain.empty() ? nullptr : m_Gain.data();
+
+    size_t count = static_cast<size_t>(width) * height;
+    if (threads == 0)
+        threads = WorkerPool::instance().concurrency();
+    threads = static_cast<unsigned int>(std::max<size_t>(1, std::min<size_t>({threads, height, count / MIN_PIXELS_PER_THREAD})));
+
+    switch (bpp)
+    {
+        case 8:
+            calibrateFrame(pixels, width, height, offset, gain, m_Width, x, y, threads);
+            break;
+        case 16:
+            calibrateFrame(reinterpret_cast<uint16_t *>(pixels), width, height, offset, gain, m_Width, x, y, threads);
+            break;
+        case 32:
+            calibrateFrame(reinterpret_cast<uint32_t *>(pixels), width, height, offset, gain, m_Width, x, y, threads);
+            break;
+    }
+
+    return true;
+}
+
+}
@@ -0,0 +1,168 @@
+/*
+    Copyright (C) 2026 by the INDI Library contributors
+
+    Frame Calibration
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace INDI
+{
+
+/**
+ * @brief The FrameCalibration class applies master bias, dark and flat frames to raw frames.
+ *
+ * Each pixel is calibrated as (raw - bias - k * (dark - bias)) * mean(flat) / flat, then rounded and clamped to
+ * the pixel range. Any master may be missing. Darks are scaled by k, the ratio of the frame and dark exposure
+ * times, only when a bias is loaded, since the dark then holds the thermal signal alone. Without a bias, the dark
+ * is subtracted as is. Flats are expected to be calibrated already.
+ *
+ * Calibration uses SSE2/AVX2 or NEON when available, and splits rows across parallel threads.
+ *
+ * All masters must have the same size and binning. Frames must have the binning of the masters, and may be a
+ * subframe of them.
+ *
+ * The class is not thread safe, callers must serialize loading masters and applying them.
+ */
+class FrameCalibration
+{
+    public:
+        typedef enum
+        {
+            MASTER_BIAS,
+            MASTER_DARK,
+            MASTER_FLAT,
+            MASTER_COUNT
+        } MasterType;
+
+        /**
+         * @brief setMaster Set a master frame.
+         * @param type master to set.
+         * @param pixels width * height pixels.
+         * @param width width in pixels.
+         * @param height height in pixels.
+         * @param binX horizontal binning the master was captured with.
+         * @param binY vertical binning the master was captured with.
+         * @param exposure exposure time of the master in seconds, used to scale darks. 0 if unknown.
+         * @param name name recorded in the FITS header of calibrated frames.
+         * @param error error message on failure.
+         * @return True on success, false if the size or binning differs from the other masters.
+         */
+        bool setMaster(MasterType type, const float *pixels, uint32_t width, uint32_t height, uint32_t binX, uint32_t binY,
+                       double exposure, const std::string &name, std::string &error);
+
+        /**
+         * @brief loadMaster Load a master frame from a FITS file in memory.
+         * The exposure time is read from the EXPTIME keyword, and the binning from XBINNING and YBINNING, 1 if missing.
+         * @return True on success, false if the file could not be read or its size or binning differs from the other
+         * masters.
+         */
+        bool loadMaster(MasterType type, const void *fits, size_t size, const std::string &name, std::string &error);
+
+        /**
+         * @brief loadMaster Load a master frame from a FITS file on disk.
+         * @return True on success, false if the file could not be read or its size or binning differs from the other
+         * masters.
+         */
+        bool loadMaster(MasterType type, const std::string &path, std::string &error);
+
+        /**
+         * @brief clearMaster Remove a master frame.
+         */
+        void clearMaster(MasterType type);
+
+        /**
+         * @return True if the master is loaded.
+         */
+        bool hasMaster(MasterType type) const
+        {
+            return m_Masters[type].pixels.empty() == false;
+        }
+
+        /**
+         * @return True if no master is loaded.
+         */
+        bool isEmpty() const;
+
+        /**
+         * @return Name of the master, empty if it is not loaded.
+         */
+        const std::string &masterName(MasterType type) const
+        {
+            return m_Masters[type].name;
+        }
+
+        /**
+         * @return Scale factor of the dark for a frame exposed for exposure seconds.
+         */
+        double darkScale(double exposure) const;
+
+        /**
+         * @brief apply Calibrate a frame in place.
+         * @param pixels frame pixels, in native byte order.
+         * @param width frame width in pixels.
+         * @param height frame height in pixels.
+         * @param bpp bits per pixel, 8, 16 or 32.
+         * @param x horizontal offset of the frame in the masters, in binned pixels.
+         * @param y vertical offset of the frame in the masters, in binned pixels.
+         * @param binX horizontal binning of the frame.
+         * @param binY vertical binning of the frame.
+         * @param exposure exposure time of the frame in seconds.
+         * @param threads number of tasks run on the shared WorkerPool, 0 to pick one based on frame size and available cores.
+         * @return True on success, false if no master is loaded, bpp is not supported, the binning differs from
+         * the masters or the frame does not fit in them.
+         */
+        bool apply(uint8_t *pixels, uint32_t width, uint32_t height, int bpp, uint32_t x, uint32_t y, uint32_t binX,
+                   uint32_t binY, double exposure, unsigned int threads = 0);
+
+    private:
+        struct Master
+        {
+            std::vector<float> pixels;
+            uint32_t width {0};
+            uint32_t height {0};
+            uint32_t binX {1};
+            uint32_t binY {1};
+            double exposure {0};
+            std::string name;
+        };
+
+        /** @brief Rebuild the gain from the flat, and invalidate the offset. */
+        void prepare();
+        /** @brief Rebuild the offset for dark scale k. */
+        void prepareOffset(double k);
+
+        Master m_Masters[MASTER_COUNT];
+        uint32_t m_Width {0};
+        uint32_t m_Height {0};
+        uint32_t m_BinX {1};
+        uint32_t m_BinY {1};
+        /// bias + k * (dark - bias), empty if there is neither bias nor dark
+        std::vector<float> m_Offset;
+        /// Dark scale of m_Offset, negative if it must be rebuilt
+        double m_OffsetScale {-1};
+        /// mean(flat) / flat, empty if there is no flat
+        std::vector<float> m_Gain;
+};
+
+}
@@ -31,8 +31,12 @@
 
 #include "fpack/fpack.h"
 #include "indicom.h"
+#include "indicompression.h"
+#include "indifitscompression.h"
+#include "indifitswriter.h"
 #include "locale_compat.h"
 #include "indiutility.h"
+#include "indistandardproperty.h"
 
 #include <fitsio.h>
 
@@ -45,11 +49,11 @@
 
 #include <cmath>
 #include <regex>
+#include <set>
 
 #include <dirent.h>
 #include <cerrno>
 #include <cstdlib>
-#include <zlib.h>
 #include <sys/stat.h>
 
 const char * IMAGE_SETTINGS_TAB = "Image Settings";
@@ -64,6 +68,13 @@ uint16_t INDIWSServer::m_global_port = 11623;
 namespace INDI
 {
 
+namespace
+{
+// CCDs with a pipeline thread, stopped by CCD::stopAllPipelines() when the driver exits
+std::mutex runningPipelinesLock;
+std::set<CCD *> runningPipelines;
+}
+
 CCD::CCD()
 {
     //ctor
@@ -118,6 +129,13 @@ CCD::CCD()
 
 CCD::~CCD()
 {
+    {
+        std::lock_guard<std::mutex> lock(runningPipelinesLock);
+        runningPipelines.erase(this);
+    }
+    // Only reached with a running pipeline if the driver is destroyed before it exits
+    stopPipeline();
+
     // Only update if index is different.
     if (m_ConfigFastExposureIndex != IUFindOnSwitchIndex(&FastExposureToggleSP))
         saveConfig(true, FastExposureToggleSP.name);
@@ -363,6 +381,104 @@ bool CCD::initProperties()
     EncodeFormatSP.fill(getDeviceName(), "CCD_TRANSFER_FORMAT", "Encode", IMAGE_SETTINGS_TAB, IP_RW, ISR_1OFMANY, 60,
                         IPS_IDLE);
 
+    /**********************************************/
+    /**************** Compression *****************/
+    /**********************************************/
+    CompressionCodecSP[CODEC_RICE].fill("CODEC_RICE", "Rice", ISS_ON);
+    CompressionCodecSP[CODEC_GZIP2].fill("CODEC_GZIP2", "GZIP 2", ISS_OFF);
+    CompressionCodecSP[CODEC_ZLIB].fill("CODEC_ZLIB", "zlib", ISS_OFF);
+    CompressionCodecSP[CODEC_ZSTD].fill("CODEC_ZSTD", "zstd", ISS_OFF);
+    CompressionCodecSP[CODEC_LZ4].fill("CODEC_LZ4", "lz4", ISS_OFF);
+    CompressionCodecSP.fill(getDeviceName(), "CCD_COMPRESSION_CODEC", "Codec", IMAGE_SETTINGS_TAB, IP_RW, ISR_1OFMANY, 60,
+                            IPS_IDLE);
+
+    CompressionLevelNP[0].fill("LEVEL", "Level", "%.f", 1, 9, 1, 1);
+    CompressionLevelNP.fill(getDeviceName(), "CCD_COMPRESSION_LEVEL", "Compression", IMAGE_SETTINGS_TAB, IP_RW, 60, IPS_IDLE);
+
+    /**********************************************/
+    /**************** Calibration *****************/
+    /**********************************************/
+
+    CalibrationSP[INDI_ENABLED].fill("INDI_ENABLED", "Enabled", ISS_OFF);
+    CalibrationSP[INDI_DISABLED].fill("INDI_DISABLED", "Disabled", ISS_ON);
+    CalibrationSP.fill(getDeviceName(), "CCD_CALIBRATION", "Calibration", IMAGE_SETTINGS_TAB, IP_RW, ISR_1OFMANY, 60,
+                       IPS_IDLE);
+
+    CalibrationFilesTP[CALIBRATION_BIAS].fill("BIAS", "Bias", "");
+    CalibrationFilesTP[CALIBRATION_DARK].fill("DARK", "Dark", "");
+    CalibrationFilesTP[CALIBRATION_FLAT].fill("FLAT", "Flat", "");
+    CalibrationFilesTP.fill(getDeviceName(), "CCD_CALIBRATION_FILES", "Masters", IMAGE_SETTINGS_TAB, IP_RW, 60, IPS_IDLE);
+
+    CalibrationMastersBP[CALIBRATION_BIAS].fill("BIAS", "Bias", ".fits");
+    CalibrationMastersBP[CALIBRATION_DARK].fill("DARK", "Dark", ".fits");
+    CalibrationMastersBP[CALIBRATION_FLAT].fill("FLAT", "Flat", ".fits");
+    CalibrationMastersBP.fill(getDeviceName(), "CCD_CALIBRATION_MASTERS", "Masters", IMAGE_SETTINGS_TAB, IP_WO, 60,
+                              IPS_IDLE);
+
+    /**********************************************/
+    /************* Regions of Interest ************/
+    /**********************************************/
+
+    for (uint32_t i = 0; i < MAX_ROIS; i++)
+    {
+        char name[MAXINDINAME], label[MAXINDILABEL];
+        const char *fields[4] = {"X", "Y", "WIDTH", "HEIGHT"};
+        const char *labels[4] = {"Left", "Top", "Width", "Height"};
+        for (int j = 0; j < 4; j++)
+        {
+            snprintf(name, MAXINDINAME, "ROI%u_%s", i + 1, fields[j]);
+            snprintf(label, MAXINDILABEL, "ROI %u %s", i + 1, labels[j]);
+            ROIsNP[i * 4 + j].fill(name, label, "%.f", 0, 100000, 1, 0);
+        }
+    }
+    ROIsNP.fill(getDeviceName(), "CCD_ROIS", "ROIs", IMAGE_SETTINGS_TAB, IP_RW, 60, IPS_IDLE);
+
+    /**********************************************/
+    /**************** Live Stacking ***************/
+    /**********************************************/
+
+    StackSP[STACK_OFF].fill("STACK_OFF", "Off", ISS_ON);
+    StackSP[STACK_MEAN].fill("STACK_MEAN", "Mean", ISS_OFF);
+    StackSP[STACK_SUM].fill("STACK_SUM", "Sum", ISS_OFF);
+    StackSP[STACK_SIGMA_CLIP].fill("STACK_SIGMA_CLIP", "Sigma Clip", ISS_OFF);
+    StackSP.fill(getDeviceName(), "CCD_STACK", "Stacking", IMAGE_SETTINGS_TAB, IP_RW, ISR_1OFMANY, 60, IPS_IDLE);
+
+    StackSettingsNP[STACK_FRAMES].fill("FRAMES", "Frames", "%.f", 1, 65535, 1, m_Stacker.depth());
+    StackSettingsNP[STACK_SIGMA].fill("SIGMA", "Sigma", "%.1f", 1, 10, 0.5, 3);
+    StackSettingsNP.fill(getDeviceName(), "CCD_STACK_SETTINGS", "Stacking", IMAGE_SETTINGS_TAB, IP_RW, 60, IPS_IDLE);
+
+    StackAlignSP[INDI_ENABLED].fill("INDI_ENABLED", "Enabled", ISS_OFF);
+    StackAlignSP[INDI_DISABLED].fill("INDI_DISABLED", "Disabled", ISS_ON);
+    StackAlignSP.fill(getDeviceName(), "CCD_STACK_ALIGN", "Align", IMAGE_SETTINGS_TAB, IP_RW, ISR_1OFMANY, 60, IPS_IDLE);
+
+    StackStatusNP[STACK_DEPTH].fill("DEPTH", "Depth", "%.f", 0, 65535, 0, 0);
+    StackStatusNP[STACK_REJECTED].fill("REJECTED", "Rejected", "%.f", 0, 4294967295.0, 0, 0);
+    StackStatusNP.fill(getDeviceName(), "CCD_STACK_STATUS", "Stack", IMAGE_INFO_TAB, IP_RO, 60, IPS_IDLE);
+
+    /**********************************************/
+    /**************** Star Detection **************/
+    /**********************************************/
+    StarDetectionSP[INDI_ENABLED].fill("INDI_ENABLED", "Enabled", ISS_OFF);
+    StarDetectionSP[INDI_DISABLED].fill("INDI_DISABLED", "Disabled", ISS_ON);
+    StarDetectionSP.fill(getDeviceName(), "CCD_STAR_DETECTION", "Star Detection", OPTIONS_TAB, IP_RW, ISR_1OFMANY, 60,
+                         IPS_IDLE);
+
+    StarDetectionSettingsNP[STAR_DETECTION_THRESHOLD].fill("THRESHOLD", "Threshold (sigma)", "%.1f", 1, 100, 0.5, 5);
+    StarDetectionSettingsNP[STAR_DETECTION_STARS].fill("STARS", "Listed stars", "%.f", 0, 100, 1, 10);
+    StarDetectionSettingsNP.fill(getDeviceName(), "CCD_STAR_DETECTION_SETTINGS", "Star Detection", OPTIONS_TAB, IP_RW, 60,
+                                 IPS_IDLE);
+
+    StarMetricsNP[STAR_METRICS_COUNT].fill("COUNT", "Stars", "%.f", 0, 4294967295.0, 0, 0);
+    StarMetricsNP[STAR_METRICS_HFR].fill("HFR", "HFR", "%.2f", 0, 1000, 0, 0);
+    StarMetricsNP[STAR_METRICS_FWHM].fill("FWHM", "FWHM", "%.2f", 0, 1000, 0, 0);
+    StarMetricsNP[STAR_METRICS_ECCENTRICITY].fill("ECCENTRICITY", "Eccentricity", "%.2f", 0, 1, 0, 0);
+    StarMetricsNP[STAR_METRICS_BACKGROUND].fill("BACKGROUND", "Background", "%.1f", 0, 4294967295.0, 0, 0);
+    StarMetricsNP[STAR_METRICS_NOISE].fill("NOISE", "Noise", "%.2f", 0, 4294967295.0, 0, 0);
+    StarMetricsNP.fill(getDeviceName(), "CCD_STAR_METRICS", "Star Metrics", IMAGE_INFO_TAB, IP_RO, 60, IPS_IDLE);
+
+    StarListTP[0].fill("STARS", "Stars", "");
+    StarListTP.fill(getDeviceName(), "CCD_STARS", "Stars", IMAGE_INFO_TAB, IP_RO, 60, IPS_IDLE);
+
     /**********************************************/
     /************** Upload Settings ***************/
     /**********************************************/
@@ -410,6 +526,31 @@ bool CCD::initProperties()
     IUFillNumberVector(&FastExposureCountNP, FastExposureCountN, 1, getDeviceName(), "CCD_FAST_COUNT", "Fast Count",
                        OPTIONS_TAB, IP_RW, 0, IPS_IDLE);
 
+    /**********************************************/
+    /************ Post-exposure Pipeline **********/
+    /**********************************************/
+    PipelineNP[PIPELINE_OCCUPANCY].fill("OCCUPANCY", "Queued frames", "%.f", 0, 255, 1, 0);
+    PipelineNP[PIPELINE_CAPACITY].fill("CAPACITY", "Ring size", "%.f", 0, 255, 1, PrimaryCCD.getFrameRingSize());
+    PipelineNP[PIPELINE_WAIT].fill("WAIT", "Wait (ms)", "%.f", 0, 1e9, 1, 0);
+    PipelineNP[PIPELINE_ENCODE].fill("ENCODE", "Encode (ms)", "%.f", 0, 1e9, 1, 0);
+    PipelineNP[PIPELINE_UPLOAD].fill("UPLOAD", "Upload (ms)", "%.f", 0, 1e9, 1, 0);
+    PipelineNP.fill(getDeviceName(), "CCD_PIPELINE", "Pipeline", IMAGE_INFO_TAB, IP_RO, 60, IPS_IDLE);
+
+    /**********************************************/
+    /**************** Frame Statistics ************/
+    /**********************************************/
+    FrameStatsNP[FRAME_STATS_MIN].fill("MIN", "Min", "%.f", 0, 4294967295.0, 0, 0);
+    FrameStatsNP[FRAME_STATS_MAX].fill("MAX", "Max", "%.f", 0, 4294967295.0, 0, 0);
+    FrameStatsNP[FRAME_STATS_MEAN].fill("MEAN", "Mean", "%.2f", 0, 4294967295.0, 0, 0);
+    FrameStatsNP[FRAME_STATS_STDDEV].fill("STDDEV", "Std. Dev.", "%.2f", 0, 4294967295.0, 0, 0);
+    FrameStatsNP[FRAME_STATS_MEDIAN].fill("MEDIAN", "Median", "%.f", 0, 4294967295.0, 0, 0);
+    FrameStatsNP.fill(getDeviceName(), "CCD_FRAME_STATS", "Frame Stats", IMAGE_INFO_TAB, IP_RO, 60, IPS_IDLE);
+
+    FrameStatsSettingsNP[0].fill("HISTOGRAM_BINS", "Histogram bins", "%.f", 0, 1024, 1, 0);
+    FrameStatsSettingsNP.fill(getDeviceName(), "CCD_FRAME_STATS_SETTINGS", "Frame Stats", OPTIONS_TAB, IP_RW, 60, IPS_IDLE);
+
+    FrameHistogramNP.fill(getDeviceName(), "CCD_FRAME_HISTOGRAM", "Histogram", IMAGE_INFO_TAB, IP_RO, 60, IPS_IDLE);
+
     /**********************************************/
     /**************** Web Socket ******************/
     /**********************************************/
@@ -548,6 +689,17 @@ bool CCD::updateProperties()
                 defineProperty(&GuideCCD.ImageBinNP);
         }
         defineProperty(&PrimaryCCD.CompressSP);
+        defineProperty(&CompressionCodecSP);
+        defineProperty(&CompressionLevelNP);
+        defineProperty(&CalibrationSP);
+        defineProperty(&CalibrationFilesTP);
+        defineProperty(&CalibrationMastersBP);
+        if (CanSubFrame())
+            defineProperty(&ROIsNP);
+        defineProperty(&StackSP);
+        defineProperty(&StackSettingsNP);
+        defineProperty(&StackAlignSP);
+        defineProperty(&StackStatusNP);
         defineProperty(&PrimaryCCD.FitsBP);
         if (HasGuideHead())
         {
@@ -600,9 +752,22 @@ bool CCD::updateProperties()
 
         defineProperty(&FastExposureToggleSP);
         defineProperty(&FastExposureCountNP);
+        defineProperty(&PipelineNP);
+        defineProperty(&FrameStatsNP);
+        defineProperty(&FrameStatsSettingsNP);
+        defineProperty(&StarDetectionSP);
+        defineProperty(&StarDetectionSettingsNP);
+        defineProperty(&StarMetricsNP);
+        defineProperty(&StarListTP);
+        std::lock_guard<std::mutex> lock(m_PipelineLock);
+        if (FrameHistogramNP.size() > 0)
+            defineProperty(&FrameHistogramNP);
     }
     else
     {
+        // Queued frames are uploaded before their properties are deleted
+        stopPipeline();
+
         deleteProperty(PrimaryCCD.ImageFrameNP.name);
         if (CanBin() || CanSubFrame())
             deleteProperty(PrimaryCCD.ResetSP.name);
@@ -620,6 +785,17 @@ bool CCD::updateProperties()
             deleteProperty(PrimaryCCD.AbortExposureSP.name);
         deleteProperty(PrimaryCCD.FitsBP.name);
         deleteProperty(PrimaryCCD.CompressSP.name);
+        deleteProperty(CompressionCodecSP.getName());
+        deleteProperty(CompressionLevelNP.getName());
+        deleteProperty(CalibrationSP.getName());
+        deleteProperty(CalibrationFilesTP.getName());
+        deleteProperty(CalibrationMastersBP.getName());
+        if (CanSubFrame())
+            deleteProperty(ROIsNP.getName());
+        deleteProperty(StackSP.getName());
+        deleteProperty(StackSettingsNP.getName());
+        deleteProperty(StackAlignSP.getName());
+        deleteProperty(StackStatusNP.getName());
 
 #if 0
         deleteProperty(PrimaryCCD.RapidGuideSP.name);
@@ -687,6 +863,16 @@ bool CCD::updateProperties()
 #endif
         deleteProperty(FastExposureToggleSP.name);
         deleteProperty(FastExposureCountNP.name);
+        deleteProperty(PipelineNP.getName());
+        deleteProperty(FrameStatsNP.getName());
+        deleteProperty(FrameStatsSettingsNP.getName());
+        deleteProperty(StarDetectionSP.getName());
+        deleteProperty(StarDetectionSettingsNP.getName());
+        deleteProperty(StarMetricsNP.getName());
+        deleteProperty(StarListTP.getName());
+        std::lock_guard<std::mutex> lock(m_PipelineLock);
+        if (FrameHistogramNP.size() > 0)
+            deleteProperty(FrameHistogramNP.getName());
     }
 
     // Streamer
@@ -957,6 +1143,43 @@ bool CCD::ISNewText(const char * dev, const char * name, char * texts[], char *
             IDSetText(&UploadSettingsTP, nullptr);
             return true;
         }
+
+        // Calibration masters on disk
+        if (CalibrationFilesTP.isNameMatch(name))
+        {
+            CalibrationFilesTP.update(texts, names, n);
+            CalibrationFilesTP.setState(IPS_OK);
+
+            // Only reload the masters the client sent, others may have been uploaded as BLOBs.
+            for (int i = 0; i < n; i++)
+            {
+                int index = -1;
+                for (int j = 0; j < static_cast<int>(CalibrationFilesTP.size()); j++)
+                    if (!strcmp(names[i], CalibrationFilesTP[j].getName()))
+                        index = j;
+                if (index < 0)
+                    continue;
+
+                auto type = static_cast<FrameCalibration::MasterType>(index);
+                const char *path = CalibrationFilesTP[index].getText();
+                std::string error;
+                std::lock_guard<std::mutex> lock(m_CalibrationLock);
+                if (path == nullptr || path[0] == '\0')
+                    m_Calibration.clearMaster(type);
+                else if (m_Calibration.loadMaster(type, path, error))
+                    LOGF_INFO("Loaded %s master %s.", CalibrationFilesTP[index].getLabel(), path);
+                else
+                {
+                    LOGF_ERROR("Failed to load %s master %s: %s", CalibrationFilesTP[index].getLabel(), path, error.c_str());
+                    CalibrationFilesTP.setState(IPS_ALERT);
+                }
+            }
+
+            CalibrationFilesTP.apply();
+            if (CalibrationFilesTP.getState() == IPS_OK)
+                saveConfig(true, CalibrationFilesTP.getName());
+            return true;
+        }
     }
 
     // Streamer
@@ -1248,6 +1471,109 @@ bool CCD::ISNewNumber(const char * dev, const char * name, double values[], char
             return true;
         }
 
+        // Compression Level
+        if (CompressionLevelNP.isNameMatch(name))
+        {
+            CompressionLevelNP.update(values, names, n);
+            CompressionLevelNP.setState(IPS_OK);
+            CompressionLevelNP.apply();
+            saveConfig(true, CompressionLevelNP.getName());
+            return true;
+        }
+
+        // Regions of Interest
+        if (ROIsNP.isNameMatch(name))
+        {
+            std::vector<double> previous(ROIsNP.size());
+            for (size_t i = 0; i < ROIsNP.size(); i++)
+                previous[i] = ROIsNP[i].getValue();
+            ROIsNP.update(values, names, n);
+
+            std::vector<FrameROI> rois;
+            bool valid = true;
+            for (uint32_t i = 0; i < MAX_ROIS; i++)
+            {
+                FrameROI roi;
+                roi.x      = static_cast<uint32_t>(ROIsNP[i * 4].getValue());
+                roi.y      = static_cast<uint32_t>(ROIsNP[i * 4 + 1].getValue());
+                roi.width  = static_cast<uint32_t>(ROIsNP[i * 4 + 2].getValue());
+                roi.height = static_cast<uint32_t>(ROIsNP[i * 4 + 3].getValue());
+                if (roi.width == 0 || roi.height == 0)
+                    continue;
+
+                if (roi.x + roi.width > static_cast<uint32_t>(PrimaryCCD.getXRes()) ||
+                        roi.y + roi.height > static_cast<uint32_t>(PrimaryCCD.getYRes()))
+                {
+                    LOGF_ERROR("Region of interest %u (%u,%u) (%u x %u) is outside of the sensor.", i + 1, roi.x, roi.y,
+                               roi.width, roi.height);
+                    valid = false;
+                }
+                rois.push_back(roi);
+            }
+
+            if (valid && UpdateCCDROIs(rois))
+            {
+                std::lock_guard<std::mutex> lock(m_ROILock);
+                m_ROIs = std::move(rois);
+                ROIsNP.setState(m_ROIs.empty() ? IPS_IDLE : IPS_OK);
+            }
+            else
+            {
+                for (size_t i = 0; i < ROIsNP.size(); i++)
+                    ROIsNP[i].setValue(previous[i]);
+                ROIsNP.setState(IPS_ALERT);
+            }
+            ROIsNP.apply();
+            return true;
+        }
+
+        // Live Stacking
+        if (StackSettingsNP.isNameMatch(name))
+        {
+            StackSettingsNP.update(values, names, n);
+            std::unique_lock<std::mutex> lock(m_StackLock);
+            m_Stacker.setDepth(static_cast<uint32_t>(StackSettingsNP[STACK_FRAMES].getValue()));
+            m_Stacker.setSigma(StackSettingsNP[STACK_SIGMA].getValue());
+            lock.unlock();
+            StackSettingsNP.setState(IPS_OK);
+            StackSettingsNP.apply();
+            saveConfig(true, StackSettingsNP.getName());
+            return true;
+        }
+
+        // Star Detection
+        if (StarDetectionSettingsNP.isNameMatch(name))
+        {
+            std::unique_lock<std::mutex> lock(m_PipelineLock);
+            StarDetectionSettingsNP.update(values, names, n);
+            lock.unlock();
+            StarDetectionSettingsNP.setState(IPS_OK);
+            StarDetectionSettingsNP.apply();
+            saveConfig(true, StarDetectionSettingsNP.getName());
+            return true;
+        }
+
+        // Frame Statistics
+        if (FrameStatsSettingsNP.isNameMatch(name))
+        {
+            FrameStatsSettingsNP.update(values, names, n);
+            FrameStatsSettingsNP.setState(IPS_OK);
+            FrameStatsSettingsNP.apply();
+
+            std::unique_lock<std::mutex> lock(m_PipelineLock);
+            if (FrameHistogramNP.size() != static_cast<size_t>(FrameStatsSettingsNP[0].getValue()))
+            {
+                if (isConnected() && FrameHistogramNP.size() > 0)
+                    deleteProperty(FrameHistogramNP.getName());
+                resizeFrameHistogram();
+                if (isConnected() && FrameHistogramNP.size() > 0)
+                    defineProperty(&FrameHistogramNP);
+                lock.unlock();
+                saveConfig(true, FrameStatsSettingsNP.getName());
+            }
+            return true;
+        }
+
         // Camera Temperature Ramp
         if (!strcmp(name, TemperatureRampNP.getName()))
         {
@@ -1332,6 +1658,16 @@ bool CCD::ISNewSwitch(const char * dev, const char * name, ISState * states, cha
 {
     if (dev != nullptr && strcmp(dev, getDeviceName()) == 0)
     {
+        // Queued frames are uploaded before the driver disconnects from the camera
+        if (!strcmp(name, INDI::SP::CONNECTION) && isConnected())
+        {
+            for (int i = 0; i < n; i++)
+            {
+                if (!strcmp(names[i], "DISCONNECT") && states[i] == ISS_ON)
+                    stopPipeline();
+            }
+        }
+
         // Upload Mode
         if (!strcmp(name, UploadSP.name))
         {
@@ -1340,6 +1676,7 @@ bool CCD::ISNewSwitch(const char * dev, const char * name, ISState * states, cha
 
             if (UpdateCCDUploadMode(static_cast<CCD_UPLOAD_MODE>(IUFindOnSwitchIndex(&UploadSP))))
             {
+                std::lock_guard<std::mutex> lock(m_FileNameLock);
                 if (UploadS[UPLOAD_CLIENT].s == ISS_ON)
                 {
                     DEBUG(Logger::DBG_SESSION, "Upload settings set to client only.");
@@ -1483,9 +1820,17 @@ bool CCD::ISNewSwitch(const char * dev, const char * name, ISState * states, cha
 
             setCurrentPollingPeriod(getPollingPeriod());
 
+            // Frames stacked before the abort are uploaded rather than dropped
+            if (StackSP[STACK_OFF].getState() != ISS_ON)
+                queueStackFlush();
+
             // Fast Exposure Count
             if (FastExposureCountNP.s == IPS_BUSY)
             {
+                {
+                    std::lock_guard<std::mutex> lock(m_PipelineLock);
+                    m_FastExposurePending = nullptr;
+                }
                 m_UploadTime = 0;
                 FastExposureCountNP.s = IPS_IDLE;
                 FastExposureCountN[0].value = 1;
@@ -1634,6 +1979,102 @@ bool CCD::ISNewSwitch(const char * dev, const char * name, ISState * states, cha
             return true;
         }
 
+        // Calibration
+        if (CalibrationSP.isNameMatch(name))
+        {
+            CalibrationSP.update(states, names, n);
+            if (CalibrationSP[INDI_ENABLED].getState() == ISS_ON)
+            {
+                std::lock_guard<std::mutex> lock(m_CalibrationLock);
+                if (m_Calibration.isEmpty())
+                    LOG_WARN("No calibration master is loaded, frames are uploaded uncalibrated.");
+            }
+            CalibrationSP.setState(IPS_OK);
+            CalibrationSP.apply();
+            saveConfig(true, CalibrationSP.getName());
+            return true;
+        }
+
+        // Live Stacking
+        if (StackSP.isNameMatch(name))
+        {
+            StackSP.update(states, names, n);
+            int index = StackSP.findOnSwitchIndex();
+            std::unique_lock<std::mutex> lock(m_StackLock);
+            if (index == STACK_MEAN)
+                m_Stacker.setMode(FrameStacker::STACK_MEAN);
+            else if (index == STACK_SUM)
+                m_Stacker.setMode(FrameStacker::STACK_SUM);
+            else if (index == STACK_SIGMA_CLIP)
+                m_Stacker.setMode(FrameStacker::STACK_SIGMA_CLIP);
+            // Every change of mode, including toggling stacking, starts a new stack
+            m_Stacker.reset();
+            m_Stacker.resetRejected();
+            lock.unlock();
+
+            StackStatusNP[STACK_DEPTH].setValue(0);
+            StackStatusNP[STACK_REJECTED].setValue(0);
+            StackStatusNP.setState(IPS_IDLE);
+            StackStatusNP.apply();
+            StackSP.setState(index == STACK_OFF ? IPS_IDLE : IPS_OK);
+            StackSP.apply();
+            return true;
+        }
+
+        if (StackAlignSP.isNameMatch(name))
+        {
+            StackAlignSP.update(states, names, n);
+            std::unique_lock<std::mutex> lock(m_StackLock);
+            m_Stacker.setAlignment(StackAlignSP[INDI_ENABLED].getState() == ISS_ON);
+            lock.unlock();
+            StackAlignSP.setState(IPS_OK);
+            StackAlignSP.apply();
+            saveConfig(true, StackAlignSP.getName());
+            return true;
+        }
+
+        // Star Detection
+        if (StarDetectionSP.isNameMatch(name))
+        {
+            std::unique_lock<std::mutex> lock(m_PipelineLock);
+            StarDetectionSP.update(states, names, n);
+            bool enabled = StarDetectionSP[INDI_ENABLED].getState() == ISS_ON;
+            lock.unlock();
+            if (!enabled)
+            {
+                StarMetricsNP.setState(IPS_IDLE);
+                StarMetricsNP.apply();
+            }
+            StarDetectionSP.setState(enabled ? IPS_OK : IPS_IDLE);
+            StarDetectionSP.apply();
+            saveConfig(true, StarDetectionSP.getName());
+            return true;
+        }
+
+        // Compression Codec
+        if (CompressionCodecSP.isNameMatch(name))
+        {
+            int previousIndex = CompressionCodecSP.findOnSwitchIndex();
+            CompressionCodecSP.update(states, names, n);
+            int index = CompressionCodecSP.findOnSwitchIndex();
+
+            if ((index == CODEC_ZSTD && !isCompressionSupported(COMPRESSION_ZSTD)) ||
+                    (index == CODEC_LZ4 && !isCompressionSupported(COMPRESSION_LZ4)))
+            {
+                LOGF_ERROR("%s compression is not supported by this build.", CompressionCodecSP[index].getLabel());
+                CompressionCodecSP.reset();
+                CompressionCodecSP[previousIndex].setState(ISS_ON);
+                CompressionCodecSP.setState(IPS_ALERT);
+                CompressionCodecSP.apply();
+                return true;
+            }
+
+            CompressionCodecSP.setState(IPS_OK);
+            CompressionCodecSP.apply();
+            saveConfig(true, CompressionCodecSP.getName());
+            return true;
+        }
+
         // Encode Format
         if (EncodeFormatSP.isNameMatch(name))
         {
@@ -1738,6 +2179,50 @@ bool CCD::ISNewSwitch(const char * dev, const char * name, ISState * states, cha
 bool CCD::ISNewBLOB(const char *dev, const char *name, int sizes[], int blobsizes[], char *blobs[],
                     char *formats[], char *names[], int n)
 {
+    if (dev != nullptr && strcmp(dev, getDeviceName()) == 0 && CalibrationMastersBP.isNameMatch(name))
+    {
+        CalibrationMastersBP.setState(IPS_OK);
+        for (int i = 0; i < n; i++)
+        {
+            int index = -1;
+            for (int j = 0; j < static_cast<int>(CalibrationMastersBP.size()); j++)
+                if (!strcmp(names[i], CalibrationMastersBP[j].getName()))
+                    index = j;
+            if (index < 0)
+                continue;
+
+            // sizes holds the uncompressed size, blobsizes the size of the BLOB as sent
+            const void *data = blobs[i];
+            std::vector<uint8_t> decompressed;
+            CompressionCodec codec;
+            std::string error;
+            if (findCompression(formats[i], codec))
+            {
+                decompressed.resize(sizes[i]);
+                if (!decompressBuffer(blobs[i], blobsizes[i], codec, decompressed.data(), decompressed.size()))
+                {
+                    LOGF_ERROR("Failed to decompress %s master.", CalibrationMastersBP[index].getLabel());
+                    CalibrationMastersBP.setState(IPS_ALERT);
+                    continue;
+                }
+                data = decompressed.data();
+            }
+
+            auto type = static_cast<FrameCalibration::MasterType>(index);
+            std::lock_guard<std::mutex> lock(m_CalibrationLock);
+            if (m_Calibration.loadMaster(type, data, decompressed.empty() ? blobsizes[i] : sizes[i],
+                                         std::string(CalibrationMastersBP[index].getLabel()) + " BLOB", error))
+                LOGF_INFO("Loaded %s master from client.", CalibrationMastersBP[index].getLabel());
+            else
+            {
+                LOGF_ERROR("Failed to load %s master: %s", CalibrationMastersBP[index].getLabel(), error.c_str());
+                CalibrationMastersBP.setState(IPS_ALERT);
+            }
+        }
+        CalibrationMastersBP.apply();
+        return true;
+    }
+
     // DSP
     if (HasDSP())
         DSP->ISNewBLOB(dev, name, sizes, blobsizes, blobs, formats, names, n);
@@ -1789,6 +2274,13 @@ bool CCD::UpdateGuiderFrame(int x, int y, int w, int h)
     return true;
 }
 
+bool CCD::UpdateCCDROIs(const std::vector<FrameROI> &rois)
+{
+    // Regions are cropped in software, unless HW layer overrides this and reads them out itself
+    INDI_UNUSED(rois);
+    return true;
+}
+
 bool CCD::UpdateCCDBin(int hor, int ver)
 {
     // Just set value, unless HW layer overrides this and performs its own processing
@@ -1834,6 +2326,12 @@ void CCD::addFITSKeywords(CCDChip * targetChip)
 
     auto fptr = *targetChip->fitsFilePointer();
 
+    // Keywords describe the frame being encoded, the chip may already be set up for the next exposure.
+    CCDChip::Frame chipFrame;
+    if (m_EncodingFrame == nullptr)
+        copyFrameSettings(targetChip, chipFrame);
+    const CCDChip::Frame &frame = m_EncodingFrame ? *m_EncodingFrame : chipFrame;
+
     AutoCNumeric locale;
     fits_update_key_str(fptr, "ROWORDER", "TOP-DOWN", "Row Order", &status);
     fits_update_key_str(fptr, "INSTRUME", getDeviceName(), "CCD Name", &status);
@@ -1872,19 +2370,19 @@ void CCD::addFITSKeywords(CCDChip * targetChip)
     // Object
     fits_update_key_str(fptr, "OBJECT", FITSHeaderT[FITS_OBJECT].text, "Object name", &status);
 
-    double subPixSize1 = static_cast<double>(targetChip->getPixelSizeX());
-    double subPixSize2 = static_cast<double>(targetChip->getPixelSizeY());
-    uint32_t subW = targetChip->getSubW();
-    uint32_t subH = targetChip->getSubH();
-    uint32_t subBinX = targetChip->getBinX();
-    uint32_t subBinY = targetChip->getBinY();
+    double subPixSize1 = static_cast<double>(frame.pixelSizeX);
+    double subPixSize2 = static_cast<double>(frame.pixelSizeY);
+    uint32_t subW = frame.subW;
+    uint32_t subH = frame.subH;
+    uint32_t subBinX = frame.binX;
+    uint32_t subBinY = frame.binY;
 
     strncpy(dev_name, getDeviceName(), MAXINDINAME);
 
-    fits_update_key_dbl(fptr, "EXPTIME", exposureDuration, 6, "Total Exposure Time (s)", &status);
+    fits_update_key_dbl(fptr, "EXPTIME", frame.exposureDuration, 6, "Total Exposure Time (s)", &status);
 
-    if (targetChip->getFrameType() == CCDChip::DARK_FRAME)
-        fits_update_key_dbl(fptr, "DARKTIME", exposureDuration, 6, "Total Dark Exposure Time (s)", &status);
+    if (frame.frameType == CCDChip::DARK_FRAME)
+        fits_update_key_dbl(fptr, "DARKTIME", frame.exposureDuration, 6, "Total Dark Exposure Time (s)", &status);
 
     // If the camera has a cooler OR if the temperature permission was explicitly set to Read-Only, then record the temperature
     if (HasCooler() || TemperatureNP.p == IP_RO)
@@ -1892,15 +2390,15 @@ void CCD::addFITSKeywords(CCDChip * targetChip)
 
     fits_update_key_dbl(fptr, "PIXSIZE1", subPixSize1, 6, "Pixel Size 1 (microns)", &status);
     fits_update_key_dbl(fptr, "PIXSIZE2", subPixSize2, 6, "Pixel Size 2 (microns)", &status);
-    fits_update_key_lng(fptr, "XBINNING", targetChip->getBinX(), "Binning factor in width", &status);
-    fits_update_key_lng(fptr, "YBINNING", targetChip->getBinY(), "Binning factor in height", &status);
+    fits_update_key_lng(fptr, "XBINNING", subBinX, "Binning factor in width", &status);
+    fits_update_key_lng(fptr, "YBINNING", subBinY, "Binning factor in height", &status);
     // XPIXSZ and YPIXSZ are logical sizes including the binning factor
     double xpixsz = subPixSize1 * subBinX;
     double ypixsz = subPixSize2 * subBinY;
     fits_update_key_dbl(fptr, "XPIXSZ", xpixsz, 6, "X binned pixel size in microns", &status);
     fits_update_key_dbl(fptr, "YPIXSZ", ypixsz, 6, "Y binned pixel size in microns", &status);
 
-    switch (targetChip->getFrameType())
+    switch (frame.frameType)
     {
         case CCDChip::LIGHT_FRAME:
             fits_update_key_str(fptr, "FRAME", "Light", "Frame Type", &status);
@@ -1925,18 +2423,41 @@ void CCD::addFITSKeywords(CCDChip * targetChip)
         fits_update_key_str(fptr, "FILTER", FilterNames.at(CurrentFilterSlot - 1).c_str(), "Filter", &status);
     }
 
+    if (m_EncodingFrame && m_FrameStatsValid)
+    {
 #ifdef WITH_MINMAX
-    if (targetChip->getNAxis() == 2)
+        fits_update_key_dbl(fptr, "DATAMIN", m_FrameStats.min, 6, "Minimum value", &status);
+        fits_update_key_dbl(fptr, "DATAMAX", m_FrameStats.max, 6, "Maximum value", &status);
+#endif
+        fits_update_key_dbl(fptr, "DATAMEAN", m_FrameStats.mean, 6, "Mean value", &status);
+        fits_update_key_dbl(fptr, "DATASTD", m_FrameStats.stddev, 6, "Standard deviation", &status);
+        fits_update_key_dbl(fptr, "DATAMED", m_FrameStats.median, 6, "Median value", &status);
+    }
+
+    if (m_EncodingFrame && m_StackedFrames > 0)
     {
-        double min_val, max_val;
-        getMinMax(&min_val, &max_val, targetChip);
+        fits_update_key_lng(fptr, "NCOMBINE", m_StackedFrames, "Number of frames stacked", &status);
+        fits_update_key_str(fptr, "STACKMOD", StackSP.findOnSwitch()->getLabel(), "Stacking method", &status);
+    }
 
-        fits_update_key_dbl(fptr, "DATAMIN", min_val, 6, "Minimum value", &status);
-        fits_update_key_dbl(fptr, "DATAMAX", max_val, 6, "Maximum value", &status);
+    if (m_EncodingFrame && m_FrameCalibrated)
+    {
+        static const char * const keywords[FrameCalibration::MASTER_COUNT] = {"BIASFILE", "DARKFILE", "FLATFILE"};
+        static const char * const comments[FrameCalibration::MASTER_COUNT] = {"Master bias", "Master dark", "Master flat"};
+        std::string applied;
+        for (int i = 0; i < FrameCalibration::MASTER_COUNT; i++)
+        {
+            if (m_AppliedCalibration[i].empty())
+                continue;
+            applied += "BDF"[i];
+            fits_update_key_str(fptr, keywords[i], m_AppliedCalibration[i].c_str(), comments[i], &status);
+        }
+        fits_update_key_str(fptr, "CALSTAT", applied.c_str(), "Calibration applied: Bias, Dark, Flat", &status);
+        if (m_AppliedCalibration[FrameCalibration::MASTER_DARK].empty() == false)
+            fits_update_key_dbl(fptr, "DARKSCAL", m_AppliedDarkScale, 6, "Scale factor of the master dark", &status);
     }
-#endif
 
-    if (HasBayer() && targetChip->getNAxis() == 2)
+    if (HasBayer() && frame.naxis == 2)
     {
         fits_update_key_lng(fptr, "XBAYROFF", atoi(BayerT[0].text), "X offset of Bayer array", &status);
         fits_update_key_lng(fptr, "YBAYROFF", atoi(BayerT[1].text), "Y offset of Bayer array", &status);
@@ -1978,7 +2499,7 @@ void CCD::addFITSKeywords(CCDChip * targetChip)
     }
 
 
-    if ( targetChip->getFrameType() == CCDChip::LIGHT_FRAME && !std::isnan(RA) && !std::isnan(Dec) && (std::isnan(J2000RA)
+    if ( frame.frameType == CCDChip::LIGHT_FRAME && !std::isnan(RA) && !std::isnan(Dec) && (std::isnan(J2000RA)
             || std::isnan(J2000DE) || !J2000Valid) )
     {
         INDI::IEquatorialCoordinates epochPos { 0, 0 }, J2000Pos { 0, 0 };
@@ -1993,7 +2514,7 @@ void CCD::addFITSKeywords(CCDChip * targetChip)
     }
     J2000Valid = false;  // enforce usage of EOD position if we receive no new epoch position
 
-    if ( targetChip->getFrameType() == CCDChip::LIGHT_FRAME && !std::isnan(J2000RA) && !std::isnan(J2000DE) )
+    if ( frame.frameType == CCDChip::LIGHT_FRAME && !std::isnan(J2000RA) && !std::isnan(J2000DE) )
     {
         if (!std::isnan(Latitude) && !std::isnan(Longitude))
         {
@@ -2122,7 +2643,7 @@ void CCD::addFITSKeywords(CCDChip * targetChip)
         }
     }
 
-    fits_update_key_str(fptr, "DATE-OBS", exposureStartTime, "UTC start date of observation", &status);
+    fits_update_key_str(fptr, "DATE-OBS", frame.exposureStartTime, "UTC start date of observation", &status);
     fits_write_comment(fptr, "Generated by INDI", &status);
 }
 
@@ -2138,54 +2659,476 @@ bool CCD::ExposureComplete(CCDChip * targetChip)
     // Reset POLLMS to default value
     setCurrentPollingPeriod(getPollingPeriod());
 
-    // Run async
-    std::thread(&CCD::ExposureCompletePrivate, this, targetChip).detach();
+    // Copy the frame, the driver may read out the next one while it is encoded and uploaded.
+    queueFrame(targetChip);
+
+    if (FastExposureToggleS[INDI_ENABLED].s == ISS_ON)
+    {
+        std::unique_lock<std::mutex> lock(m_PipelineLock);
+        if (targetChip->FrameRingCount < targetChip->FrameRing.size())
+        {
+            lock.unlock();
+            // Run async, the driver may still hold locks needed to start an exposure.
+            std::thread(&CCD::processFastExposure, this, targetChip).detach();
+        }
+        else
+        {
+            // Back-pressure: start the next exposure once a frame is uploaded.
+            LOG_DEBUG("Frame ring is full, next fast exposure waits for an upload to complete.");
+            m_FastExposurePending = targetChip;
+        }
+    }
 
     return true;
 }
 
-bool CCD::ExposureCompletePrivate(CCDChip * targetChip)
+void CCD::queueFrame(CCDChip * targetChip)
+{
+    std::unique_lock<std::mutex> lock(m_PipelineLock);
+
+    if (m_PipelineThread.joinable() == false)
+    {
+        m_PipelineThread = std::thread(&CCD::pipelineThreadEntry, this);
+
+        // Registered once the driver is constructed, so it runs before the driver is destroyed at exit
+        std::lock_guard<std::mutex> runningLock(runningPipelinesLock);
+        static bool isExitHookRegistered = false;
+        if (!isExitHookRegistered)
+        {
+            std::atexit(stopAllPipelines);
+            isExitHookRegistered = true;
+        }
+        runningPipelines.insert(this);
+    }
+
+    // The ring is only resized when empty.
+    if (targetChip->FrameRingCount == 0 && targetChip->FrameRing.size() != targetChip->FrameRingSize)
+    {
+        targetChip->FrameRing.resize(targetChip->FrameRingSize);
+        targetChip->FrameRingHead = 0;
+    }
+
+    if (targetChip->FrameRingCount >= targetChip->FrameRing.size())
+    {
+        LOG_DEBUG("Frame ring is full, waiting for an upload to complete.");
+        m_PipelineCondition.wait(lock, [targetChip]
+        {
+            return targetChip->FrameRingCount < targetChip->FrameRing.size();
+        });
+    }
+
+    // The free slot is only used by the pipeline thread once it is counted.
+    CCDChip::Frame &frame = targetChip->FrameRing[(targetChip->FrameRingHead + targetChip->FrameRingCount) %
+                            targetChip->FrameRing.size()];
+    lock.unlock();
+
+    // ccdBufferLock is not taken, drivers may call ExposureComplete() while holding it
+    frame.buffer.assign(targetChip->getFrameBuffer(), targetChip->getFrameBuffer() + targetChip->getFrameBufferSize());
+
+    copyFrameSettings(targetChip, frame);
+    // The count is decremented once the next exposure of the sequence starts
+    frame.sequenceEnd = FastExposureToggleS[INDI_ENABLED].s != ISS_ON || FastExposureCountN[0].value <= 1;
+    frame.stackedFrames = 0;
+    frame.readoutTime = std::chrono::steady_clock::now();
+
+    lock.lock();
+    targetChip->FrameRingCount++;
+    m_PipelineQueue.push_back(targetChip);
+    updatePipelineOccupancy();
+    m_PipelineCondition.notify_all();
+}
+
+void CCD::stopPipeline()
+{
+    if (m_PipelineThread.joinable() == false || m_PipelineThread.get_id() == std::this_thread::get_id())
+        return;
+
+    // The thread exits once the queued frames are uploaded
+    std::unique_lock<std::mutex> lock(m_PipelineLock);
+    m_PipelineQuit = true;
+    m_FastExposurePending = nullptr;
+    m_PipelineCondition.notify_all();
+    lock.unlock();
+
+    m_PipelineThread.join();
+
+    // queueFrame() starts it again on the next frame
+    lock.lock();
+    m_PipelineQuit = false;
+}
+
+void CCD::stopAllPipelines()
+{
+    std::set<CCD *> ccds;
+    {
+        std::lock_guard<std::mutex> lock(runningPipelinesLock);
+        ccds.swap(runningPipelines);
+    }
+
+    for (auto ccd : ccds)
+        ccd->stopPipeline();
+}
+
+void CCD::copyFrameSettings(CCDChip * targetChip, CCDChip::Frame &frame)
+{
+    frame.subX  = targetChip->getSubX();
+    frame.subY  = targetChip->getSubY();
+    frame.subW  = targetChip->getSubW();
+    frame.subH  = targetChip->getSubH();
+    frame.binX  = targetChip->getBinX();
+    frame.binY  = targetChip->getBinY();
+    frame.xRes  = targetChip->getXRes();
+    frame.yRes  = targetChip->getYRes();
+    frame.pixelSizeX = targetChip->getPixelSizeX();
+    frame.pixelSizeY = targetChip->getPixelSizeY();
+    frame.bpp   = targetChip->getBPP();
+    frame.naxis = targetChip->getNAxis();
+    frame.frameType = targetChip->getFrameType();
+    strncpy(frame.extension, targetChip->getImageExtension(), MAXINDIBLOBFMT - 1);
+    frame.exposureDuration = targetChip->getExposureDuration();
+    strncpy(frame.exposureStartTime, targetChip->getExposureStartTime(), MAXINDINAME - 1);
+}
+
+void CCD::pipelineThreadEntry()
+{
+    std::unique_lock<std::mutex> lock(m_PipelineLock);
+
+    for (;;)
+    {
+        m_PipelineCondition.wait(lock, [this]
+        {
+            return !m_PipelineQueue.empty() || m_PipelineQuit;
+        });
+
+        if (m_PipelineQueue.empty())
+            return;
+
+        CCDChip * targetChip = m_PipelineQueue.front();
+        m_PipelineQueue.pop_front();
+        if (targetChip == nullptr)
+        {
+            lock.unlock();
+            flushStack();
+            lock.lock();
+            continue;
+        }
+
+        CCDChip::Frame &frame = targetChip->FrameRing[targetChip->FrameRingHead];
+        lock.unlock();
+
+        ExposureCompletePrivate(targetChip, frame);
+
+        lock.lock();
+        targetChip->FrameRingHead = (targetChip->FrameRingHead + 1) % targetChip->FrameRing.size();
+        targetChip->FrameRingCount--;
+        updatePipelineOccupancy();
+        m_PipelineCondition.notify_all();
+
+        if (m_FastExposurePending == targetChip)
+        {
+            m_FastExposurePending = nullptr;
+            lock.unlock();
+            processFastExposure(targetChip);
+            lock.lock();
+        }
+    }
+}
+
+void CCD::updatePipelineOccupancy()
+{
+    PipelineNP[PIPELINE_OCCUPANCY].setValue(PrimaryCCD.FrameRingCount);
+    PipelineNP[PIPELINE_CAPACITY].setValue(PrimaryCCD.FrameRing.empty() ? PrimaryCCD.FrameRingSize : PrimaryCCD.FrameRing.size());
+    PipelineNP.setState(PrimaryCCD.FrameRingCount > 0 ? IPS_BUSY : IPS_OK);
+    if (isConnected())
+        PipelineNP.apply();
+}
+
+void CCD::detectFrameStars(const CCDChip::Frame &frame)
+{
+    std::unique_lock<std::mutex> lock(m_PipelineLock);
+    bool enabled = StarDetectionSP[INDI_ENABLED].getState() == ISS_ON;
+    double threshold = StarDetectionSettingsNP[STAR_DETECTION_THRESHOLD].getValue();
+    size_t listed = static_cast<size_t>(StarDetectionSettingsNP[STAR_DETECTION_STARS].getValue());
+    lock.unlock();
+
+    if (!enabled)
+        return;
+
+    uint32_t width = frame.subW / frame.binX, height = frame.subH / frame.binY;
+    StarDetection detection;
+    if (static_cast<size_t>(width) * height * (frame.bpp / 8) > frame.buffer.size() ||
+            detectStars(frame.buffer.data(), width, height, frame.bpp, detection, threshold) == false)
+    {
+        StarMetricsNP.setState(IPS_ALERT);
+        StarMetricsNP.apply();
+        return;
+    }
+
+    StarMetricsNP[STAR_METRICS_COUNT].setValue(detection.stars.size());
+    StarMetricsNP[STAR_METRICS_HFR].setValue(detection.hfr);
+    StarMetricsNP[STAR_METRICS_FWHM].setValue(detection.fwhm);
+    StarMetricsNP[STAR_METRICS_ECCENTRICITY].setValue(detection.eccentricity);
+    StarMetricsNP[STAR_METRICS_BACKGROUND].setValue(detection.background);
+    StarMetricsNP[STAR_METRICS_NOISE].setValue(detection.noise);
+    StarMetricsNP.setState(IPS_OK);
+    StarMetricsNP.apply();
+
+    std::string list;
+    for (size_t i = 0; i < std::min(listed, detection.stars.size()); i++)
+    {
+        const StarInfo &star = detection.stars[i];
+        char entry[MAXINDINAME];
+        snprintf(entry, sizeof(entry), "%s%.2f,%.2f,%.f,%.2f,%.2f", i > 0 ? ";" : "", star.x, star.y, star.flux, star.hfr,
+                 star.fwhm);
+        list += entry;
+    }
+    StarListTP[0].setText(list);
+    StarListTP.setState(IPS_OK);
+    StarListTP.apply();
+}
+
+void CCD::takeStack(CCDChip::Frame &frame)
+{
+    // The stacked frame is exposed from the start of its first frame for the total exposure time
+    std::vector<uint8_t> buffer;
+    buffer.swap(frame.buffer);
+    auto readoutTime = frame.readoutTime;
+    frame = m_StackFrame;
+    frame.buffer.swap(buffer);
+    frame.readoutTime = readoutTime;
+
+    frame.stackedFrames = m_Stacker.count();
+    frame.exposureDuration = m_Stacker.exposure();
+    frame.bpp = m_Stacker.outputBPP();
+    m_Stacker.result(frame.buffer);
+}
+
+void CCD::queueStackFlush()
+{
+    std::lock_guard<std::mutex> lock(m_PipelineLock);
+    // Nothing was stacked if the pipeline never ran
+    if (m_PipelineThread.joinable() == false)
+        return;
+
+    m_PipelineQueue.push_back(nullptr);
+    m_PipelineCondition.notify_all();
+}
+
+void CCD::flushStack()
+{
+    CCDChip::Frame frame;
+
+    std::unique_lock<std::mutex> lock(m_StackLock);
+    if (m_Stacker.count() == 0)
+        return;
+
+    LOGF_INFO("Exposure aborted, uploading an incomplete stack of %u frames.", m_Stacker.count());
+    StackStatusNP[STACK_DEPTH].setValue(m_Stacker.count());
+    frame.readoutTime = std::chrono::steady_clock::now();
+    takeStack(frame);
+    lock.unlock();
+
+    StackStatusNP.setState(IPS_OK);
+    StackStatusNP.apply();
+
+    ExposureCompletePrivate(&PrimaryCCD, frame);
+}
+
+bool CCD::ExposureCompletePrivate(CCDChip * targetChip, CCDChip::Frame &frame)
 {
+    auto encodeStart = std::chrono::steady_clock::now();
+
     // save information used for the fits header
-    exposureDuration = targetChip->getExposureDuration();
-    strncpy(exposureStartTime, targetChip->getExposureStartTime(), MAXINDINAME);
+    exposureDuration = frame.exposureDuration;
+    strncpy(exposureStartTime, frame.exposureStartTime, MAXINDINAME);
 
     if(HasDSP())
     {
-        uint8_t* buf = static_cast<uint8_t*>(malloc(targetChip->getFrameBufferSize()));
-        memcpy(buf, targetChip->getFrameBuffer(), targetChip->getFrameBufferSize());
-        DSP->processBLOB(buf, 2, new int[2] { targetChip->getXRes() / targetChip->getBinX(), targetChip->getYRes() / targetChip->getBinY() },
-                         targetChip->getBPP());
+        uint8_t* buf = static_cast<uint8_t*>(malloc(frame.buffer.size()));
+        memcpy(buf, frame.buffer.data(), frame.buffer.size());
+        DSP->processBLOB(buf, 2, new int[2] { static_cast<int>(frame.xRes / frame.binX), static_cast<int>(frame.yRes / frame.binY) },
+                         frame.bpp);
         free(buf);
     }
 
-    if (processFastExposure(targetChip) == false)
-        return false;
+    // Calibrate light frames in place, so statistics and the uploaded frame are both calibrated.
+    // Bias, dark and flat frames are left raw, they are used to build masters.
+    // Stacked frames were calibrated one by one, they keep the calibration of their last frame.
+    if (frame.stackedFrames == 0)
+        m_FrameCalibrated = false;
+    if (frame.naxis == 2 && frame.stackedFrames == 0 && frame.frameType == CCDChip::LIGHT_FRAME && CalibrationSP[INDI_ENABLED].getState() == ISS_ON)
+    {
+        std::lock_guard<std::mutex> lock(m_CalibrationLock);
+        if (m_Calibration.isEmpty() == false)
+        {
+            uint32_t width  = frame.subW / frame.binX;
+            uint32_t height = frame.subH / frame.binY;
+            if (static_cast<size_t>(width) * height * (frame.bpp / 8) <= frame.buffer.size() &&
+                    m_Calibration.apply(frame.buffer.data(), width, height, frame.bpp, frame.subX / frame.binX,
+                                        frame.subY / frame.binY, frame.binX, frame.binY, frame.exposureDuration))
+            {
+                m_FrameCalibrated = true;
+                for (int i = 0; i < FrameCalibration::MASTER_COUNT; i++)
+                    m_AppliedCalibration[i] = m_Calibration.masterName(static_cast<FrameCalibration::MasterType>(i));
+                m_AppliedDarkScale = m_Calibration.darkScale(frame.exposureDuration);
+            }
+            else
+                LOGF_WARN("Calibration masters do not match the %ux%u frame at %u,%u binned %ux%u, frame is not calibrated.",
+                          width, height, frame.subX / frame.binX, frame.subY / frame.binY, frame.binX, frame.binY);
+        }
+    }
+
+    // Live stacking of the primary chip: only the stacked frame goes through the rest of the pipeline.
+    // A stack is uploaded once complete, or with the frames stacked so far when no exposure follows.
+    m_StackedFrames = frame.stackedFrames;
+    if (targetChip == &PrimaryCCD && frame.naxis == 2 && frame.stackedFrames == 0 && StackSP[STACK_OFF].getState() != ISS_ON)
+    {
+        uint32_t width  = frame.subW / frame.binX;
+        uint32_t height = frame.subH / frame.binY;
+        FrameStacker::AddResult result = FrameStacker::FRAME_REJECTED;
+
+        std::unique_lock<std::mutex> lock(m_StackLock);
+        if (static_cast<size_t>(width) * height * (frame.bpp / 8) <= frame.buffer.size())
+            result = m_Stacker.add(frame.buffer.data(), width, height, frame.bpp, frame.exposureDuration);
+        if (result != FrameStacker::FRAME_REJECTED && m_Stacker.count() == 1)
+        {
+            std::vector<uint8_t> buffer;
+            buffer.swap(frame.buffer);
+            m_StackFrame = frame;
+            frame.buffer.swap(buffer);
+        }
+        StackStatusNP[STACK_DEPTH].setValue(m_Stacker.count());
+        StackStatusNP[STACK_REJECTED].setValue(m_Stacker.rejected());
+
+        bool upload = result == FrameStacker::STACK_COMPLETE || (frame.sequenceEnd && m_Stacker.count() > 0);
+        if (upload)
+        {
+            if (result != FrameStacker::STACK_COMPLETE)
+                LOGF_INFO("Exposure sequence ended, uploading an incomplete stack of %u frames.", m_Stacker.count());
+            takeStack(frame);
+            m_StackedFrames = frame.stackedFrames;
+        }
+        lock.unlock();
+
+        StackStatusNP.setState(result == FrameStacker::FRAME_REJECTED ? IPS_ALERT : (upload ? IPS_OK : IPS_BUSY));
+        StackStatusNP.apply();
+
+        if (upload == false)
+        {
+            // Nothing to upload for the last exposure
+            if (frame.sequenceEnd)
+            {
+                LOG_ERROR("Frame was rejected by the stacker and no frame is stacked.");
+                targetChip->setExposureFailed();
+                return false;
+            }
+            return true;
+        }
+
+        exposureDuration = frame.exposureDuration;
+        strncpy(exposureStartTime, frame.exposureStartTime, MAXINDINAME);
+    }
+
+    // Only the regions of interest are uploaded when any is set
+    std::vector<FrameROI> rois;
+    if (targetChip == &PrimaryCCD && frame.naxis == 2)
+    {
+        std::lock_guard<std::mutex> lock(m_ROILock);
+        rois = m_ROIs;
+    }
+
+    // Statistics are published before the frame, so clients may decide not to download it.
+    m_FrameStatsValid = false;
+    if (frame.naxis == 2 && rois.empty())
+    {
+        size_t pixels = static_cast<size_t>(frame.subW / frame.binX) * (frame.subH / frame.binY);
+        std::unique_lock<std::mutex> lock(m_PipelineLock);
+        uint32_t bins = FrameHistogramNP.size();
+        lock.unlock();
+
+        if (pixels * (frame.bpp / 8) <= frame.buffer.size() &&
+                computeFrameStats(frame.buffer.data(), pixels, frame.bpp, bins, m_FrameStats))
+        {
+            m_FrameStatsValid = true;
+            FrameStatsNP[FRAME_STATS_MIN].setValue(m_FrameStats.min);
+            FrameStatsNP[FRAME_STATS_MAX].setValue(m_FrameStats.max);
+            FrameStatsNP[FRAME_STATS_MEAN].setValue(m_FrameStats.mean);
+            FrameStatsNP[FRAME_STATS_STDDEV].setValue(m_FrameStats.stddev);
+            FrameStatsNP[FRAME_STATS_MEDIAN].setValue(m_FrameStats.median);
+            FrameStatsNP.setState(IPS_OK);
+            FrameStatsNP.apply();
+
+            lock.lock();
+            if (FrameHistogramNP.size() == m_FrameStats.histogram.size() && FrameHistogramNP.size() > 0)
+            {
+                for (size_t i = 0; i < FrameHistogramNP.size(); i++)
+                    FrameHistogramNP[i].setValue(m_FrameStats.histogram[i]);
+                FrameHistogramNP.setState(IPS_OK);
+                FrameHistogramNP.apply();
+            }
+        }
+    }
+
+    // Like statistics, star metrics are published before the frame
+    if (targetChip == &PrimaryCCD && frame.naxis == 2)
+        detectFrameStars(frame);
 
     bool sendImage = (UploadS[UPLOAD_CLIENT].s == ISS_ON || UploadS[UPLOAD_BOTH].s == ISS_ON);
     bool saveImage = (UploadS[UPLOAD_LOCAL].s == ISS_ON || UploadS[UPLOAD_BOTH].s == ISS_ON);
 
     // Do not send or save an empty image.
-    if (targetChip->getFrameBufferSize() == 0)
+    if (frame.buffer.empty())
         sendImage = saveImage = false;
 
+    std::chrono::steady_clock::time_point uploadStart;
+
     if (sendImage || saveImage)
     {
-        if (EncodeFormatSP[FORMAT_FITS].getState() == ISS_ON)
+        if (!rois.empty())
+        {
+            ROIFrame roiFrame;
+            roiFrame.x      = frame.subX;
+            roiFrame.y      = frame.subY;
+            roiFrame.width  = frame.subW / frame.binX;
+            roiFrame.height = frame.subH / frame.binY;
+            roiFrame.binX   = frame.binX;
+            roiFrame.binY   = frame.binY;
+            roiFrame.bpp    = frame.bpp;
+
+            std::vector<uint8_t> packed;
+            if (static_cast<size_t>(roiFrame.width) * roiFrame.height * (frame.bpp / 8) > frame.buffer.size() ||
+                    packROIs(frame.buffer.data(), roiFrame, rois, frame.exposureDuration, packed) == false)
+            {
+                LOG_ERROR("Failed to crop regions of interest.");
+                targetChip->setExposureFailed();
+                return false;
+            }
+
+            // The chip extension is left alone, the main thread may read or change it meanwhile
+            uploadStart = std::chrono::steady_clock::now();
+            bool rc = uploadFile(targetChip, packed.data(), packed.size(), "rois", sendImage, saveImage);
+
+            if (rc == false)
+            {
+                targetChip->setExposureFailed();
+                return false;
+            }
+        }
+        else if (EncodeFormatSP[FORMAT_FITS].getState() == ISS_ON)
         {
             int img_type  = 0;
             int byte_type = 0;
             int status    = 0;
-            long naxis    = targetChip->getNAxis();
+            long naxis    = frame.naxis;
             long naxes[3];
             int nelements = 0;
             std::string bit_depth;
             char error_status[MAXRBUF];
 
-            naxes[0] = targetChip->getSubW() / targetChip->getBinX();
-            naxes[1] = targetChip->getSubH() / targetChip->getBinY();
+            naxes[0] = frame.subW / frame.binX;
+            naxes[1] = frame.subH / frame.binY;
 
-            switch (targetChip->getBPP())
+            switch (frame.bpp)
             {
                 case 8:
                     byte_type = TBYTE;
@@ -2206,7 +3149,7 @@ bool CCD::ExposureCompletePrivate(CCDChip * targetChip)
                     break;
 
                 default:
-                    LOGF_ERROR("Unsupported bits per pixel value %d", targetChip->getBPP());
+                    LOGF_ERROR("Unsupported bits per pixel value %d", frame.bpp);
                     return false;
             }
 
@@ -2220,69 +3163,83 @@ bool CCD::ExposureCompletePrivate(CCDChip * targetChip)
             /*DEBUGF(Logger::DBG_DEBUG, "Exposure complete. Image Depth: %s. Width: %d Height: %d nelements: %d", bit_depth.c_str(), naxes[0],
                     naxes[1], nelements);*/
 
-            std::unique_lock<std::mutex> guard(ccdBufferLock);
-
-            // 8640 = 2880 * 3 which is sufficient for most cases.
-            uint32_t size = 8640 + nelements * (targetChip->getBPP() / 8);
-            //  Initialize FITS file.
-            if (targetChip->openFITSFile(size, status) == false)
+            void * fitsData = nullptr;
+            size_t fitsSize = 0;
+            if (writeFITSDirect(targetChip, frame, naxis, naxes, &fitsData, &fitsSize))
             {
-                fits_report_error(stderr, status); /* print out any error messages */
-                fits_get_errstatus(status, error_status);
-                LOGF_ERROR("FITS Error: %s", error_status);
-                return false;
-            }
-
-            auto fptr = *targetChip->fitsFilePointer();
+                uploadStart = std::chrono::steady_clock::now();
+                bool rc = uploadFile(targetChip, fitsData, fitsSize, frame.extension, sendImage, saveImage);
 
-            fits_create_img(fptr, img_type, naxis, naxes, &status);
+                IDSharedBlobFree(fitsData);
 
-            if (status)
-            {
-                fits_report_error(stderr, status); /* print out any error messages */
-                fits_get_errstatus(status, error_status);
-                LOGF_ERROR("FITS Error: %s", error_status);
-                targetChip->closeFITSFile();
-                return false;
+                if (rc == false)
+                {
+                    targetChip->setExposureFailed();
+                    return false;
+                }
             }
+            else
+            {
+                // Write the image with cfitsio, for frames or keywords the direct writer does not handle.
+                // 8640 = 2880 * 3 which is sufficient for most cases.
+                uint32_t size = 8640 + nelements * (frame.bpp / 8);
+                //  Initialize FITS file.
+                if (targetChip->openFITSFile(size, status) == false)
+                {
+                    fits_report_error(stderr, status); /* print out any error messages */
+                    fits_get_errstatus(status, error_status);
+                    LOGF_ERROR("FITS Error: %s", error_status);
+                    return false;
+                }
 
-            addFITSKeywords(targetChip);
+                auto fptr = *targetChip->fitsFilePointer();
 
-            fits_write_img(fptr, byte_type, 1, nelements, targetChip->getFrameBuffer(), &status);
-            fits_flush_file(fptr, &status);
+                fits_create_img(fptr, img_type, naxis, naxes, &status);
 
-            if (status)
-            {
-                fits_report_error(stderr, status); /* print out any error messages */
-                fits_get_errstatus(status, error_status);
-                LOGF_ERROR("FITS Error: %s", error_status);
-                targetChip->closeFITSFile();
-                return false;
-            }
+                if (status)
+                {
+                    fits_report_error(stderr, status); /* print out any error messages */
+                    fits_get_errstatus(status, error_status);
+                    LOGF_ERROR("FITS Error: %s", error_status);
+                    targetChip->closeFITSFile();
+                    return false;
+                }
 
+                m_EncodingFrame = &frame;
+                addFITSKeywords(targetChip);
+                m_EncodingFrame = nullptr;
 
-            bool rc = uploadFile(targetChip, *(targetChip->fitsMemoryBlockPointer()), *(targetChip->fitsMemorySizePointer()), sendImage,
-                                 saveImage);
+                fits_write_img(fptr, byte_type, 1, nelements, const_cast<uint8_t *>(frame.buffer.data()), &status);
+                fits_flush_file(fptr, &status);
 
-            targetChip->closeFITSFile();
+                if (status)
+                {
+                    fits_report_error(stderr, status); /* print out any error messages */
+                    fits_get_errstatus(status, error_status);
+                    LOGF_ERROR("FITS Error: %s", error_status);
+                    targetChip->closeFITSFile();
+                    return false;
+                }
 
-            guard.unlock();
+                uploadStart = std::chrono::steady_clock::now();
+                bool rc = uploadFile(targetChip, *(targetChip->fitsMemoryBlockPointer()), *(targetChip->fitsMemorySizePointer()),
+                                     frame.extension, sendImage, saveImage);
 
-            if (rc == false)
-            {
-                targetChip->setExposureFailed();
-                return false;
+                targetChip->closeFITSFile();
+
+                if (rc == false)
+                {
+                    targetChip->setExposureFailed();
+                    return false;
+                }
             }
         }
         else
         {
-            // If image extension was set to fits (default), change if bin if not already set to another format by the driver.
-            if (!strcmp(targetChip->getImageExtension(), "fits"))
-                targetChip->setImageExtension("bin");
-            std::unique_lock<std::mutex> guard(ccdBufferLock);
-            bool rc = uploadFile(targetChip, targetChip->getFrameBuffer(), targetChip->getFrameBufferSize(), sendImage,
-                                 saveImage);
-            guard.unlock();
+            // If image extension was set to fits (default), upload as bin if not already set to another format by the driver.
+            const char * extension = strcmp(frame.extension, "fits") ? frame.extension : "bin";
+            uploadStart = std::chrono::steady_clock::now();
+            bool rc = uploadFile(targetChip, frame.buffer.data(), frame.buffer.size(), extension, sendImage, saveImage);
 
             if (rc == false)
             {
@@ -2291,27 +3248,106 @@ bool CCD::ExposureCompletePrivate(CCDChip * targetChip)
             }
         }
     }
+    else
+        uploadStart = std::chrono::steady_clock::now();
+
+    auto uploadEnd = std::chrono::steady_clock::now();
+    PipelineNP[PIPELINE_WAIT].setValue(std::chrono::duration<double, std::milli>(encodeStart - frame.readoutTime).count());
+    PipelineNP[PIPELINE_ENCODE].setValue(std::chrono::duration<double, std::milli>(uploadStart - encodeStart).count());
+    PipelineNP[PIPELINE_UPLOAD].setValue(std::chrono::duration<double, std::milli>(uploadEnd - uploadStart).count());
 
     if (FastExposureToggleS[INDI_ENABLED].s != ISS_ON)
         targetChip->setExposureComplete();
     return true;
 }
 
-bool CCD::uploadFile(CCDChip * targetChip, const void * fitsData, size_t totalBytes, bool sendImage,
-                     bool saveImage)
+bool CCD::writeFITSDirect(CCDChip * targetChip, const CCDChip::Frame &frame, long naxis, const long * naxes,
+                          void ** fitsData, size_t * totalBytes)
 {
-    uint8_t * compressedData = nullptr;
+    int status = 0;
+
+    size_t pixels = static_cast<size_t>(naxes[0]) * naxes[1] * (naxis == 3 ? naxes[2] : 1);
+    if (fitsImageSize(0, frame.bpp, naxis, naxes) == 0 || pixels * (frame.bpp / 8) > frame.buffer.size())
+        return false;
+
+    // Collect keywords in a header only file, so drivers overriding addFITSKeywords() keep working.
+    if (targetChip->openFITSHeader(status) == false)
+        return false;
+
+    m_EncodingFrame = &frame;
+    addFITSKeywords(targetChip);
+    m_EncodingFrame = nullptr;
+
+    auto fptr = *targetChip->fitsFilePointer();
+    int nkeys = 0;
+    fits_get_hdrspace(fptr, &nkeys, nullptr, &status);
+
+    std::vector<std::string> cards;
+    cards.reserve(nkeys);
+    for (int i = 1; i <= nkeys && status == 0; i++)
+    {
+        char card[FLEN_CARD] = {0};
+        fits_read_record(fptr, i, card, &status);
+
+        char keyword[FLEN_KEYWORD] = {0};
+        int length = 0;
+        fits_get_keyname(card, keyword, &length, &status);
+
+        // Image keywords are written for the actual frame
+        if (!strcmp(keyword, "SIMPLE") || !strcmp(keyword, "BITPIX") || !strncmp(keyword, "NAXIS", 5) ||
+                !strcmp(keyword, "EXTEND"))
+            continue;
+
+        // Scaled data must be written by cfitsio
+        if (!strcmp(keyword, "BZERO") || !strcmp(keyword, "BSCALE"))
+        {
+            targetChip->closeFITSFile();
+            return false;
+        }
+
+        cards.emplace_back(card);
+    }
+
+    targetChip->closeFITSFile();
+
+    if (status)
+    {
+        char error_status[MAXRBUF];
+        fits_get_errstatus(status, error_status);
+        LOGF_DEBUG("FITS header error: %s", error_status);
+        return false;
+    }
+
+    size_t size = fitsImageSize(cards.size(), frame.bpp, naxis, naxes);
+    void * blob = IDSharedBlobAlloc(size);
+    if (blob == nullptr)
+        return false;
+
+    if (writeFITSImage(cards, frame.buffer.data(), frame.bpp, naxis, naxes, static_cast<uint8_t *>(blob), size) == false)
+    {
+        IDSharedBlobFree(blob);
+        return false;
+    }
+
+    *fitsData = blob;
+    *totalBytes = size;
+    return true;
+}
+
+bool CCD::uploadFile(CCDChip * targetChip, const void * fitsData, size_t totalBytes, const char * extension,
+                     bool sendImage, bool saveImage)
+{
+    std::vector<uint8_t> compressedData;
 
     DEBUGF(Logger::DBG_DEBUG, "Uploading file. Ext: %s, Size: %d, sendImage? %s, saveImage? %s",
-           targetChip->getImageExtension(), totalBytes, sendImage ? "Yes" : "No", saveImage ? "Yes" : "No");
+           extension, totalBytes, sendImage ? "Yes" : "No", saveImage ? "Yes" : "No");
 
     if (saveImage)
     {
         targetChip->FitsB.blob    = const_cast<void *>(fitsData);
         targetChip->FitsB.bloblen = totalBytes;
-        snprintf(targetChip->FitsB.format, MAXINDIBLOBFMT, ".%s", targetChip->getImageExtension());
+        snprintf(targetChip->FitsB.format, MAXINDIBLOBFMT, ".%s", extension);
 
-        FILE * fp = nullptr;
         char imageFileName[MAXRBUF];
 
         std::string prefix = UploadSettingsT[UPLOAD_PREFIX].text;
@@ -2345,79 +3381,92 @@ bool CCD::uploadFile(CCDChip * targetChip, const void * fitsData, size_t totalBy
 
         snprintf(imageFileName, MAXRBUF, "%s/%s%s", UploadSettingsT[0].text, prefix.c_str(), targetChip->FitsB.format);
 
-        fp = fopen(imageFileName, "w");
-        if (fp == nullptr)
+        // The file name is reported once the image is on disk
+        auto saved = [this](const std::string & path, int error)
         {
-            LOGF_ERROR("Unable to save image file (%s). %s", imageFileName, strerror(errno));
-            return false;
-        }
-
-        int n = 0;
-        for (int nr = 0; nr < targetChip->FitsB.bloblen; nr += n)
-            n = fwrite((static_cast<char *>(targetChip->FitsB.blob) + nr), 1, targetChip->FitsB.bloblen - nr, fp);
+            // Called from the writer thread
+            std::lock_guard<std::mutex> lock(m_FileNameLock);
+            if (error != 0)
+            {
+                LOGF_ERROR("Unable to save image file (%s). %s", path.c_str(), strerror(error));
+                FileNameTP.s = IPS_ALERT;
+                IDSetText(&FileNameTP, nullptr);
+                return;
+            }
 
-        fclose(fp);
+            // Save image file path
+            IUSaveText(&FileNameT[0], path.c_str());
 
-        // Save image file path
-        IUSaveText(&FileNameT[0], imageFileName);
+            DEBUGF(Logger::DBG_SESSION, "Image saved to %s", path.c_str());
+            FileNameTP.s = IPS_OK;
+            IDSetText(&FileNameTP, nullptr);
+        };
 
-        DEBUGF(Logger::DBG_SESSION, "Image saved to %s", imageFileName);
-        FileNameTP.s = IPS_OK;
-        IDSetText(&FileNameTP, nullptr);
+        if (m_FileWriter.write(imageFileName, fitsData, totalBytes, saved) == false)
+        {
+            LOGF_ERROR("Unable to save image file (%s). %s", imageFileName, strerror(ENOMEM));
+            return false;
+        }
     }
 
     if (targetChip->SendCompressed)
     {
-        if (EncodeFormatSP[FORMAT_FITS].getState() == ISS_ON && !strcmp(targetChip->getImageExtension(), "fits"))
-        {
-            fpstate	fpvar;
-            fp_init (&fpvar);
-            size_t compressedBytes = 0;
-            int islossless = 0;
-            if (fp_pack_data_to_data(reinterpret_cast<const char *>(fitsData), totalBytes, &compressedData, &compressedBytes, fpvar,
-                                     &islossless) < 0)
-            {
-                free(compressedData);
-                LOG_ERROR("Error: Ran out of memory compressing image");
-                return false;
+        int codec = CompressionCodecSP.findOnSwitchIndex();
+        int level = static_cast<int>(CompressionLevelNP[0].getValue());
+        bool isFITS = EncodeFormatSP[FORMAT_FITS].getState() == ISS_ON && !strcmp(extension, "fits");
+
+        if (isFITS && (codec == CODEC_RICE || codec == CODEC_GZIP2))
+        {
+            FITSTileCompression compression = (codec == CODEC_RICE) ? FITS_TILE_RICE : FITS_TILE_GZIP2;
+            if (compressFITSTiles(static_cast<const uint8_t *>(fitsData), totalBytes, compression, level, compressedData) == false)
+            {
+                // Floating point images are left to fpack
+                fpstate	fpvar;
+                fp_init (&fpvar);
+                fpvar.comptype = (codec == CODEC_RICE) ? RICE_1 : GZIP_2;
+                unsigned char *packedData = nullptr;
+                size_t packedBytes = 0;
+                int islossless = 0;
+                if (fp_pack_data_to_data(reinterpret_cast<const char *>(fitsData), totalBytes, &packedData, &packedBytes, fpvar,
+                                         &islossless) < 0)
+                {
+                    free(packedData);
+                    LOG_ERROR("Error: Ran out of memory compressing image");
+                    return false;
+                }
+
+                compressedData.assign(packedData, packedData + packedBytes);
+                free(packedData);
             }
 
-            targetChip->FitsB.blob    = compressedData;
-            targetChip->FitsB.bloblen = compressedBytes;
-            snprintf(targetChip->FitsB.format, MAXINDIBLOBFMT, ".%s.fz", targetChip->getImageExtension());
+            snprintf(targetChip->FitsB.format, MAXINDIBLOBFMT, ".%s.fz", extension);
         }
         else
         {
-            uLong compressedBytes = sizeof(char) * totalBytes + totalBytes / 64 + 16 + 3;
-            compressedData  = new uint8_t[compressedBytes];
+            CompressionCodec compression = COMPRESSION_ZLIB;
+            if (codec == CODEC_ZSTD)
+                compression = COMPRESSION_ZSTD;
+            else if (codec == CODEC_LZ4)
+                compression = COMPRESSION_LZ4;
 
-            if (fitsData == nullptr || compressedData == nullptr)
+            if (compressBuffer(fitsData, totalBytes, compression, level, compressedData) == false)
             {
-                if (compressedData)
-                    delete [] compressedData;
-                LOG_ERROR("Error: Ran out of memory compressing image");
-                return false;
-            }
-
-            int r = compress2(compressedData, &compressedBytes, (const Bytef *)fitsData, totalBytes, 9);
-            if (r != Z_OK)
-            {
-                /* this should NEVER happen */
                 LOG_ERROR("Error: Failed to compress image");
-                delete [] compressedData;
                 return false;
             }
 
-            targetChip->FitsB.blob    = compressedData;
-            targetChip->FitsB.bloblen = compressedBytes;
-            snprintf(targetChip->FitsB.format, MAXINDIBLOBFMT, ".%s.z", targetChip->getImageExtension());
+            snprintf(targetChip->FitsB.format, MAXINDIBLOBFMT, ".%s%s", extension,
+                     compressionSuffix(compression));
         }
+
+        targetChip->FitsB.blob    = compressedData.data();
+        targetChip->FitsB.bloblen = compressedData.size();
     }
     else
     {
         targetChip->FitsB.blob    = const_cast<void *>(fitsData);
         targetChip->FitsB.bloblen = totalBytes;
-        snprintf(targetChip->FitsB.format, MAXINDIBLOBFMT, ".%s", targetChip->getImageExtension());
+        snprintf(targetChip->FitsB.format, MAXINDIBLOBFMT, ".%s", extension);
     }
 
     targetChip->FitsB.size = totalBytes;
@@ -2449,9 +3498,6 @@ bool CCD::uploadFile(CCDChip * targetChip, const void * fitsData, size_t totalBy
         }
     }
 
-    if (compressedData)
-        delete [] compressedData;
-
     DEBUG(Logger::DBG_DEBUG, "Upload complete");
 
     return true;
@@ -2490,28 +3536,14 @@ bool CCD::processFastExposure(CCDChip * targetChip)
             FastExposureCountN[0].value--;
             IDSetNumber(&FastExposureCountNP, nullptr);
 
-            if (UploadS[UPLOAD_LOCAL].s == ISS_ON || m_UploadTime < duration)
-            {
-                if (StartExposure(duration))
-                    PrimaryCCD.ImageExposureNP.s = IPS_BUSY;
-                else
-                    PrimaryCCD.ImageExposureNP.s = IPS_ALERT;
-                if (duration * 1000 < getCurrentPollingPeriod())
-                    setCurrentPollingPeriod(duration * 950);
-            }
+            // Frames are encoded and uploaded in the background, a slow upload only delays the
+            // next exposure once the frame ring is full.
+            if (StartExposure(duration))
+                PrimaryCCD.ImageExposureNP.s = IPS_BUSY;
             else
-            {
-                LOGF_ERROR("Rapid exposure not possible since upload time is %.2f seconds while exposure time is %.2f seconds.",
-                           m_UploadTime,
-                           duration);
                 PrimaryCCD.ImageExposureNP.s = IPS_ALERT;
-                IDSetNumber(&PrimaryCCD.ImageExposureNP, nullptr);
-                FastExposureCountN[0].value = 1;
-                FastExposureCountNP.s = IPS_IDLE;
-                IDSetNumber(&FastExposureCountNP, nullptr);
-                m_UploadTime = 0;
-                return false;
-            }
+            if (duration * 1000 < getCurrentPollingPeriod())
+                setCurrentPollingPeriod(duration * 950);
         }
         else
         {
@@ -2555,6 +3587,14 @@ bool CCD::saveConfigItems(FILE * fp)
     IUSaveConfigSwitch(fp, &FastExposureToggleSP);
 
     IUSaveConfigSwitch(fp, &PrimaryCCD.CompressSP);
+    IUSaveConfigSwitch(fp, &CompressionCodecSP);
+    IUSaveConfigNumber(fp, &CompressionLevelNP);
+    IUSaveConfigSwitch(fp, &CalibrationSP);
+    IUSaveConfigText(fp, &CalibrationFilesTP);
+    IUSaveConfigNumber(fp, &StackSettingsNP);
+    IUSaveConfigSwitch(fp, &StackAlignSP);
+    IUSaveConfigSwitch(fp, &StarDetectionSP);
+    IUSaveConfigNumber(fp, &StarDetectionSettingsNP);
 
     IUSaveConfigSwitch(fp, &CaptureFormatSP);
     IUSaveConfigSwitch(fp, &EncodeFormatSP);
@@ -2562,6 +3602,8 @@ bool CCD::saveConfigItems(FILE * fp)
     if (HasCooler())
         IUSaveConfigNumber(fp, &TemperatureRampNP);
 
+    IUSaveConfigNumber(fp, &FrameStatsSettingsNP);
+
     if (HasGuideHead())
     {
         IUSaveConfigSwitch(fp, &GuideCCD.CompressSP);
@@ -2614,68 +3656,16 @@ IPState CCD::GuideWest(uint32_t ms)
     return IPS_ALERT;
 }
 
-void CCD::getMinMax(double * min, double * max, CCDChip * targetChip)
+void CCD::resizeFrameHistogram()
 {
-    int ind         = 0, i, j;
-    int imageHeight = targetChip->getSubH() / targetChip->getBinY();
-    int imageWidth  = targetChip->getSubW() / targetChip->getBinX();
-    double lmin = 0, lmax = 0;
-
-    switch (targetChip->getBPP())
+    FrameHistogramNP.resize(static_cast<size_t>(FrameStatsSettingsNP[0].getValue()));
+    for (size_t i = 0; i < FrameHistogramNP.size(); i++)
     {
-        case 8:
-        {
-            uint8_t * imageBuffer = targetChip->getFrameBuffer();
-            lmin = lmax = imageBuffer[0];
-
-            for (i = 0; i < imageHeight; i++)
-                for (j = 0; j < imageWidth; j++)
-                {
-                    ind = (i * imageWidth) + j;
-                    if (imageBuffer[ind] < lmin)
-                        lmin = imageBuffer[ind];
-                    else if (imageBuffer[ind] > lmax)
-                        lmax = imageBuffer[ind];
-                }
-        }
-        break;
-
-        case 16:
-        {
-            uint16_t * imageBuffer = reinterpret_cast<uint16_t*>(targetChip->getFrameBuffer());
-            lmin = lmax = imageBuffer[0];
-
-            for (i = 0; i < imageHeight; i++)
-                for (j = 0; j < imageWidth; j++)
-                {
-                    ind = (i * imageWidth) + j;
-                    if (imageBuffer[ind] < lmin)
-                        lmin = imageBuffer[ind];
-                    else if (imageBuffer[ind] > lmax)
-                        lmax = imageBuffer[ind];
-                }
-        }
-        break;
-
-        case 32:
-        {
-            uint32_t * imageBuffer = reinterpret_cast<uint32_t*>(targetChip->getFrameBuffer());
-            lmin = lmax = imageBuffer[0];
-
-            for (i = 0; i < imageHeight; i++)
-                for (j = 0; j < imageWidth; j++)
-                {
-                    ind = (i * imageWidth) + j;
-                    if (imageBuffer[ind] < lmin)
-                        lmin = imageBuffer[ind];
-                    else if (imageBuffer[ind] > lmax)
-                        lmax = imageBuffer[ind];
-                }
-        }
-        break;
+        char name[MAXINDINAME], label[MAXINDILABEL];
+        snprintf(name, MAXINDINAME, "BIN_%zu", i);
+        snprintf(label, MAXINDILABEL, "Bin %zu", i);
+        FrameHistogramNP[i].fill(name, label, "%.f", 0, 4294967295.0, 0, 0);
     }
-    *min = lmin;
-    *max = lmax;
 }
 
 std::string regex_replace_compat(const std::string &input, const std::string &pattern, const std::string &replace)
@@ -2689,6 +3679,16 @@ int CCD::getFileIndex(const char * dir, const char * prefix, const char * ext)
 {
     INDI_UNUSED(ext);
 
+    // Files are written asynchronously, so the directory may not hold the last ones yet. The index is
+    // scanned once, then counted up until the directory or prefix change.
+    std::unique_lock<std::mutex> lock(m_FileNameLock);
+    if (m_NextFileIndex > 0 && m_FileIndexDir == dir && m_FileIndexPrefix == prefix)
+        return m_NextFileIndex++;
+    lock.unlock();
+
+    // Complete pending writes, so the scan sees all files. Their callbacks take m_FileNameLock.
+    m_FileWriter.flush();
+
     DIR * dpdf = nullptr;
     struct dirent * epdf = nullptr;
     std::vector<std::string> files = std::vector<std::string>();
@@ -2747,6 +3747,11 @@ int CCD::getFileIndex(const char * dir, const char * prefix, const char * ext)
     }
 
     closedir(dpdf);
+
+    lock.lock();
+    m_FileIndexDir    = dir;
+    m_FileIndexPrefix = prefix;
+    m_NextFileIndex   = maxIndex + 2;
     return (maxIndex + 1);
 }
 
@@ -27,10 +27,18 @@
 #pragma once
 
 #include "indiccdchip.h"
+#include "indiframestats.h"
+#include "indifilewriter.h"
+#include "indicalibration.h"
+#include "indistacker.h"
+#include "indiroi.h"
+#include "indistardetection.h"
 #include "defaultdevice.h"
 #include "indiguiderinterface.h"
 #include "indipropertynumber.h"
 #include "indipropertyswitch.h"
+#include "indipropertytext.h"
+#include "indipropertyblob.h"
 #include "inditimer.h"
 #include "indielapsedtimer.h"
 #include "dsp/manager.h"
@@ -48,6 +56,8 @@
 #include <stdint.h>
 #include <mutex>
 #include <thread>
+#include <condition_variable>
+#include <deque>
 
 extern const char * IMAGE_SETTINGS_TAB;
 extern const char * IMAGE_INFO_TAB;
@@ -90,6 +100,12 @@ class StreamManager;
  * approach unless for the most demanding and FPS sensitive tasks.
  *
  * INDI::CCD and INDI::StreamManager both upload frames asynchrounously in a worker thread.
+ * ExposureComplete() copies the frame into a ring of frames waiting to be encoded and uploaded, so the
+ * next exposure can start right away. When the ring is full, ExposureComplete() waits for a free slot.
+ * The frame is copied before ExposureComplete() returns, so the buffer may be written again right after.
+ * The worker thread calls driver overrides such as addFITSKeywords(). It uploads the queued frames and exits
+ * when a client disconnects the CCD, before Disconnect() is called, and when the driver exits, before the
+ * driver is destroyed. Drivers have nothing to stop in Disconnect() or their destructor.
  * The CCD Buffer data is protected by the ccdBufferLock mutex. When reading the camera data
  * and writing to the buffer, it must be first locked by the mutex. After the write is complete
  * release the lock. For example:
@@ -358,6 +374,16 @@ class CCD : public DefaultDevice, GuiderInterface
          */
         virtual bool UpdateGuiderFrame(int x, int y, int w, int h);
 
+        /**
+         * \brief CCD calls this function when the regions of interest of the primary CCD change.
+         * While any region is set, only the regions are cropped from each frame and uploaded, packed
+         * with packROIs(). Drivers able to read out several regions may override this function to
+         * program them, and must still place them at their position in the frame buffer.
+         * \param rois regions of interest in unbinned pixels, empty to upload full frames again.
+         * \return true if the regions are accepted, false otherwise.
+         */
+        virtual bool UpdateCCDROIs(const std::vector<FrameROI> &rois);
+
         /**
          * \brief CCD calls this function when CCD Binning needs to be updated in the hardware.
          * Derived classes should implement this function
@@ -703,6 +729,20 @@ class CCD : public DefaultDevice, GuiderInterface
             FORMAT_NATIVE    /*!< Save Image as the native format of the camera itself. */
         };
 
+        /// Codec used when compression is enabled. Rice and GZIP 2 produce tile compressed FITS files, other formats use zlib.
+        INDI::PropertySwitch CompressionCodecSP {5};
+        enum
+        {
+            CODEC_RICE,      /*!< Tile compressed FITS, RICE_1 */
+            CODEC_GZIP2,     /*!< Tile compressed FITS, GZIP_2 */
+            CODEC_ZLIB,      /*!< zlib stream */
+            CODEC_ZSTD,      /*!< zstd frames, if supported by the build */
+            CODEC_LZ4        /*!< lz4 frames, if supported by the build */
+        };
+
+        /// Compression level, from 1 (fastest) to 9 (smallest).
+        INDI::PropertyNumber CompressionLevelNP {1};
+
         ISwitch UploadS[3];
         ISwitchVectorProperty UploadSP;
 
@@ -758,6 +798,109 @@ class CCD : public DefaultDevice, GuiderInterface
         double m_UploadTime = { 0 };
         std::chrono::system_clock::time_point FastExposureToggleStartup;
 
+        /// Post-exposure pipeline: frames waiting to be encoded and uploaded, and latency of each stage for the last frame.
+        INDI::PropertyNumber PipelineNP {5};
+        enum
+        {
+            PIPELINE_OCCUPANCY,     /*!< Frames waiting in the ring of the primary chip */
+            PIPELINE_CAPACITY,      /*!< Size of the ring of the primary chip */
+            PIPELINE_WAIT,          /*!< Milliseconds between readout and start of encoding */
+            PIPELINE_ENCODE,        /*!< Milliseconds spent in DSP and FITS encoding */
+            PIPELINE_UPLOAD         /*!< Milliseconds spent in compression, saving and upload */
+        };
+
+        /// Statistics of the last 2D frame, published before the frame is uploaded.
+        INDI::PropertyNumber FrameStatsNP {5};
+        enum
+        {
+            FRAME_STATS_MIN,
+            FRAME_STATS_MAX,
+            FRAME_STATS_MEAN,
+            FRAME_STATS_STDDEV,
+            FRAME_STATS_MEDIAN
+        };
+
+        /// Number of bins of FrameHistogramNP, 0 disables the histogram.
+        INDI::PropertyNumber FrameStatsSettingsNP {1};
+
+        /// Histogram of the last 2D frame, with bins spread over [min, max].
+        INDI::PropertyNumber FrameHistogramNP {0};
+
+        /// Toggle calibration of 2D light frames with the loaded masters.
+        INDI::PropertySwitch CalibrationSP {2};
+
+        /// Paths of the master FITS files on disk, an empty path unloads the master.
+        INDI::PropertyText CalibrationFilesTP {3};
+
+        /// Master FITS files uploaded by the client.
+        INDI::PropertyBlob CalibrationMastersBP {3};
+        enum
+        {
+            CALIBRATION_BIAS,
+            CALIBRATION_DARK,
+            CALIBRATION_FLAT
+        };
+
+        /// Live stacking of the primary chip: frames of a fast exposure sequence are accumulated in the driver, and only
+        /// the stacked frame is uploaded. A stack cut short by the end of the sequence or an abort is uploaded incomplete.
+        INDI::PropertySwitch StackSP {4};
+        enum
+        {
+            STACK_OFF,
+            STACK_MEAN,
+            STACK_SUM,
+            STACK_SIGMA_CLIP
+        };
+
+        /// Number of frames in a stack, and clipping threshold in standard deviations.
+        INDI::PropertyNumber StackSettingsNP {2};
+        enum
+        {
+            STACK_FRAMES,
+            STACK_SIGMA
+        };
+
+        /// Toggle star alignment of stacked frames.
+        INDI::PropertySwitch StackAlignSP {2};
+
+        /// Regions of interest of the primary CCD, MAX_ROIS rectangles of X, Y, WIDTH, HEIGHT. Empty rectangles are unused.
+        static constexpr uint32_t MAX_ROIS = 8;
+        INDI::PropertyNumber ROIsNP {MAX_ROIS * 4};
+
+        /// Frames in the current stack, and frames rejected since stacking was enabled.
+        INDI::PropertyNumber StackStatusNP {2};
+        enum
+        {
+            STACK_DEPTH,
+            STACK_REJECTED
+        };
+
+        /// Toggle detection of stars in 2D frames of the primary CCD.
+        INDI::PropertySwitch StarDetectionSP {2};
+
+        /// Detection threshold in standard deviations of the background noise, and number of stars listed in StarListTP.
+        INDI::PropertyNumber StarDetectionSettingsNP {2};
+        enum
+        {
+            STAR_DETECTION_THRESHOLD,
+            STAR_DETECTION_STARS
+        };
+
+        /// Metrics of the stars of the last frame, sizes in frame pixels. HFR, FWHM and eccentricity are medians.
+        INDI::PropertyNumber StarMetricsNP {6};
+        enum
+        {
+            STAR_METRICS_COUNT,
+            STAR_METRICS_HFR,
+            STAR_METRICS_FWHM,
+            STAR_METRICS_ECCENTRICITY,
+            STAR_METRICS_BACKGROUND,
+            STAR_METRICS_NOISE
+        };
+
+        /// Brightest stars of the last frame as "x,y,flux,hfr,fwhm" separated by ";", in frame pixels.
+        INDI::PropertyText StarListTP {1};
+
         // FITS Header
         IText FITSHeaderT[2] {};
         ITextVectorProperty FITSHeaderTP;
@@ -778,10 +921,88 @@ class CCD : public DefaultDevice, GuiderInterface
         ///////////////////////////////////////////////////////////////////////////////
         /// Utility Functions
         ///////////////////////////////////////////////////////////////////////////////
-        bool uploadFile(CCDChip * targetChip, const void * fitsData, size_t totalBytes, bool sendImage, bool saveImage);
-        void getMinMax(double * min, double * max, CCDChip * targetChip);
+        bool uploadFile(CCDChip * targetChip, const void * fitsData, size_t totalBytes, const char * extension, bool sendImage,
+                        bool saveImage);
+        /** @brief Resize FrameHistogramNP to the number of bins in FrameStatsSettingsNP. m_PipelineLock must be held. */
+        void resizeFrameHistogram();
+        /** @brief Next free index of files named prefix in dir. Directories are scanned once, then the index is cached. */
         int getFileIndex(const char * dir, const char * prefix, const char * ext);
-        bool ExposureCompletePrivate(CCDChip * targetChip);
+        bool ExposureCompletePrivate(CCDChip * targetChip, CCDChip::Frame &frame);
+        /**
+         * @brief Write frame as a FITS file into a shared BLOB sized for it, without going through cfitsio for
+         * the image data. Only the keywords of addFITSKeywords() are collected with cfitsio.
+         * @param fitsData FITS file, to be freed with IDSharedBlobFree.
+         * @param totalBytes size of the FITS file in bytes.
+         * @return True on success, false if the frame is not supported and must be written with cfitsio.
+         */
+        bool writeFITSDirect(CCDChip * targetChip, const CCDChip::Frame &frame, long naxis, const long * naxes,
+                             void ** fitsData, size_t * totalBytes);
+
+        ///////////////////////////////////////////////////////////////////////////////
+        /// Post-exposure pipeline
+        ///////////////////////////////////////////////////////////////////////////////
+        /** @brief Copy the frame of targetChip to its ring, waiting for a free slot if needed. */
+        void queueFrame(CCDChip * targetChip);
+        /** @brief Copy the settings targetChip is read out with, all but the buffer, to frame. */
+        static void copyFrameSettings(CCDChip * targetChip, CCDChip::Frame &frame);
+        /** @brief Encode and upload queued frames in order of readout. */
+        void pipelineThreadEntry();
+        /** @brief Upload the queued frames and stop the pipeline thread. */
+        void stopPipeline();
+        /** @brief Stop the pipeline of every CCD when the driver exits. */
+        static void stopAllPipelines();
+        /** @brief Update pipeline occupancy. m_PipelineLock must be held. */
+        void updatePipelineOccupancy();
+        /** @brief Detect stars in frame and publish their metrics. */
+        void detectFrameStars(const CCDChip::Frame &frame);
+        /** @brief Replace frame with the frames stacked so far and start a new stack. m_StackLock must be held. */
+        void takeStack(CCDChip::Frame &frame);
+        /** @brief Queue the upload of an incomplete stack once the frames already queued are stacked. */
+        void queueStackFlush();
+        /** @brief Upload the frames stacked so far, if any. Called from the pipeline thread. */
+        void flushStack();
+
+        std::thread m_PipelineThread;
+        std::mutex m_PipelineLock;
+        std::condition_variable m_PipelineCondition;
+        /// Chips of the queued frames, in order of readout. nullptr requests flushStack()
+        std::deque<CCDChip *> m_PipelineQueue;
+        bool m_PipelineQuit {false};
+        /// Chip whose next fast exposure waits for a free slot in its ring
+        CCDChip * m_FastExposurePending {nullptr};
+        /// Frame being encoded and its statistics, read by addFITSKeywords()
+        const CCDChip::Frame * m_EncodingFrame {nullptr};
+        FrameStats m_FrameStats;
+        bool m_FrameStatsValid {false};
+
+        /// Guards FileNameTP, updated from the file writer thread, and the cached file index
+        std::mutex m_FileNameLock;
+        /// Directory and prefix of the cached file index
+        std::string m_FileIndexDir;
+        std::string m_FileIndexPrefix;
+        /// Next file index in m_FileIndexDir, 0 if it must be scanned
+        int m_NextFileIndex {0};
+        /// Masters applied to 2D frames, guarded by m_CalibrationLock since they are loaded from the main thread
+        FrameCalibration m_Calibration;
+        std::mutex m_CalibrationLock;
+        /// Masters and dark scale applied to the frame being encoded, read by addFITSKeywords()
+        bool m_FrameCalibrated {false};
+        std::string m_AppliedCalibration[FrameCalibration::MASTER_COUNT];
+        double m_AppliedDarkScale {0};
+
+        /// Live stacking state, guarded by m_StackLock since settings change from the main thread
+        FrameStacker m_Stacker;
+        std::mutex m_StackLock;
+        /// Settings of the first frame of the stack, without its pixels
+        CCDChip::Frame m_StackFrame;
+        /// Regions of interest accepted by UpdateCCDROIs(), read by the pipeline thread
+        std::vector<FrameROI> m_ROIs;
+        std::mutex m_ROILock;
+        /// Frames combined into the frame being encoded, 0 if it is not stacked. Read by addFITSKeywords()
+        uint32_t m_StackedFrames {0};
+
+        /// Writes locally saved images. Destroyed before the properties its callbacks update, after completing pending writes.
+        AsyncFileWriter m_FileWriter;
 
         // Threading for Websocket
 #ifdef HAVE_WEBSOCKET
@@ -16,9 +16,11 @@
  Boston, MA 02110-1301, USA.
 *******************************************************************************/
 #include "indiccdchip.h"
+#include "indibinning.h"
 #include "indidevapi.h"
 #include "locale_compat.h"
 
+#include <algorithm>
 #include <cstring>
 #include <ctime>
 
@@ -58,6 +60,23 @@ bool CCDChip::openFITSFile(uint32_t size, int &status)
     return (status == 0);
 }
 
+bool CCDChip::openFITSHeader(int &status)
+{
+    // The header is small, so the file is managed by cfitsio and does not need a shared BLOB.
+    fits_create_file(&m_FITSFilePointer, "mem://", &status);
+    if (status == 0)
+        fits_create_img(m_FITSFilePointer, BYTE_IMG, 0, nullptr, &status);
+
+    if (status != 0 && m_FITSFilePointer != nullptr)
+    {
+        int closeStatus = 0;
+        fits_close_file(m_FITSFilePointer, &closeStatus);
+        m_FITSFilePointer = nullptr;
+    }
+
+    return (status == 0);
+}
+
 bool CCDChip::closeFITSFile()
 {
     int status = 0;
@@ -256,6 +275,11 @@ void CCDChip::setNAxis(int value)
     NAxis = value;
 }
 
+void CCDChip::setFrameRingSize(uint8_t size)
+{
+    FrameRingSize = size > 0 ? size : 1;
+}
+
 void CCDChip::setImageExtension(const char *ext)
 {
     strncpy(ImageExtention, ext, MAXINDIBLOBFMT);
@@ -263,100 +287,17 @@ void CCDChip::setImageExtension(const char *ext)
 
 void CCDChip::binFrame()
 {
-    if (BinX == 1)
-        return;
-
-    // Jasem: Keep full frame shadow in memory to enhance performance and just swap frame pointers after operation is complete
-    if (BinFrame == nullptr)
-        BinFrame = static_cast<uint8_t*>(IDSharedBlobAlloc(RawFrameSize));
-    else
-    {
-        BinFrame = static_cast<uint8_t*>(IDSharedBlobRealloc(BinFrame, RawFrameSize));
-        if (BinFrame == nullptr)
-            BinFrame = static_cast<uint8_t*>(IDSharedBlobAlloc(RawFrameSize));
-    }
-
-    memset(BinFrame, 0, RawFrameSize);
-
-    switch (getBPP())
-    {
-        case 8:
-        {
-            uint8_t *bin_buf = BinFrame;
-            // Try to average pixels since in 8bit they get saturated pretty quickly
-            double factor      = (BinX * BinX) / 2;
-            double accumulator;
-
-            for (uint32_t i = 0; i < SubH; i += BinX)
-                for (uint32_t j = 0; j < SubW; j += BinX)
-                {
-                    accumulator = 0;
-                    for (int k = 0; k < BinX; k++)
-                    {
-                        for (int l = 0; l < BinX; l++)
-                        {
-                            accumulator += *(RawFrame + j + (i + k) * SubW + l);
-                        }
-                    }
-
-                    accumulator /= factor;
-                    if (accumulator > UINT8_MAX)
-                        *bin_buf = UINT8_MAX;
-                    else
-                        *bin_buf += static_cast<uint8_t>(accumulator);
-                    bin_buf++;
-                }
-        }
-        break;
-
-        case 16:
-        {
-            uint16_t *bin_buf    = reinterpret_cast<uint16_t *>(BinFrame);
-            uint16_t *RawFrame16 = reinterpret_cast<uint16_t *>(RawFrame);
-            uint16_t val;
-
-            for (uint32_t i = 0; i < SubH; i += BinX)
-                for (uint32_t j = 0; j < SubW; j += BinX)
-                {
-                    for (int k = 0; k < BinX; k++)
-                    {
-                        for (int l = 0; l < BinX; l++)
-                        {
-                            val = *(RawFrame16 + j + (i + k) * SubW + l);
-                            if (val + *bin_buf > UINT16_MAX)
-                                *bin_buf = UINT16_MAX;
-                            else
-                                *bin_buf += val;
-                        }
-                    }
-                    bin_buf++;
-                }
-        }
-        break;
-
-        default:
-            return;
-    }
-
-    // Swap frame pointers
-    uint8_t *rawFramePointer = RawFrame;
-    RawFrame                 = BinFrame;
-    // We just memset it next time we use it
-    BinFrame = rawFramePointer;
+    binFrame(false);
 }
 
-
-// Thx8411:
-// Binning Bayer frames
-// Each raw frame pixel is mapped and summed onto the binned frame
-// The right place of each pixel in the 2x2 Bayer matrix is found by :
-// (((i/BinX) & 0xFFFFFFFE) + (i & 0x00000001))
-// and
-// ((j/BinX) & 0xFFFFFFFE) + (j & 0x00000001)
-//
 void CCDChip::binBayerFrame()
 {
-    if (BinX == 1)
+    binFrame(true);
+}
+
+void CCDChip::binFrame(bool bayer)
+{
+    if (BinX == 1 && BinY == 1)
         return;
 
     // Jasem: Keep full frame shadow in memory to enhance performance and just swap frame pointers after operation is complete
@@ -369,84 +310,28 @@ void CCDChip::binBayerFrame()
             BinFrame = static_cast<uint8_t*>(IDSharedBlobAlloc(RawFrameSize));
     }
 
-    memset(BinFrame, 0, RawFrameSize);
+    if (BinFrame == nullptr)
+        return;
+
+    bool average = (m_BinningMode == BINNING_AVERAGE);
+    uint32_t divisor = 1;
 
-    switch (getBPP())
+    // 8 bit pixels saturate pretty quickly. Keep the brightness of earlier releases: Bayer frames are averaged,
+    // other frames are summed and divided by half the number of binned pixels.
+    if (m_BinningMode == BINNING_AUTO && getBPP() == 8)
     {
-        // 8 bpp frame
-        case 8:
-        {
-            uint32_t BinFrameOffset;
-            uint32_t val;
-            uint32_t BinW = SubW / BinX;
-            uint8_t BinFactor = BinX * BinY;
-            uint32_t RawOffset = 0;
-            uint32_t BinOffsetH;
-
-            // for each raw frame row
-            for (uint32_t i = 0; i < SubH; i++)
-            {
-                // find the binned frame row
-                BinOffsetH = (((i / BinY) & 0xFFFFFFFE) + (i & 0x00000001)) * BinW;
-                // for each raw column
-                for (uint32_t j = 0; j < SubW; j++)
-                {
-                    // find the proper position in the binned frame
-                    BinFrameOffset = BinOffsetH + ((j / BinX) & 0xFFFFFFFE) + (j & 0x00000001);
-                    // get the existing value in the binned frame
-                    val = BinFrame[BinFrameOffset];
-                    // add the new value, averaged and caped
-                    val += RawFrame[RawOffset] / BinFactor;
-                    if(val > UINT8_MAX)
-                        val = UINT8_MAX;
-                    // write back into the binned frame
-                    BinFrame[BinFrameOffset] = static_cast<uint8_t>(val);
-                    // next binned frame pixel
-                    RawOffset++;
-                }
-            }
-        }
-        break;
-
-        // 16 bpp frame
-        case 16:
-        {
-            // works the same as the 8 bits version, without averaging but
-            // mapped onto 16 bits pixel
-            uint16_t *RawFrame16 = reinterpret_cast<uint16_t *>(RawFrame);
-            uint16_t *BinFrame16 = reinterpret_cast<uint16_t *>(BinFrame);
-
-            uint32_t BinFrameOffset;
-            uint32_t val;
-            uint32_t BinW = SubW / BinX;
-            uint32_t RawOffset = 0;
-
-            for (uint32_t i = 0; i < SubH; i++)
-            {
-                uint32_t BinOffsetH = (((i / BinY) & 0xFFFFFFFE) + (i & 0x00000001)) * BinW;
-                for (uint32_t j = 0; j < SubW; j++)
-                {
-                    BinFrameOffset = BinOffsetH + ((j / BinX) & 0xFFFFFFFE) + (j & 0x00000001);
-                    val = BinFrame16[BinFrameOffset];
-                    val += RawFrame16[RawOffset];
-                    if(val > UINT16_MAX)
-                        val = UINT16_MAX;
-                    BinFrame16[BinFrameOffset] = (uint16_t)val;
-                    RawOffset++;
-                }
-            }
-
-        }
-        break;
-
-        default:
-            return;
+        if (bayer)
+            average = true;
+        else
+            divisor = std::max(1u, static_cast<uint32_t>(BinX * BinY) / 2);
     }
 
+    if (binPixels(RawFrame, BinFrame, SubW, SubH, BinX, BinY, getBPP(), average, bayer, 0, divisor) == false)
+        return;
+
     // Swap frame pointers
     uint8_t *rawFramePointer = RawFrame;
     RawFrame                 = BinFrame;
-    // We just memset it next time we use it
     BinFrame = rawFramePointer;
 }
 
@@ -24,6 +24,9 @@
 #include <stdint.h>
 #include <fitsio.h>
 
+#include <chrono>
+#include <vector>
+
 namespace INDI
 {
 
@@ -40,6 +43,12 @@ class CCDChip
         typedef enum { FRAME_X, FRAME_Y, FRAME_W, FRAME_H } CCD_FRAME_INDEX;
         typedef enum { BIN_W, BIN_H } CCD_BIN_INDEX;
         typedef enum
+        {
+            BINNING_AUTO,       /*!< Sum 8 bit frames divided by half the binned pixel count, average 8 bit Bayer frames, sum others */
+            BINNING_SUM,        /*!< Sum binned pixels, saturated to the maximum pixel value */
+            BINNING_AVERAGE     /*!< Average binned pixels */
+        } CCD_BINNING_MODE;
+        typedef enum
         {
             CCD_MAX_X,
             CCD_MAX_Y,
@@ -57,6 +66,14 @@ class CCDChip
          */
         bool openFITSFile(uint32_t size, int &status);
 
+        /**
+         * @brief openFITSHeader Open an in-memory FITS file holding an empty image, to collect the header
+         * keywords of a frame before the FITS file is written directly.
+         * @param FITS error code in case an error happens.
+         * @return True if successful, false otherwise.
+         */
+        bool openFITSHeader(int &status);
+
         /**
          * @brief closeFITSFile Close the in-memory FITS File.
          * @return True if successful, false otherwise.
@@ -396,16 +413,80 @@ class CCDChip
 
         /**
          * @brief binFrame Perform software binning on the CCD frame. Only use this function if hardware
-         * binning is not supported.
+         * binning is not supported. The frame is binned by BinX x BinY pixels, see setBinningMode().
          */
         void binFrame();
 
         /**
          * @brief binBayerFrame Perform software binning on a 2x2 Bayer matrix CCD frame. Only use this function if hardware
-         * binning is not supported.
+         * binning is not supported. Each color of the matrix is binned separately.
          */
         void binBayerFrame();
 
+        /**
+         * @brief setBinningMode Set how software binning combines pixels.
+         * @param mode Binning mode. Default is BINNING_AUTO.
+         */
+        void setBinningMode(CCD_BINNING_MODE mode)
+        {
+            m_BinningMode = mode;
+        }
+
+        /**
+         * @return Software binning mode.
+         */
+        CCD_BINNING_MODE getBinningMode() const
+        {
+            return m_BinningMode;
+        }
+
+        /**
+         * @brief The Frame struct holds a copy of a captured frame, and of the chip settings it was captured with,
+         * while it waits in the frame ring to be encoded and uploaded.
+         */
+        struct Frame
+        {
+            std::vector<uint8_t> buffer;
+            uint32_t subX {0};
+            uint32_t subY {0};
+            uint32_t subW {0};
+            uint32_t subH {0};
+            uint32_t binX {1};
+            uint32_t binY {1};
+            uint32_t xRes {0};
+            uint32_t yRes {0};
+            float pixelSizeX {0};
+            float pixelSizeY {0};
+            uint8_t bpp {8};
+            uint8_t naxis {2};
+            CCD_FRAME frameType {LIGHT_FRAME};
+            char extension[MAXINDIBLOBFMT] {};
+            double exposureDuration {0};
+            char exposureStartTime[MAXINDINAME] {};
+            /// False if another exposure of the fast exposure sequence follows this one
+            bool sequenceEnd {true};
+            /// Frames combined into this one by the stacker, 0 if it is a single exposure
+            uint32_t stackedFrames {0};
+            /// Time the frame entered the ring
+            std::chrono::steady_clock::time_point readoutTime;
+        };
+
+        /**
+         * @brief setFrameRingSize Set the number of frames that can wait to be encoded and uploaded while the
+         * next exposure is running. Each slot holds a copy of the frame buffer, so reduce it for very large
+         * sensors on memory constrained systems. It takes effect once the ring is empty.
+         * @param size number of frames, at least 1. Default is 3.
+         */
+        void setFrameRingSize(uint8_t size);
+
+        /**
+         * @return Number of frames that can wait to be encoded and uploaded.
+         */
+        uint8_t getFrameRingSize() const
+        {
+            return FrameRingSize;
+        }
+
         fitsfile **fitsFilePointer()
         {
             return &m_FITSFilePointer;
@@ -421,6 +502,9 @@ class CCDChip
             return &m_FITSMemoryBlock;
         }
 
+    private:
+        void binFrame(bool bayer);
+
     private:
         /////////////////////////////////////////////////////////////////////////////////////////
         /// Chip Variables
@@ -457,6 +541,8 @@ class CCDChip
         uint32_t RawFrameSize {0};
         // BINNED Frame when software binning is used.
         uint8_t *BinFrame {nullptr};
+        // How software binning combines pixels
+        CCD_BINNING_MODE m_BinningMode {BINNING_AUTO};
         // Should we compress frame before transmission?
         bool SendCompressed {false};
         // Frame Type
@@ -471,6 +557,12 @@ class CCDChip
         size_t m_FITSMemorySize {2880};
         fitsfile * m_FITSFilePointer {nullptr};
 
+        /// Frames waiting to be encoded and uploaded, oldest at FrameRingHead. Protected by CCD::m_PipelineLock.
+        std::vector<Frame> FrameRing;
+        uint8_t FrameRingSize {3};
+        size_t FrameRingHead {0};
+        size_t FrameRingCount {0};
+
         /////////////////////////////////////////////////////////////////////////////////////////
         /// Chip Properties
         /////////////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,307 @@
+/*
+    Copyright (C) 2026 by the INDI Library contributors
+
+    BLOB Compression
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+*/
+
+#include "indicompression.h"
+#include "indiworkerpool.h"
+#include "config.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+
+#include <zlib.h>
+
+#ifdef HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+#ifdef HAVE_LZ4
+#include <lz4frame.h>
+#endif
+
+namespace INDI
+{
+
+namespace
+{
+
+// Size of independently compressed chunks. Smaller buffers are compressed in a single chunk.
+constexpr size_t CHUNK_SIZE = 4 << 20;
+
+struct Chunk
+{
+    const uint8_t *data {nullptr};
+    size_t size {0};
+    bool last {false};
+    std::vector<uint8_t> output;
+    uLong adler {0};
+    bool ok {false};
+};
+
+// Raw deflate of a chunk. All but the last chunk end on a byte boundary with a sync flush, so that the
+// chunks can be concatenated into a single deflate stream.
+bool deflateChunk(Chunk &chunk, int level)
+{
+    z_stream stream;
+    memset(&stream, 0, sizeof(stream));
+    if (deflateInit2(&stream, level, Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+        return false;
+
+    chunk.output.resize(deflateBound(&stream, chunk.size) + 16);
+    stream.next_in   = const_cast<Bytef *>(chunk.data);
+    stream.avail_in  = chunk.size;
+    stream.next_out  = chunk.output.data();
+    stream.avail_out = chunk.output.size();
+
+    int rc = deflate(&stream, chunk.last ? Z_FINISH : Z_SYNC_FLUSH);
+    bool ok = chunk.last ? (rc == Z_STREAM_END) : (rc == Z_OK && stream.avail_in == 0 && stream.avail_out > 0);
+
+    chunk.output.resize(stream.total_out);
+    deflateEnd(&stream);
+
+    chunk.adler = adler32(adler32(0, nullptr, 0), chunk.data, chunk.size);
+    return ok;
+}
+
+bool compressChunk(Chunk &chunk, CompressionCodec codec, int level)
+{
+    switch (codec)
+    {
+        case COMPRESSION_ZLIB:
+            return deflateChunk(chunk, level);
+
+#ifdef HAVE_ZSTD
+        case COMPRESSION_ZSTD:
+        {
+            chunk.output.resize(ZSTD_compressBound(chunk.size));
+            size_t rc = ZSTD_compress(chunk.output.data(), chunk.output.size(), chunk.data, chunk.size, level);
+            if (ZSTD_isError(rc))
+                return false;
+            chunk.output.resize(rc);
+            return true;
+        }
+#endif
+
+#ifdef HAVE_LZ4
+        case COMPRESSION_LZ4:
+        {
+            LZ4F_preferences_t preferences;
+            memset(&preferences, 0, sizeof(preferences));
+            preferences.frameInfo.contentSize = chunk.size;
+            // Levels below 3 use the fast compressor, higher ones the high compression one
+            preferences.compressionLevel = (level < 3) ? 0 : level;
+
+            chunk.output.resize(LZ4F_compressFrameBound(chunk.size, &preferences));
+            size_t rc = LZ4F_compressFrame(chunk.output.data(), chunk.output.size(), chunk.data, chunk.size, &preferences);
+            if (LZ4F_isError(rc))
+                return false;
+            chunk.output.resize(rc);
+            return true;
+        }
+#endif
+
+        default:
+            return false;
+    }
+}
+
+}
+
+bool isCompressionSupported(CompressionCodec codec)
+{
+    switch (codec)
+    {
+        case COMPRESSION_ZLIB:
+            return true;
+#ifdef HAVE_ZSTD
+        case COMPRESSION_ZSTD:
+            return true;
+#endif
+#ifdef HAVE_LZ4
+        case COMPRESSION_LZ4:
+            return true;
+#endif
+        default:
+            return false;
+    }
+}
+
+const char *compressionSuffix(CompressionCodec codec)
+{
+    switch (codec)
+    {
+        case COMPRESSION_ZSTD:
+            return ".zst";
+        case COMPRESSION_LZ4:
+            return ".lz4";
+        default:
+            return ".z";
+    }
+}
+
+bool findCompression(const char *format, CompressionCodec &codec)
+{
+    if (format == nullptr)
+        return false;
+
+    size_t length = strlen(format);
+    for (auto candidate : {COMPRESSION_ZLIB, COMPRESSION_ZSTD, COMPRESSION_LZ4})
+    {
+        const char *suffix = compressionSuffix(candidate);
+        size_t suffixLength = strlen(suffix);
+        if (length >= suffixLength && strcmp(format + length - suffixLength, suffix) == 0)
+        {
+            codec = candidate;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool compressBuffer(const void *data, size_t size, CompressionCodec codec, int level, std::vector<uint8_t> &output,
+                    unsigned int threads)
+{
+    if (data == nullptr || isCompressionSupported(codec) == false)
+        return false;
+
+    level = std::max(1, std::min(9, level));
+
+    std::vector<Chunk> chunks(std::max<size_t>(1, (size + CHUNK_SIZE - 1) / CHUNK_SIZE));
+    for (size_t i = 0; i < chunks.size(); i++)
+    {
+        chunks[i].data = static_cast<const uint8_t *>(data) + i * CHUNK_SIZE;
+        chunks[i].size = std::min(CHUNK_SIZE, size - i * CHUNK_SIZE);
+        chunks[i].last = (i + 1 == chunks.size());
+    }
+
+    if (threads == 0)
+        threads = WorkerPool::instance().concurrency();
+    threads = static_cast<unsigned int>(std::min<size_t>(threads, chunks.size()));
+
+    // Tasks pick the next chunk to compress until all are done
+    std::atomic<size_t> nextChunk {0};
+    WorkerPool::instance().run(threads, [&](unsigned int)
+    {
+        for (size_t i = nextChunk++; i < chunks.size(); i = nextChunk++)
+            chunks[i].ok = compressChunk(chunks[i], codec, level);
+    });
+
+    size_t compressedSize = 0;
+    for (const auto &chunk : chunks)
+    {
+        if (chunk.ok == false)
+            return false;
+        compressedSize += chunk.output.size();
+    }
+
+    output.clear();
+
+    if (codec == COMPRESSION_ZLIB)
+    {
+        output.reserve(compressedSize + 6);
+
+        // zlib header, with the compression level hint and check bits
+        int flags = (level == 1 ? 0 : level < 6 ? 1 : level == 6 ? 2 : 3) << 6;
+        flags += 31 - (0x7800 + flags) % 31;
+        output.push_back(0x78);
+        output.push_back(static_cast<uint8_t>(flags));
+
+        uLong adler = adler32(0, nullptr, 0);
+        for (const auto &chunk : chunks)
+        {
+            output.insert(output.end(), chunk.output.begin(), chunk.output.end());
+            adler = adler32_combine(adler, chunk.adler, chunk.size);
+        }
+
+        for (int shift = 24; shift >= 0; shift -= 8)
+            output.push_back(static_cast<uint8_t>(adler >> shift));
+    }
+    else
+    {
+        output.reserve(compressedSize);
+        for (const auto &chunk : chunks)
+            output.insert(output.end(), chunk.output.begin(), chunk.output.end());
+    }
+
+    return true;
+}
+
+bool decompressBuffer(const void *data, size_t size, CompressionCodec codec, void *output, size_t outputSize)
+{
+    if (data == nullptr || output == nullptr)
+        return false;
+
+    switch (codec)
+    {
+        case COMPRESSION_ZLIB:
+        {
+            uLongf dataSize = outputSize;
+            int rc = uncompress(static_cast<Bytef *>(output), &dataSize, static_cast<const Bytef *>(data), size);
+            return rc == Z_OK && dataSize == outputSize;
+        }
+
+#ifdef HAVE_ZSTD
+        case COMPRESSION_ZSTD:
+        {
+            // Decompresses all concatenated frames
+            size_t rc = ZSTD_decompress(output, outputSize, data, size);
+            return !ZSTD_isError(rc) && rc == outputSize;
+        }
+#endif
+
+#ifdef HAVE_LZ4
+        case COMPRESSION_LZ4:
+        {
+            LZ4F_dctx *context = nullptr;
+            if (LZ4F_isError(LZ4F_createDecompressionContext(&context, LZ4F_VERSION)))
+                return false;
+
+            const uint8_t *in = static_cast<const uint8_t *>(data);
+            uint8_t *out = static_cast<uint8_t *>(output);
+            size_t consumed = 0, produced = 0;
+            bool ok = true;
+
+            // A new frame starts as soon as the previous one is complete
+            while (consumed < size)
+            {
+                size_t inSize = size - consumed, outSize = outputSize - produced;
+                size_t rc = LZ4F_decompress(context, out + produced, &outSize, in + consumed, &inSize, nullptr);
+                if (LZ4F_isError(rc) || (inSize == 0 && outSize == 0))
+                {
+                    ok = false;
+                    break;
+                }
+                consumed += inSize;
+                produced += outSize;
+            }
+
+            LZ4F_freeDecompressionContext(context);
+            return ok && produced == outputSize;
+        }
+#endif
+
+        default:
+            return false;
+    }
+}
+
+}
@@ -0,0 +1,86 @@
+/*
+    Copyright (C) 2026 by the INDI Library contributors
+
+    BLOB Compression
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace INDI
+{
+
+/**
+ * @brief The CompressionCodec enum lists the general purpose codecs used to compress BLOBs.
+ */
+typedef enum
+{
+    COMPRESSION_ZLIB,   /*!< zlib stream, BLOB format suffix .z */
+    COMPRESSION_ZSTD,   /*!< Concatenated zstd frames, BLOB format suffix .zst */
+    COMPRESSION_LZ4     /*!< Concatenated lz4 frames, BLOB format suffix .lz4 */
+} CompressionCodec;
+
+/**
+ * @return True if codec is available in this build.
+ */
+bool isCompressionSupported(CompressionCodec codec);
+
+/**
+ * @return BLOB format suffix of data compressed with codec.
+ */
+const char *compressionSuffix(CompressionCodec codec);
+
+/**
+ * @brief findCompression Find the codec a BLOB was compressed with from its format.
+ * @param format BLOB format, e.g. ".fits.zst".
+ * @param codec codec matching the format suffix.
+ * @return True if the format ends with the suffix of a known codec, false otherwise.
+ */
+bool findCompression(const char *format, CompressionCodec &codec);
+
+/**
+ * @brief compressBuffer Compress a buffer in independent chunks on parallel threads.
+ * zlib chunks are joined into a single zlib stream, so any zlib inflater can decompress it. zstd and lz4
+ * chunks are complete frames written one after the other.
+ * @param data buffer to compress.
+ * @param size size of data in bytes.
+ * @param codec codec to use.
+ * @param level compression level, from 1 (fastest) to 9 (smallest).
+ * @param output compressed data.
+ * @param threads number of tasks run on the shared WorkerPool, 0 to pick one based on data size and available cores.
+ * @return True on success, false if the codec is not supported or compression failed.
+ */
+bool compressBuffer(const void *data, size_t size, CompressionCodec codec, int level, std::vector<uint8_t> &output,
+                    unsigned int threads = 0);
+
+/**
+ * @brief decompressBuffer Decompress a buffer compressed by compressBuffer().
+ * @param data compressed data.
+ * @param size size of compressed data in bytes.
+ * @param codec codec data was compressed with.
+ * @param output decompressed data.
+ * @param outputSize size of the uncompressed data, which output must hold.
+ * @return True on success, false if the codec is not supported, data is corrupted or does not decompress
+ * to exactly outputSize bytes.
+ */
+bool decompressBuffer(const void *data, size_t size, CompressionCodec codec, void *output, size_t outputSize);
+
+}
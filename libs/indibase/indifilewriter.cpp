@@ -0,0 +1,497 @@
+/*
+    Copyright (C) 2026 by the INDI Library contributors
+
+    Asynchronous File Writer
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+*/
+
+#include "indifilewriter.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace INDI
+{
+
+namespace
+{
+
+// Alignment of staging buffers and O_DIRECT writes
+constexpr size_t IO_ALIGNMENT = 4096;
+// Smaller files go through the page cache
+constexpr size_t DIRECT_IO_MIN_SIZE = 4 << 20;
+// Streams preallocate this much beyond the expected size
+constexpr uint64_t PREALLOCATE_AHEAD = 256 << 20;
+
+int syncFile(int fd)
+{
+#ifdef __linux__
+    return fdatasync(fd);
+#else
+    return fsync(fd);
+#endif
+}
+
+// Make the directory entry of a new file durable. Not all file systems support it, so errors are ignored.
+void syncDirectory(const std::string &path)
+{
+    size_t separator = path.find_last_of('/');
+    std::string directory = (separator == std::string::npos) ? "." : (separator == 0 ? "/" : path.substr(0, separator));
+
+    int fd = open(directory.c_str(), O_RDONLY);
+    if (fd >= 0)
+    {
+        fsync(fd);
+        close(fd);
+    }
+}
+
+}
+
+AsyncFileWriter::AsyncFileWriter(size_t maxPending) : m_MaxPending(std::max<size_t>(1, maxPending))
+{
+}
+
+AsyncFileWriter::~AsyncFileWriter()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_Lock);
+        m_Quit = true;
+        m_Condition.notify_all();
+    }
+    if (m_WriterThread.joinable())
+        m_WriterThread.join();
+}
+
+bool AsyncFileWriter::write(const std::string &path, const void *data, size_t size, Callback callback)
+{
+    Job job;
+    job.path = path;
+    job.size = size;
+    job.callback = std::move(callback);
+
+    // Zero padded to the alignment, so O_DIRECT can write the last block whole
+    size_t allocated = std::max(IO_ALIGNMENT, (size + IO_ALIGNMENT - 1) / IO_ALIGNMENT * IO_ALIGNMENT);
+    void *buffer = nullptr;
+    if (posix_memalign(&buffer, IO_ALIGNMENT, allocated) != 0)
+        return false;
+    job.data.reset(static_cast<uint8_t *>(buffer));
+    if (size > 0)
+        memcpy(buffer, data, size);
+    memset(static_cast<uint8_t *>(buffer) + size, 0, allocated - size);
+
+    std::unique_lock<std::mutex> lock(m_Lock);
+    m_Condition.wait(lock, [this]()
+    {
+        return m_Jobs.size() + (m_Busy ? 1 : 0) < m_MaxPending;
+    });
+
+    m_Jobs.push_back(std::move(job));
+    if (m_WriterThread.joinable() == false)
+        m_WriterThread = std::thread(&AsyncFileWriter::writerThreadEntry, this);
+    m_Condition.notify_all();
+    return true;
+}
+
+void AsyncFileWriter::flush()
+{
+    std::unique_lock<std::mutex> lock(m_Lock);
+    m_Condition.wait(lock, [this]()
+    {
+        return m_Jobs.empty() && m_Busy == false;
+    });
+}
+
+size_t AsyncFileWriter::pending()
+{
+    std::lock_guard<std::mutex> lock(m_Lock);
+    return m_Jobs.size() + (m_Busy ? 1 : 0);
+}
+
+void AsyncFileWriter::writerThreadEntry()
+{
+    std::unique_lock<std::mutex> lock(m_Lock);
+    for (;;)
+    {
+        m_Condition.wait(lock, [this]()
+        {
+            return m_Quit || m_Jobs.empty() == false;
+        });
+
+        // Pending jobs are written before quitting
+        if (m_Jobs.empty())
+            return;
+
+        Job job = std::move(m_Jobs.front());
+        m_Jobs.pop_front();
+        m_Busy = true;
+        lock.unlock();
+
+        int error = writeFile(job);
+        if (job.callback)
+            job.callback(job.path, error);
+        job.data.reset();
+
+        lock.lock();
+        m_Busy = false;
+        m_Condition.notify_all();
+    }
+}
+
+int AsyncFileWriter::writeFile(const Job &job)
+{
+    const int flags = O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC;
+    const bool large = job.size >= DIRECT_IO_MIN_SIZE;
+    bool direct = false;
+    int fd = -1;
+
+#ifdef O_DIRECT
+    if (large)
+    {
+        fd = open(job.path.c_str(), flags | O_DIRECT, 0644);
+        direct = (fd >= 0);
+    }
+#endif
+    // File systems such as tmpfs do not support O_DIRECT
+    if (fd < 0)
+        fd = open(job.path.c_str(), flags, 0644);
+    if (fd < 0)
+        return errno;
+
+#ifdef __linux__
+    // Reserve contiguous space up front. Unlike posix_fallocate, this fails instead of writing zeros when the
+    // file system cannot do it.
+    if (large)
+        fallocate(fd, 0, 0, job.size);
+#endif
+
+    const uint8_t *data = job.data.get();
+    size_t length = direct ? (job.size + IO_ALIGNMENT - 1) / IO_ALIGNMENT * IO_ALIGNMENT : job.size;
+    size_t offset = 0;
+    int error = 0;
+
+    while (offset < length)
+    {
+        ssize_t n = pwrite(fd, data + offset, length - offset, offset);
+        if (n < 0)
+        {
+            if (errno == EINTR)
+                continue;
+#ifdef O_DIRECT
+            // Alignment requirements stricter than ours, continue through the page cache
+            if (direct && errno == EINVAL)
+            {
+                fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) & ~O_DIRECT);
+                direct = false;
+                length = job.size;
+                continue;
+            }
+#endif
+            error = errno;
+            break;
+        }
+        offset += n;
+    }
+
+    // Remove the padding of the last O_DIRECT block
+    if (error == 0 && length != job.size && ftruncate(fd, job.size) != 0)
+        error = errno;
+
+    if (error == 0 && syncFile(fd) != 0)
+        error = errno;
+
+    if (close(fd) != 0 && error == 0)
+        error = errno;
+
+    if (error != 0)
+    {
+        unlink(job.path.c_str());
+        return error;
+    }
+
+    syncDirectory(job.path);
+    return 0;
+}
+
+AsyncStreamWriter::AsyncStreamWriter(size_t blockSize, size_t blocks)
+    : m_BlockSize(std::max(IO_ALIGNMENT, (blockSize + IO_ALIGNMENT - 1) / IO_ALIGNMENT * IO_ALIGNMENT))
+    , m_MaxBlocks(std::max<size_t>(2, blocks))
+{
+}
+
+AsyncStreamWriter::~AsyncStreamWriter()
+{
+    if (isOpen())
+        close();
+}
+
+int AsyncStreamWriter::open(const std::string &path, uint64_t expectedSize)
+{
+    if (isOpen())
+        return EBUSY;
+
+    const int flags = O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC;
+    int fd = -1;
+    m_Direct = false;
+#ifdef O_DIRECT
+    fd = ::open(path.c_str(), flags | O_DIRECT, 0644);
+    m_Direct = (fd >= 0);
+#endif
+    // File systems such as tmpfs do not support O_DIRECT
+    if (fd < 0)
+        fd = ::open(path.c_str(), flags, 0644);
+    if (fd < 0)
+        return errno;
+
+    m_Preallocated = 0;
+#ifdef __linux__
+    // Failures are not fatal, the file then grows with the writes
+    if (expectedSize > 0 && fallocate(fd, 0, 0, expectedSize) == 0)
+        m_Preallocated = expectedSize;
+#else
+    (void)expectedSize;
+#endif
+
+    m_FD = fd;
+    m_Path = path;
+    m_Size = 0;
+    m_Offset = 0;
+    m_Error = 0;
+    m_Stalls = 0;
+    m_Written = 0;
+    m_WriteNanoseconds = 0;
+    m_Quit = false;
+    m_WriterThread = std::thread(&AsyncStreamWriter::writerThreadEntry, this);
+    return 0;
+}
+
+bool AsyncStreamWriter::nextBlock()
+{
+    std::unique_lock<std::mutex> lock(m_Lock);
+    if (m_Current.data)
+    {
+        m_Full.push_back(std::move(m_Current));
+        m_Current = Block();
+        m_Condition.notify_all();
+    }
+
+    if (m_Free.empty() && m_Allocated < m_MaxBlocks)
+    {
+        void *buffer = nullptr;
+        if (posix_memalign(&buffer, IO_ALIGNMENT, m_BlockSize) != 0)
+            return false;
+        m_Current.data.reset(static_cast<uint8_t *>(buffer));
+        m_Allocated++;
+        return true;
+    }
+
+    if (m_Free.empty())
+    {
+        m_Stalls++;
+        m_Condition.wait(lock, [this]()
+        {
+            return m_Free.empty() == false;
+        });
+    }
+
+    m_Current = std::move(m_Free.back());
+    m_Free.pop_back();
+    m_Current.size = 0;
+    return true;
+}
+
+bool AsyncStreamWriter::write(const void *data, size_t size)
+{
+    if (isOpen() == false || m_Error != 0)
+        return false;
+
+    const uint8_t *source = static_cast<const uint8_t *>(data);
+    while (size > 0)
+    {
+        if ((m_Current.data == nullptr || m_Current.size == m_BlockSize) && nextBlock() == false)
+            return false;
+
+        size_t n = std::min(size, m_BlockSize - m_Current.size);
+        memcpy(m_Current.data.get() + m_Current.size, source, n);
+        m_Current.size += n;
+        m_Size += n;
+        source += n;
+        size -= n;
+    }
+    return true;
+}
+
+int AsyncStreamWriter::close(const void *header, size_t headerSize)
+{
+    if (isOpen() == false)
+        return EBADF;
+
+    {
+        std::lock_guard<std::mutex> lock(m_Lock);
+        if (m_Current.data)
+        {
+            m_Full.push_back(std::move(m_Current));
+            m_Current = Block();
+        }
+        m_Quit = true;
+        m_Condition.notify_all();
+    }
+    m_WriterThread.join();
+
+    int error = m_Error;
+
+    // Remove the padding of the last O_DIRECT block and the space preallocated beyond the data
+    if (error == 0 && ftruncate(m_FD, m_Size) != 0)
+        error = errno;
+
+    if (error == 0 && header != nullptr && headerSize > 0)
+    {
+#ifdef O_DIRECT
+        if (m_Direct)
+            fcntl(m_FD, F_SETFL, fcntl(m_FD, F_GETFL) & ~O_DIRECT);
+#endif
+        const uint8_t *data = static_cast<const uint8_t *>(header);
+        size_t offset = 0;
+        while (offset < headerSize)
+        {
+            ssize_t n = pwrite(m_FD, data + offset, headerSize - offset, offset);
+            if (n < 0)
+            {
+                if (errno == EINTR)
+                    continue;
+                error = errno;
+                break;
+            }
+            offset += n;
+        }
+    }
+
+    if (error == 0 && syncFile(m_FD) != 0)
+        error = errno;
+
+    if (::close(m_FD) != 0 && error == 0)
+        error = errno;
+    m_FD = -1;
+
+    // Partial recordings are kept, unlike files of AsyncFileWriter
+    syncDirectory(m_Path);
+    return error;
+}
+
+double AsyncStreamWriter::writeRate() const
+{
+    std::lock_guard<std::mutex> lock(m_Lock);
+    return m_WriteNanoseconds > 0 ? m_Written / 1e6 / (m_WriteNanoseconds / 1e9) : 0;
+}
+
+void AsyncStreamWriter::writerThreadEntry()
+{
+    std::unique_lock<std::mutex> lock(m_Lock);
+    for (;;)
+    {
+        m_Condition.wait(lock, [this]()
+        {
+            return m_Quit || m_Full.empty() == false;
+        });
+
+        // Pending blocks are written before quitting
+        if (m_Full.empty())
+            return;
+
+        Block block = std::move(m_Full.front());
+        m_Full.pop_front();
+        m_Busy = true;
+        lock.unlock();
+
+        // After a failure, blocks are still recycled so the producer does not wait forever
+        if (m_Error == 0)
+        {
+            int error = writeBlock(block);
+            if (error != 0)
+                m_Error = error;
+        }
+
+        lock.lock();
+        block.size = 0;
+        m_Free.push_back(std::move(block));
+        m_Busy = false;
+        m_Condition.notify_all();
+    }
+}
+
+int AsyncStreamWriter::writeBlock(const Block &block)
+{
+    // Only the last block is partial, zero padded so O_DIRECT can write it whole
+    size_t length = block.size;
+    if (m_Direct && length % IO_ALIGNMENT != 0)
+    {
+        size_t padded = (length + IO_ALIGNMENT - 1) / IO_ALIGNMENT * IO_ALIGNMENT;
+        memset(block.data.get() + length, 0, padded - length);
+        length = padded;
+    }
+
+#ifdef __linux__
+    // Reserve space ahead so the file system allocates large extents instead of one per write
+    if (m_Offset + length > m_Preallocated)
+    {
+        uint64_t end = m_Offset + length + PREALLOCATE_AHEAD;
+        if (fallocate(m_FD, 0, m_Preallocated, end - m_Preallocated) == 0)
+            m_Preallocated = end;
+    }
+#endif
+
+    auto start = std::chrono::steady_clock::now();
+    const uint8_t *data = block.data.get();
+    size_t offset = 0;
+    while (offset < length)
+    {
+        ssize_t n = pwrite(m_FD, data + offset, length - offset, m_Offset + offset);
+        if (n < 0)
+        {
+            if (errno == EINTR)
+                continue;
+#ifdef O_DIRECT
+            // Alignment requirements stricter than ours, continue through the page cache
+            if (m_Direct && errno == EINVAL)
+            {
+                fcntl(m_FD, F_SETFL, fcntl(m_FD, F_GETFL) & ~O_DIRECT);
+                m_Direct = false;
+                length = block.size;
+                continue;
+            }
+#endif
+            return errno;
+        }
+        offset += n;
+    }
+    uint64_t nanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+    {
+        std::lock_guard<std::mutex> lock(m_Lock);
+        m_WriteNanoseconds += nanoseconds;
+        m_Written += block.size;
+    }
+    m_Offset += block.size;
+    return 0;
+}
+
+}
@@ -0,0 +1,218 @@
+/*
+    Copyright (C) 2026 by the INDI Library contributors
+
+    Asynchronous File Writer
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+*/
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace INDI
+{
+
+/**
+ * @brief The AsyncFileWriter class writes files on a background thread.
+ *
+ * Data is copied to an aligned staging buffer when queued, so callers may reuse their buffer immediately.
+ * Large files are preallocated and written with O_DIRECT where the file system supports it, bypassing the
+ * page cache. Each file is synced to disk, along with its directory entry, before its callback is invoked.
+ *
+ * Writes complete in the order they were queued. When too many writes are pending, write() waits for the
+ * oldest one to complete, so a slow disk throttles the producer instead of exhausting memory.
+ */
+class AsyncFileWriter
+{
+    public:
+        /**
+         * @brief Callback invoked from the writer thread once a file is on disk, or failed to be written.
+         * @param path path of the file.
+         * @param error 0 on success, errno of the failed operation otherwise.
+         */
+        typedef std::function<void(const std::string &path, int error)> Callback;
+
+        /**
+         * @param maxPending number of writes that may be queued before write() waits.
+         */
+        explicit AsyncFileWriter(size_t maxPending = 4);
+
+        /** @brief Complete all pending writes, then stop the writer thread. */
+        ~AsyncFileWriter();
+
+        /**
+         * @brief write Queue a file to be written.
+         * @param path path of the file, replaced if it exists.
+         * @param data file content, copied before returning.
+         * @param size size of data in bytes.
+         * @param callback invoked once the file is written, may be empty.
+         * @return True if the file is queued, false if the staging buffer could not be allocated.
+         */
+        bool write(const std::string &path, const void *data, size_t size, Callback callback);
+
+        /** @brief Wait until all queued files are written. */
+        void flush();
+
+        /** @return Number of queued files not yet written. */
+        size_t pending();
+
+    private:
+        struct Job
+        {
+            std::string path;
+            std::unique_ptr<uint8_t, void(*)(void *)> data {nullptr, free};
+            size_t size {0};
+            Callback callback;
+        };
+
+        void writerThreadEntry();
+        static int writeFile(const Job &job);
+
+        std::mutex m_Lock;
+        std::condition_variable m_Condition;
+        std::deque<Job> m_Jobs;
+        /// True while the writer thread works on the front job
+        bool m_Busy {false};
+        bool m_Quit {false};
+        size_t m_MaxPending;
+        /// Started on the first write
+        std::thread m_WriterThread;
+};
+
+/**
+ * @brief The AsyncStreamWriter class appends a stream of data to a file on a background thread.
+ *
+ * Data is copied into large aligned blocks, and full blocks are written by the writer thread with O_DIRECT where the
+ * file system supports it. Space is preallocated ahead of the writes. When all blocks are waiting for the disk,
+ * write() waits for one and counts a stall, so a slow disk throttles the producer instead of exhausting memory.
+ *
+ * write() and close() must be called from a single thread.
+ */
+class AsyncStreamWriter
+{
+    public:
+        /**
+         * @param blockSize size of each block, rounded up to the I/O alignment.
+         * @param blocks number of blocks, at least 2 so the producer fills one while another is written.
+         */
+        explicit AsyncStreamWriter(size_t blockSize = 8 << 20, size_t blocks = 4);
+
+        /** @brief Close the file if still open, discarding the header update. */
+        ~AsyncStreamWriter();
+
+        /**
+         * @brief open Create the file, replaced if it exists.
+         * @param path path of the file.
+         * @param expectedSize expected size of the file in bytes, preallocated up front. 0 if unknown.
+         * @return 0 on success, errno otherwise.
+         */
+        int open(const std::string &path, uint64_t expectedSize = 0);
+
+        /**
+         * @brief write Append data to the file, copied before returning.
+         * @return True if queued, false if the file is not open or a previous write failed.
+         */
+        bool write(const void *data, size_t size);
+
+        /**
+         * @brief close Write all appended data, then optionally overwrite the start of the file, and close it.
+         * @param header data written at offset 0 once everything else is written, such as a header updated with
+         * the final frame count. May be null.
+         * @param headerSize size of header in bytes.
+         * @return 0 on success, errno of the first failed operation otherwise.
+         */
+        int close(const void *header = nullptr, size_t headerSize = 0);
+
+        /** @return True between a successful open() and close(). */
+        bool isOpen() const
+        {
+            return m_FD >= 0;
+        }
+
+        /** @return errno of the first failed write, 0 if none. */
+        int error() const
+        {
+            return m_Error;
+        }
+
+        /** @return Bytes appended since open(). */
+        uint64_t size() const
+        {
+            return m_Size;
+        }
+
+        /** @return Average rate in MB/s of the disk writes, excluding the time waiting for data. */
+        double writeRate() const;
+
+        /** @return Number of times write() waited for the disk since open(). */
+        uint32_t stalls() const
+        {
+            return m_Stalls;
+        }
+
+    private:
+        typedef std::unique_ptr<uint8_t, void(*)(void *)> Buffer;
+        struct Block
+        {
+            Buffer data {nullptr, free};
+            size_t size {0};
+        };
+
+        void writerThreadEntry();
+        int writeBlock(const Block &block);
+        bool nextBlock();
+
+        size_t m_BlockSize;
+        size_t m_MaxBlocks;
+        size_t m_Allocated {0};
+
+        mutable std::mutex m_Lock;
+        std::condition_variable m_Condition;
+        std::deque<Block> m_Full;
+        std::vector<Block> m_Free;
+        Block m_Current;
+        bool m_Busy {false};
+        bool m_Quit {false};
+        std::thread m_WriterThread;
+
+        int m_FD {-1};
+        bool m_Direct {false};
+        std::string m_Path;
+        uint64_t m_Size {0};
+        /// Used by the writer thread only
+        uint64_t m_Offset {0};
+        uint64_t m_Preallocated {0};
+
+        std::atomic<int> m_Error {0};
+        std::atomic<uint32_t> m_Stalls {0};
+        /// Bytes written and time spent writing them, guarded by m_Lock so the rate is read consistently
+        uint64_t m_Written {0};
+        uint64_t m_WriteNanoseconds {0};
+};
+
+}
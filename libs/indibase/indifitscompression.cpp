@@ -0,0 +1,401 @@
+/*
+    Copyright (C) 2026 by the INDI Library contributors
+
+    Tile Compressed FITS
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+*/
+
+#include "indifitscompression.h"
+#include "indiworkerpool.h"
+
+#include <fitsio.h>
+#include <zlib.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+namespace INDI
+{
+
+namespace
+{
+
+constexpr size_t FITS_BLOCK = 2880;
+constexpr size_t FITS_CARD = 80;
+// Rice block size used by fpack
+constexpr int RICE_BLOCK_SIZE = 32;
+// Smaller images are not worth splitting across the worker pool
+constexpr size_t MIN_BYTES_PER_THREAD = 1 << 22;
+
+struct ImageHeader
+{
+    int bitpix {0};
+    int naxis {0};
+    long naxes[3] {1, 1, 1};
+    bool extend {false};
+    size_t headerSize {0};
+    // Header cards copied to the compressed HDU
+    std::vector<const uint8_t *> cards;
+};
+
+struct TileRange
+{
+    size_t first {0};
+    size_t count {0};
+    std::vector<uint8_t> heap;
+    std::vector<uint32_t> sizes;
+    bool ok {false};
+};
+
+std::string cardKeyword(const uint8_t *card)
+{
+    std::string keyword(reinterpret_cast<const char *>(card), 8);
+    keyword.erase(keyword.find_last_not_of(' ') + 1);
+    return keyword;
+}
+
+bool cardInteger(const uint8_t *card, long &value)
+{
+    if (card[8] != '=')
+        return false;
+
+    std::string text(reinterpret_cast<const char *>(card) + 10, FITS_CARD - 10);
+    char *end = nullptr;
+    value = strtol(text.c_str(), &end, 10);
+    return end != text.c_str();
+}
+
+bool cardLogical(const uint8_t *card)
+{
+    std::string text(reinterpret_cast<const char *>(card) + 10, FITS_CARD - 10);
+    size_t position = text.find_first_not_of(' ');
+    return card[8] == '=' && position != std::string::npos && text[position] == 'T';
+}
+
+// Parse the header of the primary HDU, which must be the only HDU of the file
+bool parseHeader(const uint8_t *fits, size_t size, ImageHeader &header)
+{
+    if (size < FITS_BLOCK || strncmp(reinterpret_cast<const char *>(fits), "SIMPLE  =", 9) != 0 || !cardLogical(fits))
+        return false;
+
+    size_t offset = 0;
+    for (; offset + FITS_CARD <= size; offset += FITS_CARD)
+    {
+        const uint8_t *card = fits + offset;
+        std::string keyword = cardKeyword(card);
+        long value = 0;
+
+        if (keyword == "END")
+            break;
+        else if (keyword == "SIMPLE" || keyword == "PCOUNT" || keyword == "GCOUNT" || keyword == "CHECKSUM"
+                 || keyword == "DATASUM")
+            continue;
+        else if (keyword == "EXTEND")
+            header.extend = cardLogical(card);
+        else if (keyword == "BITPIX" && cardInteger(card, value))
+            header.bitpix = value;
+        else if (keyword == "NAXIS" && cardInteger(card, value))
+            header.naxis = value;
+        else if (keyword.size() == 6 && keyword.compare(0, 5, "NAXIS") == 0 && keyword[5] >= '1' && keyword[5] <= '3'
+                 && cardInteger(card, value))
+            header.naxes[keyword[5] - '1'] = value;
+        else
+            header.cards.push_back(card);
+    }
+
+    if (offset + FITS_CARD > size)
+        return false;
+
+    header.headerSize = (offset / FITS_BLOCK + 1) * FITS_BLOCK;
+
+    if ((header.bitpix != 8 && header.bitpix != 16 && header.bitpix != 32) || header.naxis < 2 || header.naxis > 3)
+        return false;
+
+    for (int i = 0; i < header.naxis; i++)
+        if (header.naxes[i] <= 0)
+            return false;
+
+    // The image must fill the rest of the file
+    size_t dataSize = header.bitpix / 8 * header.naxes[0] * header.naxes[1] * header.naxes[2];
+    size_t paddedSize = header.headerSize + (dataSize + FITS_BLOCK - 1) / FITS_BLOCK * FITS_BLOCK;
+    return header.headerSize + dataSize <= size && size <= paddedSize;
+}
+
+void addCard(std::vector<uint8_t> &header, const char *keyword, const char *value)
+{
+    char card[FITS_CARD + 1];
+    snprintf(card, sizeof(card), "%-8.8s= %-70.70s", keyword, value);
+    header.insert(header.end(), card, card + FITS_CARD);
+}
+
+void addCard(std::vector<uint8_t> &header, const char *keyword, long value)
+{
+    char text[32];
+    snprintf(text, sizeof(text), "%20ld", value);
+    addCard(header, keyword, text);
+}
+
+void addLogicalCard(std::vector<uint8_t> &header, const char *keyword, bool value)
+{
+    addCard(header, keyword, value ? "                   T" : "                   F");
+}
+
+void addStringCard(std::vector<uint8_t> &header, const char *keyword, const std::string &value)
+{
+    char text[FITS_CARD];
+    snprintf(text, sizeof(text), "'%-8s'", value.c_str());
+    addCard(header, keyword, text);
+}
+
+void endHeader(std::vector<uint8_t> &header)
+{
+    char card[FITS_CARD + 1];
+    snprintf(card, sizeof(card), "%-80s", "END");
+    header.insert(header.end(), card, card + FITS_CARD);
+    header.resize((header.size() + FITS_BLOCK - 1) / FITS_BLOCK * FITS_BLOCK, ' ');
+}
+
+// Compress a range of tiles, each holding tilePixels big endian pixels
+void compressTiles(const uint8_t *data, size_t tilePixels, int bytepix, FITSTileCompression compression, int level,
+                   TileRange &range)
+{
+    const size_t tileBytes = tilePixels * bytepix;
+    std::vector<uint8_t> scratch(tileBytes);
+    z_stream stream;
+
+    if (compression == FITS_TILE_GZIP2)
+    {
+        memset(&stream, 0, sizeof(stream));
+        // gzip format, as expected by cfitsio
+        if (deflateInit2(&stream, level, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+            return;
+    }
+
+    range.sizes.resize(range.count);
+    range.ok = true;
+
+    for (size_t i = 0; i < range.count && range.ok; i++)
+    {
+        const uint8_t *tile = data + (range.first + i) * tileBytes;
+        size_t offset = range.heap.size();
+        int compressed = -1;
+
+        if (compression == FITS_TILE_RICE)
+        {
+            // Rice works on native integers
+            int bound = static_cast<int>(tileBytes * 2 + 64);
+            range.heap.resize(offset + bound);
+            unsigned char *output = range.heap.data() + offset;
+
+            if (bytepix == 1)
+                compressed = fits_rcomp_byte(reinterpret_cast<signed char *>(const_cast<uint8_t *>(tile)), tilePixels, output, bound,
+                                             RICE_BLOCK_SIZE);
+            else if (bytepix == 2)
+            {
+                short *values = reinterpret_cast<short *>(scratch.data());
+                for (size_t j = 0; j < tilePixels; j++)
+                    values[j] = static_cast<short>((tile[2 * j] << 8) | tile[2 * j + 1]);
+                compressed = fits_rcomp_short(values, tilePixels, output, bound, RICE_BLOCK_SIZE);
+            }
+            else
+            {
+                int *values = reinterpret_cast<int *>(scratch.data());
+                for (size_t j = 0; j < tilePixels; j++)
+                    values[j] = static_cast<int>((static_cast<uint32_t>(tile[4 * j]) << 24) | (tile[4 * j + 1] << 16) |
+                                                 (tile[4 * j + 2] << 8) | tile[4 * j + 3]);
+                compressed = fits_rcomp(values, tilePixels, output, bound, RICE_BLOCK_SIZE);
+            }
+        }
+        else
+        {
+            // Group the bytes of the pixels by significance, most significant first
+            const uint8_t *input = tile;
+            if (bytepix > 1)
+            {
+                for (size_t j = 0; j < tilePixels; j++)
+                    for (int b = 0; b < bytepix; b++)
+                        scratch[b * tilePixels + j] = tile[j * bytepix + b];
+                input = scratch.data();
+            }
+
+            size_t bound = deflateBound(&stream, tileBytes);
+            range.heap.resize(offset + bound);
+            stream.next_in   = const_cast<Bytef *>(input);
+            stream.avail_in  = tileBytes;
+            stream.next_out  = range.heap.data() + offset;
+            stream.avail_out = bound;
+
+            if (deflate(&stream, Z_FINISH) == Z_STREAM_END)
+                compressed = static_cast<int>(stream.total_out);
+            deflateReset(&stream);
+        }
+
+        if (compressed < 0)
+            range.ok = false;
+        else
+        {
+            range.heap.resize(offset + compressed);
+            range.sizes[i] = compressed;
+        }
+    }
+
+    if (compression == FITS_TILE_GZIP2)
+        deflateEnd(&stream);
+}
+
+void putInt32(uint8_t *destination, uint32_t value)
+{
+    destination[0] = value >> 24;
+    destination[1] = value >> 16;
+    destination[2] = value >> 8;
+    destination[3] = value;
+}
+
+}
+
+bool compressFITSTiles(const uint8_t *fits, size_t size, FITSTileCompression compression, int level,
+                       std::vector<uint8_t> &output, unsigned int threads)
+{
+    ImageHeader image;
+    if (fits == nullptr || parseHeader(fits, size, image) == false)
+        return false;
+
+    const int bytepix = image.bitpix / 8;
+    const size_t tilePixels = image.naxes[0];
+    const size_t tiles = image.naxes[1] * image.naxes[2];
+    const size_t dataSize = tilePixels * tiles * bytepix;
+
+    if (threads == 0)
+    {
+        threads = WorkerPool::instance().concurrency();
+        threads = static_cast<unsigned int>(std::min<size_t>(threads, std::max<size_t>(1, dataSize / MIN_BYTES_PER_THREAD)));
+    }
+    threads = static_cast<unsigned int>(std::min<size_t>(threads, tiles));
+
+    level = std::max(1, std::min(9, level));
+
+    // Compress contiguous ranges of tiles in parallel
+    std::vector<TileRange> ranges(threads);
+    const size_t rangeSize = (tiles + threads - 1) / threads;
+    const uint8_t *data = fits + image.headerSize;
+
+    WorkerPool::instance().run(threads, [&](unsigned int i)
+    {
+        ranges[i].first = std::min(tiles, i * rangeSize);
+        ranges[i].count = std::min(tiles, ranges[i].first + rangeSize) - ranges[i].first;
+        ranges[i].heap.reserve(ranges[i].count * tilePixels * bytepix / 2);
+        compressTiles(data, tilePixels, bytepix, compression, level, ranges[i]);
+    });
+
+    size_t heapSize = 0;
+    uint32_t maxTileSize = 0;
+    for (const auto &range : ranges)
+    {
+        if (range.ok == false)
+            return false;
+        heapSize += range.heap.size();
+        for (auto tileSize : range.sizes)
+            maxTileSize = std::max(maxTileSize, tileSize);
+    }
+
+    if (heapSize > 0x7FFFFFFF)
+        return false;
+
+    output.clear();
+    output.reserve(2 * FITS_BLOCK + image.cards.size() * FITS_CARD + tiles * 8 + heapSize + FITS_BLOCK * 2);
+
+    // Empty primary HDU
+    addLogicalCard(output, "SIMPLE", true);
+    addCard(output, "BITPIX", 8L);
+    addCard(output, "NAXIS", 0L);
+    addLogicalCard(output, "EXTEND", true);
+    endHeader(output);
+
+    // Binary table of tile descriptors, followed by the heap of compressed tiles
+    char tform[32];
+    snprintf(tform, sizeof(tform), "1PB(%u)", maxTileSize);
+
+    std::vector<uint8_t> header;
+    addStringCard(header, "XTENSION", "BINTABLE");
+    addCard(header, "BITPIX", 8L);
+    addCard(header, "NAXIS", 2L);
+    addCard(header, "NAXIS1", 8L);
+    addCard(header, "NAXIS2", static_cast<long>(tiles));
+    addCard(header, "PCOUNT", static_cast<long>(heapSize));
+    addCard(header, "GCOUNT", 1L);
+    addCard(header, "TFIELDS", 1L);
+    addStringCard(header, "TTYPE1", "COMPRESSED_DATA");
+    addStringCard(header, "TFORM1", tform);
+    addLogicalCard(header, "ZIMAGE", true);
+    addLogicalCard(header, "ZSIMPLE", true);
+    addCard(header, "ZBITPIX", static_cast<long>(image.bitpix));
+    addCard(header, "ZNAXIS", static_cast<long>(image.naxis));
+    for (int i = 0; i < image.naxis; i++)
+    {
+        char keyword[16];
+        snprintf(keyword, sizeof(keyword), "ZNAXIS%d", i + 1);
+        addCard(header, keyword, image.naxes[i]);
+    }
+    if (image.extend)
+        addLogicalCard(header, "ZEXTEND", true);
+    for (int i = 0; i < image.naxis; i++)
+    {
+        char keyword[16];
+        snprintf(keyword, sizeof(keyword), "ZTILE%d", i + 1);
+        addCard(header, keyword, i == 0 ? image.naxes[0] : 1L);
+    }
+    if (compression == FITS_TILE_RICE)
+    {
+        addStringCard(header, "ZCMPTYPE", "RICE_1");
+        addStringCard(header, "ZNAME1", "BLOCKSIZE");
+        addCard(header, "ZVAL1", static_cast<long>(RICE_BLOCK_SIZE));
+        addStringCard(header, "ZNAME2", "BYTEPIX");
+        addCard(header, "ZVAL2", static_cast<long>(bytepix));
+    }
+    else
+        addStringCard(header, "ZCMPTYPE", "GZIP_2");
+
+    for (auto card : image.cards)
+        header.insert(header.end(), card, card + FITS_CARD);
+    endHeader(header);
+    output.insert(output.end(), header.begin(), header.end());
+
+    size_t descriptor = output.size();
+    output.resize(descriptor + tiles * 8);
+    uint32_t heapOffset = 0;
+    for (const auto &range : ranges)
+    {
+        for (auto tileSize : range.sizes)
+        {
+            putInt32(output.data() + descriptor, tileSize);
+            putInt32(output.data() + descriptor + 4, heapOffset);
+            descriptor += 8;
+            heapOffset += tileSize;
+        }
+    }
+
+    for (const auto &range : ranges)
+        output.insert(output.end(), range.heap.begin(), range.heap.end());
+
+    output.resize((output.size() + FITS_BLOCK - 1) / FITS_BLOCK * FITS_BLOCK, 0);
+    return true;
+}
+
+}
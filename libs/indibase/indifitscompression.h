@@ -0,0 +1,60 @@
+/*
+    Copyright (C) 2026 by the INDI Library contributors
+
+    Tile Compressed FITS
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace INDI
+{
+
+/**
+ * @brief The FITSTileCompression enum lists the algorithms used to compress FITS image tiles.
+ */
+typedef enum
+{
+    FITS_TILE_RICE,     /*!< RICE_1 */
+    FITS_TILE_GZIP2     /*!< GZIP_2, gzip of byte shuffled pixels */
+} FITSTileCompression;
+
+/**
+ * @brief compressFITSTiles Convert a FITS image into a tile compressed FITS file, as written by fpack.
+ *
+ * Each image row is a tile. Tiles are compressed independently on parallel threads, then assembled into a
+ * binary table extension following an empty primary HDU. Header keywords of the image are copied to the table.
+ *
+ * Only files holding a single 2D or 3D integer image with 8, 16 or 32 bits per pixel are supported. Callers
+ * must fall back to cfitsio for other files.
+ *
+ * @param fits FITS file.
+ * @param size size of the FITS file in bytes.
+ * @param compression tile compression algorithm.
+ * @param level gzip compression level, from 1 (fastest) to 9 (smallest). Rice has no level.
+ * @param output tile compressed FITS file.
+ * @param threads number of tasks run on the shared WorkerPool, 0 to pick one based on image size and available cores.
+ * @return True on success, false if the file is not supported or compression failed.
+ */
+bool compressFITSTiles(const uint8_t *fits, size_t size, FITSTileCompression compression, int level,
+                       std::vector<uint8_t> &output, unsigned int threads = 0);
+
+}
@@ -0,0 +1,263 @@
+/*
+    Copyright (C) 2026 by the INDI Library contributors
+
+    Direct FITS Writer
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+*/
+
+#include "indifitswriter.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace INDI
+{
+
+namespace
+{
+
+constexpr size_t FITS_BLOCK = 2880;
+constexpr size_t FITS_CARD  = 80;
+
+inline size_t padToBlock(size_t size)
+{
+    return (size + FITS_BLOCK - 1) / FITS_BLOCK * FITS_BLOCK;
+}
+
+bool isSupported(int bpp, int naxis, const long *naxes)
+{
+    if ((bpp != 8 && bpp != 16 && bpp != 32) || (naxis != 2 && naxis != 3) || naxes == nullptr)
+        return false;
+
+    for (int i = 0; i < naxis; i++)
+        if (naxes[i] <= 0)
+            return false;
+
+    return true;
+}
+
+// Number of cards describing the image
+size_t imageCards(int bpp, int naxis)
+{
+    // SIMPLE, BITPIX, NAXIS, NAXISn, EXTEND, then BZERO and BSCALE for unsigned 16 and 32 bits
+    return 4 + naxis + (bpp > 8 ? 2 : 0);
+}
+
+size_t dataSize(int bpp, int naxis, const long *naxes)
+{
+    size_t size = bpp / 8;
+    for (int i = 0; i < naxis; i++)
+        size *= naxes[i];
+    return size;
+}
+
+class HeaderWriter
+{
+    public:
+        explicit HeaderWriter(uint8_t *output) : m_Output(reinterpret_cast<char *>(output)) {}
+
+        void record(const std::string &text)
+        {
+            size_t length = std::min(text.size(), FITS_CARD);
+            memcpy(m_Output, text.data(), length);
+            memset(m_Output + length, ' ', FITS_CARD - length);
+            m_Output += FITS_CARD;
+        }
+
+        void value(const char *keyword, const char *value, const char *comment)
+        {
+            char card[FITS_CARD + 1];
+            snprintf(card, sizeof(card), "%-8s= %20s / %s", keyword, value, comment);
+            record(card);
+        }
+
+        void value(const char *keyword, long long value, const char *comment)
+        {
+            char text[24];
+            snprintf(text, sizeof(text), "%lld", value);
+            this->value(keyword, text, comment);
+        }
+
+        char *position() const
+        {
+            return m_Output;
+        }
+
+    private:
+        char *m_Output;
+};
+
+void swap16(const uint16_t *input, uint8_t *output, size_t count)
+{
+    size_t i = 0;
+#if defined(__AVX2__)
+    const __m256i sign256 = _mm256_set1_epi16(static_cast<short>(0x8000));
+    for (; i + 16 <= count; i += 16)
+    {
+        __m256i v = _mm256_xor_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(input + i)), sign256);
+        v = _mm256_or_si256(_mm256_slli_epi16(v, 8), _mm256_srli_epi16(v, 8));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(output + i * 2), v);
+    }
+#endif
+#if defined(__SSE2__)
+    const __m128i sign = _mm_set1_epi16(static_cast<short>(0x8000));
+    for (; i + 8 <= count; i += 8)
+    {
+        __m128i v = _mm_xor_si128(_mm_loadu_si128(reinterpret_cast<const __m128i *>(input + i)), sign);
+        v = _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(output + i * 2), v);
+    }
+#elif defined(__ARM_NEON)
+    const uint16x8_t sign = vdupq_n_u16(0x8000);
+    for (; i + 8 <= count; i += 8)
+    {
+        uint16x8_t v = veorq_u16(vld1q_u16(input + i), sign);
+        vst1q_u8(output + i * 2, vrev16q_u8(vreinterpretq_u8_u16(v)));
+    }
+#endif
+    for (; i < count; i++)
+    {
+        uint16_t v = input[i] ^ 0x8000;
+        output[i * 2]     = static_cast<uint8_t>(v >> 8);
+        output[i * 2 + 1] = static_cast<uint8_t>(v);
+    }
+}
+
+void swap32(const uint32_t *input, uint8_t *output, size_t count)
+{
+    size_t i = 0;
+#if defined(__AVX2__)
+    const __m256i sign256 = _mm256_set1_epi32(static_cast<int>(0x80000000));
+    const __m256i order256 = _mm256_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12,
+                             3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+    for (; i + 8 <= count; i += 8)
+    {
+        __m256i v = _mm256_xor_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(input + i)), sign256);
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(output + i * 4), _mm256_shuffle_epi8(v, order256));
+    }
+#endif
+#if defined(__SSE2__)
+    const __m128i sign = _mm_set1_epi32(static_cast<int>(0x80000000));
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128i v = _mm_xor_si128(_mm_loadu_si128(reinterpret_cast<const __m128i *>(input + i)), sign);
+        // Swap the 16 bits halves, then the bytes of each half
+        v = _mm_or_si128(_mm_slli_epi32(v, 16), _mm_srli_epi32(v, 16));
+        v = _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(output + i * 4), v);
+    }
+#elif defined(__ARM_NEON)
+    const uint32x4_t sign = vdupq_n_u32(0x80000000);
+    for (; i + 4 <= count; i += 4)
+    {
+        uint32x4_t v = veorq_u32(vld1q_u32(input + i), sign);
+        vst1q_u8(output + i * 4, vrev32q_u8(vreinterpretq_u8_u32(v)));
+    }
+#endif
+    for (; i < count; i++)
+    {
+        uint32_t v = input[i] ^ 0x80000000;
+        output[i * 4]     = static_cast<uint8_t>(v >> 24);
+        output[i * 4 + 1] = static_cast<uint8_t>(v >> 16);
+        output[i * 4 + 2] = static_cast<uint8_t>(v >> 8);
+        output[i * 4 + 3] = static_cast<uint8_t>(v);
+    }
+}
+
+}
+
+size_t fitsImageSize(size_t cards, int bpp, int naxis, const long *naxes)
+{
+    if (isSupported(bpp, naxis, naxes) == false)
+        return 0;
+
+    // Image cards, other cards and END
+    size_t headerSize = padToBlock((imageCards(bpp, naxis) + cards + 1) * FITS_CARD);
+    return headerSize + padToBlock(dataSize(bpp, naxis, naxes));
+}
+
+bool writeFITSImage(const std::vector<std::string> &cards, const uint8_t *pixels, int bpp, int naxis,
+                    const long *naxes, uint8_t *output, size_t outputSize)
+{
+    size_t size = fitsImageSize(cards.size(), bpp, naxis, naxes);
+    if (size == 0 || size > outputSize || pixels == nullptr || output == nullptr)
+        return false;
+
+    HeaderWriter header(output);
+    header.value("SIMPLE", "T", "file does conform to FITS standard");
+    header.value("BITPIX", bpp, "number of bits per data pixel");
+    header.value("NAXIS", naxis, "number of data axes");
+    for (int i = 0; i < naxis; i++)
+    {
+        char keyword[16], comment[32];
+        snprintf(keyword, sizeof(keyword), "NAXIS%d", i + 1);
+        snprintf(comment, sizeof(comment), "length of data axis %d", i + 1);
+        header.value(keyword, naxes[i], comment);
+    }
+    header.value("EXTEND", "T", "FITS dataset may contain extensions");
+    if (bpp == 16)
+        header.value("BZERO", 32768, "offset data range to that of unsigned short");
+    else if (bpp == 32)
+        header.value("BZERO", 2147483648LL, "offset data range to that of unsigned long");
+    if (bpp > 8)
+        header.value("BSCALE", 1, "default scaling factor");
+
+    for (const auto &card : cards)
+        header.record(card);
+    header.record("END");
+
+    // Header is padded with spaces, data with zeros
+    char *dataStart = reinterpret_cast<char *>(output) + padToBlock(header.position() - reinterpret_cast<char *>(output));
+    memset(header.position(), ' ', dataStart - header.position());
+
+    uint8_t *data = reinterpret_cast<uint8_t *>(dataStart);
+    size_t bytes = dataSize(bpp, naxis, naxes);
+    fitsSwapPixels(pixels, data, bytes / (bpp / 8), bpp);
+    memset(data + bytes, 0, size - (data + bytes - output));
+
+    return true;
+}
+
+void fitsSwapPixels(const uint8_t *input, uint8_t *output, size_t count, int bpp)
+{
+    switch (bpp)
+    {
+        case 8:
+            memcpy(output, input, count);
+            break;
+
+        case 16:
+            swap16(reinterpret_cast<const uint16_t *>(input), output, count);
+            break;
+
+        case 32:
+            swap32(reinterpret_cast<const uint32_t *>(input), output, count);
+            break;
+
+        default:
+            break;
+    }
+}
+
+}
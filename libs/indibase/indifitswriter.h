@@ -0,0 +1,70 @@
+/*
+    Copyright (C) 2026 by the INDI Library contributors
+
+    Direct FITS Writer
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace INDI
+{
+
+/**
+ * @brief fitsImageSize Size of a FITS file written by writeFITSImage().
+ * @param cards number of header cards besides the ones describing the image.
+ * @param bpp bits per pixel, 8, 16 or 32.
+ * @param naxis number of axes, 2 or 3.
+ * @param naxes length of each axis.
+ * @return Size in bytes of the header and data units, both padded to 2880 bytes, or 0 if the image is not supported.
+ */
+size_t fitsImageSize(size_t cards, int bpp, int naxis, const long *naxes);
+
+/**
+ * @brief writeFITSImage Write a FITS file holding a single unsigned integer image, as cfitsio would.
+ *
+ * The header starts with the SIMPLE, BITPIX, NAXISn and EXTEND cards, plus BZERO and BSCALE for 16 and 32
+ * bits images, followed by cards and END.
+ *
+ * @param cards header records, at most 80 characters each. They must not describe the image data.
+ * @param pixels image pixels, in native byte order.
+ * @param bpp bits per pixel, 8, 16 or 32.
+ * @param naxis number of axes, 2 or 3.
+ * @param naxes length of each axis.
+ * @param output FITS file. It must hold fitsImageSize() bytes.
+ * @param outputSize size of output in bytes.
+ * @return True on success, false if the image is not supported or output is too small.
+ */
+bool writeFITSImage(const std::vector<std::string> &cards, const uint8_t *pixels, int bpp, int naxis,
+                    const long *naxes, uint8_t *output, size_t outputSize);
+
+/**
+ * @brief fitsSwapPixels Convert unsigned pixels into FITS data: offset by BZERO to signed values and stored
+ * big endian. Uses SSE2/AVX2 or NEON when available.
+ * @param input pixels, in native byte order.
+ * @param output FITS data. It must not overlap input.
+ * @param count number of pixels.
+ * @param bpp bits per pixel, 8, 16 or 32. 8 bits pixels are copied as is.
+ */
+void fitsSwapPixels(const uint8_t *input, uint8_t *output, size_t count, int bpp);
+
+}
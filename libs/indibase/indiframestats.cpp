@@ -0,0 +1,205 @@
+/*
+    Copyright (C) 2026 by the INDI Library contributors
+
+    Frame Statistics
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+*/
+
+#include "indiframestats.h"
+#include "indiworkerpool.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace INDI
+{
+
+namespace
+{
+
+// Smaller frames are not worth splitting across the worker pool
+constexpr size_t MIN_PIXELS_PER_THREAD = 1 << 20;
+
+struct ChunkStats
+{
+    std::vector<uint32_t> histogram;
+    // Only used by 32 bit frames, whose histogram holds the upper 16 bits of pixel values
+    uint32_t min { std::numeric_limits<uint32_t>::max() };
+    uint32_t max { 0 };
+    double sum { 0 };
+    double sumSquares { 0 };
+};
+
+template <typename T>
+void histogramChunk(const T *pixels, size_t count, ChunkStats &chunk)
+{
+    uint32_t *histogram = chunk.histogram.data();
+
+    for (size_t i = 0; i < count; i++)
+        histogram[pixels[i]]++;
+}
+
+void histogramChunk32(const uint32_t *pixels, size_t count, ChunkStats &chunk)
+{
+    uint32_t *histogram = chunk.histogram.data();
+    uint32_t lmin = chunk.min, lmax = chunk.max;
+    double sum = 0, sumSquares = 0;
+
+    for (size_t i = 0; i < count; i++)
+    {
+        uint32_t value = pixels[i];
+        histogram[value >> 16]++;
+        lmin = std::min(lmin, value);
+        lmax = std::max(lmax, value);
+        sum += value;
+        sumSquares += static_cast<double>(value) * value;
+    }
+
+    chunk.min = lmin;
+    chunk.max = lmax;
+    chunk.sum = sum;
+    chunk.sumSquares = sumSquares;
+}
+
+void processChunk(const uint8_t *buffer, size_t first, size_t count, int bpp, ChunkStats &chunk)
+{
+    switch (bpp)
+    {
+        case 8:
+            histogramChunk(buffer + first, count, chunk);
+            break;
+        case 16:
+            histogramChunk(reinterpret_cast<const uint16_t *>(buffer) + first, count, chunk);
+            break;
+        case 32:
+            histogramChunk32(reinterpret_cast<const uint32_t *>(buffer) + first, count, chunk);
+            break;
+    }
+}
+
+}
+
+bool computeFrameStats(const uint8_t *buffer, size_t pixels, int bpp, uint32_t bins, FrameStats &stats,
+                       unsigned int threads)
+{
+    if (buffer == nullptr || pixels == 0 || (bpp != 8 && bpp != 16 && bpp != 32))
+        return false;
+
+    if (threads == 0)
+    {
+        threads = WorkerPool::instance().concurrency();
+        threads = static_cast<unsigned int>(std::min<size_t>(threads, std::max<size_t>(1, pixels / MIN_PIXELS_PER_THREAD)));
+    }
+
+    const size_t histogramSize = (bpp == 8) ? 256 : 65536;
+    std::vector<ChunkStats> chunks(threads);
+    const size_t chunkSize = (pixels + threads - 1) / threads;
+
+    WorkerPool::instance().run(threads, [&](unsigned int i)
+    {
+        size_t first = i * chunkSize;
+        size_t count = first < pixels ? std::min(chunkSize, pixels - first) : 0;
+
+        chunks[i].histogram.assign(histogramSize, 0);
+        processChunk(buffer, first, count, bpp, chunks[i]);
+    });
+
+    // Merge chunks
+    std::vector<uint64_t> histogram(histogramSize, 0);
+    for (const auto &chunk : chunks)
+        for (size_t i = 0; i < histogramSize; i++)
+            histogram[i] += chunk.histogram[i];
+
+    // Value represented by a histogram bin
+    auto binValue = [&](size_t index)
+    {
+        return (bpp == 32) ? static_cast<double>((index << 16) + 32768) : static_cast<double>(index);
+    };
+
+    if (bpp == 32)
+    {
+        double sum = 0, sumSquares = 0;
+        uint32_t lmin = std::numeric_limits<uint32_t>::max(), lmax = 0;
+        for (const auto &chunk : chunks)
+        {
+            lmin = std::min(lmin, chunk.min);
+            lmax = std::max(lmax, chunk.max);
+            sum += chunk.sum;
+            sumSquares += chunk.sumSquares;
+        }
+
+        stats.min    = lmin;
+        stats.max    = lmax;
+        stats.mean   = sum / pixels;
+        stats.stddev = std::sqrt(std::max(0.0, sumSquares / pixels - stats.mean * stats.mean));
+    }
+    else
+    {
+        // Exact statistics from the histogram of all pixel values
+        size_t first = 0, last = histogramSize - 1;
+        while (histogram[first] == 0)
+            first++;
+        while (histogram[last] == 0)
+            last--;
+
+        double sum = 0;
+        for (size_t i = first; i <= last; i++)
+            sum += static_cast<double>(histogram[i]) * i;
+
+        double mean = sum / pixels, variance = 0;
+        for (size_t i = first; i <= last; i++)
+            variance += histogram[i] * (i - mean) * (i - mean);
+
+        stats.min    = first;
+        stats.max    = last;
+        stats.mean   = mean;
+        stats.stddev = std::sqrt(variance / pixels);
+    }
+
+    // Median
+    uint64_t cumulative = 0;
+    for (size_t i = 0; i < histogramSize; i++)
+    {
+        cumulative += histogram[i];
+        if (cumulative * 2 >= pixels)
+        {
+            stats.median = std::min(stats.max, std::max(stats.min, binValue(i)));
+            break;
+        }
+    }
+
+    // Histogram over [min, max]
+    stats.histogram.assign(bins, 0);
+    if (bins > 0)
+    {
+        double range = stats.max - stats.min + 1;
+        for (size_t i = 0; i < histogramSize; i++)
+        {
+            if (histogram[i] == 0)
+                continue;
+
+            double value = std::min(stats.max, std::max(stats.min, binValue(i)));
+            size_t bin = std::min<size_t>(bins - 1, static_cast<size_t>((value - stats.min) / range * bins));
+            stats.histogram[bin] += static_cast<uint32_t>(histogram[i]);
+        }
+    }
+
+    return true;
+}
+
+}
@@ -0,0 +1,61 @@
+/*
+    Copyright (C) 2026 by the INDI Library contributors
+
+    Frame Statistics
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace INDI
+{
+
+/**
+ * @brief The FrameStats struct holds basic statistics of a frame.
+ */
+struct FrameStats
+{
+    double min {0};
+    double max {0};
+    double mean {0};
+    double stddev {0};
+    /// Exact for 8 and 16 bits per pixel, within 1/65536 of the 32 bit range otherwise.
+    double median {0};
+    /// Pixel counts of bins of equal width spread over [min, max].
+    std::vector<uint32_t> histogram;
+};
+
+/**
+ * @brief computeFrameStats Compute frame statistics in a single pass over the pixels.
+ * The frame is split in chunks processed by parallel threads. Each thread fills a histogram of pixel
+ * values (of the upper 16 bits for 32 bit frames), from which all statistics are derived.
+ * @param buffer frame pixels, in native byte order.
+ * @param pixels number of pixels in buffer.
+ * @param bpp bits per pixel, 8, 16 or 32.
+ * @param bins number of histogram bins, 0 to skip the histogram.
+ * @param stats computed statistics.
+ * @param threads number of tasks run on the shared WorkerPool, 0 to pick one based on frame size and available cores.
+ * @return True on success, false if bpp is not supported or there are no pixels.
+ */
+bool computeFrameStats(const uint8_t *buffer, size_t pixels, int bpp, uint32_t bins, FrameStats &stats,
+                       unsigned int threads = 0);
+
+}
@@ -23,11 +23,17 @@
 
 #include <dirent.h>
 #include <cerrno>
+#include <chrono>
 #include <iostream>
 #include <cstdlib>
 #include <cstring>
 #include <sys/stat.h>
 
+// Maximum number of lines waiting to be written to the log file
+#define LOGGER_RING_SIZE 8192
+// Period of log file flushes
+#define LOGGER_FLUSH_PERIOD_MS 1000
+
 namespace INDI
 {
 char Logger::Tags[Logger::nlevels][MAXINDINAME] = { "ERROR",       "WARNING",     "INFO",        "DEBUG",
@@ -68,6 +74,7 @@ std::string Logger::logDir_;
 std::string Logger::logFile_;
 unsigned int Logger::nDevices    = 0;
 unsigned int Logger::customLevel = 4;
+std::atomic<uint64_t> Logger::droppedLines_ { 0 };
 
 int Logger::addDebugLevel(const char *debugLevelName, const char *loggingLevelName)
 {
@@ -278,6 +285,117 @@ void Logger::unlock()
 Logger::Logger() : configured_(false)
 {
     gettimeofday(&initialTime_, nullptr);
+    ring_.resize(LOGGER_RING_SIZE);
+}
+
+void Logger::pushLine(const char *line)
+{
+    std::lock_guard<std::mutex> locker(ringLock_);
+
+    if (ringCount_ == ring_.size())
+    {
+        ringDropped_++;
+        droppedLines_++;
+        return;
+    }
+
+    // Slots keep their capacity, so no allocation happens once the ring is warmed up.
+    ring_[(ringHead_ + ringCount_) % ring_.size()].assign(line);
+    if (ringCount_++ == 0)
+        ringCondition_.notify_one();
+}
+
+size_t Logger::takeLines(std::vector<std::string> &batch, uint64_t &dropped)
+{
+    size_t count = ringCount_;
+
+    if (batch.size() < count)
+        batch.resize(count);
+
+    // Swap strings so the ring gets back the capacity of the previous batch.
+    for (size_t i = 0; i < count; i++)
+        std::swap(batch[i], ring_[(ringHead_ + i) % ring_.size()]);
+
+    ringHead_  = (ringHead_ + count) % ring_.size();
+    ringCount_ = 0;
+    dropped    = ringDropped_;
+    ringDropped_ = 0;
+
+    return count;
+}
+
+void Logger::writeLines(std::vector<std::string> &batch, size_t count, uint64_t dropped)
+{
+    if (!out_.is_open())
+        return;
+
+    for (size_t i = 0; i < count; i++)
+        out_ << batch[i] << '\n';
+
+    if (dropped > 0)
+        out_ << Tags[rank(DBG_WARNING)] << "\t" << dropped << " log lines dropped, log buffer is full.\n";
+}
+
+void Logger::writerLoop()
+{
+    std::vector<std::string> batch;
+    auto lastFlush = std::chrono::steady_clock::now();
+    std::unique_lock<std::mutex> ringLocker(ringLock_);
+
+    while (!writerQuit_)
+    {
+        ringCondition_.wait_for(ringLocker, std::chrono::milliseconds(LOGGER_FLUSH_PERIOD_MS), [this]
+        {
+            return ringCount_ > 0 || writerQuit_;
+        });
+
+        uint64_t dropped = 0;
+        size_t count = takeLines(batch, dropped);
+        ringLocker.unlock();
+
+        {
+            std::lock_guard<std::mutex> fileLocker(fileLock_);
+            writeLines(batch, count, dropped);
+
+            auto now = std::chrono::steady_clock::now();
+            if (now - lastFlush >= std::chrono::milliseconds(LOGGER_FLUSH_PERIOD_MS))
+            {
+                if (out_.is_open())
+                    out_.flush();
+                lastFlush = now;
+            }
+        }
+
+        ringLocker.lock();
+    }
+}
+
+void Logger::flush()
+{
+    std::vector<std::string> batch;
+    uint64_t dropped = 0;
+    size_t count = 0;
+
+    std::lock_guard<std::mutex> fileLocker(fileLock_);
+    {
+        std::lock_guard<std::mutex> ringLocker(ringLock_);
+        count = takeLines(batch, dropped);
+    }
+
+    writeLines(batch, count, dropped);
+    if (out_.is_open())
+        out_.flush();
+}
+
+uint64_t Logger::getDroppedLines()
+{
+    return droppedLines_;
+}
+
+// Lines still queued when the driver exits are written to the file.
+static void flushLogger()
+{
+    Logger::getInstance().flush();
 }
 
 void Logger::configure(const std::string &outputFile, const loggerConf configuration, const int fileVerbosityLevel,
@@ -288,6 +406,12 @@ void Logger::configure(const std::string &outputFile, const loggerConf configura
     fileVerbosityLevel_   = fileVerbosityLevel;
     screenVerbosityLevel_ = screenVerbosityLevel;
     rememberscreenlevel_  = screenVerbosityLevel_;
+
+    // Lines queued so far belong to the old stream
+    flush();
+
+    std::lock_guard<std::mutex> fileLocker(fileLock_);
+
     // Close the old stream, if needed
     if (configuration_ & file_on)
         out_.close();
@@ -318,6 +442,12 @@ void Logger::configure(const std::string &outputFile, const loggerConf configura
     {
         INDI::mkpath(logDir_.c_str(), 0775);
         out_.open(logFile_.c_str(), std::ios::app);
+
+        if (!writerThread_.joinable())
+        {
+            writerThread_ = std::thread(&Logger::writerLoop, this);
+            std::atexit(flushLogger);
+        }
     }
 
     configuration_ = configuration;
@@ -328,6 +458,16 @@ void Logger::configure(const std::string &outputFile, const loggerConf configura
 
 Logger::~Logger()
 {
+    {
+        std::lock_guard<std::mutex> ringLocker(ringLock_);
+        writerQuit_ = true;
+        ringCondition_.notify_one();
+    }
+    if (writerThread_.joinable())
+        writerThread_.join();
+
+    flush();
+
     Logger::lock();
     if (configuration_ & file_on)
         out_.close();
@@ -379,8 +519,12 @@ void Logger::print(const char *devicename, const unsigned int verbosityLevel, co
 
     INDI_UNUSED(file);
     INDI_UNUSED(line);
-    bool filelog   = (verbosityLevel & fileVerbosityLevel_) != 0;
-    bool screenlog = (verbosityLevel & screenVerbosityLevel_) != 0;
+    bool filelog   = (configuration_ & file_on) && (verbosityLevel & fileVerbosityLevel_) != 0;
+    bool screenlog = (configuration_ & screen_on) && (verbosityLevel & screenVerbosityLevel_) != 0;
+
+    // Do not format messages that are not logged anywhere
+    if (configured_ && !filelog && !screenlog)
+        return;
 
     va_list ap;
     char msg[257];
@@ -408,17 +552,19 @@ void Logger::print(const char *devicename, const unsigned int verbosityLevel, co
 #endif
     Logger::lock();
 
-    if ((configuration_ & file_on) && filelog)
+    if (filelog)
     {
+        char logLine[MAXRBUF];
         if (nDevices == 1)
-            out_ << Tags[rank(verbosityLevel)] << "\t" << (resTime.tv_sec) << "." << (usec) << " sec"
-                 << "\t: " << msg << std::endl;
+            snprintf(logLine, MAXRBUF, "%s\t%ld.%s sec\t: %s", Tags[rank(verbosityLevel)],
+                     static_cast<long>(resTime.tv_sec), usec, msg);
         else
-            out_ << Tags[rank(verbosityLevel)] << "\t" << (resTime.tv_sec) << "." << (usec) << " sec"
-                 << "\t: [" << devicename << "] " << msg << std::endl;
+            snprintf(logLine, MAXRBUF, "%s\t%ld.%s sec\t: [%s] %s", Tags[rank(verbosityLevel)],
+                     static_cast<long>(resTime.tv_sec), usec, devicename, msg);
+        pushLine(logLine);
     }
 
-    if ((configuration_ & screen_on) && screenlog)
+    if (screenlog)
         IDMessage(devicename, "[%s] %s", Tags[rank(verbosityLevel)], msg);
 
     Logger::unlock();
@@ -24,10 +24,15 @@
 #include "defaultdevice.h"
 
 #include <stdarg.h>
+#include <atomic>
+#include <condition_variable>
 #include <fstream>
+#include <mutex>
 #include <ostream>
 #include <string>
 #include <sstream>
+#include <thread>
+#include <vector>
 #include <sys/time.h>
 
 /**
@@ -109,6 +114,10 @@ namespace INDI
  *
  * To add a new debug level, call addDebugLevel(). You can add an additional 4 custom debug/logging levels.
  *
+ * Messages are only formatted if they are logged to the file or to the client. Lines logged to file are queued
+ * in a ring buffer and written by a background thread, so logging never waits for the disk. The file is flushed
+ * periodically and when the driver exits. If the ring buffer is full, lines are dropped and counted, see getDroppedLines().
+ *
  * Check INDI Tutorial two for an example simple implementation.
  */
 class Logger
@@ -153,6 +162,35 @@ class Logger
 
         /// Stream used when logging on a file
         std::ofstream out_;
+
+        /// Ring buffer of lines waiting to be written to the file
+        std::vector<std::string> ring_;
+        size_t ringHead_ { 0 };
+        size_t ringCount_ { 0 };
+        /// Number of lines dropped since the last line written to the file
+        uint64_t ringDropped_ { 0 };
+        /// Lock protecting the ring buffer
+        std::mutex ringLock_;
+        /// Lock protecting the file stream
+        std::mutex fileLock_;
+        std::condition_variable ringCondition_;
+        /// Background thread writing the ring buffer to the file
+        std::thread writerThread_;
+        bool writerQuit_ { false };
+        /// Total number of lines dropped because the ring buffer was full
+        static std::atomic<uint64_t> droppedLines_;
+
+        /** @brief Queue a formatted line to be written to the log file */
+        void pushLine(const char *line);
+        /** @brief Background thread writing queued lines to the log file */
+        void writerLoop();
+        /**
+         * @brief Move queued lines to the batch. ringLock_ must be held.
+         * @return Number of lines moved.
+         */
+        size_t takeLines(std::vector<std::string> &batch, uint64_t &dropped);
+        /** @brief Write a batch of lines to the log file. fileLock_ must be held. */
+        void writeLines(std::vector<std::string> &batch, size_t count, uint64_t dropped);
         /// Initial time (used to print relative times)
         struct timeval initialTime_;
         /// Verbosity threshold for files
@@ -238,6 +276,17 @@ class Logger
          */
         static Logger &getInstance();
 
+        /**
+         * @brief flush Write all queued lines to the log file and flush it to disk.
+         */
+        void flush();
+
+        /**
+         * @brief getDroppedLines Get the number of lines that could not be logged to file because the
+         * ring buffer was full.
+         */
+        static uint64_t getDroppedLines();
+
         static bool saveConfigItems(FILE *fp);
 
         /**
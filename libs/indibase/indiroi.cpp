@@ -0,0 +1,194 @@
+/*
+    Copyright (C) 2026 by the INDI Library contributors
+
+    Multiple Regions Of Interest
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+*/
+
+#include "indiroi.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+namespace INDI
+{
+
+namespace
+{
+
+constexpr char ROI_MAGIC[4] = {'I', 'R', 'O', 'I'};
+constexpr uint16_t ROI_VERSION = 1;
+constexpr size_t ROI_HEADER_SIZE = 24;
+constexpr size_t ROI_DESCRIPTOR_SIZE = 20;
+
+void put16(uint8_t *data, uint16_t value)
+{
+    data[0] = static_cast<uint8_t>(value);
+    data[1] = static_cast<uint8_t>(value >> 8);
+}
+
+void put32(uint8_t *data, uint32_t value)
+{
+    for (int i = 0; i < 4; i++)
+        data[i] = static_cast<uint8_t>(value >> (8 * i));
+}
+
+uint16_t get16(const uint8_t *data)
+{
+    return static_cast<uint16_t>(data[0] | (data[1] << 8));
+}
+
+uint32_t get32(const uint8_t *data)
+{
+    uint32_t value = 0;
+    for (int i = 3; i >= 0; i--)
+        value = (value << 8) | data[i];
+    return value;
+}
+
+bool isLittleEndian()
+{
+    const uint16_t value = 1;
+    return *reinterpret_cast<const uint8_t *>(&value) == 1;
+}
+
+// Copy count pixels of bpp bits, converting between native and little endian
+void copyPixels(const uint8_t *input, uint8_t *output, size_t count, int bpp)
+{
+    size_t bytes = bpp / 8;
+    if (bytes == 1 || isLittleEndian())
+    {
+        memcpy(output, input, count * bytes);
+        return;
+    }
+
+    for (size_t i = 0; i < count; i++)
+        for (size_t b = 0; b < bytes; b++)
+            output[i * bytes + b] = input[i * bytes + bytes - 1 - b];
+}
+
+}
+
+bool packROIs(const uint8_t *pixels, const ROIFrame &frame, const std::vector<FrameROI> &rois, double exposure,
+              std::vector<uint8_t> &output)
+{
+    if (pixels == nullptr || (frame.bpp != 8 && frame.bpp != 16 && frame.bpp != 32) || frame.binX == 0 ||
+            frame.binY == 0 || frame.binX > 0xFF || frame.binY > 0xFF || rois.size() > std::numeric_limits<uint16_t>::max())
+        return false;
+
+    size_t bytesPerPixel = frame.bpp / 8;
+
+    // Clip every region to the frame, in binned pixels of the frame
+    std::vector<FrameROI> clipped(rois.size());
+    size_t size = ROI_HEADER_SIZE + rois.size() * ROI_DESCRIPTOR_SIZE;
+    for (size_t i = 0; i < rois.size(); i++)
+    {
+        const FrameROI &roi = rois[i];
+        int64_t left   = (static_cast<int64_t>(roi.x) - frame.x) / frame.binX;
+        int64_t top    = (static_cast<int64_t>(roi.y) - frame.y) / frame.binY;
+        int64_t right  = left + roi.width / frame.binX;
+        int64_t bottom = top + roi.height / frame.binY;
+        left   = std::max<int64_t>(0, left);
+        top    = std::max<int64_t>(0, top);
+        right  = std::min<int64_t>(frame.width, right);
+        bottom = std::min<int64_t>(frame.height, bottom);
+
+        if (right > left && bottom > top)
+        {
+            clipped[i].x      = static_cast<uint32_t>(left);
+            clipped[i].y      = static_cast<uint32_t>(top);
+            clipped[i].width  = static_cast<uint32_t>(right - left);
+            clipped[i].height = static_cast<uint32_t>(bottom - top);
+        }
+        size += static_cast<size_t>(clipped[i].width) * clipped[i].height * bytesPerPixel;
+    }
+
+    if (size > std::numeric_limits<uint32_t>::max())
+        return false;
+
+    output.assign(size, 0);
+    uint8_t *header = output.data();
+    memcpy(header, ROI_MAGIC, sizeof(ROI_MAGIC));
+    put16(header + 4, ROI_VERSION);
+    put16(header + 6, static_cast<uint16_t>(rois.size()));
+    header[8]  = frame.bpp;
+    header[9]  = static_cast<uint8_t>(frame.binX);
+    header[10] = static_cast<uint8_t>(frame.binY);
+    double microseconds = std::max(0.0, std::min(exposure * 1e6, static_cast<double>(std::numeric_limits<uint32_t>::max())));
+    put32(header + 12, static_cast<uint32_t>(std::lround(microseconds)));
+
+    size_t offset = ROI_HEADER_SIZE + rois.size() * ROI_DESCRIPTOR_SIZE;
+    for (size_t i = 0; i < rois.size(); i++)
+    {
+        const FrameROI &roi = clipped[i];
+        uint8_t *descriptor = output.data() + ROI_HEADER_SIZE + i * ROI_DESCRIPTOR_SIZE;
+        // Sensor position of the region, which may differ from the requested one once clipped or binned
+        put32(descriptor, roi.width ? frame.x + roi.x * frame.binX : rois[i].x);
+        put32(descriptor + 4, roi.height ? frame.y + roi.y * frame.binY : rois[i].y);
+        put32(descriptor + 8, roi.width);
+        put32(descriptor + 12, roi.height);
+        put32(descriptor + 16, static_cast<uint32_t>(offset));
+
+        size_t rowBytes = static_cast<size_t>(roi.width) * bytesPerPixel;
+        for (uint32_t row = 0; row < roi.height; row++)
+        {
+            const uint8_t *source = pixels + ((static_cast<size_t>(roi.y) + row) * frame.width + roi.x) * bytesPerPixel;
+            copyPixels(source, output.data() + offset, roi.width, frame.bpp);
+            offset += rowBytes;
+        }
+    }
+
+    return true;
+}
+
+bool unpackROIs(const uint8_t *data, size_t size, std::vector<PackedROI> &rois, int &bpp)
+{
+    if (data == nullptr || size < ROI_HEADER_SIZE || memcmp(data, ROI_MAGIC, sizeof(ROI_MAGIC)) != 0 ||
+            get16(data + 4) != ROI_VERSION)
+        return false;
+
+    size_t count = get16(data + 6);
+    bpp = data[8];
+    if ((bpp != 8 && bpp != 16 && bpp != 32) || size < ROI_HEADER_SIZE + count * ROI_DESCRIPTOR_SIZE)
+        return false;
+
+    size_t bytesPerPixel = bpp / 8;
+    rois.resize(count);
+    for (size_t i = 0; i < count; i++)
+    {
+        const uint8_t *descriptor = data + ROI_HEADER_SIZE + i * ROI_DESCRIPTOR_SIZE;
+        PackedROI &roi = rois[i];
+        roi.roi.x      = get32(descriptor);
+        roi.roi.y      = get32(descriptor + 4);
+        roi.roi.width  = get32(descriptor + 8);
+        roi.roi.height = get32(descriptor + 12);
+        size_t offset  = get32(descriptor + 16);
+
+        size_t pixels = static_cast<size_t>(roi.roi.width) * roi.roi.height;
+        if (offset > size || pixels * bytesPerPixel > size - offset)
+            return false;
+
+        roi.pixels.resize(pixels * bytesPerPixel);
+        copyPixels(data + offset, roi.pixels.data(), pixels, bpp);
+    }
+
+    return true;
+}
+
+}
@@ -0,0 +1,109 @@
+/*
+    Copyright (C) 2026 by the INDI Library contributors
+
+    Multiple Regions Of Interest
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace INDI
+{
+
+/**
+ * @brief A rectangle of the sensor, in unbinned pixels.
+ */
+struct FrameROI
+{
+    uint32_t x {0};
+    uint32_t y {0};
+    uint32_t width {0};
+    uint32_t height {0};
+};
+
+/**
+ * @brief Geometry of the frame ROIs are cropped from.
+ */
+struct ROIFrame
+{
+    /// Origin of the frame on the sensor, in unbinned pixels
+    uint32_t x {0};
+    uint32_t y {0};
+    /// Size of the frame in binned pixels
+    uint32_t width {0};
+    uint32_t height {0};
+    uint32_t binX {1};
+    uint32_t binY {1};
+    /// 8, 16 or 32
+    uint8_t bpp {8};
+};
+
+/**
+ * @brief packROIs Crop regions of a frame into a single buffer, uploaded with the ".rois" format.
+ *
+ * All values are little endian. The buffer starts with a 24 bytes header:
+ * | Offset | Size | Content                                   |
+ * |--------|------|-------------------------------------------|
+ * | 0      | 4    | "IROI"                                    |
+ * | 4      | 2    | Version, 1                                |
+ * | 6      | 2    | Number of regions N                       |
+ * | 8      | 1    | Bits per pixel                            |
+ * | 9      | 1    | Horizontal binning                        |
+ * | 10     | 1    | Vertical binning                          |
+ * | 11     | 1    | Reserved, 0                               |
+ * | 12     | 4    | Exposure duration in microseconds         |
+ * | 16     | 8    | Reserved, 0                               |
+ *
+ * N descriptors of 20 bytes follow: x and y of the region on the sensor in unbinned pixels, width and
+ * height of its data in binned pixels, and offset of its data from the start of the buffer. Data of each
+ * region is stored row by row.
+ *
+ * Regions are clipped to the frame. Regions entirely outside of it are kept with an empty size.
+ *
+ * @param pixels frame pixels, in native byte order.
+ * @param frame geometry of the frame.
+ * @param rois regions to crop, in unbinned sensor pixels. At most 65535.
+ * @param exposure exposure duration of the frame in seconds.
+ * @param output packed regions.
+ * @return False if the frame or the number of regions are not supported.
+ */
+bool packROIs(const uint8_t *pixels, const ROIFrame &frame, const std::vector<FrameROI> &rois, double exposure,
+              std::vector<uint8_t> &output);
+
+/**
+ * @brief A region read back from a buffer written by packROIs().
+ */
+struct PackedROI
+{
+    /// Position on the sensor in unbinned pixels, size in binned pixels
+    FrameROI roi;
+    /// Pixels in native byte order
+    std::vector<uint8_t> pixels;
+};
+
+/**
+ * @brief unpackROIs Read the regions of a buffer written by packROIs().
+ * @param bpp bits per pixel of the regions.
+ * @return False if data is not a valid buffer.
+ */
+bool unpackROIs(const uint8_t *data, size_t size, std::vector<PackedROI> &rois, int &bpp);
+
+}
@@ -1071,7 +1071,7 @@ void SensorInterface::getMinMax(double *min, double *max, uint8_t *buf, int len,
                     ind = (i * integrationWidth) + j;
                     if (integrationBuffer[ind] < lmin)
                         lmin = integrationBuffer[ind];
-                    else if (integrationBuffer[ind] > lmax)
+                    if (integrationBuffer[ind] > lmax)
                         lmax = integrationBuffer[ind];
                 }
         }
@@ -1088,7 +1088,7 @@ void SensorInterface::getMinMax(double *min, double *max, uint8_t *buf, int len,
                     ind = (i * integrationWidth) + j;
                     if (integrationBuffer[ind] < lmin)
                         lmin = integrationBuffer[ind];
-                    else if (integrationBuffer[ind] > lmax)
+                    if (integrationBuffer[ind] > lmax)
                         lmax = integrationBuffer[ind];
                 }
         }
@@ -1105,7 +1105,7 @@ void SensorInterface::getMinMax(double *min, double *max, uint8_t *buf, int len,
                     ind = (i * integrationWidth) + j;
                     if (integrationBuffer[ind] < lmin)
                         lmin = integrationBuffer[ind];
-                    else if (integrationBuffer[ind] > lmax)
+                    if (integrationBuffer[ind] > lmax)
                         lmax = integrationBuffer[ind];
                 }
         }
@@ -1122,7 +1122,7 @@ void SensorInterface::getMinMax(double *min, double *max, uint8_t *buf, int len,
                     ind = (i * integrationWidth) + j;
                     if (integrationBuffer[ind] < lmin)
                         lmin = integrationBuffer[ind];
-                    else if (integrationBuffer[ind] > lmax)
+                    if (integrationBuffer[ind] > lmax)
                         lmax = integrationBuffer[ind];
                 }
         }
@@ -1139,7 +1139,7 @@ void SensorInterface::getMinMax(double *min, double *max, uint8_t *buf, int len,
                     ind = (i * integrationWidth) + j;
                     if (integrationBuffer[ind] < lmin)
                         lmin = integrationBuffer[ind];
-                    else if (integrationBuffer[ind] > lmax)
+                    if (integrationBuffer[ind] > lmax)
                         lmax = integrationBuffer[ind];
                 }
         }
@@ -1156,7 +1156,7 @@ void SensorInterface::getMinMax(double *min, double *max, uint8_t *buf, int len,
                     ind = (i * integrationWidth) + j;
                     if (integrationBuffer[ind] < lmin)
                         lmin = integrationBuffer[ind];
-                    else if (integrationBuffer[ind] > lmax)
+                    if (integrationBuffer[ind] > lmax)
                         lmax = integrationBuffer[ind];
                 }
         }
@@ -0,0 +1,383 @@
+/*
+    Copyright (C) 2026 by the INDI Library contributors
+
+    Frame Stacker
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+*/
+
+#include "indistacker.h"
+#include "indiworkerpool.h"
+
+#include "dsp.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <type_traits>
+
+namespace INDI
+{
+
+namespace
+{
+
+// Smaller frames are not worth splitting across the worker pool
+constexpr size_t MIN_PIXELS_PER_THREAD = 1 << 20;
+// Brightest stars used for alignment
+constexpr size_t ALIGN_STARS = 16;
+// Stars matched with the reference stars for a frame to be aligned
+constexpr size_t ALIGN_MIN_MATCHES = 3;
+// Distance in pixels between a star and its match once the translation is applied
+constexpr double ALIGN_MATCH_RADIUS = 2.5;
+// Samples a pixel must have before sigma clipping applies
+constexpr uint16_t CLIP_MIN_SAMPLES = 3;
+
+dsp_stream_p createStream(const std::vector<StarInfo> &stars, uint32_t width, uint32_t height)
+{
+    dsp_stream_p stream = dsp_stream_new();
+    dsp_stream_add_dim(stream, static_cast<int>(width));
+    dsp_stream_add_dim(stream, static_cast<int>(height));
+
+    for (const auto &star : stars)
+    {
+        double location[2] = {star.x, star.y};
+        dsp_star dspStar;
+        dspStar.center.location = location;
+        dspStar.center.dims = 2;
+        // Triangles are built from the largest stars first
+        dspStar.diameter = star.flux;
+        dspStar.name[0] = '\0';
+        dsp_stream_add_star(stream, dspStar);
+    }
+    return stream;
+}
+
+void freeAlignInfo(dsp_stream_p stream)
+{
+    free(stream->align_info.offset);
+    free(stream->align_info.center);
+    free(stream->align_info.radians);
+    free(stream->align_info.factor);
+    stream->align_info.offset = stream->align_info.center = stream->align_info.radians = stream->align_info.factor = nullptr;
+}
+
+void freeStream(dsp_stream_p stream)
+{
+    // dsp_stream_free() leaves the alignment result to the caller
+    freeAlignInfo(stream);
+    dsp_stream_free_buffer(stream);
+    dsp_stream_free(stream);
+}
+
+template <typename T>
+void forEachRowBlock(uint32_t height, size_t pixels, T function)
+{
+    unsigned int threads = WorkerPool::instance().concurrency();
+    threads = static_cast<unsigned int>(std::max<size_t>(1, std::min<size_t>({threads, height, pixels / MIN_PIXELS_PER_THREAD})));
+
+    uint32_t rowsPerThread = (height + threads - 1) / threads;
+    WorkerPool::instance().run(threads, [&](unsigned int i)
+    {
+        uint32_t firstRow = std::min(height, i * rowsPerThread);
+        uint32_t lastRow  = std::min(height, firstRow + rowsPerThread);
+        function(firstRow, lastRow);
+    });
+}
+
+}
+
+void FrameStacker::setMode(StackMode mode)
+{
+    if (mode != m_Mode)
+    {
+        m_Mode = mode;
+        reset();
+    }
+}
+
+void FrameStacker::setDepth(uint32_t depth)
+{
+    m_Depth = std::max<uint32_t>(1, std::min<uint32_t>(depth, std::numeric_limits<uint16_t>::max()));
+    if (m_Count >= m_Depth)
+        reset();
+}
+
+void FrameStacker::setAlignment(bool enabled)
+{
+    if (enabled != m_Align)
+    {
+        m_Align = enabled;
+        reset();
+    }
+}
+
+void FrameStacker::reset()
+{
+    m_Count = 0;
+    m_Exposure = 0;
+    m_ReferenceStars.clear();
+    std::fill(m_Sum.begin(), m_Sum.end(), 0);
+    std::fill(m_Accumulator.begin(), m_Accumulator.end(), 0.0f);
+    std::fill(m_Deviation.begin(), m_Deviation.end(), 0.0f);
+    std::fill(m_Samples.begin(), m_Samples.end(), 0);
+}
+
+int FrameStacker::outputBPP() const
+{
+    return m_Mode == STACK_SUM ? 32 : m_BPP;
+}
+
+bool FrameStacker::findOffset(const std::vector<StarInfo> &stars, int &dx, int &dy) const
+{
+    if (stars.size() < ALIGN_MIN_MATCHES || m_ReferenceStars.size() < ALIGN_MIN_MATCHES)
+        return false;
+
+    dsp_stream_p reference = createStream(m_ReferenceStars, m_Width, m_Height);
+    dsp_stream_p frame = createStream(stars, m_Width, m_Height);
+
+    // dsp_align_get_offset() replaces the alignment result of frame without freeing it
+    freeAlignInfo(frame);
+
+    // Rotation and scale are not corrected, only the translation is used
+    int result = dsp_align_get_offset(reference, frame, 1, 80);
+    double offsetX = 0, offsetY = 0;
+    bool matched = (result & DSP_ALIGN_NO_MATCH) == 0;
+    if (matched)
+    {
+        offsetX = frame->align_info.offset[0];
+        offsetY = frame->align_info.offset[1];
+    }
+
+    freeStream(reference);
+    freeStream(frame);
+
+    if (!matched)
+        return false;
+
+    // Triangle matching can pick a wrong match, check that enough stars line up and refine the offset
+    size_t matches = 0;
+    double sumX = 0, sumY = 0;
+    for (const auto &star : m_ReferenceStars)
+    {
+        for (const auto &candidate : stars)
+        {
+            double errorX = candidate.x - star.x - offsetX;
+            double errorY = candidate.y - star.y - offsetY;
+            if (errorX * errorX + errorY * errorY <= ALIGN_MATCH_RADIUS * ALIGN_MATCH_RADIUS)
+            {
+                matches++;
+                sumX += candidate.x - star.x;
+                sumY += candidate.y - star.y;
+                break;
+            }
+        }
+    }
+
+    if (matches < ALIGN_MIN_MATCHES)
+        return false;
+
+    dx = static_cast<int>(std::lround(sumX / matches));
+    dy = static_cast<int>(std::lround(sumY / matches));
+    return true;
+}
+
+template <typename T>
+void FrameStacker::accumulate(const T *pixels, int dx, int dy)
+{
+    // Pixel (x, y) of the stack receives pixel (x + dx, y + dy) of the frame
+    uint32_t firstX = static_cast<uint32_t>(std::max(0, -dx));
+    uint32_t lastX  = static_cast<uint32_t>(std::max<int64_t>(firstX, std::min<int64_t>(m_Width, static_cast<int64_t>(m_Width) - dx)));
+    bool clip = m_Mode == STACK_SIGMA_CLIP;
+    float sigma = static_cast<float>(m_Sigma);
+
+    forEachRowBlock(m_Height, static_cast<size_t>(m_Width) * m_Height, [&](uint32_t firstRow, uint32_t lastRow)
+    {
+        for (uint32_t y = firstRow; y < lastRow; y++)
+        {
+            int64_t sourceY = static_cast<int64_t>(y) + dy;
+            if (sourceY < 0 || sourceY >= m_Height)
+                continue;
+
+            size_t row = static_cast<size_t>(y) * m_Width;
+            const T *source = pixels + static_cast<size_t>(sourceY) * m_Width;
+            uint16_t *samples = m_Samples.data() + row;
+
+            if (!clip)
+            {
+                uint64_t *sum = m_Sum.data() + row;
+                for (uint32_t x = firstX; x < lastX; x++)
+                {
+                    sum[x] += source[x + dx];
+                    samples[x]++;
+                }
+                continue;
+            }
+
+            // Welford's running mean and variance of the samples kept
+            float *accumulator = m_Accumulator.data() + row;
+            float *deviation = m_Deviation.data() + row;
+            for (uint32_t x = firstX; x < lastX; x++)
+            {
+                float value = source[x + dx];
+                uint16_t n = samples[x];
+                float delta = value - accumulator[x];
+                if (n >= CLIP_MIN_SAMPLES)
+                {
+                    // Noise floor of half a unit, so constant pixels do not reject every new sample
+                    float stddev = std::max(0.5f, std::sqrt(deviation[x] / (n - 1)));
+                    if (std::fabs(delta) > sigma * stddev)
+                        continue;
+                }
+                n++;
+                accumulator[x] += delta / n;
+                deviation[x] += delta * (value - accumulator[x]);
+                samples[x] = n;
+            }
+        }
+    });
+}
+
+FrameStacker::AddResult FrameStacker::add(const uint8_t *pixels, uint32_t width, uint32_t height, int bpp,
+        double exposure)
+{
+    if (pixels == nullptr || width == 0 || height == 0 || (bpp != 8 && bpp != 16 && bpp != 32))
+    {
+        m_Rejected++;
+        return FRAME_REJECTED;
+    }
+
+    if (width != m_Width || height != m_Height || bpp != m_BPP)
+    {
+        size_t count = static_cast<size_t>(width) * height;
+        m_Width = width;
+        m_Height = height;
+        m_BPP = bpp;
+        m_Samples.assign(count, 0);
+        m_Sum.clear();
+        m_Accumulator.clear();
+        m_Deviation.clear();
+        reset();
+    }
+
+    // Only the accumulators of the current mode are kept
+    if (m_Mode == STACK_SIGMA_CLIP && m_Accumulator.size() != m_Samples.size())
+    {
+        m_Sum.clear();
+        m_Accumulator.assign(m_Samples.size(), 0.0f);
+        m_Deviation.assign(m_Samples.size(), 0.0f);
+    }
+    else if (m_Mode != STACK_SIGMA_CLIP && m_Sum.size() != m_Samples.size())
+    {
+        m_Accumulator.clear();
+        m_Deviation.clear();
+        m_Sum.assign(m_Samples.size(), 0);
+    }
+
+    int dx = 0, dy = 0;
+    if (m_Align)
+    {
+        // Background gradients are handled by the detector, only the brightest stars are kept
+        StarDetection detection;
+        detectStars(pixels, width, height, bpp, detection);
+        std::vector<StarInfo> stars = std::move(detection.stars);
+        if (stars.size() > ALIGN_STARS)
+            stars.resize(ALIGN_STARS);
+
+        if (m_Count == 0)
+        {
+            // The first frame of the stack is the reference, it needs enough stars to align the others on
+            if (stars.size() < ALIGN_MIN_MATCHES)
+            {
+                m_Rejected++;
+                return FRAME_REJECTED;
+            }
+            m_ReferenceStars = std::move(stars);
+        }
+        else if (findOffset(stars, dx, dy) == false ||
+                 static_cast<uint32_t>(std::abs(dx)) >= width || static_cast<uint32_t>(std::abs(dy)) >= height)
+        {
+            m_Rejected++;
+            return FRAME_REJECTED;
+        }
+    }
+
+    switch (bpp)
+    {
+        case 8:
+            accumulate(pixels, dx, dy);
+            break;
+        case 16:
+            accumulate(reinterpret_cast<const uint16_t *>(pixels), dx, dy);
+            break;
+        default:
+            accumulate(reinterpret_cast<const uint32_t *>(pixels), dx, dy);
+            break;
+    }
+
+    m_Count++;
+    m_Exposure += exposure;
+    return m_Count >= m_Depth ? STACK_COMPLETE : FRAME_STACKED;
+}
+
+bool FrameStacker::result(std::vector<uint8_t> &output)
+{
+    if (m_Count == 0)
+        return false;
+
+    int bpp = outputBPP();
+    size_t count = static_cast<size_t>(m_Width) * m_Height;
+    output.resize(count * (bpp / 8));
+
+    uint64_t maxValue = bpp == 8 ? 0xFF : (bpp == 16 ? 0xFFFF : 0xFFFFFFFF);
+    auto write = [&](auto * out)
+    {
+        forEachRowBlock(m_Height, count, [&](uint32_t firstRow, uint32_t lastRow)
+        {
+            for (size_t i = static_cast<size_t>(firstRow) * m_Width; i < static_cast<size_t>(lastRow) * m_Width; i++)
+            {
+                uint64_t value;
+                if (m_Mode == STACK_SIGMA_CLIP)
+                    value = static_cast<uint64_t>(std::max(0.0f, m_Accumulator[i] + 0.5f));
+                else if (m_Mode == STACK_MEAN)
+                    // Rounded to nearest, halves up
+                    value = m_Samples[i] ? (m_Sum[i] + m_Samples[i] / 2) / m_Samples[i] : 0;
+                else
+                    value = m_Sum[i];
+                out[i] = static_cast<typename std::remove_pointer<decltype(out)>::type>(std::min(maxValue, value));
+            }
+        });
+    };
+
+    switch (bpp)
+    {
+        case 8:
+            write(output.data());
+            break;
+        case 16:
+            write(reinterpret_cast<uint16_t *>(output.data()));
+            break;
+        default:
+            write(reinterpret_cast<uint32_t *>(output.data()));
+            break;
+    }
+
+    reset();
+    return true;
+}
+
+}
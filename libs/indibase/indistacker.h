@@ -0,0 +1,183 @@
+/*
+    Copyright (C) 2026 by the INDI Library contributors
+
+    Frame Stacker
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+*/
+
+#pragma once
+
+#include "indistardetection.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace INDI
+{
+
+/**
+ * @brief The FrameStacker class accumulates 2D frames into a single stacked frame.
+ *
+ * Frames are added one at a time into a 64 bit integer sum of each pixel, so only one frame worth of state
+ * is kept regardless of the stack depth and sums are exact for any depth and bit depth. Once depth frames are stacked, the result is read with result() and
+ * the next frame starts a new stack.
+ *
+ * Sigma clipping is done online: each pixel keeps its running mean and variance, and a sample further
+ * than sigma standard deviations from the running mean is left out once the pixel has a few samples.
+ *
+ * When alignment is enabled, stars are detected in every frame and matched with those of the first frame
+ * of the stack using dsp_align_get_offset(). Frames are then shifted by the whole pixel translation before
+ * being added. Rotation is not corrected. Frames that cannot be matched are rejected.
+ *
+ * The class is not thread safe.
+ */
+class FrameStacker
+{
+    public:
+        typedef enum
+        {
+            STACK_MEAN,         /*!< Mean of the frames, in the bit depth of the frames */
+            STACK_SUM,          /*!< Sum of the frames, in 32 bits, saturated at 0xFFFFFFFF */
+            STACK_SIGMA_CLIP    /*!< Mean of the samples within sigma standard deviations, in the bit depth of the frames */
+        } StackMode;
+
+        typedef enum
+        {
+            FRAME_STACKED,      /*!< Frame was added, the stack is not complete yet */
+            FRAME_REJECTED,     /*!< Frame could not be aligned, or is not supported */
+            STACK_COMPLETE      /*!< Frame was added and the stack is complete, read it with result() */
+        } AddResult;
+
+        /**
+         * @brief setMode Set how frames are combined. Resets the stack.
+         */
+        void setMode(StackMode mode);
+        StackMode mode() const
+        {
+            return m_Mode;
+        }
+
+        /**
+         * @brief setDepth Set the number of frames in a stack. Resets the stack if it already holds depth frames.
+         * @param depth number of frames, from 1 to 65535.
+         */
+        void setDepth(uint32_t depth);
+        uint32_t depth() const
+        {
+            return m_Depth;
+        }
+
+        /**
+         * @brief setSigma Set the clipping threshold of STACK_SIGMA_CLIP in standard deviations.
+         */
+        void setSigma(double sigma)
+        {
+            m_Sigma = sigma;
+        }
+
+        /**
+         * @brief setAlignment Toggle star alignment of the frames. Resets the stack.
+         */
+        void setAlignment(bool enabled);
+        bool alignment() const
+        {
+            return m_Align;
+        }
+
+        /**
+         * @brief reset Drop the frames stacked so far and the reference stars. The rejected frame count is kept.
+         */
+        void reset();
+
+        /**
+         * @brief add Add a frame to the stack. A frame of different size or bit depth than the stacked frames
+         * starts a new stack.
+         * @param pixels frame pixels, in native byte order.
+         * @param width frame width in pixels.
+         * @param height frame height in pixels.
+         * @param bpp bits per pixel, 8, 16 or 32.
+         * @param exposure exposure time of the frame in seconds.
+         * @return Whether the frame was stacked, rejected, or completed the stack.
+         */
+        AddResult add(const uint8_t *pixels, uint32_t width, uint32_t height, int bpp, double exposure);
+
+        /**
+         * @brief result Write the stacked frame and start a new stack.
+         * @param output stacked frame, resized to width * height * outputBPP() / 8 bytes.
+         * @return False if no frame is stacked.
+         */
+        bool result(std::vector<uint8_t> &output);
+
+        /** @return Number of frames in the current stack. */
+        uint32_t count() const
+        {
+            return m_Count;
+        }
+
+        /** @return Number of frames rejected since the last call to resetRejected(). */
+        uint32_t rejected() const
+        {
+            return m_Rejected;
+        }
+
+        void resetRejected()
+        {
+            m_Rejected = 0;
+        }
+
+        /** @return Total exposure of the frames in the current stack in seconds. */
+        double exposure() const
+        {
+            return m_Exposure;
+        }
+
+        /** @return Bit depth of the stacked frame. */
+        int outputBPP() const;
+
+    private:
+        /** @brief Find the whole pixel translation of stars relative to the reference stars. */
+        bool findOffset(const std::vector<StarInfo> &stars, int &dx, int &dy) const;
+
+        template <typename T>
+        void accumulate(const T *pixels, int dx, int dy);
+
+        StackMode m_Mode {STACK_MEAN};
+        uint32_t m_Depth {10};
+        double m_Sigma {3};
+        bool m_Align {false};
+
+        uint32_t m_Width {0};
+        uint32_t m_Height {0};
+        int m_BPP {0};
+        uint32_t m_Count {0};
+        uint32_t m_Rejected {0};
+        double m_Exposure {0};
+
+        /// Sum of the samples, unless sigma clipping
+        std::vector<uint64_t> m_Sum;
+        /// Running mean of the samples when sigma clipping
+        std::vector<float> m_Accumulator;
+        /// Running sum of squared deviations from the mean when sigma clipping
+        std::vector<float> m_Deviation;
+        /// Samples of each pixel, pixels may miss some once frames are shifted or clipped
+        std::vector<uint16_t> m_Samples;
+        /// Stars of the first frame of the stack
+        std::vector<StarInfo> m_ReferenceStars;
+};
+
+}
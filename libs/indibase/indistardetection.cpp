@@ -0,0 +1,356 @@
+/*
+    Copyright (C) 2026 by the INDI Library contributors
+
+    Star Detection
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+*/
+
+#include "indistardetection.h"
+#include "indiworkerpool.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace INDI
+{
+
+namespace
+{
+
+// Smaller frames are not worth splitting across the worker pool
+constexpr size_t MIN_PIXELS_PER_THREAD = 1 << 20;
+// Size of the background tiles
+constexpr uint32_t TILE_SIZE = 64;
+// Peaks must be the maximum of a (2 * PEAK_RADIUS + 1) square
+constexpr int PEAK_RADIUS = 2;
+// Neighbours of a peak above the threshold, fewer is a hot pixel or a cosmic ray
+constexpr int MIN_NEIGHBOURS = 3;
+// Largest aperture radius
+constexpr int MAX_RADIUS = 32;
+// Conversion from gaussian standard deviation to FWHM
+constexpr double SIGMA_TO_FWHM = 2.35482;
+
+struct Tile
+{
+    float background;
+    float noise;
+};
+
+struct Background
+{
+    uint32_t columns;
+    uint32_t rows;
+    std::vector<Tile> tiles;
+
+    const Tile &at(uint32_t x, uint32_t y) const
+    {
+        return tiles[(y / TILE_SIZE) * columns + x / TILE_SIZE];
+    }
+
+    // Interpolate between the centers of the tiles, so gradients do not step at their edges
+    void interpolate(double position, uint32_t count, uint32_t &first, uint32_t &second, double &weight) const
+    {
+        double tile = std::max(0.0, std::min(count - 1.0, position / TILE_SIZE - 0.5));
+        first = static_cast<uint32_t>(tile);
+        second = std::min(count - 1, first + 1);
+        weight = tile - first;
+    }
+
+    double level(uint32_t x, uint32_t y) const
+    {
+        uint32_t left, right, top, bottom;
+        double wx, wy;
+        interpolate(x + 0.5, columns, left, right, wx);
+        interpolate(y + 0.5, rows, top, bottom, wy);
+        double upper = tiles[top * columns + left].background * (1 - wx) + tiles[top * columns + right].background * wx;
+        double lower = tiles[bottom * columns + left].background * (1 - wx) + tiles[bottom * columns + right].background * wx;
+        return upper * (1 - wy) + lower * wy;
+    }
+
+    void levels(uint32_t y, uint32_t width, std::vector<float> &row) const
+    {
+        row.resize(width);
+        for (uint32_t x = 0; x < width; x++)
+            row[x] = static_cast<float>(level(x, y));
+    }
+};
+
+double median(std::vector<double> &values)
+{
+    if (values.empty())
+        return 0;
+    auto middle = values.begin() + values.size() / 2;
+    std::nth_element(values.begin(), middle, values.end());
+    return *middle;
+}
+
+template <typename F>
+void forEachRowBlock(uint32_t rows, unsigned int threads, F function)
+{
+    uint32_t rowsPerThread = (rows + threads - 1) / threads;
+    WorkerPool::instance().run(threads, [&](unsigned int i)
+    {
+        uint32_t firstRow = std::min(rows, i * rowsPerThread);
+        uint32_t lastRow  = std::min(rows, firstRow + rowsPerThread);
+        function(i, firstRow, lastRow);
+    });
+}
+
+template <typename T>
+void estimateTiles(const T *pixels, uint32_t width, uint32_t height, Background &background, uint32_t firstRow,
+                   uint32_t lastRow)
+{
+    std::vector<float> samples;
+    samples.reserve(TILE_SIZE * TILE_SIZE / 4);
+
+    for (uint32_t row = firstRow; row < lastRow; row++)
+    {
+        for (uint32_t column = 0; column < background.columns; column++)
+        {
+            // Every other pixel of every other row is enough for the median
+            samples.clear();
+            uint32_t lastY = std::min(height, (row + 1) * TILE_SIZE);
+            uint32_t lastX = std::min(width, (column + 1) * TILE_SIZE);
+            for (uint32_t y = row * TILE_SIZE; y < lastY; y += 2)
+                for (uint32_t x = column * TILE_SIZE; x < lastX; x += 2)
+                    samples.push_back(pixels[static_cast<size_t>(y) * width + x]);
+
+            auto middle = samples.begin() + samples.size() / 2;
+            std::nth_element(samples.begin(), middle, samples.end());
+            float level = *middle;
+            for (auto &sample : samples)
+                sample = std::fabs(sample - level);
+            std::nth_element(samples.begin(), middle, samples.end());
+
+            // Quantization noise is the floor of integer frames
+            Tile &tile = background.tiles[row * background.columns + column];
+            tile.background = level;
+            tile.noise = std::max(0.5f, 1.4826f * *middle);
+        }
+    }
+}
+
+template <typename T>
+bool measureStar(const T *pixels, uint32_t width, uint32_t height, uint32_t peakX, uint32_t peakY,
+                 const Background &background, StarInfo &star)
+{
+    auto signal = [&](int64_t x, int64_t y)
+    {
+        return static_cast<double>(pixels[static_cast<size_t>(y) * width + x]) - background.level(x, y);
+    };
+    double noise = background.at(peakX, peakY).noise;
+
+    // Aperture extends until the signal drops into the noise in all four directions
+    int radius = 1;
+    const int directions[4][2] = {{1, 0}, {-1, 0}, {0, 1}, {0, -1}};
+    for (const auto &direction : directions)
+    {
+        int r = 1;
+        for (; r < MAX_RADIUS; r++)
+        {
+            int64_t x = static_cast<int64_t>(peakX) + direction[0] * r;
+            int64_t y = static_cast<int64_t>(peakY) + direction[1] * r;
+            if (x < 0 || y < 0 || x >= width || y >= height || signal(x, y) < noise)
+                break;
+        }
+        radius = std::max(radius, r);
+    }
+    radius = std::min(MAX_RADIUS, radius + 2);
+
+    int64_t left   = std::max<int64_t>(0, static_cast<int64_t>(peakX) - radius);
+    int64_t right  = std::min<int64_t>(width - 1, static_cast<int64_t>(peakX) + radius);
+    int64_t top    = std::max<int64_t>(0, static_cast<int64_t>(peakY) - radius);
+    int64_t bottom = std::min<int64_t>(height - 1, static_cast<int64_t>(peakY) + radius);
+    double radius2 = static_cast<double>(radius) * radius;
+
+    // Centroid of the positive signal within the aperture
+    double flux = 0, sumX = 0, sumY = 0;
+    for (int64_t y = top; y <= bottom; y++)
+        for (int64_t x = left; x <= right; x++)
+        {
+            double dx = x - static_cast<double>(peakX), dy = y - static_cast<double>(peakY);
+            double s = signal(x, y);
+            if (s <= 0 || dx * dx + dy * dy > radius2)
+                continue;
+            flux += s;
+            sumX += s * x;
+            sumY += s * y;
+        }
+    if (flux <= 0)
+        return false;
+
+    star.x = sumX / flux;
+    star.y = sumY / flux;
+    star.flux = flux;
+    star.peak = signal(peakX, peakY);
+
+    // Second moments and half flux radius around the centroid
+    double xx = 0, yy = 0, xy = 0, distance = 0;
+    for (int64_t y = top; y <= bottom; y++)
+        for (int64_t x = left; x <= right; x++)
+        {
+            double px = x - static_cast<double>(peakX), py = y - static_cast<double>(peakY);
+            double s = signal(x, y);
+            if (s <= 0 || px * px + py * py > radius2)
+                continue;
+            double dx = x - star.x, dy = y - star.y;
+            xx += s * dx * dx;
+            yy += s * dy * dy;
+            xy += s * dx * dy;
+            distance += s * std::sqrt(dx * dx + dy * dy);
+        }
+    xx /= flux;
+    yy /= flux;
+    xy /= flux;
+
+    double mean = (xx + yy) / 2;
+    double spread = std::sqrt((xx - yy) * (xx - yy) / 4 + xy * xy);
+    double major = mean + spread, minor = std::max(0.0, mean - spread);
+
+    star.hfr = distance / flux;
+    star.fwhm = SIGMA_TO_FWHM * std::sqrt(mean);
+    star.eccentricity = major > 0 ? std::sqrt(1 - minor / major) : 0;
+    return true;
+}
+
+template <typename T>
+void detectRows(const T *pixels, uint32_t width, uint32_t height, const Background &background, double threshold,
+                uint32_t firstRow, uint32_t lastRow, std::vector<StarInfo> &stars)
+{
+    firstRow = std::max<uint32_t>(firstRow, PEAK_RADIUS);
+    lastRow  = std::min<uint32_t>(lastRow, height - PEAK_RADIUS);
+
+    std::vector<float> levels;
+    for (uint32_t y = firstRow; y < lastRow; y++)
+    {
+        background.levels(y, width, levels);
+        const T *row = pixels + static_cast<size_t>(y) * width;
+        for (uint32_t x = PEAK_RADIUS; x < width - PEAK_RADIUS; x++)
+        {
+            double level = levels[x] + threshold * background.at(x, y).noise;
+            T value = row[x];
+            if (value <= level)
+                continue;
+
+            bool peak = true;
+            int neighbours = 0;
+            for (int j = -PEAK_RADIUS; j <= PEAK_RADIUS && peak; j++)
+                for (int i = -PEAK_RADIUS; i <= PEAK_RADIUS && peak; i++)
+                {
+                    if (i == 0 && j == 0)
+                        continue;
+                    T neighbour = row[static_cast<ptrdiff_t>(j) * width + x + i];
+                    // Plateaus are resolved in favour of their first pixel
+                    if (neighbour > value || (neighbour == value && (j < 0 || (j == 0 && i < 0))))
+                        peak = false;
+                    else if (std::abs(i) <= 1 && std::abs(j) <= 1 && neighbour > level)
+                        neighbours++;
+                }
+            if (!peak || neighbours < MIN_NEIGHBOURS)
+                continue;
+
+            StarInfo star;
+            if (measureStar(pixels, width, height, x, y, background, star))
+                stars.push_back(star);
+        }
+    }
+}
+
+template <typename T>
+void detect(const T *pixels, uint32_t width, uint32_t height, double threshold, unsigned int threads,
+            StarDetection &result)
+{
+    Background background;
+    background.columns = (width + TILE_SIZE - 1) / TILE_SIZE;
+    background.rows = (height + TILE_SIZE - 1) / TILE_SIZE;
+    background.tiles.resize(static_cast<size_t>(background.columns) * background.rows);
+
+    unsigned int tileThreads = std::min(threads, background.rows);
+    forEachRowBlock(background.rows, tileThreads, [&](unsigned int, uint32_t firstRow, uint32_t lastRow)
+    {
+        estimateTiles(pixels, width, height, background, firstRow, lastRow);
+    });
+
+    std::vector<double> levels, noises;
+    for (const auto &tile : background.tiles)
+    {
+        levels.push_back(tile.background);
+        noises.push_back(tile.noise);
+    }
+    result.background = median(levels);
+    result.noise = median(noises);
+
+    std::vector<std::vector<StarInfo>> stars(threads);
+    forEachRowBlock(height, threads, [&](unsigned int thread, uint32_t firstRow, uint32_t lastRow)
+    {
+        detectRows(pixels, width, height, background, threshold, firstRow, lastRow, stars[thread]);
+    });
+
+    for (auto &chunk : stars)
+        result.stars.insert(result.stars.end(), chunk.begin(), chunk.end());
+    std::sort(result.stars.begin(), result.stars.end(), [](const StarInfo & a, const StarInfo & b)
+    {
+        return a.flux > b.flux;
+    });
+}
+
+}
+
+bool detectStars(const uint8_t *buffer, uint32_t width, uint32_t height, int bpp, StarDetection &result,
+                 double threshold, unsigned int threads)
+{
+    result = StarDetection();
+    if (buffer == nullptr || width <= 2 * PEAK_RADIUS || height <= 2 * PEAK_RADIUS)
+        return false;
+
+    if (threads == 0)
+    {
+        size_t pixels = static_cast<size_t>(width) * height;
+        threads = static_cast<unsigned int>(std::max<size_t>(1, std::min<size_t>(WorkerPool::instance().concurrency(),
+                                            pixels / MIN_PIXELS_PER_THREAD)));
+    }
+    threads = std::min(threads, height);
+
+    switch (bpp)
+    {
+        case 8:
+            detect(buffer, width, height, threshold, threads, result);
+            break;
+        case 16:
+            detect(reinterpret_cast<const uint16_t *>(buffer), width, height, threshold, threads, result);
+            break;
+        case 32:
+            detect(reinterpret_cast<const uint32_t *>(buffer), width, height, threshold, threads, result);
+            break;
+        default:
+            return false;
+    }
+
+    std::vector<double> hfr, fwhm, eccentricity;
+    for (const auto &star : result.stars)
+    {
+        hfr.push_back(star.hfr);
+        fwhm.push_back(star.fwhm);
+        eccentricity.push_back(star.eccentricity);
+    }
+    result.hfr = median(hfr);
+    result.fwhm = median(fwhm);
+    result.eccentricity = median(eccentricity);
+    return true;
+}
+
+}
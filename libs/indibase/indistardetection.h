@@ -0,0 +1,88 @@
+/*
+    Copyright (C) 2026 by the INDI Library contributors
+
+    Star Detection
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace INDI
+{
+
+/**
+ * @brief The StarInfo struct holds the measurements of a star. Positions and sizes are in frame pixels.
+ */
+struct StarInfo
+{
+    /// Flux weighted centroid
+    double x {0};
+    double y {0};
+    /// Background subtracted flux and peak
+    double flux {0};
+    double peak {0};
+    /// Half flux radius, mean distance of the flux to the centroid
+    double hfr {0};
+    /// Full width at half maximum of a gaussian with the same second moments
+    double fwhm {0};
+    /// 0 for round stars, close to 1 for elongated ones
+    double eccentricity {0};
+};
+
+/**
+ * @brief The StarDetection struct holds the stars of a frame and their median metrics.
+ */
+struct StarDetection
+{
+    /// Median background and noise of the frame
+    double background {0};
+    double noise {0};
+    /// Stars, brightest first
+    std::vector<StarInfo> stars;
+    /// Medians over all stars, 0 without stars
+    double hfr {0};
+    double fwhm {0};
+    double eccentricity {0};
+};
+
+/**
+ * @brief detectStars Detect stars and measure their centroid, HFR, FWHM and eccentricity.
+ *
+ * The background and noise are estimated in 64x64 pixels tiles from the median and median absolute
+ * deviation of their pixels, so gradients do not produce false detections. Stars are local maxima above
+ * threshold times the noise of their tile, with enough neighbours above it to reject hot pixels.
+ * Each star is measured within an aperture extending until its signal drops into the noise.
+ *
+ * Rows are split across parallel threads for both background estimation and detection.
+ *
+ * @param buffer frame pixels, in native byte order.
+ * @param width frame width in pixels.
+ * @param height frame height in pixels.
+ * @param bpp bits per pixel, 8, 16 or 32.
+ * @param result detected stars and metrics.
+ * @param threshold detection threshold in noise standard deviations.
+ * @param threads number of tasks run on the shared WorkerPool, 0 to pick one based on frame size and available cores.
+ * @return True on success, false if bpp is not supported or the frame is too small.
+ */
+bool detectStars(const uint8_t *buffer, uint32_t width, uint32_t height, int bpp, StarDetection &result,
+                 double threshold = 5, unsigned int threads = 0);
+
+}
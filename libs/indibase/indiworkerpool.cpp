@@ -0,0 +1,120 @@
+/*
+    Copyright (C) 2026 by the INDI Library contributors
+
+    Worker Pool
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+*/
+
+#include "indiworkerpool.h"
+
+#include <algorithm>
+
+namespace INDI
+{
+
+WorkerPool::WorkerPool(unsigned int concurrency)
+    : m_Concurrency(concurrency > 0 ? concurrency : std::max(1u, std::thread::hardware_concurrency()))
+{
+}
+
+WorkerPool::~WorkerPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_Lock);
+        m_Quit = true;
+    }
+    m_Condition.notify_all();
+
+    for (auto &thread : m_Threads)
+        thread.join();
+}
+
+WorkerPool &WorkerPool::instance()
+{
+    // Never destroyed, frames may still be processed by detached threads while the driver exits
+    static WorkerPool *pool = new WorkerPool();
+    return *pool;
+}
+
+void WorkerPool::run(unsigned int count, const std::function<void(unsigned int index)> &task)
+{
+    if (count <= 1 || m_Concurrency == 1)
+    {
+        for (unsigned int i = 0; i < count; i++)
+            task(i);
+        return;
+    }
+
+    Job job {&task, count, 0, count, {}};
+
+    std::unique_lock<std::mutex> lock(m_Lock);
+    if (m_Threads.empty())
+    {
+        for (unsigned int i = 1; i < m_Concurrency; i++)
+            m_Threads.emplace_back(&WorkerPool::workerThreadEntry, this);
+    }
+    m_Jobs.push_back(&job);
+    m_Condition.notify_all();
+
+    // Run tasks of this job until all are started, so it completes even if every worker is busy
+    while (job.next < job.count)
+    {
+        unsigned int index = job.next++;
+        if (job.next == job.count)
+            m_Jobs.erase(std::find(m_Jobs.begin(), m_Jobs.end(), &job));
+
+        lock.unlock();
+        task(index);
+        lock.lock();
+        job.pending--;
+    }
+
+    job.done.wait(lock, [&job]()
+    {
+        return job.pending == 0;
+    });
+}
+
+void WorkerPool::workerThreadEntry()
+{
+    std::unique_lock<std::mutex> lock(m_Lock);
+    while (true)
+    {
+        m_Condition.wait(lock, [this]()
+        {
+            return m_Quit || m_Jobs.empty() == false;
+        });
+
+        if (m_Quit)
+            return;
+
+        Job *job = m_Jobs.front();
+        unsigned int index = job->next++;
+        if (job->next == job->count)
+            m_Jobs.pop_front();
+
+        lock.unlock();
+        (*job->task)(index);
+        lock.lock();
+
+        // The job lives on the stack of run(), which waits for this under m_Lock
+        if (--job->pending == 0)
+            job->done.notify_one();
+    }
+}
+
+}
@@ -0,0 +1,97 @@
+/*
+    Copyright (C) 2026 by the INDI Library contributors
+
+    Worker Pool
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+*/
+
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace INDI
+{
+
+/**
+ * @brief The WorkerPool class runs the parallel parts of frame processing on long lived threads.
+ *
+ * Binning, calibration, stacking, compression and color conversion split a frame into tasks and hand them to
+ * run(), instead of starting and joining threads for every frame. The calling thread runs tasks as well,
+ * so run() can be called from several threads at once, and from a task of another run().
+ *
+ * The shared pool is returned by instance(). Its threads are started on the first run() of more than one task.
+ */
+class WorkerPool
+{
+    public:
+        /**
+         * @brief WorkerPool Create a pool.
+         * @param concurrency number of tasks run at once, counting the calling thread. 0 for the number of cores.
+         */
+        explicit WorkerPool(unsigned int concurrency = 0);
+        ~WorkerPool();
+
+        WorkerPool(const WorkerPool &) = delete;
+        WorkerPool &operator=(const WorkerPool &) = delete;
+
+        /**
+         * @brief instance The pool shared by the frame processing functions, with one task per core.
+         */
+        static WorkerPool &instance();
+
+        /**
+         * @brief concurrency Number of tasks run at once, the pool threads and the calling thread.
+         */
+        unsigned int concurrency() const
+        {
+            return m_Concurrency;
+        }
+
+        /**
+         * @brief run Call task(0) to task(count - 1) in parallel and wait for all of them to return.
+         */
+        void run(unsigned int count, const std::function<void(unsigned int index)> &task);
+
+    private:
+        struct Job
+        {
+            const std::function<void(unsigned int)> *task;
+            unsigned int count;
+            /// Next index to run
+            unsigned int next;
+            /// Tasks not finished yet
+            unsigned int pending;
+            std::condition_variable done;
+        };
+
+        void workerThreadEntry();
+
+        const unsigned int m_Concurrency;
+        std::mutex m_Lock;
+        std::condition_variable m_Condition;
+        /// Jobs with tasks left to start, guarded by m_Lock
+        std::deque<Job *> m_Jobs;
+        std::vector<std::thread> m_Threads;
+        bool m_Quit {false};
+};
+
+}
@@ -103,6 +103,136 @@ static int tty_generic_udp_format = 0;
 static int tty_sequence_number = 1;
 static int tty_clear_trailing_lf = 0;
 
+#ifndef _WIN32
+/* Size of the read-ahead buffer of a file descriptor */
+#define TTY_READ_AHEAD_SIZE 1024
+
+/* Bytes read from a file descriptor but not yet returned to the caller.
+ * tty_read_section and tty_nread_section read as much as is available in a single read()
+ * and keep the bytes following the stop char for the next call. */
+struct tty_read_ahead
+{
+    char data[TTY_READ_AHEAD_SIZE];
+    int start;
+    int count;
+};
+
+/* Indexed by file descriptor. select() limits usable descriptors to FD_SETSIZE anyway. */
+static struct tty_read_ahead *tty_read_ahead_buffers[FD_SETSIZE];
+
+static struct tty_read_ahead *tty_get_read_ahead(int fd)
+{
+    if (fd < 0 || fd >= FD_SETSIZE)
+        return NULL;
+
+    if (tty_read_ahead_buffers[fd] == NULL)
+        tty_read_ahead_buffers[fd] = (struct tty_read_ahead *)calloc(1, sizeof(struct tty_read_ahead));
+
+    return tty_read_ahead_buffers[fd];
+}
+
+/* Copy up to nbytes buffered bytes to buf, returns the number of bytes copied. */
+static int tty_take_read_ahead(int fd, char *buf, int nbytes)
+{
+    struct tty_read_ahead *ra = (fd >= 0 && fd < FD_SETSIZE) ? tty_read_ahead_buffers[fd] : NULL;
+
+    if (ra == NULL || ra->count == 0 || nbytes <= 0)
+        return 0;
+
+    if (nbytes > ra->count)
+        nbytes = ra->count;
+
+    memcpy(buf, ra->data + ra->start, nbytes);
+    ra->start += nbytes;
+    ra->count -= nbytes;
+
+    return nbytes;
+}
+
+/* Read until stop_char, at most nsize bytes if nsize > 0. */
+static int tty_read_section_buffered(int fd, char *buf, int nsize, char stop_char, long timeout_seconds,
+                                     long timeout_microseconds, int *nbytes_read)
+{
+    struct tty_read_ahead *ra = tty_get_read_ahead(fd);
+    int err = TTY_OK;
+
+    if (ra == NULL)
+        return TTY_ERRNO;
+
+    for (;;)
+    {
+        if (ra->count == 0)
+        {
+            if ((err = tty_timeout_microseconds(fd, timeout_seconds, timeout_microseconds)))
+                return err;
+
+            ra->start = 0;
+            ra->count = read(fd, ra->data, TTY_READ_AHEAD_SIZE);
+
+            if (ra->count <= 0)
+            {
+                ra->count = 0;
+                return TTY_READ_ERROR;
+            }
+
+            if (tty_debug)
+            {
+                int i = 0;
+                for (i = 0; i < ra->count; i++)
+                    IDLog("%s: buffer[%d]=%#X (%c)\n", __FUNCTION__, (*nbytes_read) + i, (unsigned char)ra->data[i], ra->data[i]);
+            }
+        }
+
+        if (tty_clear_trailing_lf && *nbytes_read == 0 && ra->data[ra->start] == 0x0A)
+        {
+            if (tty_debug)
+                IDLog("%s: Cleared LF char left in buf\n", __FUNCTION__);
+
+            ra->start++;
+            ra->count--;
+
+            if (stop_char == 0x0A)
+                return TTY_OK;
+
+            continue;
+        }
+
+        char *begin = ra->data + ra->start;
+        char *stop  = (char *)memchr(begin, stop_char, ra->count);
+        int length  = stop ? (int)(stop - begin) + 1 : ra->count;
+
+        if (nsize > 0 && length > nsize - *nbytes_read)
+        {
+            length = nsize - *nbytes_read;
+            stop   = NULL;
+        }
+
+        memcpy(buf + *nbytes_read, begin, length);
+        ra->start += length;
+        ra->count -= length;
+        *nbytes_read += length;
+
+        if (stop)
+            return TTY_OK;
+        else if (nsize > 0 && *nbytes_read >= nsize)
+            return TTY_OVERFLOW;
+    }
+}
+#endif
+
+void tty_clear_read_buffer(int fd)
+{
+#ifdef _WIN32
+    INDI_UNUSED(fd);
+#else
+    if (fd >= 0 && fd < FD_SETSIZE && tty_read_ahead_buffers[fd] != NULL)
+    {
+        tty_read_ahead_buffers[fd]->start = 0;
+        tty_read_ahead_buffers[fd]->count = 0;
+    }
+#endif
+}
+
 #if defined(HAVE_LIBNOVA)
 int extractISOTime(const char *timestr, struct ln_date *iso_date)
 {
@@ -385,6 +515,10 @@ int tty_timeout_microseconds(int fd, long timeout_seconds, long timeout_microsec
     
     if (fd == -1)
         return TTY_ERRNO;
+
+    /* Bytes read ahead since the last write are available right away, select() does not see them */
+    if (fd < FD_SETSIZE && tty_read_ahead_buffers[fd] != NULL && tty_read_ahead_buffers[fd]->count > 0)
+        return TTY_OK;
     
     struct timeval tv;
     fd_set readout;
@@ -444,6 +578,9 @@ int tty_write(int fd, const char *buf, int nbytes, int *nbytes_written)
             IDLog("%s: buffer[%d]=%#X (%c)\n", __FUNCTION__, i, (unsigned char)buf[i], buf[i]);
     }
 
+    // A new command starts a new exchange, bytes left over from the previous reply are stale.
+    tty_clear_read_buffer(fd);
+
     while (nbytes > 0)
     {
         bytes_w = write(fd, buffer + (*nbytes_written), nbytes);
@@ -505,6 +642,22 @@ int tty_read_expanded(int fd, char *buf, int nbytes, long timeout_seconds, long
         buffer = geminiBuffer;
     }
 
+    // Bytes left over by a previous section read come first
+    if (!tty_gemini_udp_format)
+    {
+        *nbytes_read = tty_take_read_ahead(fd, buffer, numBytesToRead);
+
+        if (*nbytes_read > 0 && tty_clear_trailing_lf && *buffer == 0x0A)
+        {
+            if (tty_debug)
+                IDLog("%s: Cleared LF char left in buf\n", __FUNCTION__);
+
+            memmove(buffer, buffer + 1, --(*nbytes_read));
+        }
+
+        numBytesToRead -= *nbytes_read;
+    }
+
     while (numBytesToRead > 0)
     {
         if ((err = tty_timeout_microseconds(fd, timeout_seconds, timeout_microseconds)))
@@ -572,11 +725,8 @@ int tty_read_section_expanded(int fd, char *buf, char stop_char, long timeout_se
         return TTY_ERRNO;
 
     int bytesRead = 0;
-    int err       = TTY_OK;
     *nbytes_read  = 0;
 
-    uint8_t *read_char = 0;
-
     if (tty_debug)
         IDLog("%s: Request to read until stop char '%#02X' with %ld s %ld us timeout for fd %d\n", __FUNCTION__, stop_char, timeout_seconds, timeout_microseconds, fd);
 
@@ -623,31 +773,7 @@ int tty_read_section_expanded(int fd, char *buf, char stop_char, long timeout_se
     }
     else
     {
-        for (;;)
-        {
-            if ((err = tty_timeout_microseconds(fd, timeout_seconds, timeout_microseconds)))
-                return err;
-
-            read_char = (uint8_t*)(buf + *nbytes_read);
-            bytesRead = read(fd, read_char, 1);
-
-            if (bytesRead < 0)
-                return TTY_READ_ERROR;
-
-            if (tty_debug)
-                IDLog("%s: buffer[%d]=%#X (%c)\n", __FUNCTION__, (*nbytes_read), *read_char, *read_char);
-
-            if (!(tty_clear_trailing_lf && *read_char == 0X0A && *nbytes_read == 0))
-                (*nbytes_read)++;
-            else {
-                if (tty_debug)
-                    IDLog("%s: Cleared LF char left in buf\n", __FUNCTION__);
-            }
-
-            if (*read_char == stop_char) {
-                return TTY_OK;
-            }
-        }
+        return tty_read_section_buffered(fd, buf, 0, stop_char, timeout_seconds, timeout_microseconds, nbytes_read);
     }
 
     return TTY_TIME_OUT;
@@ -668,41 +794,16 @@ int tty_nread_section(int fd, char *buf, int nsize, char stop_char, int timeout,
     if (tty_gemini_udp_format || tty_generic_udp_format)
         return tty_read_section(fd, buf, stop_char, timeout, nbytes_read);
 
-    int bytesRead = 0;
-    int err       = TTY_OK;
     *nbytes_read  = 0;
-    uint8_t *read_char = 0;
     memset(buf, 0, nsize);
 
+    if (nsize <= 0)
+        return TTY_PARAM_ERROR;
+
     if (tty_debug)
         IDLog("%s: Request to read until stop char '%#02X' with %d timeout for fd %d\n", __FUNCTION__, stop_char, timeout, fd);
 
-    for (;;)
-    {
-        if ((err = tty_timeout(fd, timeout)))
-            return err;
-
-        read_char = (uint8_t*)(buf + *nbytes_read);
-        bytesRead = read(fd, read_char, 1);
-
-        if (bytesRead < 0)
-            return TTY_READ_ERROR;
-
-        if (tty_debug)
-            IDLog("%s: buffer[%d]=%#X (%c)\n", __FUNCTION__, (*nbytes_read), *read_char, *read_char);
-
-        if (!(tty_clear_trailing_lf && *read_char == 0X0A && *nbytes_read == 0))
-            (*nbytes_read)++;
-        else {
-            if (tty_debug)
-                IDLog("%s: Cleared LF char left in buf\n", __FUNCTION__);
-        }
-
-        if (*read_char == stop_char)
-            return TTY_OK;
-        else if (*nbytes_read >= nsize)
-            return TTY_OVERFLOW;
-    }
+    return tty_read_section_buffered(fd, buf, nsize, stop_char, (long) timeout, (long) 0, nbytes_read);
 
 #endif
 }
@@ -1113,7 +1214,8 @@ int tty_connect(const char *device, int bit_rate, int word_size, int parity, int
     tty_setting.c_lflag &= ~(ICANON | ECHO | ECHOE | ISIG | IEXTEN | NOFLSH | TOSTOP);
     tty_setting.c_lflag |= NOFLSH;
 
-    /* blocking read until 1 char arrives */
+    /* Reads always follow a select() that bounds the wait, so a read returns at once with
+       all bytes queued by the kernel. An inter-byte VTIME would only delay the end of each reply. */
     tty_setting.c_cc[VMIN]  = 1;
     tty_setting.c_cc[VTIME] = 0;
 
@@ -1126,6 +1228,7 @@ int tty_connect(const char *device, int bit_rate, int word_size, int parity, int
         return TTY_PORT_FAILURE;
     }
 
+    tty_clear_read_buffer(t_fd);
     *fd = t_fd;
     /* return success */
     return TTY_OK;
@@ -1145,6 +1248,11 @@ int tty_disconnect(int fd)
 #else
     int err;
     tcflush(fd, TCIOFLUSH);
+    if (fd < FD_SETSIZE)
+    {
+        free(tty_read_ahead_buffers[fd]);
+        tty_read_ahead_buffers[fd] = NULL;
+    }
     err = close(fd);
 
     if (err != 0)
@@ -287,6 +287,16 @@ void tty_set_gemini_udp_format(int enabled);
 void tty_set_generic_udp_format(int enabled);
 void tty_clr_trailing_read_lf(int enabled);
 
+/**
+ * @brief tty_clear_read_buffer Discard bytes read ahead from fd by tty_read_section and tty_nread_section.
+ * Section reads keep bytes following the stop char for the next read. They are returned first by tty_read,
+ * tty_read_section and tty_nread_section, reported as available by tty_timeout, and discarded by tty_write and
+ * tty_disconnect. Reading fd directly misses them. Call this function after discarding the input of fd by other
+ * means without writing to it, e.g. tcflush() before waiting for an unsolicited message.
+ * @param fd file descriptor
+ */
+void tty_clear_read_buffer(int fd);
+
 int tty_timeout(int fd, int timeout);
 /*@}*/
 
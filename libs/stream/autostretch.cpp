@@ -0,0 +1,266 @@
+/*
+    Copyright (C) 2026 by the INDI Library contributors
+
+    Auto Stretch
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+*/
+#include "autostretch.h"
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace INDI
+{
+
+constexpr uint32_t AutoStretch::CURVE_SIZE;
+
+namespace
+{
+
+// Pixels sampled to measure the levels
+constexpr size_t LEVEL_SAMPLES = 16384;
+// Pixels scaled at once before looking up the curve, small enough to stay in L1 cache
+constexpr size_t BLOCK_SIZE = 1024;
+constexpr double GAMMA = 2.2;
+constexpr double ASINH_STRENGTH = 10;
+
+/*
+ * Fixed point scaling of pixels between the levels to [0, target): (min(v - black, range) << shift) * multiplier >> 16.
+ * The shift keeps small ranges precise, the multiplier fits 16 bits so the product is a 16 bit high multiplication.
+ */
+struct Scale
+{
+    uint16_t black;
+    uint16_t range;
+    int shift;
+    uint16_t multiplier;
+
+    Scale(uint16_t black, uint16_t white, uint32_t target)
+        : black(black)
+        , range(white > black ? white - black : 1)
+        , shift(0)
+    {
+        while ((static_cast<uint32_t>(range) << shift) < target)
+            shift++;
+        uint32_t scaled = static_cast<uint32_t>(range) << shift;
+        multiplier = static_cast<uint16_t>(std::min<uint64_t>(0xFFFF, (static_cast<uint64_t>(target) << 16) / (scaled + 1)));
+    }
+
+    uint16_t operator()(uint16_t value) const
+    {
+        uint32_t offset = std::min<uint32_t>(value > black ? value - black : 0, range);
+        return static_cast<uint16_t>(((offset << shift) * multiplier) >> 16);
+    }
+};
+
+// Scale count pixels to [0, target), returns the number of pixels done with SIMD
+size_t scaleBlock(const uint16_t *source, size_t count, const Scale &scale, uint16_t *output)
+{
+    size_t i = 0;
+#if defined(__AVX2__)
+    const __m256i black      = _mm256_set1_epi16(static_cast<short>(scale.black));
+    const __m256i range      = _mm256_set1_epi16(static_cast<short>(scale.range));
+    const __m256i multiplier = _mm256_set1_epi16(static_cast<short>(scale.multiplier));
+    const __m128i shift      = _mm_cvtsi32_si128(scale.shift);
+    for (; i + 16 <= count; i += 16)
+    {
+        __m256i value = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(source + i));
+        value = _mm256_min_epu16(_mm256_subs_epu16(value, black), range);
+        value = _mm256_mulhi_epu16(_mm256_sll_epi16(value, shift), multiplier);
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(output + i), value);
+    }
+#elif defined(__SSE2__)
+    const __m128i black      = _mm_set1_epi16(static_cast<short>(scale.black));
+    const __m128i range      = _mm_set1_epi16(static_cast<short>(scale.range));
+    const __m128i multiplier = _mm_set1_epi16(static_cast<short>(scale.multiplier));
+    const __m128i shift      = _mm_cvtsi32_si128(scale.shift);
+    for (; i + 8 <= count; i += 8)
+    {
+        __m128i value = _mm_subs_epu16(_mm_loadu_si128(reinterpret_cast<const __m128i *>(source + i)), black);
+        // SSE2 has no unsigned 16 bit minimum, min(a, b) = a - (a - b saturated)
+        value = _mm_sub_epi16(value, _mm_subs_epu16(value, range));
+        value = _mm_mulhi_epu16(_mm_sll_epi16(value, shift), multiplier);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(output + i), value);
+    }
+#elif defined(__ARM_NEON)
+    const uint16x8_t black      = vdupq_n_u16(scale.black);
+    const uint16x8_t range      = vdupq_n_u16(scale.range);
+    const uint16x4_t multiplier = vdup_n_u16(scale.multiplier);
+    const int16x8_t shift       = vdupq_n_s16(static_cast<int16_t>(scale.shift));
+    for (; i + 8 <= count; i += 8)
+    {
+        uint16x8_t value = vminq_u16(vqsubq_u16(vld1q_u16(source + i), black), range);
+        value = vshlq_u16(value, shift);
+        uint32x4_t low  = vmull_u16(vget_low_u16(value), multiplier);
+        uint32x4_t high = vmull_u16(vget_high_u16(value), multiplier);
+        vst1q_u16(output + i, vcombine_u16(vshrn_n_u32(low, 16), vshrn_n_u32(high, 16)));
+    }
+#endif
+    return i;
+}
+
+// Linear stretch straight to 8 bit, returns the number of pixels done with SIMD
+size_t stretchLinear(const uint16_t *source, size_t count, const Scale &scale, uint8_t *destination)
+{
+    size_t i = 0;
+#if defined(__AVX2__) || defined(__SSE2__) || defined(__ARM_NEON)
+    uint16_t scaled[BLOCK_SIZE];
+    while (i < count)
+    {
+        size_t block = std::min(BLOCK_SIZE, count - i);
+        size_t done = scaleBlock(source + i, block, scale, scaled);
+        size_t j = 0;
+#if defined(__AVX2__) || defined(__SSE2__)
+        for (; j + 16 <= done; j += 16)
+        {
+            __m128i low  = _mm_loadu_si128(reinterpret_cast<const __m128i *>(scaled + j));
+            __m128i high = _mm_loadu_si128(reinterpret_cast<const __m128i *>(scaled + j + 8));
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(destination + i + j), _mm_packus_epi16(low, high));
+        }
+#elif defined(__ARM_NEON)
+        for (; j + 8 <= done; j += 8)
+            vst1_u8(destination + i + j, vqmovn_u16(vld1q_u16(scaled + j)));
+#endif
+        for (; j < done; j++)
+            destination[i + j] = static_cast<uint8_t>(scaled[j]);
+        i += j;
+        if (done < block)
+            break;
+    }
+#endif
+    return i;
+}
+
+}
+
+AutoStretch::AutoStretch()
+{
+    setCurve(CURVE_LINEAR);
+}
+
+void AutoStretch::setCurve(Curve curve)
+{
+    m_Curve = curve;
+    m_Table.resize(CURVE_SIZE);
+    for (uint32_t i = 0; i < CURVE_SIZE; i++)
+    {
+        double x = (i + 0.5) / CURVE_SIZE;
+        double y;
+        switch (curve)
+        {
+            case CURVE_GAMMA:
+                y = std::pow(x, 1 / GAMMA);
+                break;
+            case CURVE_ASINH:
+                y = std::asinh(ASINH_STRENGTH * x) / std::asinh(ASINH_STRENGTH);
+                break;
+            default:
+                y = x;
+                break;
+        }
+        m_Table[i] = static_cast<uint8_t>(std::min(255.0, std::floor(y * 256)));
+    }
+}
+
+void AutoStretch::setPercentiles(double low, double high)
+{
+    m_Low = std::max(0.0, std::min(100.0, low));
+    m_High = std::max(m_Low, std::min(100.0, high));
+}
+
+void AutoStretch::setSmoothing(double weight)
+{
+    m_Smoothing = std::max(0.01, std::min(1.0, weight));
+}
+
+void AutoStretch::reset()
+{
+    m_HasLevels = false;
+}
+
+void AutoStretch::updateLevels(const uint16_t *source, size_t count)
+{
+    // An odd step avoids sampling the same columns of every row
+    size_t step = std::max<size_t>(1, count / LEVEL_SAMPLES) | 1;
+    m_Samples.clear();
+    for (size_t i = 0; i < count; i += step)
+        m_Samples.push_back(source[i]);
+    if (m_Samples.empty())
+        return;
+
+    size_t last = m_Samples.size() - 1;
+    auto low = m_Samples.begin() + static_cast<size_t>(std::lround(last * m_Low / 100));
+    std::nth_element(m_Samples.begin(), low, m_Samples.end());
+    double black = *low;
+    auto high = m_Samples.begin() + static_cast<size_t>(std::lround(last * m_High / 100));
+    std::nth_element(low, high, m_Samples.end());
+    double white = *high;
+
+    if (m_HasLevels)
+    {
+        m_Black += m_Smoothing * (black - m_Black);
+        m_White += m_Smoothing * (white - m_White);
+    }
+    else
+    {
+        m_Black = black;
+        m_White = white;
+        m_HasLevels = true;
+    }
+}
+
+void AutoStretch::apply(const uint16_t *source, size_t count, uint8_t *destination)
+{
+    updateLevels(source, count);
+    uint16_t black = static_cast<uint16_t>(std::lround(m_Black));
+    uint16_t white = static_cast<uint16_t>(std::max<long>(black + 1, std::min<long>(65535, std::lround(m_White))));
+    apply(source, count, destination, black, white);
+}
+
+void AutoStretch::apply(const uint16_t *source, size_t count, uint8_t *destination, uint16_t black,
+                        uint16_t white) const
+{
+    if (m_Curve == CURVE_LINEAR)
+    {
+        Scale scale(black, white, 256);
+        size_t i = stretchLinear(source, count, scale, destination);
+        for (; i < count; i++)
+            destination[i] = static_cast<uint8_t>(scale(source[i]));
+        return;
+    }
+
+    Scale scale(black, white, CURVE_SIZE);
+    const uint8_t *table = m_Table.data();
+    uint16_t scaled[BLOCK_SIZE];
+    for (size_t i = 0; i < count; i += BLOCK_SIZE)
+    {
+        size_t block = std::min(BLOCK_SIZE, count - i);
+        size_t j = scaleBlock(source + i, block, scale, scaled);
+        for (; j < block; j++)
+            scaled[j] = scale(source[i + j]);
+        for (j = 0; j < block; j++)
+            destination[i + j] = table[scaled[j]];
+    }
+}
+
+}
@@ -0,0 +1,116 @@
+/*
+    Copyright (C) 2026 by the INDI Library contributors
+
+    Auto Stretch
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+*/
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace INDI
+{
+
+/**
+ * @brief The AutoStretch class downscales 16 bit frames to 8 bit, stretched between levels measured on each frame.
+ *
+ * Black and white levels are percentiles of a subsample of the frame, optionally smoothed over frames so
+ * the preview does not flicker. Pixels are scaled between the levels with SIMD instructions, then mapped
+ * through a linear, gamma or asinh curve. Unlike GammaLut16, frames of 12 or 14 bit sensors use the whole
+ * 8 bit range.
+ */
+class AutoStretch
+{
+    public:
+        enum Curve
+        {
+            CURVE_LINEAR,
+            CURVE_GAMMA,
+            CURVE_ASINH
+        };
+
+        /// Resolution of the curves, the scaled pixels index a table of this size
+        static constexpr uint32_t CURVE_SIZE = 16384;
+
+    public:
+        AutoStretch();
+
+    public:
+        void setCurve(Curve curve);
+        Curve curve() const
+        {
+            return m_Curve;
+        }
+
+        /**
+         * @brief Percentiles of the black and white levels, in percent.
+         */
+        void setPercentiles(double low, double high);
+
+        /**
+         * @brief Weight of the levels of a new frame, from 0 exclusive to 1. 1 follows every frame without smoothing.
+         */
+        void setSmoothing(double weight);
+
+        /**
+         * @brief Forget the levels of previous frames.
+         */
+        void reset();
+
+        /**
+         * @brief Measure the levels of source, then stretch it into destination.
+         */
+        void apply(const uint16_t *source, size_t count, uint8_t *destination);
+
+        /**
+         * @brief Stretch source into destination between the given levels, without measuring them.
+         */
+        void apply(const uint16_t *source, size_t count, uint8_t *destination, uint16_t black, uint16_t white) const;
+
+        /** @return Black level used for the last frame. */
+        double black() const
+        {
+            return m_Black;
+        }
+
+        /** @return White level used for the last frame. */
+        double white() const
+        {
+            return m_White;
+        }
+
+    protected:
+        void updateLevels(const uint16_t *source, size_t count);
+
+    protected:
+        Curve m_Curve {CURVE_LINEAR};
+        double m_Low {0.1};
+        double m_High {99.9};
+        double m_Smoothing {1};
+
+        bool m_HasLevels {false};
+        double m_Black {0};
+        double m_White {65535};
+
+        /// Curve from CURVE_SIZE scaled values to 8 bit
+        std::vector<uint8_t> m_Table;
+        std::vector<uint16_t> m_Samples;
+};
+
+}
@@ -0,0 +1,1183 @@
+/*
+    Copyright (C) 2026 by the INDI Library contributors
+
+    Color Conversion
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+*/
+#include "colorconvert.h"
+#include "indiworkerpool.h"
+
+#include <algorithm>
+#include <functional>
+#include <vector>
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace INDI
+{
+
+namespace
+{
+
+// Conversions do more work per pixel than binning, so smaller frames are already worth splitting
+constexpr size_t MIN_PIXELS_PER_THREAD = 1 << 18;
+// Pixels converted at once to planar buffers, small enough to stay in L1 cache
+constexpr size_t BLOCK_PIXELS = 1024;
+
+unsigned int threadCount(unsigned int threads, size_t pixels, uint32_t rows)
+{
+    if (threads == 0)
+    {
+        threads = WorkerPool::instance().concurrency();
+        threads = static_cast<unsigned int>(std::min<size_t>(threads, std::max<size_t>(1, pixels / MIN_PIXELS_PER_THREAD)));
+    }
+    return std::max(1u, std::min(threads, rows));
+}
+
+// Call convert(first, last) on ranges of rows in parallel
+template <typename Convert>
+void convertRows(uint32_t rows, unsigned int threads, const Convert &convert)
+{
+    const uint32_t chunkSize = (rows + threads - 1) / threads;
+
+    WorkerPool::instance().run(threads, [&](unsigned int i)
+    {
+        uint32_t first = std::min(rows, i * chunkSize);
+        uint32_t last  = std::min(rows, first + chunkSize);
+        convert(first, last);
+    });
+}
+
+#if defined(__SSE2__) && !defined(__SSSE3__)
+// Pack the low 6 bytes of both 64 bit halves to 12 bytes
+inline __m128i packHalves(__m128i v)
+{
+    const __m128i low  = _mm_set_epi32(0, 0, 0x0000FFFF, static_cast<int>(0xFFFFFFFF));
+    const __m128i high = _mm_set_epi32(0x0000FFFF, static_cast<int>(0xFFFFFFFF), 0, 0);
+    return _mm_or_si128(_mm_and_si128(v, low), _mm_srli_si128(_mm_and_si128(v, high), 2));
+}
+
+// Pack 4 pixels of 3 bytes stored in 32 bit words to 12 bytes
+inline __m128i packPixels(__m128i v)
+{
+    const __m128i first  = _mm_set1_epi64x(0x0000000000FFFFFF);
+    const __m128i second = _mm_set1_epi64x(0x0000FFFFFF000000);
+    return packHalves(_mm_or_si128(_mm_and_si128(v, first), _mm_and_si128(_mm_srli_epi64(v, 8), second)));
+}
+#endif
+
+// Interleave three planes to packed pixels
+void interleave3(const uint8_t *c0, const uint8_t *c1, const uint8_t *c2, uint8_t *output, size_t count)
+{
+    size_t i = 0;
+#if defined(__SSSE3__)
+    const __m128i m00 = _mm_setr_epi8(0, -1, -1, 1, -1, -1, 2, -1, -1, 3, -1, -1, 4, -1, -1, 5);
+    const __m128i m01 = _mm_setr_epi8(-1, 0, -1, -1, 1, -1, -1, 2, -1, -1, 3, -1, -1, 4, -1, -1);
+    const __m128i m02 = _mm_setr_epi8(-1, -1, 0, -1, -1, 1, -1, -1, 2, -1, -1, 3, -1, -1, 4, -1);
+    const __m128i m10 = _mm_setr_epi8(-1, -1, 6, -1, -1, 7, -1, -1, 8, -1, -1, 9, -1, -1, 10, -1);
+    const __m128i m11 = _mm_setr_epi8(5, -1, -1, 6, -1, -1, 7, -1, -1, 8, -1, -1, 9, -1, -1, 10);
+    const __m128i m12 = _mm_setr_epi8(-1, 5, -1, -1, 6, -1, -1, 7, -1, -1, 8, -1, -1, 9, -1, -1);
+    const __m128i m20 = _mm_setr_epi8(-1, 11, -1, -1, 12, -1, -1, 13, -1, -1, 14, -1, -1, 15, -1, -1);
+    const __m128i m21 = _mm_setr_epi8(-1, -1, 11, -1, -1, 12, -1, -1, 13, -1, -1, 14, -1, -1, 15, -1);
+    const __m128i m22 = _mm_setr_epi8(10, -1, -1, 11, -1, -1, 12, -1, -1, 13, -1, -1, 14, -1, -1, 15);
+    for (; i + 16 <= count; i += 16)
+    {
+        __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(c0 + i));
+        __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i *>(c1 + i));
+        __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i *>(c2 + i));
+        __m128i *out = reinterpret_cast<__m128i *>(output + 3 * i);
+        _mm_storeu_si128(out, _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(a, m00), _mm_shuffle_epi8(b, m01)),
+                                           _mm_shuffle_epi8(c, m02)));
+        _mm_storeu_si128(out + 1, _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(a, m10), _mm_shuffle_epi8(b, m11)),
+                                               _mm_shuffle_epi8(c, m12)));
+        _mm_storeu_si128(out + 2, _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(a, m20), _mm_shuffle_epi8(b, m21)),
+                                               _mm_shuffle_epi8(c, m22)));
+    }
+#elif defined(__SSE2__)
+    // Each store writes 4 bytes past its 12 bytes, overwritten by the next one
+    const __m128i zero = _mm_setzero_si128();
+    for (; i + 18 <= count; i += 16)
+    {
+        __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(c0 + i));
+        __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i *>(c1 + i));
+        __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i *>(c2 + i));
+        __m128i ab[2] = {_mm_unpacklo_epi8(a, b), _mm_unpackhi_epi8(a, b)};
+        __m128i cz[2] = {_mm_unpacklo_epi8(c, zero), _mm_unpackhi_epi8(c, zero)};
+        for (int k = 0; k < 2; k++)
+        {
+            uint8_t *out = output + 3 * i + 24 * k;
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(out), packPixels(_mm_unpacklo_epi16(ab[k], cz[k])));
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(out + 12), packPixels(_mm_unpackhi_epi16(ab[k], cz[k])));
+        }
+    }
+#elif defined(__ARM_NEON)
+    for (; i + 16 <= count; i += 16)
+    {
+        uint8x16x3_t pixels = {{vld1q_u8(c0 + i), vld1q_u8(c1 + i), vld1q_u8(c2 + i)}};
+        vst3q_u8(output + 3 * i, pixels);
+    }
+#endif
+    for (; i < count; i++)
+    {
+        output[3 * i]     = c0[i];
+        output[3 * i + 1] = c1[i];
+        output[3 * i + 2] = c2[i];
+    }
+}
+
+void interleave3(const uint16_t *c0, const uint16_t *c1, const uint16_t *c2, uint16_t *output, size_t count)
+{
+    size_t i = 0;
+#if defined(__SSSE3__)
+    const __m128i m00 = _mm_setr_epi8(0, 1, -1, -1, -1, -1, 2, 3, -1, -1, -1, -1, 4, 5, -1, -1);
+    const __m128i m01 = _mm_setr_epi8(-1, -1, 0, 1, -1, -1, -1, -1, 2, 3, -1, -1, -1, -1, 4, 5);
+    const __m128i m02 = _mm_setr_epi8(-1, -1, -1, -1, 0, 1, -1, -1, -1, -1, 2, 3, -1, -1, -1, -1);
+    const __m128i m10 = _mm_setr_epi8(-1, -1, 6, 7, -1, -1, -1, -1, 8, 9, -1, -1, -1, -1, 10, 11);
+    const __m128i m11 = _mm_setr_epi8(-1, -1, -1, -1, 6, 7, -1, -1, -1, -1, 8, 9, -1, -1, -1, -1);
+    const __m128i m12 = _mm_setr_epi8(4, 5, -1, -1, -1, -1, 6, 7, -1, -1, -1, -1, 8, 9, -1, -1);
+    const __m128i m20 = _mm_setr_epi8(-1, -1, -1, -1, 12, 13, -1, -1, -1, -1, 14, 15, -1, -1, -1, -1);
+    const __m128i m21 = _mm_setr_epi8(10, 11, -1, -1, -1, -1, 12, 13, -1, -1, -1, -1, 14, 15, -1, -1);
+    const __m128i m22 = _mm_setr_epi8(-1, -1, 10, 11, -1, -1, -1, -1, 12, 13, -1, -1, -1, -1, 14, 15);
+    for (; i + 8 <= count; i += 8)
+    {
+        __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(c0 + i));
+        __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i *>(c1 + i));
+        __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i *>(c2 + i));
+        __m128i *out = reinterpret_cast<__m128i *>(output + 3 * i);
+        _mm_storeu_si128(out, _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(a, m00), _mm_shuffle_epi8(b, m01)),
+                                           _mm_shuffle_epi8(c, m02)));
+        _mm_storeu_si128(out + 1, _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(a, m10), _mm_shuffle_epi8(b, m11)),
+                                               _mm_shuffle_epi8(c, m12)));
+        _mm_storeu_si128(out + 2, _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(a, m20), _mm_shuffle_epi8(b, m21)),
+                                               _mm_shuffle_epi8(c, m22)));
+    }
+#elif defined(__SSE2__)
+    // Each store writes 4 bytes past its 12 bytes, overwritten by the next one
+    const __m128i zero = _mm_setzero_si128();
+    for (; i + 9 <= count; i += 8)
+    {
+        __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(c0 + i));
+        __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i *>(c1 + i));
+        __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i *>(c2 + i));
+        __m128i ab[2] = {_mm_unpacklo_epi16(a, b), _mm_unpackhi_epi16(a, b)};
+        __m128i cz[2] = {_mm_unpacklo_epi16(c, zero), _mm_unpackhi_epi16(c, zero)};
+        for (int k = 0; k < 2; k++)
+        {
+            uint8_t *out = reinterpret_cast<uint8_t *>(output + 3 * i) + 24 * k;
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(out), packHalves(_mm_unpacklo_epi32(ab[k], cz[k])));
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(out + 12), packHalves(_mm_unpackhi_epi32(ab[k], cz[k])));
+        }
+    }
+#elif defined(__ARM_NEON)
+    for (; i + 8 <= count; i += 8)
+    {
+        uint16x8x3_t pixels = {{vld1q_u16(c0 + i), vld1q_u16(c1 + i), vld1q_u16(c2 + i)}};
+        vst3q_u16(output + 3 * i, pixels);
+    }
+#endif
+    for (; i < count; i++)
+    {
+        output[3 * i]     = c0[i];
+        output[3 * i + 1] = c1[i];
+        output[3 * i + 2] = c2[i];
+    }
+}
+
+// Split packed pixels to three planes
+void deinterleave3(const uint8_t *input, uint8_t *c0, uint8_t *c1, uint8_t *c2, size_t count)
+{
+    size_t i = 0;
+#if defined(__SSSE3__)
+    const __m128i m00 = _mm_setr_epi8(0, 3, 6, 9, 12, 15, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+    const __m128i m01 = _mm_setr_epi8(-1, -1, -1, -1, -1, -1, 2, 5, 8, 11, 14, -1, -1, -1, -1, -1);
+    const __m128i m02 = _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 1, 4, 7, 10, 13);
+    const __m128i m10 = _mm_setr_epi8(1, 4, 7, 10, 13, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+    const __m128i m11 = _mm_setr_epi8(-1, -1, -1, -1, -1, 0, 3, 6, 9, 12, 15, -1, -1, -1, -1, -1);
+    const __m128i m12 = _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 2, 5, 8, 11, 14);
+    const __m128i m20 = _mm_setr_epi8(2, 5, 8, 11, 14, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+    const __m128i m21 = _mm_setr_epi8(-1, -1, -1, -1, -1, 1, 4, 7, 10, 13, -1, -1, -1, -1, -1, -1);
+    const __m128i m22 = _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 0, 3, 6, 9, 12, 15);
+    for (; i + 16 <= count; i += 16)
+    {
+        const __m128i *in = reinterpret_cast<const __m128i *>(input + 3 * i);
+        __m128i a = _mm_loadu_si128(in);
+        __m128i b = _mm_loadu_si128(in + 1);
+        __m128i c = _mm_loadu_si128(in + 2);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(c0 + i),
+                         _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(a, m00), _mm_shuffle_epi8(b, m01)), _mm_shuffle_epi8(c, m02)));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(c1 + i),
+                         _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(a, m10), _mm_shuffle_epi8(b, m11)), _mm_shuffle_epi8(c, m12)));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(c2 + i),
+                         _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(a, m20), _mm_shuffle_epi8(b, m21)), _mm_shuffle_epi8(c, m22)));
+    }
+#elif defined(__ARM_NEON)
+    for (; i + 16 <= count; i += 16)
+    {
+        uint8x16x3_t pixels = vld3q_u8(input + 3 * i);
+        vst1q_u8(c0 + i, pixels.val[0]);
+        vst1q_u8(c1 + i, pixels.val[1]);
+        vst1q_u8(c2 + i, pixels.val[2]);
+    }
+#endif
+    for (; i < count; i++)
+    {
+        c0[i] = input[3 * i];
+        c1[i] = input[3 * i + 1];
+        c2[i] = input[3 * i + 2];
+    }
+}
+
+/* Packed 4:2:2 reordering */
+
+// Offsets of Y0, U, Y1 and V in a pixel pair of each order
+constexpr uint8_t PAIR_OFFSETS[4][4] = {{0, 1, 2, 3}, {1, 0, 3, 2}, {0, 3, 2, 1}, {1, 2, 3, 0}};
+
+#if defined(__AVX2__)
+inline __m256i reorderPairs(__m256i pairs, PackedYUVOrder order)
+{
+    switch (order)
+    {
+        case PACKED_UYVY:
+            return _mm256_or_si256(_mm256_srli_epi16(pairs, 8), _mm256_slli_epi16(pairs, 8));
+        case PACKED_YVYU:
+        {
+            const __m256i chroma = _mm256_set1_epi32(static_cast<int>(0xFF00FF00));
+            __m256i swapped = _mm256_and_si256(pairs, chroma);
+            swapped = _mm256_or_si256(_mm256_slli_epi32(swapped, 16), _mm256_srli_epi32(swapped, 16));
+            return _mm256_or_si256(_mm256_andnot_si256(chroma, pairs), swapped);
+        }
+        case PACKED_VYUY:
+            return _mm256_or_si256(_mm256_srli_epi32(pairs, 8), _mm256_slli_epi32(pairs, 24));
+        default:
+            return pairs;
+    }
+}
+#elif defined(__SSE2__)
+inline __m128i reorderPairs(__m128i pairs, PackedYUVOrder order)
+{
+    switch (order)
+    {
+        case PACKED_UYVY:
+            return _mm_or_si128(_mm_srli_epi16(pairs, 8), _mm_slli_epi16(pairs, 8));
+        case PACKED_YVYU:
+        {
+            const __m128i chroma = _mm_set1_epi32(static_cast<int>(0xFF00FF00));
+            __m128i swapped = _mm_and_si128(pairs, chroma);
+            swapped = _mm_or_si128(_mm_slli_epi32(swapped, 16), _mm_srli_epi32(swapped, 16));
+            return _mm_or_si128(_mm_andnot_si128(chroma, pairs), swapped);
+        }
+        case PACKED_VYUY:
+            return _mm_or_si128(_mm_srli_epi32(pairs, 8), _mm_slli_epi32(pairs, 24));
+        default:
+            return pairs;
+    }
+}
+#endif
+
+// Reorder count pixel pairs to YUYV, returns the number of pairs done with SIMD
+size_t reorderBlock(const uint8_t *source, size_t count, PackedYUVOrder order, uint8_t *destination)
+{
+    size_t i = 0;
+#if defined(__AVX2__)
+    for (; i + 8 <= count; i += 8)
+    {
+        __m256i pairs = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(source + 4 * i));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(destination + 4 * i), reorderPairs(pairs, order));
+    }
+#elif defined(__SSE2__)
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128i pairs = _mm_loadu_si128(reinterpret_cast<const __m128i *>(source + 4 * i));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(destination + 4 * i), reorderPairs(pairs, order));
+    }
+#elif defined(__ARM_NEON)
+    const uint8_t *offset = PAIR_OFFSETS[order];
+    for (; i + 16 <= count; i += 16)
+    {
+        uint8x16x4_t pairs = vld4q_u8(source + 4 * i);
+        uint8x16x4_t reordered = {{pairs.val[offset[0]], pairs.val[offset[1]], pairs.val[offset[2]], pairs.val[offset[3]]}};
+        vst4q_u8(destination + 4 * i, reordered);
+    }
+#endif
+    return i;
+}
+
+/* YUYV to RGB24 */
+
+inline uint8_t saturate(int value)
+{
+    return static_cast<uint8_t>(value < 0 ? 0 : (value > 255 ? 255 : value));
+}
+
+#if defined(__AVX2__)
+// Channels of 8 pixel pairs per 128 bit lane, as 16 bit samples
+inline void yuyvChannels(__m256i pairs, __m256i &r, __m256i &g, __m256i &b)
+{
+    const __m256i y  = _mm256_and_si256(pairs, _mm256_set1_epi16(0x00FF));
+    const __m256i uv = _mm256_sub_epi16(_mm256_srli_epi16(pairs, 8), _mm256_set1_epi16(128));
+    // Each product of a pair is computed in 32 bits, then duplicated for both pixels
+    __m256i cb = _mm256_srai_epi32(_mm256_madd_epi16(uv, _mm256_set1_epi32(454)), 8);
+    __m256i cg = _mm256_srai_epi32(_mm256_madd_epi16(uv, _mm256_set1_epi32((183 << 16) | 88)), 8);
+    __m256i cr = _mm256_srai_epi32(_mm256_madd_epi16(uv, _mm256_set1_epi32(359 << 16)), 8);
+    cb = _mm256_packs_epi32(cb, cb);
+    cg = _mm256_packs_epi32(cg, cg);
+    cr = _mm256_packs_epi32(cr, cr);
+    r = _mm256_add_epi16(y, _mm256_unpacklo_epi16(cr, cr));
+    g = _mm256_sub_epi16(y, _mm256_unpacklo_epi16(cg, cg));
+    b = _mm256_add_epi16(y, _mm256_unpacklo_epi16(cb, cb));
+}
+
+inline void storePacked(uint8_t *destination, __m256i low, __m256i high)
+{
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(destination),
+                        _mm256_permute4x64_epi64(_mm256_packus_epi16(low, high), 0xD8));
+}
+#elif defined(__SSE2__)
+// Channels of 4 pixel pairs, as 16 bit samples
+inline void yuyvChannels(__m128i pairs, __m128i &r, __m128i &g, __m128i &b)
+{
+    const __m128i y  = _mm_and_si128(pairs, _mm_set1_epi16(0x00FF));
+    const __m128i uv = _mm_sub_epi16(_mm_srli_epi16(pairs, 8), _mm_set1_epi16(128));
+    // Each product of a pair is computed in 32 bits, then duplicated for both pixels
+    __m128i cb = _mm_srai_epi32(_mm_madd_epi16(uv, _mm_set1_epi32(454)), 8);
+    __m128i cg = _mm_srai_epi32(_mm_madd_epi16(uv, _mm_set1_epi32((183 << 16) | 88)), 8);
+    __m128i cr = _mm_srai_epi32(_mm_madd_epi16(uv, _mm_set1_epi32(359 << 16)), 8);
+    cb = _mm_packs_epi32(cb, cb);
+    cg = _mm_packs_epi32(cg, cg);
+    cr = _mm_packs_epi32(cr, cr);
+    r = _mm_add_epi16(y, _mm_unpacklo_epi16(cr, cr));
+    g = _mm_sub_epi16(y, _mm_unpacklo_epi16(cg, cg));
+    b = _mm_add_epi16(y, _mm_unpacklo_epi16(cb, cb));
+}
+#elif defined(__ARM_NEON)
+// (a * ka + b * kb) >> 8 of 8 chroma pairs
+inline int16x8_t scaleChroma(int16x8_t a, int16_t ka, int16x8_t b, int16_t kb)
+{
+    int32x4_t low  = vmlal_n_s16(vmull_n_s16(vget_low_s16(a), ka), vget_low_s16(b), kb);
+    int32x4_t high = vmlal_n_s16(vmull_n_s16(vget_high_s16(a), ka), vget_high_s16(b), kb);
+    return vcombine_s16(vshrn_n_s32(low, 8), vshrn_n_s32(high, 8));
+}
+
+inline void storeZipped(uint8_t *destination, uint8x8_t even, uint8x8_t odd)
+{
+    uint8x8x2_t zipped = vzip_u8(even, odd);
+    vst1q_u8(destination, vcombine_u8(zipped.val[0], zipped.val[1]));
+}
+#endif
+
+// Convert count pixel pairs to planar channels, returns the number of pairs done with SIMD
+size_t yuyvBlock(const uint8_t *source, size_t count, uint8_t *r, uint8_t *g, uint8_t *b)
+{
+    size_t i = 0;
+#if defined(__AVX2__)
+    for (; i + 16 <= count; i += 16)
+    {
+        __m256i r0, g0, b0, r1, g1, b1;
+        yuyvChannels(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(source + 4 * i)), r0, g0, b0);
+        yuyvChannels(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(source + 4 * i + 32)), r1, g1, b1);
+        storePacked(r + 2 * i, r0, r1);
+        storePacked(g + 2 * i, g0, g1);
+        storePacked(b + 2 * i, b0, b1);
+    }
+#elif defined(__SSE2__)
+    for (; i + 8 <= count; i += 8)
+    {
+        __m128i r0, g0, b0, r1, g1, b1;
+        yuyvChannels(_mm_loadu_si128(reinterpret_cast<const __m128i *>(source + 4 * i)), r0, g0, b0);
+        yuyvChannels(_mm_loadu_si128(reinterpret_cast<const __m128i *>(source + 4 * i + 16)), r1, g1, b1);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(r + 2 * i), _mm_packus_epi16(r0, r1));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(g + 2 * i), _mm_packus_epi16(g0, g1));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(b + 2 * i), _mm_packus_epi16(b0, b1));
+    }
+#elif defined(__ARM_NEON)
+    for (; i + 8 <= count; i += 8)
+    {
+        uint8x8x4_t pairs = vld4_u8(source + 4 * i);
+        int16x8_t u  = vreinterpretq_s16_u16(vsubl_u8(pairs.val[1], vdup_n_u8(128)));
+        int16x8_t v  = vreinterpretq_s16_u16(vsubl_u8(pairs.val[3], vdup_n_u8(128)));
+        int16x8_t cb = scaleChroma(u, 454, v, 0);
+        int16x8_t cg = scaleChroma(u, 88, v, 183);
+        int16x8_t cr = scaleChroma(v, 359, u, 0);
+        int16x8_t y0 = vreinterpretq_s16_u16(vmovl_u8(pairs.val[0]));
+        int16x8_t y1 = vreinterpretq_s16_u16(vmovl_u8(pairs.val[2]));
+        storeZipped(r + 2 * i, vqmovun_s16(vaddq_s16(y0, cr)), vqmovun_s16(vaddq_s16(y1, cr)));
+        storeZipped(g + 2 * i, vqmovun_s16(vsubq_s16(y0, cg)), vqmovun_s16(vsubq_s16(y1, cg)));
+        storeZipped(b + 2 * i, vqmovun_s16(vaddq_s16(y0, cb)), vqmovun_s16(vaddq_s16(y1, cb)));
+    }
+#endif
+    return i;
+}
+
+/* YUYV to YUV 4:2:0 */
+
+// Copy the luma of count pixels, returns the number of pixels done with SIMD
+size_t lumaBlock(const uint8_t *source, size_t count, uint8_t *y)
+{
+    size_t i = 0;
+#if defined(__AVX2__)
+    const __m256i mask = _mm256_set1_epi16(0x00FF);
+    for (; i + 32 <= count; i += 32)
+    {
+        __m256i low  = _mm256_and_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(source + 2 * i)), mask);
+        __m256i high = _mm256_and_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(source + 2 * i + 32)), mask);
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(y + i),
+                            _mm256_permute4x64_epi64(_mm256_packus_epi16(low, high), 0xD8));
+    }
+#elif defined(__SSE2__)
+    const __m128i mask = _mm_set1_epi16(0x00FF);
+    for (; i + 16 <= count; i += 16)
+    {
+        __m128i low  = _mm_and_si128(_mm_loadu_si128(reinterpret_cast<const __m128i *>(source + 2 * i)), mask);
+        __m128i high = _mm_and_si128(_mm_loadu_si128(reinterpret_cast<const __m128i *>(source + 2 * i + 16)), mask);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(y + i), _mm_packus_epi16(low, high));
+    }
+#elif defined(__ARM_NEON)
+    for (; i + 16 <= count; i += 16)
+        vst1q_u8(y + i, vld2q_u8(source + 2 * i).val[0]);
+#endif
+    return i;
+}
+
+#if defined(__AVX2__) || defined(__SSE2__)
+// Rounded down average of bytes, _mm_avg_epu8 rounds up
+inline __m128i averageDown(__m128i a, __m128i b)
+{
+    return _mm_sub_epi8(_mm_avg_epu8(a, b), _mm_and_si128(_mm_xor_si128(a, b), _mm_set1_epi8(1)));
+}
+
+// Average chroma of 8 pixel pairs of two rows, as U V U V...
+inline __m128i averageChroma(const uint8_t *row0, const uint8_t *row1)
+{
+    __m128i low  = averageDown(_mm_loadu_si128(reinterpret_cast<const __m128i *>(row0)),
+                               _mm_loadu_si128(reinterpret_cast<const __m128i *>(row1)));
+    __m128i high = averageDown(_mm_loadu_si128(reinterpret_cast<const __m128i *>(row0 + 16)),
+                               _mm_loadu_si128(reinterpret_cast<const __m128i *>(row1 + 16)));
+    return _mm_packus_epi16(_mm_srli_epi16(low, 8), _mm_srli_epi16(high, 8));
+}
+#endif
+
+// Average the chroma of count pixel pairs of two rows, returns the number of pairs done with SIMD
+size_t chromaBlock(const uint8_t *row0, const uint8_t *row1, size_t count, uint8_t *u, uint8_t *v)
+{
+    size_t i = 0;
+#if defined(__AVX2__) || defined(__SSE2__)
+    const __m128i mask = _mm_set1_epi16(0x00FF);
+    for (; i + 16 <= count; i += 16)
+    {
+        __m128i low  = averageChroma(row0 + 4 * i, row1 + 4 * i);
+        __m128i high = averageChroma(row0 + 4 * i + 32, row1 + 4 * i + 32);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(u + i), _mm_packus_epi16(_mm_and_si128(low, mask),
+                         _mm_and_si128(high, mask)));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(v + i), _mm_packus_epi16(_mm_srli_epi16(low, 8),
+                         _mm_srli_epi16(high, 8)));
+    }
+#elif defined(__ARM_NEON)
+    for (; i + 16 <= count; i += 16)
+    {
+        uint8x16x4_t pairs0 = vld4q_u8(row0 + 4 * i);
+        uint8x16x4_t pairs1 = vld4q_u8(row1 + 4 * i);
+        vst1q_u8(u + i, vhaddq_u8(pairs0.val[1], pairs1.val[1]));
+        vst1q_u8(v + i, vhaddq_u8(pairs0.val[3], pairs1.val[3]));
+    }
+#endif
+    return i;
+}
+
+/* Bayer demosaicing */
+
+// Bilinear interpolation of pixel i of a BGGR frame, borders included, as bayer2rgb24() and bayer16_2_rgb24()
+template <typename T>
+void demosaicPixel(const T *source, long i, long width, long height, T &c0, T &c1, T &c2)
+{
+    const T *p = source + i;
+    const long w = width;
+
+    if ((i / w) % 2 == 0)
+    {
+        if (i % 2 == 0)
+        {
+            // Blue
+            if (i > w && i % w > 0)
+            {
+                c0 = (p[-w - 1] + p[-w + 1] + p[w - 1] + p[w + 1]) / 4;
+                c1 = (p[-1] + p[1] + p[w] + p[-w]) / 4;
+            }
+            else
+            {
+                c0 = p[w + 1];
+                c1 = (p[1] + p[w]) / 2;
+            }
+            c2 = p[0];
+        }
+        else
+        {
+            // Green on a blue row
+            if (i > w && i % w < w - 1)
+            {
+                c0 = (p[w] + p[-w]) / 2;
+                c2 = (p[-1] + p[1]) / 2;
+            }
+            else
+            {
+                c0 = p[w];
+                c2 = p[-1];
+            }
+            c1 = p[0];
+        }
+    }
+    else
+    {
+        if (i % 2 == 0)
+        {
+            // Green on a red row
+            if (i < w * (height - 1) && i % w > 0)
+            {
+                c0 = (p[-1] + p[1]) / 2;
+                c2 = (p[w] + p[-w]) / 2;
+            }
+            else
+            {
+                c0 = p[1];
+                c2 = p[-w];
+            }
+            c1 = p[0];
+        }
+        else
+        {
+            // Red
+            if (i < w * (height - 1) && i % w < w - 1)
+            {
+                c1 = (p[-1] + p[1] + p[-w] + p[w]) / 4;
+                c2 = (p[-w - 1] + p[-w + 1] + p[w - 1] + p[w + 1]) / 4;
+            }
+            else
+            {
+                c1 = (p[-1] + p[-w]) / 2;
+                c2 = p[-w - 1];
+            }
+            c0 = p[0];
+        }
+    }
+}
+
+/*
+ * Samples are processed as 16 bit lanes. Interpolations are exact floor divisions without overflow, so 8 and 16 bit
+ * frames share the same kernel.
+ */
+#if defined(__AVX2__)
+using Samples = __m256i;
+constexpr size_t SAMPLE_LANES = 16;
+
+inline Samples loadSamples(const uint8_t *p)
+{
+    return _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i *>(p)));
+}
+
+inline Samples loadSamples(const uint16_t *p)
+{
+    return _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+}
+
+inline void storeSamples(uint8_t *p, Samples x)
+{
+    __m256i packed = _mm256_permute4x64_epi64(_mm256_packus_epi16(x, x), 0xD8);
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(p), _mm256_castsi256_si128(packed));
+}
+
+inline void storeSamples(uint16_t *p, Samples x)
+{
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(p), x);
+}
+
+// (a + b) / 2, _mm256_avg_epu16 rounds up
+inline Samples half(Samples a, Samples b)
+{
+    return _mm256_sub_epi16(_mm256_avg_epu16(a, b), _mm256_and_si256(_mm256_xor_si256(a, b), _mm256_set1_epi16(1)));
+}
+
+// (a + b + c + d) / 4
+inline Samples quarter(Samples a, Samples b, Samples c, Samples d)
+{
+    const __m256i three = _mm256_set1_epi16(3);
+    __m256i high = _mm256_add_epi16(_mm256_add_epi16(_mm256_srli_epi16(a, 2), _mm256_srli_epi16(b, 2)),
+                                    _mm256_add_epi16(_mm256_srli_epi16(c, 2), _mm256_srli_epi16(d, 2)));
+    __m256i low  = _mm256_add_epi16(_mm256_add_epi16(_mm256_and_si256(a, three), _mm256_and_si256(b, three)),
+                                    _mm256_add_epi16(_mm256_and_si256(c, three), _mm256_and_si256(d, three)));
+    return _mm256_add_epi16(high, _mm256_srli_epi16(low, 2));
+}
+
+// Even lanes of even, odd lanes of odd
+inline Samples alternate(Samples even, Samples odd)
+{
+    return _mm256_blend_epi16(odd, even, 0x55);
+}
+#elif defined(__SSE2__)
+using Samples = __m128i;
+constexpr size_t SAMPLE_LANES = 8;
+
+inline Samples loadSamples(const uint8_t *p)
+{
+    return _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(p)), _mm_setzero_si128());
+}
+
+inline Samples loadSamples(const uint16_t *p)
+{
+    return _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+}
+
+inline void storeSamples(uint8_t *p, Samples x)
+{
+    _mm_storel_epi64(reinterpret_cast<__m128i *>(p), _mm_packus_epi16(x, x));
+}
+
+inline void storeSamples(uint16_t *p, Samples x)
+{
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(p), x);
+}
+
+// (a + b) / 2, _mm_avg_epu16 rounds up
+inline Samples half(Samples a, Samples b)
+{
+    return _mm_sub_epi16(_mm_avg_epu16(a, b), _mm_and_si128(_mm_xor_si128(a, b), _mm_set1_epi16(1)));
+}
+
+// (a + b + c + d) / 4
+inline Samples quarter(Samples a, Samples b, Samples c, Samples d)
+{
+    const __m128i three = _mm_set1_epi16(3);
+    __m128i high = _mm_add_epi16(_mm_add_epi16(_mm_srli_epi16(a, 2), _mm_srli_epi16(b, 2)),
+                                 _mm_add_epi16(_mm_srli_epi16(c, 2), _mm_srli_epi16(d, 2)));
+    __m128i low  = _mm_add_epi16(_mm_add_epi16(_mm_and_si128(a, three), _mm_and_si128(b, three)),
+                                 _mm_add_epi16(_mm_and_si128(c, three), _mm_and_si128(d, three)));
+    return _mm_add_epi16(high, _mm_srli_epi16(low, 2));
+}
+
+// Even lanes of even, odd lanes of odd
+inline Samples alternate(Samples even, Samples odd)
+{
+    const __m128i mask = _mm_set1_epi32(0x0000FFFF);
+    return _mm_or_si128(_mm_and_si128(mask, even), _mm_andnot_si128(mask, odd));
+}
+#elif defined(__ARM_NEON)
+using Samples = uint16x8_t;
+constexpr size_t SAMPLE_LANES = 8;
+
+inline Samples loadSamples(const uint8_t *p)
+{
+    return vmovl_u8(vld1_u8(p));
+}
+
+inline Samples loadSamples(const uint16_t *p)
+{
+    return vld1q_u16(p);
+}
+
+inline void storeSamples(uint8_t *p, Samples x)
+{
+    vst1_u8(p, vmovn_u16(x));
+}
+
+inline void storeSamples(uint16_t *p, Samples x)
+{
+    vst1q_u16(p, x);
+}
+
+// (a + b) / 2
+inline Samples half(Samples a, Samples b)
+{
+    return vhaddq_u16(a, b);
+}
+
+// (a + b + c + d) / 4
+inline Samples quarter(Samples a, Samples b, Samples c, Samples d)
+{
+    const uint16x8_t three = vdupq_n_u16(3);
+    uint16x8_t high = vaddq_u16(vaddq_u16(vshrq_n_u16(a, 2), vshrq_n_u16(b, 2)),
+                                vaddq_u16(vshrq_n_u16(c, 2), vshrq_n_u16(d, 2)));
+    uint16x8_t low  = vaddq_u16(vaddq_u16(vandq_u16(a, three), vandq_u16(b, three)),
+                                vaddq_u16(vandq_u16(c, three), vandq_u16(d, three)));
+    return vaddq_u16(high, vshrq_n_u16(low, 2));
+}
+
+// Even lanes of even, odd lanes of odd
+inline Samples alternate(Samples even, Samples odd)
+{
+    return vbslq_u16(vreinterpretq_u16_u32(vdupq_n_u32(0x0000FFFF)), even, odd);
+}
+#endif
+
+// Demosaic count pixels of an inner row from an even column, returns the number of pixels done with SIMD
+template <typename T>
+size_t demosaicBlock(const T *center, size_t stride, bool oddRow, size_t count, T *c0, T *c1, T *c2)
+{
+    size_t i = 0;
+#if defined(__AVX2__) || defined(__SSE2__) || defined(__ARM_NEON)
+    const T *up   = center - stride;
+    const T *down = center + stride;
+    for (; i + SAMPLE_LANES <= count; i += SAMPLE_LANES)
+    {
+        Samples pixel  = loadSamples(center + i);
+        Samples left   = loadSamples(center + i - 1);
+        Samples right  = loadSamples(center + i + 1);
+        Samples top    = loadSamples(up + i);
+        Samples bottom = loadSamples(down + i);
+
+        Samples diagonal   = quarter(loadSamples(up + i - 1), loadSamples(up + i + 1), loadSamples(down + i - 1),
+                                     loadSamples(down + i + 1));
+        Samples cross      = quarter(left, right, top, bottom);
+        Samples vertical   = half(top, bottom);
+        Samples horizontal = half(left, right);
+
+        if (oddRow)
+        {
+            // Green, red
+            storeSamples(c0 + i, alternate(horizontal, pixel));
+            storeSamples(c1 + i, alternate(pixel, cross));
+            storeSamples(c2 + i, alternate(vertical, diagonal));
+        }
+        else
+        {
+            // Blue, green
+            storeSamples(c0 + i, alternate(diagonal, vertical));
+            storeSamples(c1 + i, alternate(cross, pixel));
+            storeSamples(c2 + i, alternate(pixel, horizontal));
+        }
+    }
+#endif
+    return i;
+}
+
+template <typename T>
+void demosaic(const T *source, T *destination, uint32_t width, uint32_t height, BayerPattern pattern,
+              unsigned int threads)
+{
+    threads = threadCount(threads, static_cast<size_t>(width) * height, height);
+
+    convertRows(height, threads, [&](uint32_t first, uint32_t last)
+    {
+        std::vector<T> planes(3 * static_cast<size_t>(width));
+        T *c0 = planes.data();
+        T *c1 = c0 + width;
+        T *c2 = c1 + width;
+        // RGGB is BGGR with red and blue swapped, borders included
+        const T *red  = pattern == BAYER_RGGB ? c2 : c0;
+        const T *blue = pattern == BAYER_RGGB ? c0 : c2;
+
+        for (uint32_t row = first; row < last; row++)
+        {
+            const long offset = static_cast<long>(row) * width;
+            uint32_t col = 0;
+            // Inner rows of frames with an even width have every neighbour, and columns keep the pattern parity
+            if (width % 2 == 0 && width > 3 && row > 0 && row + 1 < height)
+            {
+                for (; col < 2; col++)
+                    demosaicPixel(source, offset + col, width, height, c0[col], c1[col], c2[col]);
+                col += demosaicBlock(source + offset + 2, width, row % 2 == 1, width - 3, c0 + 2, c1 + 2, c2 + 2);
+            }
+            for (; col < width; col++)
+                demosaicPixel(source, offset + col, width, height, c0[col], c1[col], c2[col]);
+
+            interleave3(red, c1, blue, destination + 3 * offset, width);
+        }
+    });
+}
+
+/* RGB24 to YUV 4:2:0 */
+
+constexpr float Y_RED     = static_cast<float>(0.2990);
+constexpr float Y_GREEN   = static_cast<float>(0.5870);
+constexpr float Y_BLUE    = static_cast<float>(0.1140);
+constexpr float U_RED     = static_cast<float>(0.1684);
+constexpr float U_GREEN   = static_cast<float>(0.3316);
+constexpr float V_GREEN   = static_cast<float>(0.4187);
+constexpr float V_BLUE    = static_cast<float>(0.0813);
+
+// Products rounded to float, as in the tables of RGB2YUV()
+struct YUVTables
+{
+    float yRed[256], yGreen[256], yBlue[256];
+    float uRed[256], uGreen[256];
+    float vGreen[256], vBlue[256];
+
+    YUVTables()
+    {
+        for (int i = 0; i < 256; i++)
+        {
+            yRed[i]   = Y_RED * i;
+            yGreen[i] = Y_GREEN * i;
+            yBlue[i]  = Y_BLUE * i;
+            uRed[i]   = U_RED * i;
+            uGreen[i] = U_GREEN * i;
+            vGreen[i] = V_GREEN * i;
+            vBlue[i]  = V_BLUE * i;
+        }
+    }
+};
+
+const YUVTables &yuvTables()
+{
+    static const YUVTables tables;
+    return tables;
+}
+
+// Keep a product rounded to float, a fused multiply add would not round it as the tables do
+#if defined(__GNUC__) && (defined(__AVX2__) || defined(__SSE2__))
+#define KEEP_ROUNDED(x) __asm__("" : "+x"(x))
+#elif defined(__GNUC__) && defined(__ARM_NEON)
+#define KEEP_ROUNDED(x) __asm__("" : "+w"(x))
+#else
+#define KEEP_ROUNDED(x)
+#endif
+
+#if defined(__AVX2__)
+using Floats = __m256;
+
+inline Floats multiply(Floats a, float k)
+{
+    Floats product = _mm256_mul_ps(a, _mm256_set1_ps(k));
+    KEEP_ROUNDED(product);
+    return product;
+}
+
+// Y, U and V of 8 pixels as 32 bit integers
+inline void yuvPixels(const uint8_t *r, const uint8_t *g, const uint8_t *b, __m256i &y, __m256i &u, __m256i &v)
+{
+    __m256i ri = _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(r)));
+    __m256i gi = _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(g)));
+    __m256i bi = _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(b)));
+    Floats rf = _mm256_cvtepi32_ps(ri);
+    Floats gf = _mm256_cvtepi32_ps(gi);
+    Floats bf = _mm256_cvtepi32_ps(bi);
+    const Floats offset = _mm256_set1_ps(128);
+
+    y = _mm256_cvttps_epi32(_mm256_add_ps(_mm256_add_ps(multiply(rf, Y_RED), multiply(gf, Y_GREEN)),
+                                          multiply(bf, Y_BLUE)));
+    Floats uf = _mm256_sub_ps(_mm256_sub_ps(_mm256_setzero_ps(), multiply(rf, U_RED)), multiply(gf, U_GREEN));
+    uf = _mm256_add_ps(_mm256_add_ps(uf, _mm256_cvtepi32_ps(_mm256_srli_epi32(bi, 1))), offset);
+    u = _mm256_cvttps_epi32(uf);
+    Floats vf = _mm256_sub_ps(_mm256_sub_ps(_mm256_cvtepi32_ps(_mm256_srli_epi32(ri, 1)), multiply(gf, V_GREEN)),
+                              multiply(bf, V_BLUE));
+    v = _mm256_cvttps_epi32(_mm256_add_ps(vf, offset));
+}
+
+inline void storeBytes(uint8_t *p, __m256i low, __m256i high)
+{
+    __m256i words = _mm256_permute4x64_epi64(_mm256_packs_epi32(low, high), 0xD8);
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(p),
+                     _mm_packus_epi16(_mm256_castsi256_si128(words), _mm256_extracti128_si256(words, 1)));
+}
+#elif defined(__SSE2__)
+using Floats = __m128;
+
+inline Floats multiply(Floats a, float k)
+{
+    Floats product = _mm_mul_ps(a, _mm_set1_ps(k));
+    KEEP_ROUNDED(product);
+    return product;
+}
+
+// Y, U and V of 4 pixels as 32 bit integers
+inline void yuvPixels(__m128i ri, __m128i gi, __m128i bi, __m128i &y, __m128i &u, __m128i &v)
+{
+    Floats rf = _mm_cvtepi32_ps(ri);
+    Floats gf = _mm_cvtepi32_ps(gi);
+    Floats bf = _mm_cvtepi32_ps(bi);
+    const Floats offset = _mm_set1_ps(128);
+
+    y = _mm_cvttps_epi32(_mm_add_ps(_mm_add_ps(multiply(rf, Y_RED), multiply(gf, Y_GREEN)), multiply(bf, Y_BLUE)));
+    Floats uf = _mm_sub_ps(_mm_sub_ps(_mm_setzero_ps(), multiply(rf, U_RED)), multiply(gf, U_GREEN));
+    u = _mm_cvttps_epi32(_mm_add_ps(_mm_add_ps(uf, _mm_cvtepi32_ps(_mm_srli_epi32(bi, 1))), offset));
+    Floats vf = _mm_sub_ps(_mm_sub_ps(_mm_cvtepi32_ps(_mm_srli_epi32(ri, 1)), multiply(gf, V_GREEN)),
+                           multiply(bf, V_BLUE));
+    v = _mm_cvttps_epi32(_mm_add_ps(vf, offset));
+}
+#elif defined(__ARM_NEON)
+using Floats = float32x4_t;
+
+inline Floats multiply(Floats a, float k)
+{
+    Floats product = vmulq_n_f32(a, k);
+    KEEP_ROUNDED(product);
+    return product;
+}
+
+// Y, U and V of 4 pixels
+inline void yuvPixels(uint32x4_t ri, uint32x4_t gi, uint32x4_t bi, uint16x4_t &y, uint16x4_t &u, uint16x4_t &v)
+{
+    Floats rf = vcvtq_f32_u32(ri);
+    Floats gf = vcvtq_f32_u32(gi);
+    Floats bf = vcvtq_f32_u32(bi);
+    const Floats offset = vdupq_n_f32(128);
+
+    y = vmovn_u32(vcvtq_u32_f32(vaddq_f32(vaddq_f32(multiply(rf, Y_RED), multiply(gf, Y_GREEN)), multiply(bf, Y_BLUE))));
+    Floats uf = vsubq_f32(vsubq_f32(vdupq_n_f32(0), multiply(rf, U_RED)), multiply(gf, U_GREEN));
+    u = vmovn_u32(vcvtq_u32_f32(vaddq_f32(vaddq_f32(uf, vcvtq_f32_u32(vshrq_n_u32(bi, 1))), offset)));
+    Floats vf = vsubq_f32(vsubq_f32(vcvtq_f32_u32(vshrq_n_u32(ri, 1)), multiply(gf, V_GREEN)), multiply(bf, V_BLUE));
+    v = vmovn_u32(vcvtq_u32_f32(vaddq_f32(vf, offset)));
+}
+#endif
+
+#undef KEEP_ROUNDED
+
+// Convert count pixels of planar channels to Y, U and V, returns the number of pixels done with SIMD
+size_t yuvBlock(const uint8_t *r, const uint8_t *g, const uint8_t *b, size_t count, uint8_t *y, uint8_t *u,
+                uint8_t *v)
+{
+    size_t i = 0;
+#if defined(__AVX2__)
+    for (; i + 16 <= count; i += 16)
+    {
+        __m256i y0, u0, v0, y1, u1, v1;
+        yuvPixels(r + i, g + i, b + i, y0, u0, v0);
+        yuvPixels(r + i + 8, g + i + 8, b + i + 8, y1, u1, v1);
+        storeBytes(y + i, y0, y1);
+        storeBytes(u + i, u0, u1);
+        storeBytes(v + i, v0, v1);
+    }
+#elif defined(__SSE2__)
+    const __m128i zero = _mm_setzero_si128();
+    for (; i + 16 <= count; i += 16)
+    {
+        __m128i rw[2], gw[2], bw[2], yw[2], uw[2], vw[2];
+        __m128i rb = _mm_loadu_si128(reinterpret_cast<const __m128i *>(r + i));
+        __m128i gb = _mm_loadu_si128(reinterpret_cast<const __m128i *>(g + i));
+        __m128i bb = _mm_loadu_si128(reinterpret_cast<const __m128i *>(b + i));
+        rw[0] = _mm_unpacklo_epi8(rb, zero);
+        rw[1] = _mm_unpackhi_epi8(rb, zero);
+        gw[0] = _mm_unpacklo_epi8(gb, zero);
+        gw[1] = _mm_unpackhi_epi8(gb, zero);
+        bw[0] = _mm_unpacklo_epi8(bb, zero);
+        bw[1] = _mm_unpackhi_epi8(bb, zero);
+        for (int k = 0; k < 2; k++)
+        {
+            __m128i y0, u0, v0, y1, u1, v1;
+            yuvPixels(_mm_unpacklo_epi16(rw[k], zero), _mm_unpacklo_epi16(gw[k], zero), _mm_unpacklo_epi16(bw[k], zero),
+                      y0, u0, v0);
+            yuvPixels(_mm_unpackhi_epi16(rw[k], zero), _mm_unpackhi_epi16(gw[k], zero), _mm_unpackhi_epi16(bw[k], zero),
+                      y1, u1, v1);
+            yw[k] = _mm_packs_epi32(y0, y1);
+            uw[k] = _mm_packs_epi32(u0, u1);
+            vw[k] = _mm_packs_epi32(v0, v1);
+        }
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(y + i), _mm_packus_epi16(yw[0], yw[1]));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(u + i), _mm_packus_epi16(uw[0], uw[1]));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(v + i), _mm_packus_epi16(vw[0], vw[1]));
+    }
+#elif defined(__ARM_NEON)
+    for (; i + 8 <= count; i += 8)
+    {
+        uint16x8_t rw = vmovl_u8(vld1_u8(r + i));
+        uint16x8_t gw = vmovl_u8(vld1_u8(g + i));
+        uint16x8_t bw = vmovl_u8(vld1_u8(b + i));
+        uint16x4_t y0, u0, v0, y1, u1, v1;
+        yuvPixels(vmovl_u16(vget_low_u16(rw)), vmovl_u16(vget_low_u16(gw)), vmovl_u16(vget_low_u16(bw)), y0, u0, v0);
+        yuvPixels(vmovl_u16(vget_high_u16(rw)), vmovl_u16(vget_high_u16(gw)), vmovl_u16(vget_high_u16(bw)), y1, u1, v1);
+        vst1_u8(y + i, vqmovn_u16(vcombine_u16(y0, y1)));
+        vst1_u8(u + i, vqmovn_u16(vcombine_u16(u0, u1)));
+        vst1_u8(v + i, vqmovn_u16(vcombine_u16(v0, v1)));
+    }
+#endif
+    return i;
+}
+
+// Average 2x2 blocks of two rows to count samples, returns the number of samples done with SIMD
+size_t subsampleBlock(const uint8_t *row0, const uint8_t *row1, size_t count, uint8_t *output)
+{
+    size_t i = 0;
+#if defined(__AVX2__) || defined(__SSE2__)
+    const __m128i mask = _mm_set1_epi16(0x00FF);
+    for (; i + 16 <= count; i += 16)
+    {
+        __m128i sums[2];
+        for (int k = 0; k < 2; k++)
+        {
+            __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(row0 + 2 * i + 16 * k));
+            __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i *>(row1 + 2 * i + 16 * k));
+            __m128i sum = _mm_add_epi16(_mm_add_epi16(_mm_and_si128(a, mask), _mm_srli_epi16(a, 8)),
+                                        _mm_add_epi16(_mm_and_si128(b, mask), _mm_srli_epi16(b, 8)));
+            sums[k] = _mm_srli_epi16(sum, 2);
+        }
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(output + i), _mm_packus_epi16(sums[0], sums[1]));
+    }
+#elif defined(__ARM_NEON)
+    for (; i + 8 <= count; i += 8)
+    {
+        uint16x8_t sum = vpadalq_u8(vpaddlq_u8(vld1q_u8(row0 + 2 * i)), vld1q_u8(row1 + 2 * i));
+        vst1_u8(output + i, vshrn_n_u16(sum, 2));
+    }
+#endif
+    return i;
+}
+
+}
+
+void packedYUVToYUYV(const uint8_t *src, size_t stride, uint8_t *dst, uint32_t width, uint32_t height,
+                     PackedYUVOrder order, unsigned int threads)
+{
+    const size_t pairs = width / 2;
+    const uint8_t *offset = PAIR_OFFSETS[order];
+    threads = threadCount(threads, static_cast<size_t>(width) * height, height);
+
+    convertRows(height, threads, [&](uint32_t first, uint32_t last)
+    {
+        for (uint32_t row = first; row < last; row++)
+        {
+            const uint8_t *input = src + row * stride;
+            uint8_t *output = dst + row * pairs * 4;
+            for (size_t i = reorderBlock(input, pairs, order, output); i < pairs; i++)
+            {
+                output[4 * i]     = input[4 * i + offset[0]];
+                output[4 * i + 1] = input[4 * i + offset[1]];
+                output[4 * i + 2] = input[4 * i + offset[2]];
+                output[4 * i + 3] = input[4 * i + offset[3]];
+            }
+        }
+    });
+}
+
+void yuyvToRGB24(const uint8_t *src, uint8_t *dst, uint32_t width, uint32_t height, unsigned int threads)
+{
+    const size_t pairs = width / 2;
+    threads = threadCount(threads, static_cast<size_t>(width) * height, height);
+
+    convertRows(height, threads, [&](uint32_t first, uint32_t last)
+    {
+        uint8_t r[BLOCK_PIXELS], g[BLOCK_PIXELS], b[BLOCK_PIXELS];
+        const size_t end = last * pairs;
+        for (size_t pair = first * pairs; pair < end; pair += BLOCK_PIXELS / 2)
+        {
+            const size_t block = std::min(BLOCK_PIXELS / 2, end - pair);
+            const uint8_t *input = src + 4 * pair;
+            for (size_t i = yuyvBlock(input, block, r, g, b); i < block; i++)
+            {
+                const uint8_t *s = input + 4 * i;
+                int cb = ((s[1] - 128) * 454) >> 8;
+                int cg = ((s[1] - 128) * 88 + (s[3] - 128) * 183) >> 8;
+                int cr = ((s[3] - 128) * 359) >> 8;
+                for (int k = 0; k < 2; k++)
+                {
+                    r[2 * i + k] = saturate(s[2 * k] + cr);
+                    g[2 * i + k] = saturate(s[2 * k] - cg);
+                    b[2 * i + k] = saturate(s[2 * k] + cb);
+                }
+            }
+            interleave3(r, g, b, dst + 6 * pair, 2 * block);
+        }
+    });
+}
+
+void yuyvToYUV420p(const uint8_t *src, uint8_t *y, uint8_t *u, uint8_t *v, uint32_t width, uint32_t height,
+                   unsigned int threads)
+{
+    width -= width % 2;
+    height -= height % 2;
+
+    const size_t pairs = width / 2;
+    const size_t rowSize = 2 * static_cast<size_t>(width);
+    threads = threadCount(threads, static_cast<size_t>(width) * height, height / 2);
+
+    convertRows(height / 2, threads, [&](uint32_t first, uint32_t last)
+    {
+        // Luma rows are contiguous
+        const size_t begin = 2 * first * static_cast<size_t>(width);
+        const size_t count = 2 * (last - first) * static_cast<size_t>(width);
+        for (size_t i = lumaBlock(src + 2 * begin, count, y + begin); i < count; i++)
+            y[begin + i] = src[2 * (begin + i)];
+
+        for (uint32_t line = first; line < last; line++)
+        {
+            const uint8_t *row0 = src + 2 * line * rowSize;
+            const uint8_t *row1 = row0 + rowSize;
+            uint8_t *outU = u + line * pairs;
+            uint8_t *outV = v + line * pairs;
+            for (size_t i = chromaBlock(row0, row1, pairs, outU, outV); i < pairs; i++)
+            {
+                outU[i] = (row0[4 * i + 1] + row1[4 * i + 1]) / 2;
+                outV[i] = (row0[4 * i + 3] + row1[4 * i + 3]) / 2;
+            }
+        }
+    });
+}
+
+void bayerToRGB24(const uint8_t *src, uint8_t *dst, uint32_t width, uint32_t height, BayerPattern pattern,
+                  unsigned int threads)
+{
+    demosaic(src, dst, width, height, pattern, threads);
+}
+
+void bayer16ToRGB48(const uint16_t *src, uint16_t *dst, uint32_t width, uint32_t height, BayerPattern pattern,
+                    unsigned int threads)
+{
+    demosaic(src, dst, width, height, pattern, threads);
+}
+
+bool rgb24ToYUV420p(const uint8_t *src, uint8_t *y, uint8_t *u, uint8_t *v, uint32_t width, uint32_t height,
+                    bool bgr, bool bottomUp, unsigned int threads)
+{
+    if (width % 2 || height % 2)
+        return false;
+
+    const YUVTables &tables = yuvTables();
+    const size_t pairs = width / 2;
+    threads = threadCount(threads, static_cast<size_t>(width) * height, height / 2);
+
+    convertRows(height / 2, threads, [&](uint32_t first, uint32_t last)
+    {
+        std::vector<uint8_t> buffer(7 * static_cast<size_t>(width));
+        uint8_t *c0 = buffer.data();
+        uint8_t *c1 = c0 + width;
+        uint8_t *c2 = c1 + width;
+        uint8_t *rowU[2] = {c2 + width, c2 + 2 * width};
+        uint8_t *rowV[2] = {c2 + 3 * width, c2 + 4 * width};
+        const uint8_t *red  = bgr ? c2 : c0;
+        const uint8_t *blue = bgr ? c0 : c2;
+
+        for (uint32_t line = first; line < last; line++)
+        {
+            for (uint32_t k = 0; k < 2; k++)
+            {
+                const uint32_t row = 2 * line + k;
+                const uint32_t sourceRow = bottomUp ? height - 1 - row : row;
+                uint8_t *outY = y + static_cast<size_t>(row) * width;
+
+                deinterleave3(src + 3 * static_cast<size_t>(sourceRow) * width, c0, c1, c2, width);
+                for (size_t i = yuvBlock(red, c1, blue, width, outY, rowU[k], rowV[k]); i < width; i++)
+                {
+                    const uint8_t r = red[i], g = c1[i], b = blue[i];
+                    outY[i]    = static_cast<uint8_t>(tables.yRed[r] + tables.yGreen[g] + tables.yBlue[b]);
+                    rowU[k][i] = static_cast<uint8_t>(-tables.uRed[r] - tables.uGreen[g] + b / 2 + 128);
+                    rowV[k][i] = static_cast<uint8_t>(r / 2 - tables.vGreen[g] - tables.vBlue[b] + 128);
+                }
+            }
+
+            uint8_t *outU = u + line * pairs;
+            uint8_t *outV = v + line * pairs;
+            for (size_t i = subsampleBlock(rowU[0], rowU[1], pairs, outU); i < pairs; i++)
+                outU[i] = (rowU[0][2 * i] + rowU[0][2 * i + 1] + rowU[1][2 * i] + rowU[1][2 * i + 1]) / 4;
+            for (size_t i = subsampleBlock(rowV[0], rowV[1], pairs, outV); i < pairs; i++)
+                outV[i] = (rowV[0][2 * i] + rowV[0][2 * i + 1] + rowV[1][2 * i] + rowV[1][2 * i + 1]) / 4;
+        }
+    });
+
+    return true;
+}
+
+}
@@ -0,0 +1,102 @@
+/*
+    Copyright (C) 2026 by the INDI Library contributors
+
+    Color Conversion
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+*/
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace INDI
+{
+
+/**
+ * @defgroup colorConvert Vectorized color space conversion functions
+ *
+ * Conversions of the V4L2 decoder, using SSE2/SSSE3/AVX2 or NEON when available, with rows split across
+ * parallel threads. Each function gives exactly the same output as the scalar ccvt routine it replaces.
+ *
+ * The threads parameter is the number of tasks run on the shared WorkerPool, 0 to pick one based on frame size
+ * and available cores.
+ */
+/*@{*/
+
+/** Byte order of packed 4:2:2 YUV pixel pairs */
+enum PackedYUVOrder
+{
+    PACKED_YUYV,
+    PACKED_UYVY,
+    PACKED_YVYU,
+    PACKED_VYUY
+};
+
+/** Color of the first two pixels of the first two rows of a Bayer frame */
+enum BayerPattern
+{
+    BAYER_BGGR,
+    BAYER_RGGB
+};
+
+/**
+ * @brief packedYUVToYUYV Reorder packed 4:2:2 pixel pairs to YUYV.
+ * @param src first row of the frame.
+ * @param stride distance between rows of src in bytes.
+ * @param dst YUYV frame, width / 2 pixel pairs per row without padding.
+ */
+void packedYUVToYUYV(const uint8_t *src, size_t stride, uint8_t *dst, uint32_t width, uint32_t height,
+                     PackedYUVOrder order, unsigned int threads = 0);
+
+/**
+ * @brief yuyvToRGB24 Convert YUYV to RGB24, as ccvt_yuyv_rgb24().
+ */
+void yuyvToRGB24(const uint8_t *src, uint8_t *dst, uint32_t width, uint32_t height, unsigned int threads = 0);
+
+/**
+ * @brief yuyvToYUV420p Convert YUYV to 4:2:0 planar, as ccvt_yuyv_420p(). Chroma of two rows is averaged.
+ * The last column and row are dropped if width or height is odd.
+ */
+void yuyvToYUV420p(const uint8_t *src, uint8_t *y, uint8_t *u, uint8_t *v, uint32_t width, uint32_t height,
+                   unsigned int threads = 0);
+
+/**
+ * @brief bayerToRGB24 Bilinear demosaic of an 8 bit Bayer frame, as bayer2rgb24() and bayer_rggb_2rgb24().
+ */
+void bayerToRGB24(const uint8_t *src, uint8_t *dst, uint32_t width, uint32_t height, BayerPattern pattern,
+                  unsigned int threads = 0);
+
+/**
+ * @brief bayer16ToRGB48 Bilinear demosaic of a 16 bit Bayer frame to three 16 bit samples per pixel,
+ * as bayer16_2_rgb24().
+ */
+void bayer16ToRGB48(const uint16_t *src, uint16_t *dst, uint32_t width, uint32_t height, BayerPattern pattern,
+                    unsigned int threads = 0);
+
+/**
+ * @brief rgb24ToYUV420p Convert packed 24 bit pixels to 4:2:0 planar, as RGB2YUV() and BGR2YUV().
+ * @param bgr True if the first byte of a pixel is blue, as read by RGB2YUV(), false if it is red, as read by BGR2YUV().
+ * @param bottomUp True if the rows of src are stored from the bottom, as in BMP images, false to keep the row
+ * order. It matches a flip argument of 0 and 1 respectively.
+ * @return True on success, false if width or height is odd.
+ */
+bool rgb24ToYUV420p(const uint8_t *src, uint8_t *y, uint8_t *u, uint8_t *v, uint32_t width, uint32_t height,
+                    bool bgr, bool bottomUp, unsigned int threads = 0);
+
+/*@}*/
+
+}
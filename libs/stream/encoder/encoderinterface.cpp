@@ -50,6 +50,20 @@ bool EncoderInterface::setSize(uint16_t width, uint16_t height)
     return true;
 }
 
+void EncoderInterface::setBitrate(uint32_t kbps)
+{
+    bitrate = kbps;
+}
+
+void EncoderInterface::setKeyframeInterval(uint32_t frames)
+{
+    keyframeInterval = frames;
+}
+
+void EncoderInterface::reset()
+{
+}
+
 bool EncoderInterface::setPixelFormat(INDI_PIXEL_FORMAT pixelFormat, uint8_t pixelDepth)
 {
     this->pixelFormat = pixelFormat;
@@ -54,6 +54,21 @@ class EncoderInterface
 
         virtual bool upload(IBLOB *bp, const uint8_t *buffer, uint32_t nbytes, bool isCompressed = false) = 0;
 
+        /**
+         * @brief Target bitrate of inter-frame encoders in kbit/s, 0 for a constant quality. Ignored by intra-frame encoders.
+         */
+        virtual void setBitrate(uint32_t kbps);
+
+        /**
+         * @brief Maximum number of frames between two key frames of inter-frame encoders.
+         */
+        virtual void setKeyframeInterval(uint32_t frames);
+
+        /**
+         * @brief Start a new stream, inter-frame encoders send their stream headers with the next frame.
+         */
+        virtual void reset();
+
         const char *getName();
 
     protected:
@@ -62,6 +77,8 @@ class EncoderInterface
         INDI_PIXEL_FORMAT pixelFormat;            // INDI Pixel Format
         uint8_t pixelDepth = 8;                   // Bits per Pixels
         uint16_t rawWidth, rawHeight;
+        uint32_t bitrate = 0;                     // kbit/s, 0 for constant quality
+        uint32_t keyframeInterval = 64;
 };
 
 }
@@ -19,10 +19,16 @@
 
 */
 
+#include <config.h>
+
 #include "encodermanager.h"
 #include "rawencoder.h"
 #include "mjpegencoder.h"
 
+#ifdef HAVE_THEORA
+#include "theoraencoder.h"
+#endif
+
 namespace INDI
 {
 
@@ -30,6 +36,9 @@ EncoderManager::EncoderManager()
 {
     encoder_list.push_back(new RawEncoder());
     encoder_list.push_back(new MJPEGEncoder());
+#ifdef HAVE_THEORA
+    encoder_list.push_back(new TheoraEncoder());
+#endif
     default_encoder = encoder_list.at(0);
 }
 
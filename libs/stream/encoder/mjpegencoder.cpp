@@ -20,82 +20,60 @@
 */
 
 #include "mjpegencoder.h"
+#include "indiworkerpool.h"
 #include "stream/streammanager.h"
 #include "indiccd.h"
+
+#include <algorithm>
 #include <cmath>
-#include <zlib.h>
 #include <jpeglib.h>
 #include <jerror.h>
 
-static void init_destination(j_compress_ptr cinfo)
+namespace
 {
-    INDI_UNUSED(cinfo);
-    /* No work necessary here */
-}
 
-static boolean empty_output_buffer(j_compress_ptr cinfo)
+// JPEG markers, libjpeg keeps its own list private
+enum
 {
-    INDI_UNUSED(cinfo);
-    /* No work necessary here */
-    return TRUE;
-}
-
-static void term_destination(j_compress_ptr cinfo)
+    MARKER_SOF0 = 0xC0,
+    MARKER_SOF1 = 0xC1,
+    MARKER_RST0 = 0xD0,
+    MARKER_SOI  = 0xD8,
+    MARKER_EOI  = 0xD9,
+    MARKER_SOS  = 0xDA,
+    MARKER_DRI  = 0xDD
+};
+
+// Destination manager growing a reused vector, the vector holds the compressed frame once done
+struct VectorDestination
 {
-    INDI_UNUSED(cinfo);
-    /* no work necessary here */
-}
+    struct jpeg_destination_mgr manager;
+    std::vector<uint8_t> *buffer;
+};
 
-namespace INDI
+void init_destination(j_compress_ptr cinfo)
 {
-
-MJPEGEncoder::MJPEGEncoder()
-{
-    name = "MJPEG";
+    VectorDestination *dest = reinterpret_cast<VectorDestination *>(cinfo->dest);
+    dest->buffer->resize(std::max<size_t>(dest->buffer->capacity(), 65536));
+    dest->manager.next_output_byte = dest->buffer->data();
+    dest->manager.free_in_buffer = dest->buffer->size();
 }
 
-MJPEGEncoder::~MJPEGEncoder()
+boolean empty_output_buffer(j_compress_ptr cinfo)
 {
-    delete [] jpegBuffer;
-}
-
-const char *MJPEGEncoder::getDeviceName()
-{
-    return currentDevice->getDeviceName();
+    // The whole buffer is full when libjpeg calls this
+    VectorDestination *dest = reinterpret_cast<VectorDestination *>(cinfo->dest);
+    size_t used = dest->buffer->size();
+    dest->buffer->resize(used * 2);
+    dest->manager.next_output_byte = dest->buffer->data() + used;
+    dest->manager.free_in_buffer = dest->buffer->size() - used;
+    return TRUE;
 }
 
-bool MJPEGEncoder::upload(IBLOB *bp, const uint8_t *buffer, uint32_t nbytes, bool isCompressed)
+void term_destination(j_compress_ptr cinfo)
 {
-    // We do not support compression
-    if (isCompressed)
-    {
-        LOG_ERROR("Compression is not supported in MJPEG stream.");
-        return false;
-    }
-
-    INDI_UNUSED(nbytes);
-    int bufsize = rawWidth * rawHeight * ((pixelFormat == INDI_RGB) ? 3 : 1);
-    if (bufsize != jpegBufferSize)
-    {
-        delete [] jpegBuffer;
-        jpegBuffer = new uint8_t[bufsize];
-        jpegBufferSize = bufsize;
-    }
-
-    // Scale image DOWN by this factor
-    // 640 is now selected arbitrary to test mpeg streaming performance
-    int scale = std::max(1, static_cast<int>(std::floor(rawWidth / SCALE_WIDTH)));
-    if (pixelFormat == INDI_RGB)
-        jpeg_compress_8u_rgb(buffer, rawWidth, rawHeight, rawWidth * 3, scale, jpegBuffer, &bufsize, 85);
-    else
-        jpeg_compress_8u_gray(buffer, rawWidth, rawHeight, rawWidth, scale, jpegBuffer, &bufsize, 85);
-
-    bp->blob    = jpegBuffer;
-    bp->bloblen = bufsize;
-    bp->size    = bufsize;
-    strcpy(bp->format, ".stream_jpg");
-
-    return true;
+    VectorDestination *dest = reinterpret_cast<VectorDestination *>(cinfo->dest);
+    dest->buffer->resize(dest->buffer->size() - dest->manager.free_in_buffer);
 }
 
 /*
@@ -118,38 +96,32 @@ Requirements:
   For faster performance, install libjpeg-turbo, an SSE-accelerated
   library that is ABI compatible with libjpeg62.
 */
-
-int MJPEGEncoder::jpeg_compress_8u_gray (const uint8_t * src, uint16_t width, uint16_t height, int stride, int scale,
-        uint8_t * dest,
-        int * destsize, int quality)
+void compressStripe(const uint8_t *src, uint16_t width, uint16_t height, int components, int quality,
+                    std::vector<uint8_t> &dest)
 {
     struct jpeg_compress_struct cinfo;
     struct jpeg_error_mgr jerr;
-    struct jpeg_destination_mgr jdest;
-    int out_size = *destsize;
+    VectorDestination jdest;
 
     cinfo.err = jpeg_std_error (&jerr);
     jpeg_create_compress (&cinfo);
-    jdest.next_output_byte = dest;
-    jdest.free_in_buffer = out_size;
-    jdest.init_destination = init_destination;
-    jdest.empty_output_buffer = empty_output_buffer;
-    jdest.term_destination = term_destination;
-    cinfo.dest = &jdest;
+    jdest.manager.init_destination = init_destination;
+    jdest.manager.empty_output_buffer = empty_output_buffer;
+    jdest.manager.term_destination = term_destination;
+    jdest.buffer = &dest;
+    cinfo.dest = &jdest.manager;
 
     cinfo.image_width = width;
     cinfo.image_height = height;
-#if JPEG_LIB_VERSION >= 70
-    cinfo.scale_denom = scale;
-#else
-    INDI_UNUSED(scale);
-#endif
-    cinfo.input_components = 1;
-    cinfo.in_color_space = JCS_GRAYSCALE;
+    cinfo.input_components = components;
+    cinfo.in_color_space = (components == 3) ? JCS_RGB : JCS_GRAYSCALE;
     jpeg_set_defaults (&cinfo);
     jpeg_set_quality (&cinfo, quality, TRUE);
+    // SIMD accelerated in libjpeg-turbo, the loss of precision is below the quantization of previews
+    cinfo.dct_method = JDCT_IFAST;
 
     jpeg_start_compress (&cinfo, TRUE);
+    const int stride = width * components;
     while (cinfo.next_scanline < height)
     {
         JSAMPROW row = (JSAMPROW)(src + cinfo.next_scanline * stride);
@@ -157,50 +129,187 @@ int MJPEGEncoder::jpeg_compress_8u_gray (const uint8_t * src, uint16_t width, ui
     }
 
     jpeg_finish_compress (&cinfo);
-    *destsize = out_size - jdest.free_in_buffer;
     jpeg_destroy_compress (&cinfo);
-    return 0;
 }
 
-int MJPEGEncoder::jpeg_compress_8u_rgb (const uint8_t * src, uint16_t width, uint16_t height, int stride, int scale,
-                                        uint8_t * dest, int * destsize, int quality)
+// Offsets of the frame header, the scan header and the entropy coded data of a baseline JPEG
+bool findScan(const std::vector<uint8_t> &jpeg, size_t &sof, size_t &sos, size_t &entropy)
 {
-    struct jpeg_compress_struct cinfo;
-    struct jpeg_error_mgr jerr;
-    struct jpeg_destination_mgr jdest;
-    int out_size = *destsize;
+    size_t size = jpeg.size();
+    if (size < 4 || jpeg[0] != 0xFF || jpeg[1] != MARKER_SOI || jpeg[size - 2] != 0xFF || jpeg[size - 1] != MARKER_EOI)
+        return false;
 
-    cinfo.err = jpeg_std_error (&jerr);
-    jpeg_create_compress (&cinfo);
-    jdest.next_output_byte = dest;
-    jdest.free_in_buffer = out_size;
-    jdest.init_destination = init_destination;
-    jdest.empty_output_buffer = empty_output_buffer;
-    jdest.term_destination = term_destination;
-    cinfo.dest = &jdest;
+    sof = 0;
+    for (size_t pos = 2; pos + 4 <= size;)
+    {
+        if (jpeg[pos] != 0xFF)
+            return false;
+        uint8_t marker = jpeg[pos + 1];
+        size_t length = (jpeg[pos + 2] << 8) | jpeg[pos + 3];
+        if (marker == MARKER_SOF0 || marker == MARKER_SOF1)
+            sof = pos;
+        if (marker == MARKER_SOS)
+        {
+            sos = pos;
+            entropy = pos + 2 + length;
+            return sof != 0 && entropy <= size - 2;
+        }
+        pos += 2 + length;
+    }
+    return false;
+}
 
-    cinfo.image_width = width;
-    cinfo.image_height = height;
-#if JPEG_LIB_VERSION >= 70
-    cinfo.scale_denom = scale;
-#else
-    INDI_UNUSED(scale);
-#endif
-    cinfo.input_components = 3;
-    cinfo.in_color_space = JCS_RGB;
-    jpeg_set_defaults (&cinfo);
-    jpeg_set_quality (&cinfo, quality, TRUE);
+}
 
-    jpeg_start_compress (&cinfo, TRUE);
-    while (cinfo.next_scanline < height)
+namespace INDI
+{
+
+MJPEGEncoder::MJPEGEncoder()
+{
+    name = "MJPEG";
+}
+
+MJPEGEncoder::~MJPEGEncoder()
+{
+}
+
+const char *MJPEGEncoder::getDeviceName()
+{
+    return currentDevice->getDeviceName();
+}
+
+bool MJPEGEncoder::upload(IBLOB *bp, const uint8_t *buffer, uint32_t nbytes, bool isCompressed)
+{
+    // We do not support compression
+    if (isCompressed)
     {
-        JSAMPROW row = (JSAMPROW)(src + cinfo.next_scanline * stride);
-        jpeg_write_scanlines (&cinfo, &row, 1);
+        LOG_ERROR("Compression is not supported in MJPEG stream.");
+        return false;
     }
-    jpeg_finish_compress (&cinfo);
-    *destsize = out_size - jdest.free_in_buffer;
-    jpeg_destroy_compress (&cinfo);
-    return 0;
+
+    int components = (pixelFormat == INDI_RGB) ? 3 : 1;
+    if (nbytes < static_cast<uint32_t>(rawWidth * rawHeight * components))
+    {
+        LOGF_ERROR("MJPEG encoder expects %d bytes per frame, received %u.", rawWidth * rawHeight * components, nbytes);
+        return false;
+    }
+
+    // Scale image DOWN by this factor, averaging the pixels of each block
+    // 640 is now selected arbitrary to test mpeg streaming performance
+    int scale = std::max(1, static_cast<int>(std::floor(rawWidth / SCALE_WIDTH)));
+    uint16_t width = rawWidth / scale, height = rawHeight / scale;
+    const uint8_t *source = buffer;
+    if (scale > 1)
+    {
+        scaledBuffer.resize(static_cast<size_t>(width) * height * components);
+        const int area = scale * scale;
+        for (uint32_t y = 0; y < height; y++)
+        {
+            uint8_t *out = scaledBuffer.data() + static_cast<size_t>(y) * width * components;
+            for (uint32_t x = 0; x < width; x++)
+                for (int c = 0; c < components; c++)
+                {
+                    uint32_t sum = 0;
+                    for (int dy = 0; dy < scale; dy++)
+                    {
+                        const uint8_t *in = buffer + ((static_cast<size_t>(y) * scale + dy) * rawWidth + x * scale) * components + c;
+                        for (int dx = 0; dx < scale; dx++)
+                            sum += in[dx * components];
+                    }
+                    *out++ = static_cast<uint8_t>(sum / area);
+                }
+        }
+        source = scaledBuffer.data();
+    }
+
+    if (compress(source, width, height, components, 85) == false)
+        return false;
+
+    bp->blob    = jpegBuffer.data();
+    bp->bloblen = jpegBuffer.size();
+    bp->size    = jpegBuffer.size();
+    strcpy(bp->format, ".stream_jpg");
+
+    return true;
+}
+
+bool MJPEGEncoder::compress(const uint8_t *source, uint16_t width, uint16_t height, int components, int quality,
+                            unsigned int threads)
+{
+    if (source == nullptr || width == 0 || height == 0 || (components != 1 && components != 3))
+        return false;
+
+    // libjpeg subsamples the chroma of RGB frames 2x2, their MCUs are 16x16
+    const uint32_t mcuSize = (components == 3) ? 16 : 8;
+    const uint32_t mcusPerRow = (width + mcuSize - 1) / mcuSize;
+    const uint32_t mcuRows = (height + mcuSize - 1) / mcuSize;
+
+    if (threads == 0)
+    {
+        size_t pixels = static_cast<size_t>(width) * height;
+        threads = WorkerPool::instance().concurrency();
+        threads = static_cast<unsigned int>(std::min<size_t>(threads, std::max<size_t>(1, pixels / MIN_PIXELS_PER_STRIPE)));
+    }
+
+    // Every stripe but the last one is a restart interval, limited to 65535 MCUs
+    uint32_t stripeRows = (mcuRows + threads - 1) / threads;
+    stripeRows = std::max(1u, std::min(stripeRows, 65535 / mcusPerRow));
+    const size_t stripes = (mcuRows + stripeRows - 1) / stripeRows;
+
+    if (stripes > 1)
+    {
+        if (stripeBuffers.size() < stripes)
+            stripeBuffers.resize(stripes);
+
+        threads = std::min<unsigned int>(threads, stripes);
+        WorkerPool::instance().run(threads, [&](unsigned int first)
+        {
+            for (size_t i = first; i < stripes; i += threads)
+            {
+                uint32_t top = i * stripeRows * mcuSize;
+                uint16_t rows = std::min<uint32_t>(height - top, stripeRows * mcuSize);
+                compressStripe(source + static_cast<size_t>(top) * width * components, width, rows, components, quality,
+                               stripeBuffers[i]);
+            }
+        });
+
+        if (joinStripes(stripes, height, stripeRows * mcusPerRow))
+            return true;
+    }
+
+    compressStripe(source, width, height, components, quality, jpegBuffer);
+    return true;
+}
+
+bool MJPEGEncoder::joinStripes(size_t count, uint16_t height, uint16_t restartInterval)
+{
+    size_t sof, sos, entropy;
+    const std::vector<uint8_t> &first = stripeBuffers[0];
+    if (!findScan(first, sof, sos, entropy))
+        return false;
+
+    // Headers of the first stripe with the height of the frame and a restart interval
+    jpegBuffer.assign(first.begin(), first.begin() + sos);
+    jpegBuffer[sof + 5] = height >> 8;
+    jpegBuffer[sof + 6] = height & 0xFF;
+    const uint8_t dri[] = { 0xFF, MARKER_DRI, 0x00, 0x04, static_cast<uint8_t>(restartInterval >> 8), static_cast<uint8_t>(restartInterval & 0xFF) };
+    jpegBuffer.insert(jpegBuffer.end(), dri, dri + sizeof(dri));
+    jpegBuffer.insert(jpegBuffer.end(), first.begin() + sos, first.end() - 2);
+
+    // Each stripe starts with reset DC predictors, exactly like after a restart marker
+    for (size_t i = 1; i < count; i++)
+    {
+        const std::vector<uint8_t> &stripe = stripeBuffers[i];
+        if (!findScan(stripe, sof, sos, entropy))
+            return false;
+        jpegBuffer.push_back(0xFF);
+        jpegBuffer.push_back(static_cast<uint8_t>(MARKER_RST0 + ((i - 1) & 7)));
+        jpegBuffer.insert(jpegBuffer.end(), stripe.begin() + entropy, stripe.end() - 2);
+    }
+
+    jpegBuffer.push_back(0xFF);
+    jpegBuffer.push_back(MARKER_EOI);
+    return true;
 }
 
 }
@@ -19,17 +19,21 @@
 
 */
 
+
 #pragma once
 
 #include "encoderinterface.h"
 
+#include <vector>
+
 namespace INDI
 {
 
 /**
  * @brief The MJPEGEncoder class encodes frames in JPEG format before transmitting them to the client.
  *
- * The quality is now hard-coded at 70 when encoding the JPEG image. Further compression is not supported.
+ * Frames wider than SCALE_WIDTH are downscaled first. Large frames are split into horizontal stripes compressed
+ * concurrently, then joined with restart markers into one baseline JPEG. The quality is hard-coded at 85.
  */
 class MJPEGEncoder : public EncoderInterface
 {
@@ -39,17 +43,34 @@ class MJPEGEncoder : public EncoderInterface
 
         virtual bool upload(IBLOB *bp, const uint8_t *buffer, uint32_t nbytes, bool isCompressed = false) override;
 
+        /**
+         * @brief Compress an 8 bit frame into jpegFrame().
+         * @param source gray or interleaved RGB pixels
+         * @param components 1 for gray, 3 for RGB
+         * @param threads number of stripes compressed concurrently, 0 to pick one by frame size
+         * @return true on success
+         */
+        bool compress(const uint8_t *source, uint16_t width, uint16_t height, int components, int quality,
+                      unsigned int threads = 0);
+
+        /** @return Last compressed frame. */
+        const std::vector<uint8_t> &jpegFrame() const
+        {
+            return jpegBuffer;
+        }
+
     private:
         const char *getDeviceName();
-        int jpeg_compress_8u_gray (const uint8_t * src, uint16_t width, uint16_t height, int stride, int scale, uint8_t * dest,
-                                   int * destsize, int quality);
-        int jpeg_compress_8u_rgb (const uint8_t * src, uint16_t width, uint16_t height, int stride, int scale, uint8_t * dest,
-                                  int * destsize, int quality);
-        uint8_t *jpegBuffer = nullptr;
-        uint16_t jpegBufferSize = 1;
+        bool joinStripes(size_t count, uint16_t height, uint16_t restartInterval);
 
-        static const int SCALE_WIDTH = 640;
+        // Reused across frames
+        std::vector<uint8_t> jpegBuffer;
+        std::vector<uint8_t> scaledBuffer;
+        std::vector<std::vector<uint8_t>> stripeBuffers;
 
+        static const int SCALE_WIDTH = 640;
+        // Smallest stripe worth a thread
+        static const size_t MIN_PIXELS_PER_STRIPE = 1 << 18;
 };
 
 }
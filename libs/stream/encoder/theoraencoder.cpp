@@ -0,0 +1,275 @@
+/*
+    Copyright (C) 2026 by the INDI Library contributors
+
+    Theora Encoder Interface
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+*/
+
+#include "theoraencoder.h"
+#include "stream/streammanager.h"
+#include "stream/theorautils.h"
+#include "indiccd.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace INDI
+{
+
+TheoraEncoder::TheoraEncoder()
+{
+    name = "THEORA";
+    memset(ycbcr, 0, sizeof(ycbcr));
+}
+
+TheoraEncoder::~TheoraEncoder()
+{
+    stop();
+}
+
+const char *TheoraEncoder::getDeviceName()
+{
+    return currentDevice->getDeviceName();
+}
+
+bool TheoraEncoder::setPixelFormat(INDI_PIXEL_FORMAT pixelFormat, uint8_t pixelDepth)
+{
+    // JPEG frames are sent as they are by the stream manager
+    if (pixelFormat == INDI_JPG)
+        return false;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    restart = true;
+    return EncoderInterface::setPixelFormat(pixelFormat, pixelDepth);
+}
+
+bool TheoraEncoder::setSize(uint16_t width, uint16_t height)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    restart = restart || width != rawWidth || height != rawHeight;
+    return EncoderInterface::setSize(width, height);
+}
+
+void TheoraEncoder::setBitrate(uint32_t kbps)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    restart = restart || kbps != bitrate;
+    EncoderInterface::setBitrate(kbps);
+}
+
+void TheoraEncoder::setKeyframeInterval(uint32_t frames)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    restart = restart || frames != keyframeInterval;
+    EncoderInterface::setKeyframeInterval(std::max<uint32_t>(1, frames));
+}
+
+void TheoraEncoder::reset()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    restart = true;
+}
+
+void TheoraEncoder::stop()
+{
+    if (context)
+    {
+        th_encode_free(context);
+        context = nullptr;
+    }
+    if (hasStream)
+    {
+        ogg_stream_clear(&oggStream);
+        hasStream = false;
+    }
+}
+
+bool TheoraEncoder::start()
+{
+    stop();
+
+    th_info info;
+    th_info_init(&info);
+    info.frame_width = (rawWidth + 15) & ~15;
+    info.frame_height = (rawHeight + 15) & ~15;
+    info.pic_width = rawWidth;
+    info.pic_height = rawHeight;
+    info.pic_x = 0;
+    info.pic_y = 0;
+    info.fps_numerator = NOMINAL_FPS;
+    info.fps_denominator = 1;
+    info.colorspace = TH_CS_UNSPECIFIED;
+    info.pixel_fmt = TH_PF_420;
+    info.target_bitrate = bitrate * 1000;
+    info.quality = bitrate > 0 ? 0 : DEFAULT_QUALITY;
+    info.keyframe_granule_shift = theoraGranuleShift(keyframeInterval);
+
+    context = th_encode_alloc(&info);
+    th_info_clear(&info);
+    if (context == nullptr)
+    {
+        LOGF_ERROR("Theora encoder does not support %dx%d frames.", rawWidth, rawHeight);
+        return false;
+    }
+
+    /* setting just the granule shift only allows power-of-two keyframe
+       spacing.  Set the actual requested spacing. */
+    ogg_uint32_t frequency = keyframeInterval;
+    th_encode_ctl(context, TH_ENCCTL_SET_KEYFRAME_FREQUENCY_FORCE, &frequency, sizeof(frequency));
+
+    // Fastest encoding, the stream is live
+    int speed = 0;
+    if (th_encode_ctl(context, TH_ENCCTL_GET_SPLEVEL_MAX, &speed, sizeof(speed)) == 0)
+        th_encode_ctl(context, TH_ENCCTL_SET_SPLEVEL, &speed, sizeof(speed));
+
+    for (int i = 0; i < 3; i++)
+    {
+        ycbcr[i].width  = i == 0 ? ((rawWidth + 15) & ~15) : ((rawWidth + 15) & ~15) >> 1;
+        ycbcr[i].height = i == 0 ? ((rawHeight + 15) & ~15) : ((rawHeight + 15) & ~15) >> 1;
+        ycbcr[i].stride = ycbcr[i].width;
+        // Neutral chroma for mono frames
+        planes[i].assign(ycbcr[i].stride * ycbcr[i].height, i == 0 ? 0 : 0x80);
+        ycbcr[i].data = planes[i].data();
+    }
+
+    if (ogg_stream_init(&oggStream, oggSerialNumber()))
+    {
+        LOG_ERROR("Could not create Ogg stream state.");
+        return false;
+    }
+    hasStream = true;
+
+    /* The first header packet gets its own page, the data starts on a new page after the others */
+    th_comment comment;
+    th_comment_init(&comment);
+    ogg_packet packet;
+    bool first = true;
+    int ret;
+    while ((ret = th_encode_flushheader(context, &comment, &packet)) > 0)
+    {
+        ogg_stream_packetin(&oggStream, &packet);
+        if (first)
+            flushPages();
+        first = false;
+    }
+    th_comment_clear(&comment);
+    if (ret < 0)
+    {
+        LOG_ERROR("Internal Theora library error.");
+        return false;
+    }
+    flushPages();
+
+    return true;
+}
+
+void TheoraEncoder::flushPages()
+{
+    ogg_page page;
+    while (ogg_stream_flush(&oggStream, &page))
+    {
+        oggBuffer.insert(oggBuffer.end(), page.header, page.header + page.header_len);
+        oggBuffer.insert(oggBuffer.end(), page.body, page.body + page.body_len);
+    }
+}
+
+void TheoraEncoder::fillPlanes(const uint8_t *buffer)
+{
+    uint8_t *y = ycbcr[0].data, *cb = ycbcr[1].data, *cr = ycbcr[2].data;
+
+    if (pixelFormat != INDI_RGB)
+    {
+        for (uint32_t row = 0; row < rawHeight; row++)
+            memcpy(y + row * ycbcr[0].stride, buffer + row * rawWidth, rawWidth);
+        return;
+    }
+
+    // BT.601 full range, chroma averaged over 2x2 blocks
+    for (uint32_t row = 0; row < rawHeight; row += 2)
+    {
+        for (uint32_t column = 0; column < rawWidth; column += 2)
+        {
+            int sumCb = 0, sumCr = 0, count = 0;
+            for (uint32_t dy = row; dy < std::min<uint32_t>(row + 2, rawHeight); dy++)
+            {
+                for (uint32_t dx = column; dx < std::min<uint32_t>(column + 2, rawWidth); dx++)
+                {
+                    const uint8_t *pixel = buffer + (dy * rawWidth + dx) * 3;
+                    int r = pixel[0], g = pixel[1], b = pixel[2];
+                    y[dy * ycbcr[0].stride + dx] = static_cast<uint8_t>((77 * r + 150 * g + 29 * b) >> 8);
+                    sumCb += -43 * r - 85 * g + 128 * b;
+                    sumCr += 128 * r - 107 * g - 21 * b;
+                    count++;
+                }
+            }
+            size_t offset = (row / 2) * ycbcr[1].stride + column / 2;
+            cb[offset] = static_cast<uint8_t>(std::min(255, std::max(0, sumCb / (count * 256) + 128)));
+            cr[offset] = static_cast<uint8_t>(std::min(255, std::max(0, sumCr / (count * 256) + 128)));
+        }
+    }
+}
+
+bool TheoraEncoder::upload(IBLOB *bp, const uint8_t *buffer, uint32_t nbytes, bool isCompressed)
+{
+    // Theora frames are compressed already
+    INDI_UNUSED(isCompressed);
+
+    std::lock_guard<std::mutex> lock(mutex);
+
+    uint32_t frameBytes = rawWidth * rawHeight * ((pixelFormat == INDI_RGB) ? 3 : 1);
+    if (nbytes < frameBytes)
+    {
+        LOGF_ERROR("Theora encoder expects %u bytes per frame, received %u.", frameBytes, nbytes);
+        return false;
+    }
+
+    oggBuffer.clear();
+    if (restart || context == nullptr || streamFrames >= keyframeInterval)
+    {
+        if (start() == false)
+        {
+            stop();
+            return false;
+        }
+        restart = false;
+        streamFrames = 0;
+    }
+
+    fillPlanes(buffer);
+    if (th_encode_ycbcr_in(context, ycbcr) != 0)
+    {
+        LOG_ERROR("Theora encoder could not encode frame.");
+        return false;
+    }
+
+    // The last frame of the interval ends the stream, the next BLOB starts a new one with its headers
+    int last = ++streamFrames >= keyframeInterval ? 1 : 0;
+    ogg_packet packet;
+    while (th_encode_packetout(context, last, &packet) > 0)
+        ogg_stream_packetin(&oggStream, &packet);
+    // One frame per BLOB, do not wait for the page to fill
+    flushPages();
+
+    bp->blob    = oggBuffer.data();
+    bp->bloblen = oggBuffer.size();
+    bp->size    = oggBuffer.size();
+    strcpy(bp->format, ".stream_ogv");
+
+    return true;
+}
+
+}
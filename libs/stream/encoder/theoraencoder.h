@@ -0,0 +1,84 @@
+/*
+    Copyright (C) 2026 by the INDI Library contributors
+
+    Theora Encoder Interface
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+*/
+
+#pragma once
+
+#include "encoderinterface.h"
+
+#include <ogg/ogg.h>
+#include <theora/theoraenc.h>
+
+#include <mutex>
+#include <vector>
+
+namespace INDI
+{
+
+/**
+ * @brief The TheoraEncoder class encodes frames with the libtheora inter-frame codec in an Ogg stream (.stream_ogv).
+ *
+ * Each BLOB holds the Ogg pages of one frame, so clients feed them to their decoder as they arrive. The first BLOB
+ * of a stream also holds the Theora headers. Every key frame interval the stream ends and a chained stream starts
+ * with a key frame and its own headers, so clients that enable BLOBs late, or miss some, decode from the next one.
+ * A change of size, pixel format, bitrate or key frame interval also starts a new stream. Mono and Bayer frames
+ * are encoded as luminance, RGB frames as YCbCr 4:2:0.
+ */
+class TheoraEncoder : public EncoderInterface
+{
+    public:
+        TheoraEncoder();
+        ~TheoraEncoder();
+
+        virtual bool setPixelFormat(INDI_PIXEL_FORMAT pixelFormat, uint8_t pixelDepth) override;
+        virtual bool setSize(uint16_t width, uint16_t height) override;
+        virtual void setBitrate(uint32_t kbps) override;
+        virtual void setKeyframeInterval(uint32_t frames) override;
+        virtual void reset() override;
+
+        virtual bool upload(IBLOB *bp, const uint8_t *buffer, uint32_t nbytes, bool isCompressed = false) override;
+
+    private:
+        const char *getDeviceName();
+        bool start();
+        void stop();
+        void fillPlanes(const uint8_t *buffer);
+        void flushPages();
+
+        // Quality of the encoder when no bitrate is set, from 0 to 63
+        static const int DEFAULT_QUALITY = 48;
+        // Frame rate written in the headers, clients decode live streams as they arrive
+        static const int NOMINAL_FPS = 30;
+
+        std::mutex mutex;
+        bool restart = true;
+        // Frames encoded since the stream started
+        uint32_t streamFrames = 0;
+
+        th_enc_ctx *context = nullptr;
+        th_ycbcr_buffer ycbcr;
+        std::vector<uint8_t> planes[3];
+
+        ogg_stream_state oggStream;
+        bool hasStream = false;
+        std::vector<uint8_t> oggBuffer;
+};
+
+}
@@ -0,0 +1,169 @@
+/*
+    Copyright (C) 2026 by the INDI Library contributors
+
+    Frame Pool
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+*/
+#include "framepool.h"
+
+#include <mutex>
+#include <new>
+#include <vector>
+
+namespace INDI
+{
+
+constexpr size_t FramePool::MIN_SLOTS;
+
+struct FramePool::State
+{
+    mutable std::mutex mutex;
+    std::vector<std::unique_ptr<Buffer>> free;
+    size_t limit {0};
+    size_t allocated {0};
+    size_t slots {0};
+    bool closed {false};
+
+    // mutex must be held
+    void drop(std::unique_ptr<Buffer> buffer)
+    {
+        allocated -= buffer->m_Capacity;
+        slots--;
+    }
+
+    void release(Buffer *buffer)
+    {
+        std::unique_ptr<Buffer> owned(buffer);
+        std::lock_guard<std::mutex> lock(mutex);
+        if (closed || (allocated > limit && slots > MIN_SLOTS))
+            drop(std::move(owned));
+        else
+            free.push_back(std::move(owned));
+    }
+};
+
+FramePool::FramePool(size_t limit)
+    : m_State(std::make_shared<State>())
+{
+    m_State->limit = limit;
+}
+
+FramePool::~FramePool()
+{
+    // Frames still in use are freed when released
+    std::lock_guard<std::mutex> lock(m_State->mutex);
+    m_State->closed = true;
+    m_State->free.clear();
+}
+
+void FramePool::setLimit(size_t limit)
+{
+    std::lock_guard<std::mutex> lock(m_State->mutex);
+    m_State->limit = limit;
+    while (m_State->allocated > limit && m_State->slots > MIN_SLOTS && !m_State->free.empty())
+    {
+        m_State->drop(std::move(m_State->free.back()));
+        m_State->free.pop_back();
+    }
+}
+
+size_t FramePool::limit() const
+{
+    std::lock_guard<std::mutex> lock(m_State->mutex);
+    return m_State->limit;
+}
+
+FramePool::Frame FramePool::acquire(size_t size)
+{
+    std::unique_lock<std::mutex> lock(m_State->mutex);
+    auto &free = m_State->free;
+
+    // Most recently released buffer large enough, it is the most likely to still be in cache
+    std::unique_ptr<Buffer> buffer;
+    for (auto it = free.rbegin(); it != free.rend(); ++it)
+    {
+        if ((*it)->m_Capacity >= size)
+        {
+            buffer = std::move(*it);
+            free.erase(std::next(it).base());
+            break;
+        }
+    }
+
+    if (!buffer)
+    {
+        // Free buffers too small for this frame make room for a larger one
+        while (!free.empty() && m_State->allocated + size > m_State->limit)
+        {
+            m_State->drop(std::move(free.back()));
+            free.pop_back();
+        }
+
+        if (m_State->allocated + size > m_State->limit && m_State->slots >= MIN_SLOTS)
+            return Frame();
+
+        buffer.reset(new Buffer());
+        buffer->m_Data.reset(new (std::nothrow) uint8_t[size]);
+        if (!buffer->m_Data)
+            return Frame();
+        buffer->m_Capacity = size;
+        m_State->allocated += size;
+        m_State->slots++;
+    }
+    lock.unlock();
+
+    buffer->m_Size = size;
+    std::shared_ptr<State> state = m_State;
+    return Frame(buffer.release(), [state](Buffer * released)
+    {
+        state->release(released);
+    });
+}
+
+FramePool::Frame FramePool::wrap(uint8_t *data, size_t size, std::function<void()> release)
+{
+    Buffer *buffer = new Buffer();
+    buffer->m_External = data;
+    buffer->m_Size = size;
+    buffer->m_Capacity = size;
+    return Frame(buffer, [release](Buffer * released)
+    {
+        delete released;
+        if (release)
+            release();
+    });
+}
+
+size_t FramePool::allocated() const
+{
+    std::lock_guard<std::mutex> lock(m_State->mutex);
+    return m_State->allocated;
+}
+
+size_t FramePool::slots() const
+{
+    std::lock_guard<std::mutex> lock(m_State->mutex);
+    return m_State->slots;
+}
+
+size_t FramePool::used() const
+{
+    std::lock_guard<std::mutex> lock(m_State->mutex);
+    return m_State->slots - m_State->free.size();
+}
+
+}
@@ -0,0 +1,120 @@
+/*
+    Copyright (C) 2026 by the INDI Library contributors
+
+    Frame Pool
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+*/
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+
+namespace INDI
+{
+
+/**
+ * @brief The FramePool class recycles frame buffers of the stream pipeline.
+ *
+ * Buffers are allocated on first use and returned to the pool once the last handle to them is released,
+ * so a running stream does not allocate memory per frame. The total size of the buffers is bounded by
+ * a limit, except for the first MIN_SLOTS buffers so a small limit cannot stall the stream.
+ *
+ * Handles are reference counted: the same frame may be shared by the recorder and the preview.
+ * The pool may be destroyed while handles are still in use, their buffers are then freed on release.
+ *
+ * Memory owned by a device, such as memory mapped capture buffers, can be passed down the pipeline as a frame
+ * with wrap(): it is handed back to its owner when the last handle is released instead of being copied.
+ */
+class FramePool
+{
+    public:
+        class Buffer
+        {
+            public:
+                uint8_t *data()
+                {
+                    return m_External ? m_External : m_Data.get();
+                }
+                const uint8_t *data() const
+                {
+                    return m_External ? m_External : m_Data.get();
+                }
+                /** @brief Size of the frame in bytes. */
+                size_t size() const
+                {
+                    return m_Size;
+                }
+                /** @brief Allocated size in bytes, at least size(). */
+                size_t capacity() const
+                {
+                    return m_Capacity;
+                }
+
+            private:
+                friend class FramePool;
+                std::unique_ptr<uint8_t[]> m_Data;
+                uint8_t *m_External {nullptr};
+                size_t m_Size {0};
+                size_t m_Capacity {0};
+        };
+
+        /** @brief A frame of the pool, returned to it when the last copy is destroyed. */
+        typedef std::shared_ptr<Buffer> Frame;
+
+        /** Buffers allocated regardless of the limit */
+        static constexpr size_t MIN_SLOTS = 4;
+
+    public:
+        explicit FramePool(size_t limit = 0);
+        ~FramePool();
+
+    public:
+        /**
+         * @brief Maximum total size of the buffers in bytes. Free buffers above it are released.
+         */
+        void setLimit(size_t limit);
+        size_t limit() const;
+
+        /**
+         * @brief Get a frame of size bytes. Its content is undefined.
+         * @return Frame, or an empty handle if all buffers are in use and the limit is reached.
+         */
+        Frame acquire(size_t size);
+
+        /**
+         * @brief Wrap size bytes of memory owned by the caller as a frame, without copying it.
+         * @param release called once the last handle to the frame is released, from the thread releasing it.
+         * The memory must stay valid until then. Wrapped frames do not count in the size of any pool.
+         */
+        static Frame wrap(uint8_t *data, size_t size, std::function<void()> release);
+
+    public:
+        /** @brief Total size of the buffers in bytes, in use or free. */
+        size_t allocated() const;
+        /** @brief Number of buffers, in use or free. */
+        size_t slots() const;
+        /** @brief Number of buffers in use. */
+        size_t used() const;
+
+    private:
+        struct State;
+        std::shared_ptr<State> m_State;
+};
+
+}
@@ -0,0 +1,102 @@
+/*
+    Copyright (C) 2026 by the INDI Library contributors
+
+    Frame Timing
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+*/
+#include "frametiming.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace INDI
+{
+
+constexpr size_t FrameTiming::BINS;
+
+namespace
+{
+
+const double JITTER_LIMITS[FrameTiming::BINS - 1] = {0.1, 0.2, 0.5, 1, 2, 5, 10};
+const double LATENCY_LIMITS[FrameTiming::BINS - 1] = {1, 2, 5, 10, 20, 50, 100};
+// Weight of a new interval in the average interval
+constexpr double INTERVAL_WEIGHT = 1.0 / 16;
+
+size_t findBin(const double *limits, double value)
+{
+    size_t bin = 0;
+    while (bin < FrameTiming::BINS - 1 && value >= limits[bin])
+        bin++;
+    return bin;
+}
+
+}
+
+void FrameTiming::reset()
+{
+    *this = FrameTiming();
+}
+
+void FrameTiming::addTimestamp(std::chrono::system_clock::time_point timestamp)
+{
+    if (m_HasTimestamp)
+    {
+        double interval = std::chrono::duration<double, std::milli>(timestamp - m_Timestamp).count();
+        if (m_Intervals == 0)
+            m_Interval = interval;
+
+        double jitter = std::fabs(interval - m_Interval);
+        m_JitterSquares += jitter * jitter;
+        m_JitterHistogram[findBin(JITTER_LIMITS, jitter)]++;
+        m_Intervals++;
+
+        m_Interval += INTERVAL_WEIGHT * (interval - m_Interval);
+    }
+    m_Timestamp = timestamp;
+    m_HasTimestamp = true;
+}
+
+void FrameTiming::addLatency(double latency)
+{
+    m_LatencySum += latency;
+    m_MaxLatency = m_Latencies == 0 ? latency : std::max(m_MaxLatency, latency);
+    m_LatencyHistogram[findBin(LATENCY_LIMITS, latency)]++;
+    m_Latencies++;
+}
+
+double FrameTiming::jitterLimit(size_t bin)
+{
+    return bin < BINS - 1 ? JITTER_LIMITS[bin] : std::numeric_limits<double>::infinity();
+}
+
+double FrameTiming::latencyLimit(size_t bin)
+{
+    return bin < BINS - 1 ? LATENCY_LIMITS[bin] : std::numeric_limits<double>::infinity();
+}
+
+double FrameTiming::jitter() const
+{
+    return m_Intervals > 0 ? std::sqrt(m_JitterSquares / m_Intervals) : 0;
+}
+
+double FrameTiming::latency() const
+{
+    return m_Latencies > 0 ? m_LatencySum / m_Latencies : 0;
+}
+
+}
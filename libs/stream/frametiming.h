@@ -0,0 +1,109 @@
+/*
+    Copyright (C) 2026 by the INDI Library contributors
+
+    Frame Timing
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+*/
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+namespace INDI
+{
+
+/**
+ * @brief The FrameTiming class measures the regularity of the capture timestamps of a stream, and the latency from
+ * capture to recording.
+ *
+ * The jitter of a frame is the difference between the interval since the previous frame and the average interval,
+ * which follows changes of frame rate. Jitter and latency are counted in histograms of BINS bins, the last bin
+ * counting everything above the limit of the previous one.
+ */
+class FrameTiming
+{
+    public:
+        static constexpr size_t BINS = 8;
+        typedef std::array<uint64_t, BINS> Histogram;
+
+    public:
+        /**
+         * @brief Forget all frames.
+         */
+        void reset();
+
+        /**
+         * @brief Count a frame captured at timestamp.
+         */
+        void addTimestamp(std::chrono::system_clock::time_point timestamp);
+
+        /**
+         * @brief Count the latency in milliseconds of a recorded frame.
+         */
+        void addLatency(double latency);
+
+    public:
+        /** @return Upper limit in milliseconds of a jitter bin, infinity for the last bin. */
+        static double jitterLimit(size_t bin);
+        /** @return Upper limit in milliseconds of a latency bin, infinity for the last bin. */
+        static double latencyLimit(size_t bin);
+
+        /** @return Average interval between frames in milliseconds. */
+        double interval() const
+        {
+            return m_Interval;
+        }
+
+        /** @return Root mean square of the jitter in milliseconds. */
+        double jitter() const;
+
+        /** @return Average latency in milliseconds. */
+        double latency() const;
+
+        /** @return Largest latency in milliseconds. */
+        double maxLatency() const
+        {
+            return m_MaxLatency;
+        }
+
+        const Histogram &jitterHistogram() const
+        {
+            return m_JitterHistogram;
+        }
+
+        const Histogram &latencyHistogram() const
+        {
+            return m_LatencyHistogram;
+        }
+
+    private:
+        bool m_HasTimestamp {false};
+        std::chrono::system_clock::time_point m_Timestamp;
+        double m_Interval {0};
+        uint64_t m_Intervals {0};
+        double m_JitterSquares {0};
+        Histogram m_JitterHistogram {};
+
+        uint64_t m_Latencies {0};
+        double m_LatencySum {0};
+        double m_MaxLatency {0};
+        Histogram m_LatencyHistogram {};
+};
+
+}
@@ -0,0 +1,496 @@
+/*
+    Copyright (C) 2026 by the INDI Library contributors
+
+    Lossless Recorder
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+*/
+
+#include "losslessrecorder.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+#define ERRMSGSIZ 1024
+
+namespace INDI
+{
+
+namespace
+{
+
+// Index entries reserved at open, 16 MB
+constexpr uint64_t MAX_RESERVED_ENTRIES = 1 << 20;
+// Expected compression ratio of the frames, only used to preallocate the file
+constexpr uint64_t EXPECTED_RATIO = 2;
+
+void putLE32(std::vector<uint8_t> &out, uint32_t value)
+{
+    for (int i = 0; i < 4; i++)
+        out.push_back(static_cast<uint8_t>(value >> (8 * i)));
+}
+
+void putLE64(std::vector<uint8_t> &out, uint64_t value)
+{
+    for (int i = 0; i < 8; i++)
+        out.push_back(static_cast<uint8_t>(value >> (8 * i)));
+}
+
+uint32_t getLE32(const uint8_t *in)
+{
+    uint32_t value = 0;
+    for (int i = 3; i >= 0; i--)
+        value = (value << 8) | in[i];
+    return value;
+}
+
+uint64_t getLE64(const uint8_t *in)
+{
+    return getLE32(in) | static_cast<uint64_t>(getLE32(in + 4)) << 32;
+}
+
+uint64_t toMicroseconds(std::chrono::system_clock::time_point timestamp)
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(timestamp.time_since_epoch()).count();
+}
+
+// Distance in samples to the previous sample of the same color
+size_t sameColorDistance(const ILV::Header &header)
+{
+    if (header.pixelFormat >= INDI_BAYER_RGGB && header.pixelFormat <= INDI_BAYER_MYYC)
+        return 2;
+    return header.planes;
+}
+
+// Delta of a row of 16 bit samples split in byte planes, returns the number of samples done with SIMD
+size_t deltaRow16(const uint16_t *row, size_t count, size_t distance, uint8_t *low, uint8_t *high)
+{
+    size_t x = distance;
+#if defined(__SSE2__)
+    const __m128i mask = _mm_set1_epi16(0x00FF);
+    for (; x + 16 <= count; x += 16)
+    {
+        __m128i first  = _mm_sub_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i *>(row + x)),
+                                       _mm_loadu_si128(reinterpret_cast<const __m128i *>(row + x - distance)));
+        __m128i second = _mm_sub_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i *>(row + x + 8)),
+                                       _mm_loadu_si128(reinterpret_cast<const __m128i *>(row + x + 8 - distance)));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(low + x),
+                         _mm_packus_epi16(_mm_and_si128(first, mask), _mm_and_si128(second, mask)));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(high + x),
+                         _mm_packus_epi16(_mm_srli_epi16(first, 8), _mm_srli_epi16(second, 8)));
+    }
+#elif defined(__ARM_NEON)
+    for (; x + 8 <= count; x += 8)
+    {
+        uint16x8_t delta = vsubq_u16(vld1q_u16(row + x), vld1q_u16(row + x - distance));
+        vst1_u8(low + x, vmovn_u16(delta));
+        vst1_u8(high + x, vshrn_n_u16(delta, 8));
+    }
+#endif
+    return x;
+}
+
+}
+
+size_t ILV::Header::frameSize() const
+{
+    return static_cast<size_t>(width) * height * planes * (pixelDepth > 8 ? 2 : 1);
+}
+
+void ILV::encodeFrame(const Header &header, const uint8_t *frame, std::vector<uint8_t> &output)
+{
+    const size_t size = header.frameSize();
+    output.resize(size);
+    if (header.filter == FILTER_NONE)
+    {
+        std::memcpy(output.data(), frame, size);
+        return;
+    }
+
+    const size_t rowSamples = static_cast<size_t>(header.width) * header.planes;
+    const size_t distance = std::min(sameColorDistance(header), rowSamples);
+    if (header.pixelDepth <= 8)
+    {
+        for (uint32_t y = 0; y < header.height; y++)
+        {
+            const uint8_t *row = frame + y * rowSamples;
+            uint8_t *out = output.data() + y * rowSamples;
+            std::memcpy(out, row, distance);
+            for (size_t x = distance; x < rowSamples; x++)
+                out[x] = static_cast<uint8_t>(row[x] - row[x - distance]);
+        }
+        return;
+    }
+
+    const size_t samples = size / 2;
+    const uint16_t *pixels = reinterpret_cast<const uint16_t *>(frame);
+    uint8_t *low = output.data();
+    uint8_t *high = output.data() + samples;
+    for (uint32_t y = 0; y < header.height; y++)
+    {
+        const uint16_t *row = pixels + y * rowSamples;
+        uint8_t *rowLow = low + y * rowSamples;
+        uint8_t *rowHigh = high + y * rowSamples;
+        for (size_t x = 0; x < distance; x++)
+        {
+            rowLow[x] = static_cast<uint8_t>(row[x]);
+            rowHigh[x] = static_cast<uint8_t>(row[x] >> 8);
+        }
+        for (size_t x = deltaRow16(row, rowSamples, distance, rowLow, rowHigh); x < rowSamples; x++)
+        {
+            uint16_t delta = static_cast<uint16_t>(row[x] - row[x - distance]);
+            rowLow[x] = static_cast<uint8_t>(delta);
+            rowHigh[x] = static_cast<uint8_t>(delta >> 8);
+        }
+    }
+}
+
+void ILV::decodeFrame(const Header &header, const uint8_t *filtered, uint8_t *output)
+{
+    const size_t size = header.frameSize();
+    if (header.filter == FILTER_NONE)
+    {
+        std::memcpy(output, filtered, size);
+        return;
+    }
+
+    const size_t rowSamples = static_cast<size_t>(header.width) * header.planes;
+    const size_t distance = std::min(sameColorDistance(header), rowSamples);
+    if (header.pixelDepth <= 8)
+    {
+        for (uint32_t y = 0; y < header.height; y++)
+        {
+            const uint8_t *in = filtered + y * rowSamples;
+            uint8_t *row = output + y * rowSamples;
+            std::memcpy(row, in, distance);
+            for (size_t x = distance; x < rowSamples; x++)
+                row[x] = static_cast<uint8_t>(in[x] + row[x - distance]);
+        }
+        return;
+    }
+
+    const size_t samples = size / 2;
+    uint16_t *pixels = reinterpret_cast<uint16_t *>(output);
+    for (uint32_t y = 0; y < header.height; y++)
+    {
+        const uint8_t *low = filtered + y * rowSamples;
+        const uint8_t *high = filtered + samples + y * rowSamples;
+        uint16_t *row = pixels + y * rowSamples;
+        for (size_t x = 0; x < rowSamples; x++)
+        {
+            uint16_t value = static_cast<uint16_t>(low[x] | high[x] << 8);
+            row[x] = x < distance ? value : static_cast<uint16_t>(value + row[x - distance]);
+        }
+    }
+}
+
+LosslessRecorder::LosslessRecorder()
+{
+    name = "ILV";
+}
+
+bool LosslessRecorder::setPixelFormat(INDI_PIXEL_FORMAT pixelFormat, uint8_t pixelDepth)
+{
+    if (m_IsRecording)
+        return false;
+
+    switch (pixelFormat)
+    {
+        case INDI_RGB:
+        case INDI_BGR:
+            m_Header.planes = 3;
+            break;
+        // Compressed frames cannot be recorded losslessly
+        case INDI_JPG:
+            return false;
+        default:
+            m_Header.planes = 1;
+            break;
+    }
+
+    m_Header.pixelFormat = pixelFormat;
+    m_Header.pixelDepth = pixelDepth;
+    return true;
+}
+
+bool LosslessRecorder::setSize(uint16_t width, uint16_t height)
+{
+    if (m_IsRecording)
+        return false;
+
+    m_Header.width = width;
+    m_Header.height = height;
+    return true;
+}
+
+bool LosslessRecorder::open(const char *filename, char *errmsg)
+{
+    if (m_IsRecording)
+        return false;
+
+    // Fastest codec available, the recording must keep up with the stream
+    if (isCompressionSupported(COMPRESSION_LZ4))
+        m_Header.codec = COMPRESSION_LZ4;
+    else if (isCompressionSupported(COMPRESSION_ZSTD))
+        m_Header.codec = COMPRESSION_ZSTD;
+    else
+        m_Header.codec = COMPRESSION_ZLIB;
+
+    m_Header.filter = ILV::FILTER_DELTA;
+    m_Header.frameCount = 0;
+    m_Header.indexOffset = 0;
+    m_Header.startTime = toMicroseconds(std::chrono::system_clock::now());
+    m_RawBytes = 0;
+
+    uint64_t expectedSize = 0;
+    if (m_ExpectedFrames > 0)
+        expectedSize = ILV::HEADER_SIZE + m_ExpectedFrames * (ILV::RECORD_SIZE + ILV::INDEX_ENTRY_SIZE +
+                       m_Header.frameSize() / EXPECTED_RATIO);
+
+    int error = m_Writer.open(filename, expectedSize);
+    if (error != 0)
+    {
+        snprintf(errmsg, ERRMSGSIZ, "recorder open error %d, %s\n", error, strerror(error));
+        return false;
+    }
+
+    m_Serialized.clear();
+    serializeHeader(m_Serialized);
+    m_Writer.write(m_Serialized.data(), m_Serialized.size());
+
+    // Growing the index would copy it on the streaming thread
+    m_Index.clear();
+    m_Index.reserve(2 * std::min<uint64_t>(m_ExpectedFrames, MAX_RESERVED_ENTRIES));
+
+    m_IsRecording = true;
+    return true;
+}
+
+bool LosslessRecorder::close()
+{
+    bool success = true;
+    if (m_Writer.isOpen())
+    {
+        m_Header.indexOffset = m_Writer.size();
+        m_Serialized.clear();
+        m_Serialized.reserve(m_Index.size() * sizeof(uint64_t));
+        for (uint64_t value : m_Index)
+            putLE64(m_Serialized, value);
+        m_Writer.write(m_Serialized.data(), m_Serialized.size());
+        m_Index.clear();
+
+        // The header with the frame count and the index offset overwrites the one written at open
+        m_Serialized.clear();
+        serializeHeader(m_Serialized);
+        success = m_Writer.close(m_Serialized.data(), m_Serialized.size()) == 0;
+    }
+
+    m_IsRecording = false;
+    return success;
+}
+
+bool LosslessRecorder::writeFrame(const uint8_t *frame, uint32_t nbytes)
+{
+    return writeFrame(frame, nbytes, std::chrono::system_clock::now());
+}
+
+bool LosslessRecorder::writeFrame(const uint8_t *frame, uint32_t nbytes,
+                                  std::chrono::system_clock::time_point timestamp)
+{
+    if (!m_IsRecording)
+        return false;
+
+    const size_t frameSize = m_Header.frameSize();
+    if (nbytes < frameSize)
+        return false;
+
+    ILV::encodeFrame(m_Header, frame, m_Filtered);
+    if (compressBuffer(m_Filtered.data(), frameSize, static_cast<CompressionCodec>(m_Header.codec), m_Level,
+                       m_Compressed) == false)
+        return false;
+
+    uint64_t offset = m_Writer.size();
+    m_Serialized.clear();
+    putLE64(m_Serialized, toMicroseconds(timestamp));
+    putLE32(m_Serialized, static_cast<uint32_t>(m_Compressed.size()));
+    putLE32(m_Serialized, static_cast<uint32_t>(frameSize));
+    if (m_Writer.write(m_Serialized.data(), m_Serialized.size()) == false ||
+            m_Writer.write(m_Compressed.data(), m_Compressed.size()) == false)
+        return false;
+
+    m_Index.push_back(offset);
+    m_Index.push_back(toMicroseconds(timestamp));
+    m_Header.frameCount++;
+    m_RawBytes += frameSize;
+    return true;
+}
+
+bool LosslessRecorder::getWriteStatistics(double &rate, uint32_t &stalls) const
+{
+    rate = m_Writer.writeRate();
+    stalls = m_Writer.stalls();
+    return true;
+}
+
+double LosslessRecorder::compressionRatio() const
+{
+    uint64_t written = m_Writer.size();
+    if (m_RawBytes == 0 || written == 0)
+        return 1;
+    return static_cast<double>(m_RawBytes) / written;
+}
+
+void LosslessRecorder::serializeHeader(std::vector<uint8_t> &out) const
+{
+    out.insert(out.end(), ILV::MAGIC, ILV::MAGIC + sizeof(ILV::MAGIC));
+    putLE32(out, m_Header.version);
+    putLE32(out, m_Header.width);
+    putLE32(out, m_Header.height);
+    putLE32(out, m_Header.pixelFormat);
+    putLE32(out, m_Header.pixelDepth);
+    putLE32(out, m_Header.planes);
+    putLE32(out, m_Header.codec);
+    putLE32(out, m_Header.filter);
+    putLE64(out, m_Header.frameCount);
+    putLE64(out, m_Header.indexOffset);
+    putLE64(out, m_Header.startTime);
+}
+
+LosslessReader::~LosslessReader()
+{
+    close();
+}
+
+bool LosslessReader::open(const std::string &path)
+{
+    close();
+
+    m_File = fopen(path.c_str(), "rb");
+    if (m_File == nullptr)
+        return false;
+
+    uint8_t header[ILV::HEADER_SIZE];
+    if (fread(header, 1, sizeof(header), m_File) != sizeof(header) ||
+            std::memcmp(header, ILV::MAGIC, sizeof(ILV::MAGIC)) != 0)
+    {
+        close();
+        return false;
+    }
+
+    m_Header.version     = getLE32(header + 8);
+    m_Header.width       = getLE32(header + 12);
+    m_Header.height      = getLE32(header + 16);
+    m_Header.pixelFormat = getLE32(header + 20);
+    m_Header.pixelDepth  = getLE32(header + 24);
+    m_Header.planes      = getLE32(header + 28);
+    m_Header.codec       = getLE32(header + 32);
+    m_Header.filter      = getLE32(header + 36);
+    m_Header.frameCount  = getLE64(header + 40);
+    m_Header.indexOffset = getLE64(header + 48);
+    m_Header.startTime   = getLE64(header + 56);
+
+    if (m_Header.version > ILV::VERSION || (m_Header.indexOffset != 0 ? readIndex() : scanRecords()) == false)
+    {
+        close();
+        return false;
+    }
+    return true;
+}
+
+void LosslessReader::close()
+{
+    if (m_File)
+        fclose(m_File);
+    m_File = nullptr;
+    m_Offsets.clear();
+    m_Timestamps.clear();
+}
+
+bool LosslessReader::readIndex()
+{
+    std::vector<uint8_t> index(m_Header.frameCount * ILV::INDEX_ENTRY_SIZE);
+    if (fseeko(m_File, m_Header.indexOffset, SEEK_SET) != 0 ||
+            fread(index.data(), 1, index.size(), m_File) != index.size())
+        return false;
+
+    for (uint64_t i = 0; i < m_Header.frameCount; i++)
+    {
+        m_Offsets.push_back(getLE64(index.data() + i * ILV::INDEX_ENTRY_SIZE));
+        m_Timestamps.push_back(getLE64(index.data() + i * ILV::INDEX_ENTRY_SIZE + 8));
+    }
+    return true;
+}
+
+bool LosslessReader::scanRecords()
+{
+    if (fseeko(m_File, 0, SEEK_END) != 0)
+        return false;
+    const uint64_t fileSize = ftello(m_File);
+
+    // Only complete records, the last one may have been cut by the interruption
+    uint64_t offset = ILV::HEADER_SIZE;
+    uint8_t record[ILV::RECORD_SIZE];
+    while (offset + ILV::RECORD_SIZE <= fileSize)
+    {
+        if (fseeko(m_File, offset, SEEK_SET) != 0 || fread(record, 1, sizeof(record), m_File) != sizeof(record))
+            break;
+        uint64_t next = offset + ILV::RECORD_SIZE + getLE32(record + 8);
+        if (getLE32(record + 12) != m_Header.frameSize() || next > fileSize)
+            break;
+        m_Offsets.push_back(offset);
+        m_Timestamps.push_back(getLE64(record));
+        offset = next;
+    }
+    m_Header.frameCount = m_Offsets.size();
+    return true;
+}
+
+bool LosslessReader::readFrame(uint64_t frame, std::vector<uint8_t> &output)
+{
+    if (m_File == nullptr || frame >= m_Offsets.size())
+        return false;
+
+    uint8_t record[ILV::RECORD_SIZE];
+    if (fseeko(m_File, m_Offsets[frame], SEEK_SET) != 0 || fread(record, 1, sizeof(record), m_File) != sizeof(record))
+        return false;
+
+    const size_t frameSize = m_Header.frameSize();
+    if (getLE32(record + 12) != frameSize)
+        return false;
+
+    m_Compressed.resize(getLE32(record + 8));
+    if (fread(m_Compressed.data(), 1, m_Compressed.size(), m_File) != m_Compressed.size())
+        return false;
+
+    m_Filtered.resize(frameSize);
+    if (decompressBuffer(m_Compressed.data(), m_Compressed.size(), static_cast<CompressionCodec>(m_Header.codec),
+                         m_Filtered.data(), frameSize) == false)
+        return false;
+
+    output.resize(frameSize);
+    ILV::decodeFrame(m_Header, m_Filtered.data(), output.data());
+    return true;
+}
+
+}
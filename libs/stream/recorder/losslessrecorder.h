@@ -0,0 +1,196 @@
+/*
+    Copyright (C) 2026 by the INDI Library contributors
+
+    Lossless Recorder
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+*/
+
+#pragma once
+
+#include "recorderinterface.h"
+#include "indicompression.h"
+#include "indifilewriter.h"
+#include "indimacros.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace INDI
+{
+
+/**
+ * @brief Layout of the ILV (INDI Lossless Video) files written by LosslessRecorder.
+ *
+ * All fields are little endian. The file starts with a header of HEADER_SIZE bytes, followed by one record
+ * per frame: its timestamp, compressed and raw sizes (RECORD_SIZE bytes), then the compressed pixels. An index
+ * of the offset and timestamp of every record follows the last frame, the header holds its offset.
+ *
+ * Before compression, each sample is replaced by its difference with the previous sample of the same color on
+ * the row, and the low and high bytes of 16 bit samples are stored in two separate planes. Both steps only
+ * depend on sample values, so the pixels do not depend on the byte order of the recording host.
+ */
+namespace ILV
+{
+constexpr char MAGIC[8] = {'I', 'N', 'D', 'I', 'I', 'L', 'V', '1'};
+constexpr uint32_t VERSION = 1;
+constexpr size_t HEADER_SIZE = 64;
+constexpr size_t RECORD_SIZE = 16;
+constexpr size_t INDEX_ENTRY_SIZE = 16;
+
+enum Filter
+{
+    FILTER_NONE,        /*!< Samples stored as they are */
+    FILTER_DELTA        /*!< Horizontal delta of same color samples, 16 bit samples split in byte planes */
+};
+
+struct Header
+{
+    uint32_t version {VERSION};
+    uint32_t width {0};
+    uint32_t height {0};
+    uint32_t pixelFormat {INDI_MONO};
+    uint32_t pixelDepth {8};
+    uint32_t planes {1};
+    uint32_t codec {COMPRESSION_ZLIB};
+    uint32_t filter {FILTER_DELTA};
+    uint64_t frameCount {0};
+    /// Offset of the index, 0 if the recording was not closed
+    uint64_t indexOffset {0};
+    /// Start of the recording, microseconds since the Unix epoch
+    uint64_t startTime {0};
+
+    /// Size in bytes of a raw frame
+    size_t frameSize() const;
+};
+
+/**
+ * @brief Apply the filter to a raw frame. output is resized to the frame size.
+ */
+void encodeFrame(const Header &header, const uint8_t *frame, std::vector<uint8_t> &output);
+
+/**
+ * @brief Revert the filter applied by encodeFrame(). output must hold the frame size.
+ */
+void decodeFrame(const Header &header, const uint8_t *filtered, uint8_t *output);
+}
+
+/**
+ * @brief The LosslessRecorder class records raw frames losslessly, including 16 bit mono and Bayer frames.
+ *
+ * Frames are filtered and compressed with the fastest codec available (lz4, zstd, then zlib), and
+ * appended through an AsyncStreamWriter. Each frame is timestamped, and the index written on close makes every
+ * frame directly readable with LosslessReader.
+ */
+class LosslessRecorder : public RecorderInterface
+{
+    public:
+        LosslessRecorder();
+        virtual ~LosslessRecorder() = default;
+
+        virtual const char *getExtension() override
+        {
+            return ".ilv";
+        }
+        virtual bool setPixelFormat(INDI_PIXEL_FORMAT pixelFormat, uint8_t pixelDepth) override;
+        virtual bool setSize(uint16_t width, uint16_t height) override;
+        virtual bool open(const char *filename, char *errmsg) override;
+        virtual bool close() override;
+        virtual bool writeFrame(const uint8_t *frame, uint32_t nbytes) override;
+        virtual bool writeFrame(const uint8_t *frame, uint32_t nbytes,
+                                std::chrono::system_clock::time_point timestamp) override;
+        virtual bool getWriteStatistics(double &rate, uint32_t &stalls) const override;
+        virtual void setStreamEnabled(bool enable) override
+        {
+            INDI_UNUSED(enable);
+        }
+
+        /** @return Size of the recorded raw frames over the size written so far, 1 if nothing was written. */
+        double compressionRatio() const;
+
+    protected:
+        void serializeHeader(std::vector<uint8_t> &out) const;
+
+    protected:
+        ILV::Header m_Header;
+        bool m_IsRecording {false};
+        int m_Level {1};
+        AsyncStreamWriter m_Writer;
+        std::vector<uint8_t> m_Filtered;
+        std::vector<uint8_t> m_Compressed;
+        std::vector<uint8_t> m_Serialized;
+        /// Offset and timestamp of every record
+        std::vector<uint64_t> m_Index;
+        uint64_t m_RawBytes {0};
+};
+
+/**
+ * @brief The LosslessReader class reads frames of files recorded by LosslessRecorder in any order.
+ *
+ * Files without an index, when the recording was interrupted, are indexed by reading the record headers.
+ */
+class LosslessReader
+{
+    public:
+        LosslessReader() = default;
+        ~LosslessReader();
+
+        /**
+         * @brief open Read the header and the index of a file.
+         * @return True on success, false if the file cannot be read or is not an ILV file.
+         */
+        bool open(const std::string &path);
+        void close();
+
+        const ILV::Header &header() const
+        {
+            return m_Header;
+        }
+
+        uint64_t frameCount() const
+        {
+            return m_Offsets.size();
+        }
+
+        /** @return Timestamp of a frame, in microseconds since the Unix epoch. */
+        uint64_t timestamp(uint64_t frame) const
+        {
+            return m_Timestamps.at(frame);
+        }
+
+        /**
+         * @brief readFrame Read and decompress a frame.
+         * @param frame frame number, from 0.
+         * @param output raw frame, resized to the frame size.
+         * @return True on success, false if the frame does not exist or is corrupted.
+         */
+        bool readFrame(uint64_t frame, std::vector<uint8_t> &output);
+
+    protected:
+        bool readIndex();
+        bool scanRecords();
+
+    protected:
+        FILE *m_File {nullptr};
+        ILV::Header m_Header;
+        std::vector<uint64_t> m_Offsets;
+        std::vector<uint64_t> m_Timestamps;
+        std::vector<uint8_t> m_Compressed;
+        std::vector<uint8_t> m_Filtered;
+};
+
+}
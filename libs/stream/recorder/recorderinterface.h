@@ -28,6 +28,7 @@
 #include <cstdlib>
 #include <stdint.h>
 
+#include <chrono>
 #include <vector>
 
 #if 0
@@ -71,10 +72,28 @@ class RecorderInterface
             m_FPS = FPS;
             return true;
         }
+        // Frames expected in the next recording, 0 if unknown. Recorders may preallocate space.
+        virtual void setExpectedFrames(uint64_t frames)
+        {
+            m_ExpectedFrames = frames;
+        }
+        // Sustained disk write rate in MB/s, and number of times frames waited for the disk
+        virtual bool getWriteStatistics(double &rate, uint32_t &stalls) const
+        {
+            rate = 0;
+            stalls = 0;
+            return false;
+        }
         virtual bool open(const char *filename, char *errmsg)                          = 0;
         virtual bool close()                                                           = 0;
         // when frame is in known encoding format
         virtual bool writeFrame(const uint8_t *frame, uint32_t nbytes) = 0;
+        // Frame captured at timestamp. Recorders storing timestamps should override this, the default ignores it.
+        virtual bool writeFrame(const uint8_t *frame, uint32_t nbytes, std::chrono::system_clock::time_point timestamp)
+        {
+            INDI_UNUSED(timestamp);
+            return writeFrame(frame, nbytes);
+        }
         // If streaming is enabled, then any subframing is already done by the stream recorder
         // and no need to do any further subframing operations. Otherwise, subframing must be done.
         // This is to reduce process time and save memory for a dedicated subframe buffer
@@ -83,6 +102,7 @@ class RecorderInterface
     protected:
         const char *name;
         float m_FPS = 1;
+        uint64_t m_ExpectedFrames = 0;
 };
 
 }
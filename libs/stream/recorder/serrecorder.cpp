@@ -28,6 +28,8 @@
 #include "serrecorder.h"
 #include "jpegutils.h"
 
+#include <algorithm>
+#include <chrono>
 #include <ctime>
 #include <cerrno>
 #include <cstring>
@@ -36,6 +38,9 @@
 
 #define ERRMSGSIZ 1024
 
+// Timestamps reserved at open, 8 MB
+static const uint64_t MAX_RESERVED_STAMPS = 1 << 20;
+
 namespace INDI
 {
 
@@ -53,7 +58,6 @@ SER_Recorder::SER_Recorder()
     // always default to. LITTLE_ENDIAN appears to be ignored by them leading to garbled data.
     serh.LittleEndian = SER_BIG_ENDIAN;
     isRecordingActive = false;
-    f = nullptr;
 
     jpegBuffer = static_cast<uint8_t*>(malloc(1));
 }
@@ -70,49 +74,49 @@ bool SER_Recorder::is_little_endian()
     return black_magic == 0x01;
 }
 
-void SER_Recorder::write_int_le(uint32_t *i)
+void SER_Recorder::write_int_le(std::vector<uint8_t> &out, uint32_t *i)
 {
+    unsigned char *c = (unsigned char *)i;
     if (is_little_endian())
-        fwrite((i), sizeof(uint32_t), 1, f);
+        out.insert(out.end(), c, c + sizeof(uint32_t));
     else
     {
-        unsigned char *c = (unsigned char *)i;
-        fwrite((c + 3), sizeof(char), 1, f);
-        fwrite((c + 2), sizeof(char), 1, f);
-        fwrite((c + 1), sizeof(char), 1, f);
-        fwrite((c), sizeof(char), 1, f);
+        out.push_back(c[3]);
+        out.push_back(c[2]);
+        out.push_back(c[1]);
+        out.push_back(c[0]);
     }
 }
 
-void SER_Recorder::write_long_int_le(uint64_t *i)
+void SER_Recorder::write_long_int_le(std::vector<uint8_t> &out, uint64_t *i)
 {
     if (is_little_endian())
     {
-        fwrite(((uint32_t *)i), sizeof(int), 1, f);
-        fwrite(((uint32_t *)(i) + 1), sizeof(int), 1, f);
+        unsigned char *c = (unsigned char *)i;
+        out.insert(out.end(), c, c + sizeof(uint64_t));
     }
     else
     {
-        write_int_le((uint32_t *)(i) + 1);
-        write_int_le((uint32_t *)(i));
+        write_int_le(out, (uint32_t *)(i) + 1);
+        write_int_le(out, (uint32_t *)(i));
     }
 }
 
-void SER_Recorder::write_header(ser_header *s)
+void SER_Recorder::write_header(std::vector<uint8_t> &out, ser_header *s)
 {
-    fwrite((s->FileID), sizeof(char), 14, f);
-    write_int_le(&(s->LuID));
-    write_int_le(&(s->ColorID));
-    write_int_le(&(s->LittleEndian));
-    write_int_le(&(s->ImageWidth));
-    write_int_le(&(s->ImageHeight));
-    write_int_le(&(s->PixelDepth));
-    write_int_le(&(s->FrameCount));
-    fwrite((s->Observer), sizeof(char), 40, f);
-    fwrite((s->Instrume), sizeof(char), 40, f);
-    fwrite((s->Telescope), sizeof(char), 40, f);
-    write_long_int_le(&(s->DateTime));
-    write_long_int_le(&(s->DateTime_UTC));
+    out.insert(out.end(), s->FileID, s->FileID + 14);
+    write_int_le(out, &(s->LuID));
+    write_int_le(out, &(s->ColorID));
+    write_int_le(out, &(s->LittleEndian));
+    write_int_le(out, &(s->ImageWidth));
+    write_int_le(out, &(s->ImageHeight));
+    write_int_le(out, &(s->PixelDepth));
+    write_int_le(out, &(s->FrameCount));
+    out.insert(out.end(), s->Observer, s->Observer + 40);
+    out.insert(out.end(), s->Instrume, s->Instrume + 40);
+    out.insert(out.end(), s->Telescope, s->Telescope + 40);
+    write_long_int_le(out, &(s->DateTime));
+    write_long_int_le(out, &(s->DateTime_UTC));
 }
 
 bool SER_Recorder::setPixelFormat(INDI_PIXEL_FORMAT pixelFormat, uint8_t pixelDepth)
@@ -175,44 +179,64 @@ bool SER_Recorder::open(const char *filename, char *errmsg)
     if (isRecordingActive)
         return false;
     serh.FrameCount = 0;
-    if ((f = fopen(filename, "w")) == nullptr)
-    {
-        snprintf(errmsg, ERRMSGSIZ, "recorder open error %d, %s\n", errno, strerror(errno));
-        return false;
-    }
+    frame_size      = serh.ImageWidth * serh.ImageHeight * (serh.PixelDepth <= 8 ? 1 : 2) * number_of_planes;
 
     serh.DateTime     = getLocalTimeStamp();
     serh.DateTime_UTC = getUTCTimeStamp();
-    write_header(&serh);
-    frame_size        = serh.ImageWidth * serh.ImageHeight * (serh.PixelDepth <= 8 ? 1 : 2) * number_of_planes;
+    serializeBuffer.clear();
+    write_header(serializeBuffer, &serh);
+
+    // Header, frames and their timestamps
+    uint64_t expectedSize = 0;
+    if (m_ExpectedFrames > 0)
+        expectedSize = serializeBuffer.size() + m_ExpectedFrames * (frame_size + sizeof(uint64_t));
+
+    int error = writer.open(filename, expectedSize);
+    if (error != 0)
+    {
+        snprintf(errmsg, ERRMSGSIZ, "recorder open error %d, %s\n", error, strerror(error));
+        return false;
+    }
+    writer.write(serializeBuffer.data(), serializeBuffer.size());
     isRecordingActive = true;
 
+    // Growing the timestamps would copy them on the streaming thread
     frameStamps.clear();
+    frameStamps.reserve(std::min<uint64_t>(m_ExpectedFrames, MAX_RESERVED_STAMPS));
 
     return true;
 }
 
 bool SER_Recorder::close()
 {
-    if (f)
+    bool success = true;
+    if (writer.isOpen())
     {
         // Write all timestamps
+        serializeBuffer.clear();
+        serializeBuffer.reserve(frameStamps.size() * sizeof(uint64_t));
         for (auto value : frameStamps)
-            write_long_int_le(&value);
+            write_long_int_le(serializeBuffer, &value);
+        writer.write(serializeBuffer.data(), serializeBuffer.size());
 
         frameStamps.clear();
 
-        fseek(f, 0L, SEEK_SET);
-        write_header(&serh);
-        fclose(f);
-        f = nullptr;
+        // The header with the final frame count overwrites the one written at open
+        serializeBuffer.clear();
+        write_header(serializeBuffer, &serh);
+        success = writer.close(serializeBuffer.data(), serializeBuffer.size()) == 0;
     }
 
     isRecordingActive = false;
-    return true;
+    return success;
 }
 
 bool SER_Recorder::writeFrame(const uint8_t *frame, uint32_t nbytes)
+{
+    return writeFrame(frame, nbytes, std::chrono::system_clock::now());
+}
+
+bool SER_Recorder::writeFrame(const uint8_t *frame, uint32_t nbytes, std::chrono::system_clock::time_point timestamp)
 {
     if (!isRecordingActive)
         return false;
@@ -253,7 +277,7 @@ bool SER_Recorder::writeFrame(const uint8_t *frame, uint32_t nbytes)
     }
 #endif
 
-    frameStamps.push_back(getUTCTimeStamp());
+    frameStamps.push_back(getUTCTimeStamp(timestamp));
 
     // Not technically pixel format, but let's use this for now.
     if (m_PixelFormat == INDI_JPG)
@@ -266,14 +290,22 @@ bool SER_Recorder::writeFrame(const uint8_t *frame, uint32_t nbytes)
         serh.ImageWidth = w;
         serh.ImageHeight = h;
         serh.ColorID = (naxis == 3) ? SER_RGB : SER_MONO;
-        fwrite(jpegBuffer, 1, memsize, f);
+        if (writer.write(jpegBuffer, memsize) == false)
+            return false;
     }
-    else
-        fwrite(frame, 1, nbytes, f);
+    else if (writer.write(frame, nbytes) == false)
+        return false;
     serh.FrameCount += 1;
     return true;
 }
 
+bool SER_Recorder::getWriteStatistics(double &rate, uint32_t &stalls) const
+{
+    rate = writer.writeRate();
+    stalls = writer.stalls();
+    return true;
+}
+
 // Copyright (C) 2015 Chris Garry
 //
 
@@ -306,20 +338,22 @@ bool SER_Recorder::is_leap_year(uint32_t year)
 
 uint64_t SER_Recorder::getUTCTimeStamp()
 {
-    uint64_t utcTS;
+    return getUTCTimeStamp(std::chrono::system_clock::now());
+}
 
-    // Get starting time
-    timeval currentTime;
-    gettimeofday(&currentTime, nullptr);
+uint64_t SER_Recorder::getUTCTimeStamp(std::chrono::system_clock::time_point timestamp)
+{
+    uint64_t utcTS;
 
-    struct tm *tp;
-    time_t t   = (time_t)currentTime.tv_sec;
-    uint32_t u = currentTime.tv_usec;
+    int64_t microseconds = std::chrono::duration_cast<std::chrono::microseconds>(timestamp.time_since_epoch()).count();
+    time_t t   = static_cast<time_t>(microseconds / 1000000);
+    uint32_t u = static_cast<uint32_t>(microseconds % 1000000);
 
     // UTC Time
-    tp = gmtime(&t);
+    struct tm utc;
+    gmtime_r(&t, &utc);
 
-    dateTo64BitTS(tp->tm_year + 1900, tp->tm_mon + 1, tp->tm_mday, tp->tm_hour, tp->tm_min, tp->tm_sec, u, &utcTS);
+    dateTo64BitTS(utc.tm_year + 1900, utc.tm_mon + 1, utc.tm_mday, utc.tm_hour, utc.tm_min, utc.tm_sec, u, &utcTS);
 
     return utcTS;
 }
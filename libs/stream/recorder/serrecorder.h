@@ -22,6 +22,7 @@
 #pragma once
 
 #include "recorderinterface.h"
+#include "indifilewriter.h"
 
 #include <cstdint>
 #include <stdio.h>
@@ -66,6 +67,9 @@ namespace INDI
 
 /**
  * @brief The SER_Recorder class implements recording of video streams in SER format.
+ *
+ * Frames are appended through an AsyncStreamWriter, so the disk is written from a dedicated thread in large
+ * blocks while frames keep coming.
  */
 class SER_Recorder : public RecorderInterface
 {
@@ -82,6 +86,9 @@ class SER_Recorder : public RecorderInterface
         virtual bool open(const char *filename, char *errmsg);
         virtual bool close();
         virtual bool writeFrame(const uint8_t *frame, uint32_t nbytes);
+        virtual bool writeFrame(const uint8_t *frame, uint32_t nbytes,
+                                std::chrono::system_clock::time_point timestamp) override;
+        virtual bool getWriteStatistics(double &rate, uint32_t &stalls) const override;
         virtual void setStreamEnabled(bool enable)
         {
             isStreamingActive = enable;
@@ -93,12 +100,13 @@ class SER_Recorder : public RecorderInterface
     protected:
         uint64_t utcTo64BitTS();
         bool is_little_endian();
-        void write_int_le(uint32_t *i);
-        void write_long_int_le(uint64_t *i);
-        void write_header(ser_header *s);
+        void write_int_le(std::vector<uint8_t> &out, uint32_t *i);
+        void write_long_int_le(std::vector<uint8_t> &out, uint64_t *i);
+        void write_header(std::vector<uint8_t> &out, ser_header *s);
         ser_header serh;
         bool isRecordingActive = false, isStreamingActive = false;
-        FILE *f;
+        AsyncStreamWriter writer;
+        std::vector<uint8_t> serializeBuffer;
         uint32_t frame_size;
         uint32_t number_of_planes;
         uint16_t rawWidth = 0, rawHeight = 0;
@@ -113,6 +121,7 @@ class SER_Recorder : public RecorderInterface
                            int32_t microsec, uint64_t *p_ts);
 
         uint64_t getUTCTimeStamp();
+        uint64_t getUTCTimeStamp(std::chrono::system_clock::time_point timestamp);
         uint64_t getLocalTimeStamp();
 
         // Calculate if a year is a leap yer
@@ -21,7 +21,8 @@
 
 #include "theorarecorder.h"
 #include "jpegutils.h"
-#include "ccvt.h"
+#include "colorconvert.h"
+#include "theorautils.h"
 
 #define _FILE_OFFSET_BITS 64
 
@@ -32,13 +33,6 @@
 
 #define ERRMSGSIZ 1024
 
-static int ilog(unsigned _v)
-{
-    int ret;
-    for(ret = 0; _v; ret++)_v >>= 1;
-    return ret;
-}
-
 namespace INDI
 {
 
@@ -171,8 +165,7 @@ bool TheoraRecorder::open(const char *filename, char *errmsg)
         return false;
     }
 
-    srand(time(nullptr));
-    if(ogg_stream_init(&ogg_os, rand()))
+    if(ogg_stream_init(&ogg_os, oggSerialNumber()))
     {
         snprintf(errmsg, ERRMSGSIZ, "%s: error: could not create ogg stream state", filename);
         return false;
@@ -194,7 +187,7 @@ bool TheoraRecorder::open(const char *filename, char *errmsg)
     ti.pixel_fmt = static_cast<th_pixel_fmt>(chroma_format);
     ti.target_bitrate = video_rate;
     ti.quality = video_quality;
-    ti.keyframe_granule_shift = ilog(keyframe_frequency - 1);
+    ti.keyframe_granule_shift = theoraGranuleShift(keyframe_frequency);
 
     td = th_encode_alloc(&ti);
     th_info_clear(&ti);
@@ -429,7 +422,7 @@ bool TheoraRecorder::writeFrame(const uint8_t *frame, uint32_t nbytes)
     }
     else if (m_PixelFormat == INDI_RGB)
     {
-        BGR2YUV(rawWidth, rawHeight, const_cast<uint8_t*>(frame), ycbcr[0].data, ycbcr[1].data, ycbcr[2].data, 0);
+        rgb24ToYUV420p(frame, ycbcr[0].data, ycbcr[1].data, ycbcr[2].data, rawWidth, rawHeight, false, true);
     }
     else if (m_PixelFormat == INDI_JPG)
     {
@@ -28,7 +28,6 @@
 #include "indisensorinterface.h"
 #include "indilogger.h"
 #include "indiutility.h"
-#include "indisinglethreadpool.h"
 #include "indielapsedtimer.h"
 
 #include <cerrno>
@@ -58,15 +57,21 @@ StreamManagerPrivate::StreamManagerPrivate(DefaultDevice *defaultDevice)
     LOGF_DEBUG("Using default encoder (%s)", encoder->getName());
 
     framesThread = std::thread(&StreamManagerPrivate::asyncStreamThread, this);
+    recordThread = std::thread(&StreamManagerPrivate::recordStreamThread, this);
+    previewThread = std::thread(&StreamManagerPrivate::previewStreamThread, this);
 }
 
 StreamManagerPrivate::~StreamManagerPrivate()
 {
-    if (framesThread.joinable())
+    framesThreadTerminate = true;
+    framesIncoming.abort();
+    framesRecord.abort();
+    framesPreview.abort();
+
+    for (std::thread *thread : {&framesThread, &recordThread, &previewThread})
     {
-        framesThreadTerminate = true;
-        framesIncoming.abort();
-        framesThread.join();
+        if (thread->joinable())
+            thread->join();
     }
 }
 
@@ -147,28 +152,94 @@ bool StreamManagerPrivate::initProperties()
     // Encoder Selection
     EncoderSP[ENCODER_RAW  ].fill("RAW",   "RAW",   ISS_ON);
     EncoderSP[ENCODER_MJPEG].fill("MJPEG", "MJPEG", ISS_OFF);
+    EncoderSP[ENCODER_THEORA].fill("THEORA", "THEORA", ISS_OFF);
     if(currentDevice->getDriverInterface() & INDI::DefaultDevice::SENSOR_INTERFACE)
         EncoderSP.fill(getDeviceName(), "SENSOR_STREAM_ENCODER", "Encoder", STREAM_TAB, IP_RW, ISR_1OFMANY, 0, IPS_IDLE);
     else
         EncoderSP.fill(getDeviceName(), "CCD_STREAM_ENCODER",    "Encoder", STREAM_TAB, IP_RW, ISR_1OFMANY, 0, IPS_IDLE);
 
+    // Bitrate of 0 encodes at constant quality
+    EncoderSettingsNP[ENCODER_BITRATE          ].fill("ENCODER_BITRATE",           "Bitrate (kbit/s)",   "%.0f", 0, 100000, 100, 0);
+    EncoderSettingsNP[ENCODER_KEYFRAME_INTERVAL].fill("ENCODER_KEYFRAME_INTERVAL", "Key frame interval", "%.0f", 1, 1000,   1,   64);
+    EncoderSettingsNP.fill(getDeviceName(), "STREAM_ENCODER_SETTINGS", "Encoder Rate", STREAM_TAB, IP_RW, 0, IPS_IDLE);
+
     // Recorder Selector
     RecorderSP[RECORDER_RAW].fill("SER", "SER", ISS_ON);
+    RecorderSP[RECORDER_LOSSLESS].fill("ILV", "Lossless", ISS_OFF);
     RecorderSP[RECORDER_OGV].fill("OGV", "OGV", ISS_OFF);
     if(currentDevice->getDriverInterface() & INDI::DefaultDevice::SENSOR_INTERFACE)
         RecorderSP.fill(getDeviceName(), "SENSOR_STREAM_RECORDER", "Recorder", STREAM_TAB, IP_RW, ISR_1OFMANY, 0, IPS_IDLE);
     else
         RecorderSP.fill(getDeviceName(), "CCD_STREAM_RECORDER",    "Recorder", STREAM_TAB, IP_RW, ISR_1OFMANY, 0, IPS_IDLE);
 
-    // If we do not have theora installed, let's just define SER default recorder
+    // If we do not have theora installed, let's just define the SER and lossless recorders and the intra-frame encoders
 #ifndef HAVE_THEORA
-    RecorderSP.resize(1);
+    RecorderSP.resize(2);
+    EncoderSP.resize(2);
 #endif
 
     // Limits
     LimitsNP[LIMITS_BUFFER_MAX ].fill("LIMITS_BUFFER_MAX",  "Maximum Buffer Size (MB)", "%.0f", 1, 1024 * 64, 1, 512);
     LimitsNP[LIMITS_PREVIEW_FPS].fill("LIMITS_PREVIEW_FPS", "Maximum Preview FPS",      "%.0f", 1, 120,     1,  10);
     LimitsNP.fill(getDeviceName(), "LIMITS", "Limits", STREAM_TAB, IP_RW, 0, IPS_IDLE);
+
+    /* Preview Stretch */
+    StretchSP[STRETCH_FIXED_GAMMA].fill("STRETCH_FIXED_GAMMA", "Fixed gamma", ISS_ON);
+    StretchSP[STRETCH_LINEAR     ].fill("STRETCH_LINEAR",      "Auto linear", ISS_OFF);
+    StretchSP[STRETCH_GAMMA      ].fill("STRETCH_GAMMA",       "Auto gamma",  ISS_OFF);
+    StretchSP[STRETCH_ASINH      ].fill("STRETCH_ASINH",       "Auto asinh",  ISS_OFF);
+    StretchSP.fill(getDeviceName(), "STREAM_STRETCH", "Stretch", STREAM_TAB, IP_RW, ISR_1OFMANY, 0, IPS_IDLE);
+
+    StretchSettingsNP[STRETCH_LOW      ].fill("STRETCH_LOW",       "Black percentile", "%.2f", 0,    50,  0.1, 0.1);
+    StretchSettingsNP[STRETCH_HIGH     ].fill("STRETCH_HIGH",      "White percentile", "%.2f", 50,   100, 0.1, 99.9);
+    StretchSettingsNP[STRETCH_SMOOTHING].fill("STRETCH_SMOOTHING", "New frame weight", "%.2f", 0.01, 1,   0.1, 0.5);
+    StretchSettingsNP.fill(getDeviceName(), "STREAM_STRETCH_SETTINGS", "Stretch Levels", STREAM_TAB, IP_RW, 0, IPS_IDLE);
+    autoStretch.setPercentiles(StretchSettingsNP[STRETCH_LOW].getValue(), StretchSettingsNP[STRETCH_HIGH].getValue());
+    autoStretch.setSmoothing(StretchSettingsNP[STRETCH_SMOOTHING].getValue());
+
+    /* Pipeline stages */
+    StreamStagesNP[STAGE_RECORD_FPS     ].fill("STAGE_RECORD_FPS",      "Record FPS",           "%.2f", 0, 999,           0, 0);
+    StreamStagesNP[STAGE_RECORD_LATENCY ].fill("STAGE_RECORD_LATENCY",  "Record latency (ms)",  "%.1f", 0, 1e6,           0, 0);
+    StreamStagesNP[STAGE_RECORD_DROPPED ].fill("STAGE_RECORD_DROPPED",  "Record dropped",       "%.f",  0, 4294967295.0,  0, 0);
+    StreamStagesNP[STAGE_PREVIEW_FPS    ].fill("STAGE_PREVIEW_FPS",     "Preview FPS",          "%.2f", 0, 999,           0, 0);
+    StreamStagesNP[STAGE_PREVIEW_LATENCY].fill("STAGE_PREVIEW_LATENCY", "Preview latency (ms)", "%.1f", 0, 1e6,           0, 0);
+    StreamStagesNP[STAGE_PREVIEW_DROPPED].fill("STAGE_PREVIEW_DROPPED", "Preview dropped",      "%.f",  0, 4294967295.0,  0, 0);
+    StreamStagesNP[STAGE_RECORD_WRITE_RATE].fill("STAGE_RECORD_WRITE_RATE", "Disk write (MB/s)", "%.1f", 0, 1e6,      0, 0);
+    StreamStagesNP[STAGE_RECORD_STALLS    ].fill("STAGE_RECORD_STALLS",     "Disk stalls",       "%.f",  0, 4294967295.0, 0, 0);
+    StreamStagesNP.fill(getDeviceName(), "STREAM_STAGES", "Pipeline", STREAM_TAB, IP_RO, 60, IPS_IDLE);
+
+    /* Frame timestamps */
+    FrameInfoNP[FRAME_NUMBER].fill("FRAME_NUMBER", "Frame",        "%.f",  0, 1e15, 0, 0);
+    FrameInfoNP[FRAME_TIME  ].fill("FRAME_TIME",   "UTC time (s)", "%.6f", 0, 1e10, 0, 0);
+    FrameInfoNP.fill(getDeviceName(), "STREAM_FRAME_INFO", "Preview Frame", STREAM_TAB, IP_RO, 60, IPS_IDLE);
+
+    TimingNP[TIMING_INTERVAL   ].fill("TIMING_INTERVAL",    "Interval (ms)",    "%.3f", 0, 1e6, 0, 0);
+    TimingNP[TIMING_JITTER     ].fill("TIMING_JITTER",      "Jitter RMS (ms)",  "%.3f", 0, 1e6, 0, 0);
+    TimingNP[TIMING_LATENCY    ].fill("TIMING_LATENCY",     "Latency (ms)",     "%.1f", 0, 1e6, 0, 0);
+    TimingNP[TIMING_LATENCY_MAX].fill("TIMING_LATENCY_MAX", "Max latency (ms)", "%.1f", 0, 1e6, 0, 0);
+    TimingNP.fill(getDeviceName(), "STREAM_TIMING", "Timing", STREAM_TAB, IP_RO, 60, IPS_IDLE);
+
+    for (size_t bin = 0; bin < FrameTiming::BINS; bin++)
+    {
+        char name[MAXINDINAME], label[MAXINDILABEL];
+        bool last = bin == FrameTiming::BINS - 1;
+
+        snprintf(name, MAXINDINAME, "JITTER_%zu", bin);
+        if (last)
+            snprintf(label, MAXINDILABEL, "Jitter >= %g ms", FrameTiming::jitterLimit(bin - 1));
+        else
+            snprintf(label, MAXINDILABEL, "Jitter < %g ms", FrameTiming::jitterLimit(bin));
+        TimingHistogramNP[bin].fill(name, label, "%.f", 0, 1e15, 0, 0);
+
+        snprintf(name, MAXINDINAME, "LATENCY_%zu", bin);
+        if (last)
+            snprintf(label, MAXINDILABEL, "Latency >= %g ms", FrameTiming::latencyLimit(bin - 1));
+        else
+            snprintf(label, MAXINDILABEL, "Latency < %g ms", FrameTiming::latencyLimit(bin));
+        TimingHistogramNP[FrameTiming::BINS + bin].fill(name, label, "%.f", 0, 1e15, 0, 0);
+    }
+    TimingHistogramNP.fill(getDeviceName(), "STREAM_TIMING_HISTOGRAM", "Timing Histogram", STREAM_TAB, IP_RO, 60, IPS_IDLE);
+    framePool.setLimit(static_cast<size_t>(LimitsNP[LIMITS_BUFFER_MAX].getValue()) * 1024 * 1024);
     return true;
 }
 
@@ -189,13 +260,20 @@ void StreamManagerPrivate::ISGetProperties(const char *dev)
         if (hasStreamingExposure)
             currentDevice->defineProperty(StreamExposureNP);
         currentDevice->defineProperty(FpsNP);
+        currentDevice->defineProperty(StreamStagesNP);
+        currentDevice->defineProperty(FrameInfoNP);
+        currentDevice->defineProperty(TimingNP);
+        currentDevice->defineProperty(TimingHistogramNP);
         currentDevice->defineProperty(RecordStreamSP);
         currentDevice->defineProperty(RecordFileTP);
         currentDevice->defineProperty(RecordOptionsNP);
         currentDevice->defineProperty(StreamFrameNP);
         currentDevice->defineProperty(EncoderSP);
+        currentDevice->defineProperty(EncoderSettingsNP);
         currentDevice->defineProperty(RecorderSP);
         currentDevice->defineProperty(LimitsNP);
+        currentDevice->defineProperty(StretchSP);
+        currentDevice->defineProperty(StretchSettingsNP);
     }
 }
 
@@ -223,13 +301,20 @@ bool StreamManagerPrivate::updateProperties()
         if (hasStreamingExposure)
             currentDevice->defineProperty(StreamExposureNP);
         currentDevice->defineProperty(FpsNP);
+        currentDevice->defineProperty(StreamStagesNP);
+        currentDevice->defineProperty(FrameInfoNP);
+        currentDevice->defineProperty(TimingNP);
+        currentDevice->defineProperty(TimingHistogramNP);
         currentDevice->defineProperty(RecordStreamSP);
         currentDevice->defineProperty(RecordFileTP);
         currentDevice->defineProperty(RecordOptionsNP);
         currentDevice->defineProperty(StreamFrameNP);
         currentDevice->defineProperty(EncoderSP);
+        currentDevice->defineProperty(EncoderSettingsNP);
         currentDevice->defineProperty(RecorderSP);
         currentDevice->defineProperty(LimitsNP);
+        currentDevice->defineProperty(StretchSP);
+        currentDevice->defineProperty(StretchSettingsNP);
     }
     else
     {
@@ -238,13 +323,20 @@ bool StreamManagerPrivate::updateProperties()
         if (hasStreamingExposure)
             currentDevice->deleteProperty(StreamExposureNP.getName());
         currentDevice->deleteProperty(FpsNP.getName());
+        currentDevice->deleteProperty(StreamStagesNP.getName());
+        currentDevice->deleteProperty(FrameInfoNP.getName());
+        currentDevice->deleteProperty(TimingNP.getName());
+        currentDevice->deleteProperty(TimingHistogramNP.getName());
         currentDevice->deleteProperty(RecordFileTP.getName());
         currentDevice->deleteProperty(RecordStreamSP.getName());
         currentDevice->deleteProperty(RecordOptionsNP.getName());
         currentDevice->deleteProperty(StreamFrameNP.getName());
         currentDevice->deleteProperty(EncoderSP.getName());
+        currentDevice->deleteProperty(EncoderSettingsNP.getName());
         currentDevice->deleteProperty(RecorderSP.getName());
         currentDevice->deleteProperty(LimitsNP.getName());
+        currentDevice->deleteProperty(StretchSP.getName());
+        currentDevice->deleteProperty(StretchSettingsNP.getName());
     }
 
     return true;
@@ -261,16 +353,23 @@ bool StreamManager::updateProperties()
  * Subframing for streaming/recording is done in the stream manager.
  * Therefore nbytes is expected to be SubW/BinX * SubH/BinY * Bytes_Per_Pixels * Number_Color_Components
  * Binned frame must be sent from the camera driver for this to work consistentaly for all drivers.*/
-void StreamManagerPrivate::newFrame(const uint8_t * buffer, uint32_t nbytes)
+bool StreamManagerPrivate::beginFrame(std::chrono::system_clock::time_point timestamp)
 {
     // close the data stream on the same thread as the data stream
     // manually triggered to stop recording.
     if (isRecordingAboutToClose)
     {
         stopRecording();
-        return;
+        return false;
     }
 
+    // Frames discarded below still show the regularity of the driver
+    {
+        std::lock_guard<std::mutex> lock(timingMutex);
+        frameTiming.addTimestamp(timestamp);
+    }
+    ++frameSequence;
+
     // Discard every N frame.
     // do not count it to fps statistics
     // N is StreamExposureNP[STREAM_DIVISOR].getValue()
@@ -280,7 +379,7 @@ void StreamManagerPrivate::newFrame(const uint8_t * buffer, uint32_t nbytes)
         (frameCountDivider % static_cast<int>(StreamExposureNP[STREAM_DIVISOR].value)) == 0
     )
     {
-        return;
+        return false;
     }
 
     if (FPSAverage.newFrame())
@@ -299,20 +398,37 @@ void StreamManagerPrivate::newFrame(const uint8_t * buffer, uint32_t nbytes)
         }).detach();
     }
 
-    if (isStreaming || (isRecording && !isRecordingAboutToClose))
-    {
-        size_t allocatedSize = nbytes * framesIncoming.size() / 1024 / 1024; // allocated size in MB
-        if (allocatedSize > LimitsNP[LIMITS_BUFFER_MAX].getValue())
-        {
-            LOG_WARN("Frame buffer is full, skipping frame...");
-            return;
-        }
+    return true;
+}
 
-        std::vector<uint8_t> copyBuffer(buffer, buffer + nbytes); // copy the frame
+void StreamManagerPrivate::queueFrame(FramePool::Frame &&frame, std::chrono::system_clock::time_point timestamp)
+{
+    if (!frame)
+    {
+        LOG_WARN("Frame buffer is full, skipping frame...");
+        return;
+    }
 
-        framesIncoming.push(TimeFrame{FPSFast.deltaTime(), std::move(copyBuffer)}); // push it into the queue
+    bool record = isRecording && !isRecordingAboutToClose;
+    if (record)
+    {
+        std::lock_guard<std::mutex> lock(recordPendingMutex);
+        ++recordPending;
     }
 
+    // push it into the queue
+    framesIncoming.push(TimeFrame{timestamp, frameSequence, std::move(frame), std::chrono::steady_clock::now(), record});
+}
+
+void StreamManagerPrivate::recordDone()
+{
+    std::lock_guard<std::mutex> lock(recordPendingMutex);
+    --recordPending;
+    recordPendingCondition.notify_all();
+}
+
+void StreamManagerPrivate::endFrame()
+{
     if (isRecording && !isRecordingAboutToClose)
     {
         FPSRecorder.newFrame(); // count frames and total time
@@ -324,7 +440,13 @@ void StreamManagerPrivate::newFrame(const uint8_t * buffer, uint32_t nbytes)
         )
         {
             LOG_INFO("Waiting for all buffered frames to be recorded");
-            framesIncoming.waitForEmpty();
+            {
+                std::unique_lock<std::mutex> lock(recordPendingMutex);
+                recordPendingCondition.wait(lock, [this]()
+                {
+                    return recordPending == 0;
+                });
+            }
             // duplicated message
 #if 0
             LOGF_INFO(
@@ -335,7 +457,7 @@ void StreamManagerPrivate::newFrame(const uint8_t * buffer, uint32_t nbytes)
 #endif
             RecordStreamSP.reset();
             RecordStreamSP[RECORD_OFF].setState(ISS_ON);
-            RecordStreamSP.setState(IPS_IDLE);
+            RecordStreamSP.setState(framesRecord.dropped() > 0 ? IPS_ALERT : IPS_IDLE);
             RecordStreamSP.apply();
 
             stopRecording();
@@ -343,10 +465,62 @@ void StreamManagerPrivate::newFrame(const uint8_t * buffer, uint32_t nbytes)
     }
 }
 
+void StreamManagerPrivate::newFrame(const uint8_t * buffer, uint32_t nbytes,
+                                    std::chrono::system_clock::time_point timestamp)
+{
+    if (beginFrame(timestamp) == false)
+        return;
+
+    if (isStreaming || (isRecording && !isRecordingAboutToClose))
+    {
+        FramePool::Frame frame = framePool.acquire(nbytes);
+        if (frame)
+            memcpy(frame->data(), buffer, nbytes); // copy the frame
+        queueFrame(std::move(frame), timestamp);
+    }
+
+    endFrame();
+}
+
+void StreamManagerPrivate::newFrame(FramePool::Frame &&frame, std::chrono::system_clock::time_point timestamp)
+{
+    if (beginFrame(timestamp) == false)
+        return;
+
+    if (isStreaming || (isRecording && !isRecordingAboutToClose))
+        queueFrame(std::move(frame), timestamp);
+
+    endFrame();
+}
+
 void StreamManager::newFrame(const uint8_t * buffer, uint32_t nbytes)
 {
     D_PTR(StreamManager);
-    d->newFrame(buffer, nbytes);
+    d->newFrame(buffer, nbytes, std::chrono::system_clock::now());
+}
+
+void StreamManager::newFrame(const uint8_t * buffer, uint32_t nbytes, std::chrono::system_clock::time_point timestamp)
+{
+    D_PTR(StreamManager);
+    d->newFrame(buffer, nbytes, timestamp);
+}
+
+FramePool::Frame StreamManager::acquireFrame(uint32_t nbytes)
+{
+    D_PTR(StreamManager);
+    return d->framePool.acquire(nbytes);
+}
+
+void StreamManager::newFrame(FramePool::Frame &&frame)
+{
+    D_PTR(StreamManager);
+    d->newFrame(std::move(frame), std::chrono::system_clock::now());
+}
+
+void StreamManager::newFrame(FramePool::Frame &&frame, std::chrono::system_clock::time_point timestamp)
+{
+    D_PTR(StreamManager);
+    d->newFrame(std::move(frame), timestamp);
 }
 
 
@@ -413,13 +587,6 @@ void StreamManagerPrivate::subframe(
 void StreamManagerPrivate::asyncStreamThread()
 {
     TimeFrame sourceTimeFrame;
-    sourceTimeFrame.time = 0;
-
-    std::vector<uint8_t> subframeBuffer;  // Subframe buffer for recording/streaming
-    std::vector<uint8_t> downscaleBuffer; // Downscale buffer for streaming
-
-    INDI::SingleThreadPool previewThreadPool;
-    INDI::ElapsedTimer previewElapsed;
 
     while(!framesThreadTerminate)
     {
@@ -428,11 +595,15 @@ void StreamManagerPrivate::asyncStreamThread()
 
         FrameInfo srcFrameInfo = updateSourceFrameInfo();
 
-        std::vector<uint8_t> *sourceBuffer = &sourceTimeFrame.frame;
+        // Frames go back to the pool once recorded and previewed
+        FramePool::Frame sourceFrame = std::move(sourceTimeFrame.frame);
+        bool record = sourceTimeFrame.record;
 
-        if (sourceBuffer->size() != srcFrameInfo.totalSize())
+        if (sourceFrame->size() != srcFrameInfo.totalSize())
         {
             LOG_ERROR("Invalid source buffer size, skipping frame...");
+            if (record)
+                recordDone();
             continue;
         }
 
@@ -443,58 +614,200 @@ void StreamManagerPrivate::asyncStreamThread()
             dstFrameInfo != srcFrameInfo
         )
         {
-            subframeBuffer.resize(dstFrameInfo.totalSize());
-            subframe(sourceBuffer->data(), srcFrameInfo, subframeBuffer.data(), dstFrameInfo);
+            FramePool::Frame subframeFrame = framePool.acquire(dstFrameInfo.totalSize());
+            if (!subframeFrame)
+            {
+                LOG_WARN("Frame buffer is full, skipping frame...");
+                if (record)
+                    recordDone();
+                continue;
+            }
+            subframe(sourceFrame->data(), srcFrameInfo, subframeFrame->data(), dstFrameInfo);
 
-            sourceBuffer = &subframeBuffer;
+            sourceFrame = std::move(subframeFrame);
         }
 
-        // For recording, save immediately.
+        // The record stage may hold half of the frame buffer, so a slow disk leaves room for the preview
+        if (record)
+        {
+            framesRecord.setCapacity(framePool.limit() / 2 / sourceFrame->capacity());
+            if (framesRecord.push(TimeFrame{sourceTimeFrame.timestamp, sourceTimeFrame.sequence, sourceFrame,
+                                                   sourceTimeFrame.received, true}) == false)
+            {
+                // The recording is incomplete, it stays in alert until the next one starts
+                if (framesRecord.dropped() == 1)
+                {
+                    LOG_WARN("Recording is slower than the stream, dropping frames...");
+                    RecordStreamSP.setState(IPS_ALERT);
+                    RecordStreamSP.apply();
+                }
+                recordDone();
+            }
+        }
+
+        // You can reduce the number of frames by setting a frame limit.
+        // A slow preview only replaces its pending frame with the newest one.
+        if (isStreaming && FPSPreview.newFrame())
+            framesPreview.push(TimeFrame{sourceTimeFrame.timestamp, sourceTimeFrame.sequence, std::move(sourceFrame),
+                                         sourceTimeFrame.received, false});
+    }
+}
+
+void StreamManagerPrivate::recordStreamThread()
+{
+    TimeFrame timeFrame;
+
+    while(!framesThreadTerminate)
+    {
+        if (framesRecord.pop(timeFrame) == false)
+            continue;
+
+        FramePool::Frame frame = std::move(timeFrame.frame);
         {
             std::lock_guard<std::mutex> lock(recordMutex);
             if (
                 isRecording && !isRecordingAboutToClose &&
-                recordStream(sourceBuffer->data(), sourceBuffer->size(), sourceTimeFrame.time) == false
+                recordStream(frame->data(), frame->size(), timeFrame.timestamp) == false
             )
             {
                 LOG_ERROR("Recording failed.");
                 isRecordingAboutToClose = true;
             }
         }
+        frame.reset();
 
-        // For streaming, downscale to 8bit if higher than 8bit to reduce bandwidth
-        // You can reduce the number of frames by setting a frame limit.
-        if (isStreaming && FPSPreview.newFrame())
         {
-            // Downscale to 8bit always for streaming to reduce bandwidth
-            if (PixelFormat != INDI_JPG && PixelDepth > 8)
-            {
-                // Allocale new buffer if size changes
-                downscaleBuffer.resize(dstFrameInfo.pixels());
+            std::lock_guard<std::mutex> lock(timingMutex);
+            frameTiming.addLatency(std::chrono::duration<double, std::milli>(
+                                       std::chrono::system_clock::now() - timeFrame.timestamp).count());
+        }
+
+        updateStage(STAGE_RECORD, timeFrame.received);
+        recordDone();
+    }
+}
+
+void StreamManagerPrivate::previewStreamThread()
+{
+    TimeFrame timeFrame;
+    INDI::ElapsedTimer previewElapsed;
+
+    while(!framesThreadTerminate)
+    {
+        if (framesPreview.pop(timeFrame) == false)
+            continue;
 
-                // Apply gamma
-                gammaLut16.apply(
-                    reinterpret_cast<const uint16_t*>(sourceBuffer->data()),
-                    downscaleBuffer.size(),
-                    downscaleBuffer.data()
-                );
+        FramePool::Frame frame = std::move(timeFrame.frame);
 
-                sourceBuffer = &downscaleBuffer;
+        // Downscale to 8bit always for streaming to reduce bandwidth
+        if (PixelFormat != INDI_JPG && PixelDepth > 8)
+        {
+            FramePool::Frame downscaleFrame = framePool.acquire(frame->size() / 2);
+            if (!downscaleFrame)
+            {
+                LOG_WARN("Frame buffer is full, skipping preview...");
+                continue;
             }
 
-            //uploadStream(sourceBuffer->data(), sourceBuffer->size());
-            previewThreadPool.start(std::bind([this, &previewElapsed](const std::atomic_bool & isAboutToQuit,
-                                              std::vector<uint8_t> frame)
             {
-                INDI_UNUSED(isAboutToQuit);
-                previewElapsed.start();
-                uploadStream(frame.data(), frame.size());
-                StreamTimeNP[0].setValue(previewElapsed.nsecsElapsed() / 1000000000.0);
-                StreamTimeNP.apply();
+                std::lock_guard<std::mutex> lock(stretchMutex);
+                if (StretchSP.findOnSwitchIndex() == STRETCH_FIXED_GAMMA)
+                    gammaLut16.apply(
+                        reinterpret_cast<const uint16_t*>(frame->data()),
+                        downscaleFrame->size(),
+                        downscaleFrame->data()
+                    );
+                else
+                    autoStretch.apply(
+                        reinterpret_cast<const uint16_t*>(frame->data()),
+                        downscaleFrame->size(),
+                        downscaleFrame->data()
+                    );
+            }
+
+            frame = std::move(downscaleFrame);
+        }
+
+        // Clients pair the frame information with the BLOB that follows it
+        FrameInfoNP[FRAME_NUMBER].setValue(timeFrame.sequence);
+        FrameInfoNP[FRAME_TIME].setValue(std::chrono::duration<double>(timeFrame.timestamp.time_since_epoch()).count());
+        FrameInfoNP.setState(IPS_OK);
+        FrameInfoNP.apply();
+
+        previewElapsed.start();
+        uploadStream(frame->data(), frame->size());
+        StreamTimeNP[0].setValue(previewElapsed.nsecsElapsed() / 1000000000.0);
+        StreamTimeNP.apply();
+        frame.reset();
+
+        updateStage(STAGE_PREVIEW, timeFrame.received);
+    }
+}
+
+void StreamManagerPrivate::updateStage(int stage, const std::chrono::steady_clock::time_point &received)
+{
+    std::lock_guard<std::mutex> lock(stageMutex);
+    StageCounters &counters = stageCounters[stage];
+    counters.latency += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - received).count();
+    counters.frames++;
+
+    if (counters.fps.newFrame() == false)
+        return;
 
-            }, std::placeholders::_1, std::move(*sourceBuffer)));
+    int first = (stage == STAGE_RECORD) ? STAGE_RECORD_FPS : STAGE_PREVIEW_FPS;
+    StreamStagesNP[first].setValue(counters.fps.framesPerSecond());
+    StreamStagesNP[first + 1].setValue(counters.latency / counters.frames);
+    StreamStagesNP[STAGE_RECORD_DROPPED].setValue(framesRecord.dropped());
+    StreamStagesNP[STAGE_PREVIEW_DROPPED].setValue(framesPreview.dropped());
+    double writeRate;
+    uint32_t stalls;
+    bool writeStatistics = false;
+    if (stage == STAGE_RECORD)
+    {
+        // The recorder may be closed or replaced from the main thread
+        std::lock_guard<std::mutex> recordLock(recordMutex);
+        writeStatistics = recorder->getWriteStatistics(writeRate, stalls);
+    }
+    if (writeStatistics)
+    {
+        StreamStagesNP[STAGE_RECORD_WRITE_RATE].setValue(writeRate);
+        StreamStagesNP[STAGE_RECORD_STALLS].setValue(stalls);
+    }
+    StreamStagesNP.setState(IPS_OK);
+    StreamStagesNP.apply();
+
+    counters.latency = 0;
+    counters.frames = 0;
+
+    // Once per second from the recorder while recording, from the preview otherwise
+    if (stage == STAGE_RECORD || !isRecording)
+        updateTiming();
+}
+
+void StreamManagerPrivate::resetTiming()
+{
+    std::lock_guard<std::mutex> lock(timingMutex);
+    frameTiming.reset();
+}
+
+void StreamManagerPrivate::updateTiming()
+{
+    {
+        std::lock_guard<std::mutex> lock(timingMutex);
+        TimingNP[TIMING_INTERVAL].setValue(frameTiming.interval());
+        TimingNP[TIMING_JITTER].setValue(frameTiming.jitter());
+        TimingNP[TIMING_LATENCY].setValue(frameTiming.latency());
+        TimingNP[TIMING_LATENCY_MAX].setValue(frameTiming.maxLatency());
+        for (size_t bin = 0; bin < FrameTiming::BINS; bin++)
+        {
+            TimingHistogramNP[bin].setValue(frameTiming.jitterHistogram()[bin]);
+            TimingHistogramNP[FrameTiming::BINS + bin].setValue(frameTiming.latencyHistogram()[bin]);
         }
     }
+    TimingNP.setState(IPS_OK);
+    TimingNP.apply();
+    TimingHistogramNP.setState(IPS_OK);
+    TimingHistogramNP.apply();
 }
 
 void StreamManagerPrivate::setSize(uint16_t width, uint16_t height)
@@ -584,13 +897,13 @@ void StreamManager::setSize(uint16_t width, uint16_t height)
     d->setSize(width, height);
 }
 
-bool StreamManagerPrivate::recordStream(const uint8_t * buffer, uint32_t nbytes, double deltams)
+bool StreamManagerPrivate::recordStream(const uint8_t * buffer, uint32_t nbytes,
+                                        std::chrono::system_clock::time_point timestamp)
 {
-    INDI_UNUSED(deltams);
     if (!isRecording)
         return false;
 
-    return recorder->writeFrame(buffer, nbytes);
+    return recorder->writeFrame(buffer, nbytes, timestamp);
 }
 
 std::string StreamManagerPrivate::expand(const std::string &fname, const std::map<std::string, std::string> &patterns)
@@ -640,6 +953,12 @@ bool StreamManagerPrivate::startRecording()
     }
 
     recorder->setFPS(FpsNP[FPS_AVERAGE].value);
+    if (RecordStreamSP[RECORD_FRAME].getState() == ISS_ON)
+        recorder->setExpectedFrames(RecordOptionsNP[1].getValue());
+    else if (RecordStreamSP[RECORD_TIME].getState() == ISS_ON)
+        recorder->setExpectedFrames(RecordOptionsNP[0].getValue() * FpsNP[FPS_AVERAGE].getValue());
+    else
+        recorder->setExpectedFrames(0);
 
     /* pattern substitution */
     recordfiledir.assign(RecordFileTP[0].text);
@@ -689,12 +1008,15 @@ bool StreamManagerPrivate::startRecording()
     }
 #endif
     FPSRecorder.reset();
+    framesRecord.resetDropped();
     frameCountDivider = 0;
+    resetTiming();
 
     if (isStreaming == false)
     {
         FPSAverage.reset();
         FPSFast.reset();
+        frameSequence = 0;
     }
 
     if(currentDevice->getDriverInterface() & INDI::DefaultDevice::CCD_INTERFACE)
@@ -756,6 +1078,9 @@ bool StreamManagerPrivate::stopRecording(bool force)
         FPSRecorder.totalTime(),
         FPSRecorder.totalFrames()
     );
+    if (framesRecord.dropped() > 0)
+        LOGF_WARN("%llu frames were dropped from the recording, the disk could not keep up with the stream.",
+                  static_cast<unsigned long long>(framesRecord.dropped()));
 
     return true;
 }
@@ -826,7 +1151,7 @@ bool StreamManagerPrivate::ISNewSwitch(const char * dev, const char * name, ISSt
         }
         else
         {
-            RecordStreamSP.setState(IPS_IDLE);
+            RecordStreamSP.setState(isRecording && framesRecord.dropped() > 0 ? IPS_ALERT : IPS_IDLE);
             Format.clear();
             FpsNP[FPS_INSTANT].setValue(0);
             FpsNP[FPS_AVERAGE].setValue(0);
@@ -855,6 +1180,7 @@ bool StreamManagerPrivate::ISNewSwitch(const char * dev, const char * name, ISSt
             {
                 encoderManager.setEncoder(oneEncoder);
 
+                oneEncoder->init(currentDevice);
                 oneEncoder->setPixelFormat(PixelFormat, PixelDepth);
 
                 encoder = oneEncoder;
@@ -866,6 +1192,30 @@ bool StreamManagerPrivate::ISNewSwitch(const char * dev, const char * name, ISSt
         return true;
     }
 
+    // Preview Stretch
+    if (StretchSP.isNameMatch(name))
+    {
+        std::lock_guard<std::mutex> lock(stretchMutex);
+        StretchSP.update(states, names, n);
+        switch (StretchSP.findOnSwitchIndex())
+        {
+            case STRETCH_GAMMA:
+                autoStretch.setCurve(AutoStretch::CURVE_GAMMA);
+                break;
+            case STRETCH_ASINH:
+                autoStretch.setCurve(AutoStretch::CURVE_ASINH);
+                break;
+            default:
+                autoStretch.setCurve(AutoStretch::CURVE_LINEAR);
+                break;
+        }
+        autoStretch.reset();
+
+        StretchSP.setState(IPS_OK);
+        StretchSP.apply();
+        return true;
+    }
+
     // Recorder Selection
     if (RecorderSP.isNameMatch(name))
     {
@@ -880,9 +1230,13 @@ bool StreamManagerPrivate::ISNewSwitch(const char * dev, const char * name, ISSt
             {
                 recorderManager.setRecorder(oneRecorder);
 
-                oneRecorder->setPixelFormat(PixelFormat, PixelDepth);
+                if (oneRecorder->setPixelFormat(PixelFormat, PixelDepth) == false)
+                    LOGF_WARN("Pixel format %d is not supported by %s recorder.", PixelFormat, oneRecorder->getName());
 
-                recorder = oneRecorder;
+                {
+                    std::lock_guard<std::mutex> lock(recordMutex);
+                    recorder = oneRecorder;
+                }
 
                 RecorderSP.setState(IPS_OK);
             }
@@ -950,6 +1304,7 @@ bool StreamManagerPrivate::ISNewNumber(const char * dev, const char * name, doub
     {
         LimitsNP.update(values, names, n);
 
+        framePool.setLimit(static_cast<size_t>(LimitsNP[LIMITS_BUFFER_MAX].getValue()) * 1024 * 1024);
         FPSPreview.setTimeWindow(1000.0 / LimitsNP[LIMITS_PREVIEW_FPS].getValue());
         FPSPreview.reset();
 
@@ -958,6 +1313,35 @@ bool StreamManagerPrivate::ISNewNumber(const char * dev, const char * name, doub
         return true;
     }
 
+    /* Encoder Rate */
+    if (EncoderSettingsNP.isNameMatch(name))
+    {
+        EncoderSettingsNP.update(values, names, n);
+        for (EncoderInterface * oneEncoder : encoderManager.getEncoderList())
+        {
+            oneEncoder->setBitrate(EncoderSettingsNP[ENCODER_BITRATE].getValue());
+            oneEncoder->setKeyframeInterval(EncoderSettingsNP[ENCODER_KEYFRAME_INTERVAL].getValue());
+        }
+
+        EncoderSettingsNP.setState(IPS_OK);
+        EncoderSettingsNP.apply();
+        return true;
+    }
+
+    /* Preview Stretch Levels */
+    if (StretchSettingsNP.isNameMatch(name))
+    {
+        std::lock_guard<std::mutex> lock(stretchMutex);
+        StretchSettingsNP.update(values, names, n);
+        autoStretch.setPercentiles(StretchSettingsNP[STRETCH_LOW].getValue(), StretchSettingsNP[STRETCH_HIGH].getValue());
+        autoStretch.setSmoothing(StretchSettingsNP[STRETCH_SMOOTHING].getValue());
+        autoStretch.reset();
+
+        StretchSettingsNP.setState(IPS_OK);
+        StretchSettingsNP.apply();
+        return true;
+    }
+
     /* Record Options */
     if (RecordOptionsNP.isNameMatch(name))
     {
@@ -1041,6 +1425,11 @@ bool StreamManagerPrivate::setStream(bool enable)
             FPSPreview.reset();
             FPSPreview.setTimeWindow(1000.0 / LimitsNP[LIMITS_PREVIEW_FPS].getValue());
             frameCountDivider = 0;
+            frameSequence = 0;
+            resetTiming();
+
+            // Clients joining the new stream need the headers of inter-frame encoders
+            encoder->reset();
 
             if(currentDevice->getDriverInterface() & INDI::DefaultDevice::CCD_INTERFACE)
             {
@@ -1132,10 +1521,13 @@ bool StreamManager::saveConfigItems(FILE * fp)
 {
     D_PTR(StreamManager);
     d->EncoderSP.save(fp);
+    d->EncoderSettingsNP.save(fp);
     d->RecordFileTP.save(fp);
     d->RecordOptionsNP.save(fp);
     d->RecorderSP.save(fp);
     d->LimitsNP.save(fp);
+    d->StretchSP.save(fp);
+    d->StretchSettingsNP.save(fp);
     return true;
 }
 
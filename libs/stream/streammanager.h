@@ -26,6 +26,9 @@
 #include "indidevapi.h"
 #include "indibasetypes.h"
 #include "indimacros.h"
+#include "framepool.h"
+
+#include <chrono>
 #include <memory>
 
 /**
@@ -46,6 +49,16 @@
 
    It is highly recommended to implement the streaming functionality in a dedicated thread.
 
+   newFrame() copies the frame into a buffer of the stream. Drivers may avoid this copy by capturing directly into a buffer
+   returned by acquireFrame(), then passing it to newFrame(). Buffers are recycled, and their total size is bounded by the
+   LIMITS_BUFFER_MAX limit. Memory of the device, such as memory mapped V4L2 buffers, may also be passed with
+   FramePool::wrap(), it is handed back to the device once the stream is done with the frame.
+
+   Frames are timestamped when newFrame() is called, unless the driver passes the time the frame was captured, such as the
+   timestamp of a V4L2 buffer or the time reported by the camera SDK. The timestamp follows the frame to the recorder and
+   to the STREAM_FRAME_INFO property sent before each preview. STREAM_TIMING and STREAM_TIMING_HISTOGRAM report the jitter
+   of the timestamps and the latency from capture to recording.
+
    \section Encoders
 
    Encoders are responsible for encoding the frame and transmitting it to the client. The CCD1 BLOB format is set to the desired format.
@@ -117,6 +130,30 @@ class StreamManager
          */
         void newFrame(const uint8_t *buffer, uint32_t nbytes);
 
+        /**
+         * @brief newFrame Stream or record a frame captured at timestamp.
+         * @param timestamp UTC time the frame was captured. Drivers with monotonic capture times should convert them
+         * with the offset between the system and steady clocks.
+         */
+        void newFrame(const uint8_t *buffer, uint32_t nbytes, std::chrono::system_clock::time_point timestamp);
+
+        /**
+         * @brief acquireFrame Get a buffer to capture the next frame into, so it can be passed to newFrame() without a copy.
+         * @param nbytes size of the frame in bytes, as for newFrame().
+         * @return Frame buffer, or an empty handle if the stream buffers are full and the frame must be skipped.
+         */
+        FramePool::Frame acquireFrame(uint32_t nbytes);
+
+        /**
+         * @brief newFrame Stream or record a frame captured into a buffer of acquireFrame().
+         */
+        void newFrame(FramePool::Frame &&frame);
+
+        /**
+         * @brief newFrame Stream or record a frame captured into a buffer of acquireFrame() at timestamp.
+         */
+        void newFrame(FramePool::Frame &&frame, std::chrono::system_clock::time_point timestamp);
+
         bool close();
 
     public:
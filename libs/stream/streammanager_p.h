@@ -28,9 +28,14 @@
 #include "encoder/encodermanager.h"
 #include "fpsmeter.h"
 #include "uniquequeue.h"
+#include "framepool.h"
 #include "gammalut16.h"
+#include "autostretch.h"
+#include "frametiming.h"
 
 #include <atomic>
+#include <chrono>
+#include <condition_variable>
 #include <string>
 #include <map>
 #include <thread>
@@ -109,7 +114,20 @@ class StreamManagerPrivate
         bool ISNewSwitch(const char * dev, const char * name, ISState * states, char * names[], int n);
         bool ISNewNumber(const char * dev, const char * name, double values[], char * names[], int n);
 
-        void newFrame(const uint8_t * buffer, uint32_t nbytes);
+        void newFrame(const uint8_t * buffer, uint32_t nbytes, std::chrono::system_clock::time_point timestamp);
+        void newFrame(FramePool::Frame &&frame, std::chrono::system_clock::time_point timestamp);
+
+        /**
+         * @brief beginFrame Count a new frame from the driver, captured at timestamp.
+         * @return False if the frame is discarded and must not be queued.
+         */
+        bool beginFrame(std::chrono::system_clock::time_point timestamp);
+
+        /** @brief Queue frame for recording and preview, an empty frame is skipped. */
+        void queueFrame(FramePool::Frame &&frame, std::chrono::system_clock::time_point timestamp);
+
+        /** @brief Stop recording once its duration or number of frames is reached. */
+        void endFrame();
 
         bool updateProperties();
         bool setStream(bool enable);
@@ -120,10 +138,35 @@ class StreamManagerPrivate
         bool setPixelFormat(INDI_PIXEL_FORMAT pixelFormat, uint8_t pixelDepth);
 
         /**
-         * @brief Thread processing frames and forwarding to recording and preview
+         * @brief Thread subframing incoming frames and forwarding them to the record and preview stages
          */
         void asyncStreamThread();
 
+        /**
+         * @brief Thread recording frames, it does not wait for the preview
+         */
+        void recordStreamThread();
+
+        /**
+         * @brief Thread downscaling, encoding and uploading preview frames, it does not wait for the recorder
+         */
+        void previewStreamThread();
+
+        /**
+         * @brief Account a frame of a stage and publish the stage counters once per second
+         * @param received time the frame was received from the driver
+         */
+        void updateStage(int stage, const std::chrono::steady_clock::time_point &received);
+
+        /** @brief Forget the timing of previous frames, when a stream or a recording starts. */
+        void resetTiming();
+
+        /** @brief Publish the jitter and latency of the frames. stageMutex must be held. */
+        void updateTiming();
+
+        /** @brief A frame queued for recording was recorded or dropped. */
+        void recordDone();
+
         // helpers
         static std::string expand(const std::string &fname, const std::map<std::string, std::string> &patterns);
 
@@ -143,9 +186,9 @@ class StreamManagerPrivate
 
         /**
          * @brief recordStream Calls the backend recorder to record a single frame.
-         * @param deltams time in milliseconds since last frame
+         * @param timestamp time the frame was captured
          */
-        bool recordStream(const uint8_t *buffer, uint32_t nbytes, double deltams);
+        bool recordStream(const uint8_t *buffer, uint32_t nbytes, std::chrono::system_clock::time_point timestamp);
 
         void getStreamFrame(uint16_t * x, uint16_t * y, uint16_t * w, uint16_t * h) const;
         void setStreamFrame(uint16_t x, uint16_t y, uint16_t w, uint16_t h);
@@ -204,17 +247,56 @@ class StreamManagerPrivate
         INDI::PropertyView<IBLOB> *imageBP {nullptr};
 
         // Encoder Selector. It's static now but should this implemented as plugin interface?
-        INDI::PropertySwitch EncoderSP {2};
-        enum { ENCODER_RAW, ENCODER_MJPEG };
+        INDI::PropertySwitch EncoderSP {3};
+        enum { ENCODER_RAW, ENCODER_MJPEG, ENCODER_THEORA };
+
+        // Rate control of inter-frame encoders
+        INDI::PropertyNumber EncoderSettingsNP {2};
+        enum { ENCODER_BITRATE, ENCODER_KEYFRAME_INTERVAL };
 
         // Recorder Selector. Static but should be implmeneted as a dynamic plugin interface
-        INDI::PropertySwitch RecorderSP {2};
-        enum { RECORDER_RAW, RECORDER_OGV };
+        INDI::PropertySwitch RecorderSP {3};
+        enum { RECORDER_RAW, RECORDER_LOSSLESS, RECORDER_OGV };
 
         // Limits. Maximum queue size for incoming frames. FPS Limit for preview
         INDI::PropertyNumber LimitsNP {2};
         enum { LIMITS_BUFFER_MAX, LIMITS_PREVIEW_FPS };
 
+        // Frame rate, latency from the driver in ms, and frames dropped by the record and preview stages,
+        // and disk write rate and stalls of the recorder
+        INDI::PropertyNumber StreamStagesNP {8};
+        enum
+        {
+            STAGE_RECORD_FPS,
+            STAGE_RECORD_LATENCY,
+            STAGE_RECORD_DROPPED,
+            STAGE_PREVIEW_FPS,
+            STAGE_PREVIEW_LATENCY,
+            STAGE_PREVIEW_DROPPED,
+            STAGE_RECORD_WRITE_RATE,
+            STAGE_RECORD_STALLS
+        };
+        enum { STAGE_RECORD, STAGE_PREVIEW, STAGE_COUNT };
+
+        // Downscale of 16 bit previews to 8 bit, the fixed gamma curve or a stretch between levels measured on the frames
+        INDI::PropertySwitch StretchSP {4};
+        enum { STRETCH_FIXED_GAMMA, STRETCH_LINEAR, STRETCH_GAMMA, STRETCH_ASINH };
+
+        // Percentiles of the black and white levels, and weight of a new frame when smoothing them
+        INDI::PropertyNumber StretchSettingsNP {3};
+        enum { STRETCH_LOW, STRETCH_HIGH, STRETCH_SMOOTHING };
+
+        // Number and capture time of the frame in the next preview
+        INDI::PropertyNumber FrameInfoNP {2};
+        enum { FRAME_NUMBER, FRAME_TIME };
+
+        // Average interval between capture timestamps, their jitter, and the latency from capture to recording in ms
+        INDI::PropertyNumber TimingNP {4};
+        enum { TIMING_INTERVAL, TIMING_JITTER, TIMING_LATENCY, TIMING_LATENCY_MAX };
+
+        // Frames per jitter bin, then per latency bin, see FrameTiming
+        INDI::PropertyNumber TimingHistogramNP {2 * FrameTiming::BINS};
+
         std::atomic<bool> isStreaming { false };
         std::atomic<bool> isRecording { false };
         std::atomic<bool> isRecordingAboutToClose { false };
@@ -246,18 +328,51 @@ class StreamManagerPrivate
         // Processing for streaming
         typedef struct
         {
-            double time;
-            std::vector<uint8_t> frame;
+            std::chrono::system_clock::time_point timestamp;    // capture time
+            uint64_t sequence;                                  // number of the frame from the driver
+            FramePool::Frame frame;
+            std::chrono::steady_clock::time_point received;
+            bool record;
         } TimeFrame;
 
+        // Buffers of incoming frames, and of their subframes and previews, bounded by LIMITS_BUFFER_MAX
+        FramePool                framePool;
+
         std::thread              framesThread;   // async incoming frames processing
         std::atomic<bool>        framesThreadTerminate {false};
         UniqueQueue<TimeFrame>   framesIncoming;
 
+        // Stages after subframing. Recording keeps the queued frames, the preview only needs the latest one.
+        std::thread              recordThread;
+        std::thread              previewThread;
+        BoundedQueue<TimeFrame>  framesRecord  {1, BoundedQueue<TimeFrame>::DROP_NEWEST};
+        BoundedQueue<TimeFrame>  framesPreview {1, BoundedQueue<TimeFrame>::DROP_OLDEST};
+
+        // Frames queued for recording and not recorded yet, a recording ends once they are written
+        std::mutex               recordPendingMutex;
+        std::condition_variable  recordPendingCondition;
+        size_t                   recordPending {0};
+
+        struct StageCounters
+        {
+            FPSMeter fps;
+            double latency {0};
+            uint32_t frames {0};
+        };
+        StageCounters            stageCounters[STAGE_COUNT];
+        std::mutex               stageMutex;
+
         std::mutex               fastFPSUpdate;
         std::mutex               recordMutex;
 
+        // Jitter is measured on the driver thread, latency on the record thread
+        FrameTiming              frameTiming;
+        std::mutex               timingMutex;
+        std::atomic<uint64_t>    frameSequence {0};
+
         GammaLut16               gammaLut16;
+        AutoStretch              autoStretch;
+        std::mutex               stretchMutex;
 };
 
 }
@@ -0,0 +1,47 @@
+/*
+    Copyright (C) 2026 by the INDI Library contributors
+
+    Ogg/Theora stream helpers
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+*/
+
+#include "theorautils.h"
+
+#include <limits>
+#include <random>
+
+namespace INDI
+{
+
+int theoraGranuleShift(uint32_t keyframeInterval)
+{
+    int bits = 0;
+    for (uint32_t frames = keyframeInterval > 0 ? keyframeInterval - 1 : 0; frames; frames >>= 1)
+        bits++;
+    return bits;
+}
+
+int oggSerialNumber()
+{
+    // Streams started in the same second get different serial numbers, and rand() state is left alone
+    std::random_device device;
+    std::mt19937 generator(device());
+    std::uniform_int_distribution<int> serial(std::numeric_limits<int>::min(), std::numeric_limits<int>::max());
+    return serial(generator);
+}
+
+}
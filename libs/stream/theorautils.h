@@ -0,0 +1,40 @@
+/*
+    Copyright (C) 2026 by the INDI Library contributors
+
+    Ogg/Theora stream helpers
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+*/
+#pragma once
+
+#include <cstdint>
+
+namespace INDI
+{
+
+/**
+ * @brief theoraGranuleShift Key frame granule shift of a Theora stream, the number of bits needed to count the
+ * frames between two key frames.
+ * @param keyframeInterval maximum number of frames between two key frames.
+ */
+int theoraGranuleShift(uint32_t keyframeInterval);
+
+/**
+ * @brief oggSerialNumber Random serial number of a new Ogg logical stream.
+ */
+int oggSerialNumber();
+
+}
@@ -179,3 +179,96 @@ inline void UniqueQueue<T>::abort()
     increase.notify_all();
     decrease.notify_all();
 }
+
+/**
+ * \class BoundedQueue template
+ * \brief The BoundedQueue class is a UniqueQueue holding a limited number of elements.
+ *
+ * Producers never wait for consumers: when the queue is full, push drops either the new element or the oldest one.
+ * Dropped elements are counted, so a slow consumer can be reported without slowing down the producer.
+ */
+template <typename T>
+class BoundedQueue : public UniqueQueue<T>
+{
+    public:
+        enum DropPolicy
+        {
+            DROP_NEWEST, /*!< Keep the queued elements, the pushed one is not moved */
+            DROP_OLDEST  /*!< Discard the oldest element to make room for the pushed one */
+        };
+
+        explicit BoundedQueue(size_t capacity = 1, DropPolicy policy = DROP_NEWEST)
+            : maxSize(capacity > 0 ? capacity : 1)
+            , policy(policy)
+        { }
+
+    public:
+        /**
+         * @brief Move data to queue, or drop an element if the queue is full
+         * @return returns false if an element was dropped
+         */
+        bool push(T &&data);
+
+        /**
+         * @brief Set the maximum number of elements, at least 1
+         */
+        void setCapacity(size_t capacity);
+        size_t capacity() const;
+
+        /**
+         * @brief Number of elements dropped since the last reset
+         */
+        uint64_t dropped() const;
+        void resetDropped();
+
+    protected:
+        size_t     maxSize;
+        DropPolicy policy;
+        uint64_t   droppedCount {0};
+};
+
+template <typename T>
+inline bool BoundedQueue<T>::push(T &&data)
+{
+    std::lock_guard<std::mutex> lock(this->mutex);
+    bool full = this->queue.size() >= maxSize;
+    if (full)
+    {
+        ++droppedCount;
+        if (policy == DROP_NEWEST)
+            return false;
+        while (this->queue.size() >= maxSize)
+            this->queue.pop();
+    }
+    this->queue.push(std::move(data));
+    this->increase.notify_all();
+    return !full;
+}
+
+template <typename T>
+inline void BoundedQueue<T>::setCapacity(size_t capacity)
+{
+    std::lock_guard<std::mutex> lock(this->mutex);
+    maxSize = capacity > 0 ? capacity : 1;
+}
+
+template <typename T>
+inline size_t BoundedQueue<T>::capacity() const
+{
+    std::lock_guard<std::mutex> lock(this->mutex);
+    return maxSize;
+}
+
+template <typename T>
+inline uint64_t BoundedQueue<T>::dropped() const
+{
+    std::lock_guard<std::mutex> lock(this->mutex);
+    return droppedCount;
+}
+
+template <typename T>
+inline void BoundedQueue<T>::resetDropped()
+{
+    std::lock_guard<std::mutex> lock(this->mutex);
+    droppedCount = 0;
+}
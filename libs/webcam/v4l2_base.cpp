@@ -30,7 +30,10 @@
 // PWC framerate support
 #include "pwc-ioctl.h"
 
+#include <algorithm>
 #include <iostream>
+#include <mutex>
+#include <vector>
 
 #include <sys/ioctl.h>
 #include <sys/types.h>
@@ -132,6 +135,55 @@ using namespace std;
 namespace INDI
 {
 
+constexpr unsigned int V4L2_Base::MIN_QUEUED_BUFFERS;
+
+/* Memory mapped buffers lent to the stream, shared with the frames so they can requeue them */
+struct V4L2_Base::LentBuffers
+{
+    std::mutex mutex;
+    int fd {-1};
+    bool streaming {false};
+    std::vector<bool> isLent;
+    unsigned int lentCount {0};
+    /* Mappings released by uninit_device() while lent, unmapped when their frame is released */
+    std::vector<buffer> orphans;
+
+    void release(unsigned int index, void *start)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        lentCount--;
+
+        auto orphan = std::find_if(orphans.begin(), orphans.end(), [start](const buffer & b)
+        {
+            return b.start == start;
+        });
+        if (orphan != orphans.end())
+        {
+            munmap(orphan->start, orphan->length);
+            orphans.erase(orphan);
+            return;
+        }
+
+        isLent[index] = false;
+        if (!streaming || fd == -1)
+            return;
+
+        struct v4l2_buffer buf;
+        CLEAR(buf);
+        buf.type   = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+        buf.memory = V4L2_MEMORY_MMAP;
+        buf.index  = index;
+        int r;
+        do
+        {
+            r = ioctl(fd, VIDIOC_QBUF, &buf);
+        }
+        while (-1 == r && EINTR == errno);
+        if (-1 == r)
+            IDLog("V4L2_Base: failed to requeue buffer %u: %s\n", index, strerror(errno));
+    }
+};
+
 V4L2_Base::V4L2_Base()
 {
     frameRate.numerator   = 1;
@@ -149,6 +201,11 @@ V4L2_Base::V4L2_Base()
     buffers   = nullptr;
     n_buffers = 0;
 
+    lent          = std::make_shared<LentBuffers>();
+    inCallback    = false;
+    frameLent     = false;
+    decodePending = false;
+
     callback = nullptr;
 
     cancrop      = true;
@@ -471,6 +528,9 @@ int V4L2_Base::read_frame(char * errmsg)
     unsigned int i;
     //cerr << "in read Frame" << endl;
 
+    // Replaced by the capture time when the buffer has a usable timestamp
+    frameTimestamp = std::chrono::system_clock::now();
+
     switch (io)
     {
         case IO_METHOD_READ:
@@ -594,6 +654,7 @@ int V4L2_Base::read_frame(char * errmsg)
                 {
                     struct timespec uptime = { 0, 0 };
                     clock_gettime(CLOCK_MONOTONIC, &uptime);
+                    std::chrono::system_clock::time_point now = std::chrono::system_clock::now();
 
                     struct timeval epochtime = { 0, 0 };
                     /*gettimeofday(&epochtime, nullptr); uncomment this to get the timestamp from epoch start */
@@ -616,6 +677,13 @@ int V4L2_Base::read_frame(char * errmsg)
                         DEBUGFDEVICE(deviceName, INDI::Logger::DBG_DEBUG, "%s: unsupported timestamp in frame",
                                      __FUNCTION__);
 
+                    // Monotonic capture time to UTC, the frame is as old on both clocks
+                    std::chrono::nanoseconds age =
+                        std::chrono::seconds(uptime.tv_sec - buf.timestamp.tv_sec) +
+                        std::chrono::nanoseconds(uptime.tv_nsec - buf.timestamp.tv_usec * 1000L);
+                    if (age >= std::chrono::nanoseconds::zero())
+                        frameTimestamp = now - std::chrono::duration_cast<std::chrono::system_clock::duration>(age);
+
                     break;
                 }
 
@@ -629,12 +697,9 @@ int V4L2_Base::read_frame(char * errmsg)
             /* TODO: there is probably a better error handling than asserting the buffer index */
             assert(buf.index < n_buffers);
 
-            if (dodecode)
-            {
-                DEBUGFDEVICE(deviceName, INDI::Logger::DBG_DEBUG, "%s: [%p] decoding %d-byte buffer %p cropset %c",
-                             __FUNCTION__, decoder, buf.bytesused, buffers[buf.index].start, cropset ? 'Y' : 'N');
-                decoder->decode((unsigned char *)(buffers[buf.index].start), &buf);
-            }
+            /* Decoded when the callback requests a decoded buffer, frames lent by lendFrame() may never be */
+            decodePending = dodecode;
+            frameLent     = false;
 
             /*
             if (dorecord)
@@ -647,18 +712,27 @@ int V4L2_Base::read_frame(char * errmsg)
 
             //DEBUGFDEVICE(deviceName, INDI::Logger::DBG_DEBUG,"lxstate is %d, dropFrame %c\n", lxstate, (dropFrame?'Y':'N'));
 
-            /* Requeue buffer */
-            if (-1 == XIOCTL(fd, VIDIOC_QBUF, &buf))
-                return errno_exit("ReadFrame IO_METHOD_MMAP: VIDIOC_QBUF", errmsg);
-
             if (lxstate == LX_ACTIVE)
             {
                 /* Call provided callback function if any */
                 //if (callback && !dorecord)
                 if (callback)
+                {
+                    inCallback = true;
                     (*callback)(uptr);
+                    inCallback = false;
+                }
             }
 
+            /* Requeue buffer, lent buffers are requeued when their frame is released */
+            if (!frameLent && streamactive)
+            {
+                decodeFrame();
+                if (-1 == XIOCTL(fd, VIDIOC_QBUF, &buf))
+                    return errno_exit("ReadFrame IO_METHOD_MMAP: VIDIOC_QBUF", errmsg);
+            }
+            decodePending = false;
+
             if (lxstate == LX_TRIGGERED)
                 lxstate = LX_ACTIVE;
 
@@ -728,6 +802,11 @@ int V4L2_Base::stop_capturing(char * errmsg)
                 selectCallBackID = -1;
             }
             streamactive = false;
+            {
+                /* Frames released from now on leave their buffer to start_capturing */
+                std::lock_guard<std::mutex> lock(lent->mutex);
+                lent->streaming = false;
+            }
             if (-1 == XIOCTL(fd, VIDIOC_STREAMOFF, &type))
                 return errno_exit("VIDIOC_STREAMOFF", errmsg);
             break;
@@ -752,10 +831,16 @@ int V4L2_Base::start_capturing(char * errmsg)
             break;
 
         case IO_METHOD_MMAP:
+        {
+            std::lock_guard<std::mutex> lock(lent->mutex);
             for (i = 0; i < n_buffers; ++i)
             {
                 struct v4l2_buffer buf;
 
+                /* Buffers still lent to the stream are queued when released */
+                if (i < lent->isLent.size() && lent->isLent[i])
+                    continue;
+
                 CLEAR(buf);
 
                 buf.type   = V4L2_BUF_TYPE_VIDEO_CAPTURE;
@@ -770,11 +855,12 @@ int V4L2_Base::start_capturing(char * errmsg)
             type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
             if (-1 == XIOCTL(fd, VIDIOC_STREAMON, &type))
                 return errno_exit("VIDIOC_STREAMON", errmsg);
+            lent->streaming = true;
 
             selectCallBackID = IEAddCallback(fd, newFrame, this);
             streamactive     = true;
-
-            break;
+        }
+        break;
 
         case IO_METHOD_USERPTR:
             for (i = 0; i < n_buffers; ++i)
@@ -805,6 +891,45 @@ int V4L2_Base::start_capturing(char * errmsg)
     return 0;
 }
 
+INDI::FramePool::Frame V4L2_Base::lendFrame()
+{
+    if (!inCallback || frameLent || io != IO_METHOD_MMAP || cropset || is_compressed())
+        return INDI::FramePool::Frame();
+
+    /* Only packed rows, padding would have to be removed by a copy anyway */
+    size_t pixels = static_cast<size_t>(fmt.fmt.pix.width) * fmt.fmt.pix.height;
+    if (pixels == 0 || buf.bytesused % pixels != 0 ||
+            fmt.fmt.pix.bytesperline != fmt.fmt.pix.width * (buf.bytesused / pixels))
+        return INDI::FramePool::Frame();
+
+    std::lock_guard<std::mutex> lock(lent->mutex);
+    if (buf.index >= lent->isLent.size() || lent->lentCount + 1 + MIN_QUEUED_BUFFERS > n_buffers)
+        return INDI::FramePool::Frame();
+
+    unsigned int index = buf.index;
+    void *start        = buffers[index].start;
+    lent->isLent[index] = true;
+    lent->lentCount++;
+    frameLent = true;
+
+    std::shared_ptr<LentBuffers> state = lent;
+    return INDI::FramePool::wrap(static_cast<uint8_t *>(start), buf.bytesused, [state, index, start]()
+    {
+        state->release(index, start);
+    });
+}
+
+void V4L2_Base::decodeFrame()
+{
+    if (!decodePending)
+        return;
+    decodePending = false;
+
+    DEBUGFDEVICE(deviceName, INDI::Logger::DBG_DEBUG, "%s: [%p] decoding %d-byte buffer %p cropset %c",
+                 __FUNCTION__, decoder, buf.bytesused, buffers[buf.index].start, cropset ? 'Y' : 'N');
+    decoder->decode((unsigned char *)(buffers[buf.index].start), &buf);
+}
+
 void V4L2_Base::newFrame(int /*fd*/, void * p)
 {
     char errmsg[ERRMSGSIZ];
@@ -821,10 +946,22 @@ int V4L2_Base::uninit_device(char * errmsg)
             break;
 
         case IO_METHOD_MMAP:
+        {
+            std::lock_guard<std::mutex> lock(lent->mutex);
             for (unsigned int i = 0; i < n_buffers; ++i)
+            {
+                /* Frames still in use unmap their buffer when released */
+                if (i < lent->isLent.size() && lent->isLent[i])
+                {
+                    lent->orphans.push_back(buffers[i]);
+                    continue;
+                }
                 if (-1 == munmap(buffers[i].start, buffers[i].length))
                     return errno_exit("munmap", errmsg);
-            break;
+            }
+            lent->isLent.clear();
+        }
+        break;
 
         case IO_METHOD_USERPTR:
             for (unsigned int i = 0; i < n_buffers; ++i)
@@ -919,6 +1056,10 @@ int V4L2_Base::init_mmap(char * errmsg)
             return errno_exit("mmap", errmsg);
     }
 
+    std::lock_guard<std::mutex> lock(lent->mutex);
+    lent->fd = fd;
+    lent->isLent.assign(n_buffers, false);
+
     return 0;
 }
 
@@ -1337,6 +1478,12 @@ void V4L2_Base::close_device()
     char errmsg[ERRMSGSIZ];
     uninit_device(errmsg);
 
+    {
+        std::lock_guard<std::mutex> lock(lent->mutex);
+        lent->fd        = -1;
+        lent->streaming = false;
+    }
+
     if (-1 == close(fd))
         errno_exit("close", errmsg);
 
@@ -1942,16 +2089,19 @@ void V4L2_Base::setColorProcessing(bool quantization, bool colorconvert, bool li
 
 unsigned char * V4L2_Base::getY()
 {
+    decodeFrame();
     return decoder->getY();
 }
 
 unsigned char * V4L2_Base::getU()
 {
+    decodeFrame();
     return decoder->getU();
 }
 
 unsigned char * V4L2_Base::getV()
 {
+    decodeFrame();
     return decoder->getV();
 }
 
@@ -1962,11 +2112,13 @@ unsigned char * V4L2_Base::getV()
 
 unsigned char * V4L2_Base::getRGBBuffer()
 {
+    decodeFrame();
     return decoder->getRGBBuffer();
 }
 
 float * V4L2_Base::getLinearY()
 {
+    decodeFrame();
     return decoder->getLinearY();
 }
 
@@ -36,7 +36,9 @@
 
 #include <stdio.h>
 #include <cstdlib>
+#include <chrono>
 #include <map>
+#include <memory>
 
 #include <dirent.h>
 #include <linux/videodev2.h>
@@ -103,6 +105,26 @@ class V4L2_Base
         unsigned char *getRGBBuffer();
         float *getLinearY();
 
+        /** @return UTC time the last frame was captured, from the buffer timestamp when the device provides one. */
+        std::chrono::system_clock::time_point getFrameTimestamp() const
+        {
+            return frameTimestamp;
+        }
+
+        /**
+         * @brief Lend the memory mapped buffer of the frame being delivered to the callback, without copying it.
+         *
+         * The buffer is requeued to the device when the last copy of the frame is released, instead of after the
+         * callback, and the frame is not decoded unless getY() or another decoded buffer is requested. Only valid
+         * from the callback.
+         * @return The frame as captured, or an empty frame if the device does not use memory mapped buffers, the
+         * frame is soft cropped or padded, or lending it would leave less than MIN_QUEUED_BUFFERS to the device.
+         */
+        INDI::FramePool::Frame lendFrame();
+
+        /** Buffers kept queued to the device, frames are copied rather than lent below this */
+        static constexpr unsigned int MIN_QUEUED_BUFFERS = 2;
+
         void registerCallback(WPF *fp, void *ud);
 
         int start_capturing(char *errmsg);
@@ -170,6 +192,7 @@ class V4L2_Base
         void init_read(unsigned int buffer_size);
 
         void findMinMax();
+        void decodeFrame();
 
         int enumeratedInputs;
         int enumeratedCaptureFormats;
@@ -185,6 +208,7 @@ class V4L2_Base
         struct v4l2_format fmt;
         struct v4l2_input input;
         struct v4l2_buffer buf;
+        std::chrono::system_clock::time_point frameTimestamp;
 
         bool cancrop;
         bool cropset;
@@ -209,6 +233,13 @@ class V4L2_Base
         struct buffer *buffers;
         unsigned int n_buffers;
         bool reallocate_buffers;
+
+        /* Memory mapped buffers lent to the stream, shared with the frames requeuing them */
+        struct LentBuffers;
+        std::shared_ptr<LentBuffers> lent;
+        bool inCallback;
+        bool frameLent;
+        bool decodePending;
         //int		dropFrame;
         //bool      dropFrameEnabled;
         //unsigned int      dropFrameCount;
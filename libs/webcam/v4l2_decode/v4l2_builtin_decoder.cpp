@@ -61,6 +61,7 @@
 
 //#include "indilogger.h"
 #include "ccvt.h"
+#include "colorconvert.h"
 #include "v4l2_colorspace.h"
 
 #include <cstring> // memcpy
@@ -322,57 +323,18 @@ void V4L2_Builtin_Decoder::decode(unsigned char *frame, struct v4l2_buffer *buf)
         case V4L2_PIX_FMT_VYUY:
         case V4L2_PIX_FMT_YVYU:
         {
-            unsigned char *src = nullptr;
-            unsigned char *dest = yuyvBuffer;
-            unsigned char *s = nullptr, *s1 = nullptr, *s2 = nullptr, *s3 = nullptr, *s4 = nullptr;
+            unsigned char *src = frame;
+            INDI::PackedYUVOrder order = INDI::PACKED_UYVY;
 
             if (useSoftCrop && doCrop)
-            {
                 src = frame + 2 * (crop.c.left) + (crop.c.top * fmt.fmt.pix.bytesperline);
-                //IDLog("Decoding UYVY with cropping %dx%d frame at %lx\n", width, height, src);
-            }
-            else
-            {
-                src = frame;
-                //IDLog("Decoding UYVY  %dx%d frame at %lx\n", width, height, src);
-            }
-            for (int i = 0; i < (int)bufheight; i++)
-            {
-                s = src;
-                switch (fmt.fmt.pix.pixelformat)
-                {
-                    case V4L2_PIX_FMT_UYVY:
-                        s1 = (s + 1);
-                        s2 = (s);
-                        s3 = (s + 3);
-                        s4 = (s + 2);
-                        break;
-                    case V4L2_PIX_FMT_VYUY:
-                        s1 = (s + 1);
-                        s2 = (s + 2);
-                        s3 = (s + 3);
-                        s4 = (s);
-                        break;
-                    case V4L2_PIX_FMT_YVYU:
-                        s1 = (s);
-                        s2 = (s + 3);
-                        s3 = (s + 2);
-                        s4 = (s + 1);
-                        break;
-                }
-                for (int j = 0; j < (int)(bufwidth / 2); j++)
-                {
-                    *(dest++) = *(s1);
-                    *(dest++) = *(s2);
-                    *(dest++) = *(s3);
-                    *(dest++) = *(s4);
-                    s1 += 4;
-                    s2 += 4;
-                    s3 += 4;
-                    s4 += 4;
-                }
-                src += fmt.fmt.pix.bytesperline;
-            }
+
+            if (fmt.fmt.pix.pixelformat == V4L2_PIX_FMT_VYUY)
+                order = INDI::PACKED_VYUY;
+            else if (fmt.fmt.pix.pixelformat == V4L2_PIX_FMT_YVYU)
+                order = INDI::PACKED_YVYU;
+
+            INDI::packedYUVToYUYV(src, fmt.fmt.pix.bytesperline, yuyvBuffer, bufwidth, bufheight, order);
         }
         break;
 
@@ -453,18 +415,18 @@ void V4L2_Builtin_Decoder::decode(unsigned char *frame, struct v4l2_buffer *buf)
         break;
 
         case V4L2_PIX_FMT_SBGGR8:
-            bayer2rgb24(rgb24_buffer, frame, fmt.fmt.pix.width, fmt.fmt.pix.height);
+            INDI::bayerToRGB24(frame, rgb24_buffer, fmt.fmt.pix.width, fmt.fmt.pix.height, INDI::BAYER_BGGR);
             break;
 
         case V4L2_PIX_FMT_SRGGB8:
-            bayer_rggb_2rgb24(rgb24_buffer, frame, fmt.fmt.pix.width, fmt.fmt.pix.height);
+            INDI::bayerToRGB24(frame, rgb24_buffer, fmt.fmt.pix.width, fmt.fmt.pix.height, INDI::BAYER_RGGB);
             break;
         case V4L2_PIX_FMT_SGRBG8:
             bayer_grbg_to_rgb24(rgb24_buffer, frame, fmt.fmt.pix.width, fmt.fmt.pix.height);
             break;
         case V4L2_PIX_FMT_SBGGR16:
-            bayer16_2_rgb24((unsigned short *)rgb24_buffer, (unsigned short *)frame, fmt.fmt.pix.width,
-                            fmt.fmt.pix.height);
+            INDI::bayer16ToRGB48(reinterpret_cast<uint16_t *>(frame), reinterpret_cast<uint16_t *>(rgb24_buffer),
+                                 fmt.fmt.pix.width, fmt.fmt.pix.height, INDI::BAYER_BGGR);
             break;
 
         case V4L2_PIX_FMT_JPEG:
@@ -654,14 +616,14 @@ void V4L2_Builtin_Decoder::makeY()
         case V4L2_PIX_FMT_SBGGR8:
         case V4L2_PIX_FMT_SRGGB8:
         case V4L2_PIX_FMT_SGRBG8:
-            RGB2YUV(bufwidth, bufheight, rgb24_buffer, YBuf, UBuf, VBuf, 0);
+            INDI::rgb24ToYUV420p(rgb24_buffer, YBuf, UBuf, VBuf, bufwidth, bufheight, true, true);
             break;
         case V4L2_PIX_FMT_YUYV:
         case V4L2_PIX_FMT_UYVY:
         case V4L2_PIX_FMT_VYUY:
         case V4L2_PIX_FMT_YVYU:
             // todo handcopy only Ybuf using an int, byfwidth should be even
-            ccvt_yuyv_420p(bufwidth, bufheight, yuyvBuffer, YBuf, UBuf, VBuf);
+            INDI::yuyvToYUV420p(yuyvBuffer, YBuf, UBuf, VBuf, bufwidth, bufheight);
             break;
     }
 }
@@ -816,7 +778,7 @@ unsigned char *V4L2_Builtin_Decoder::getRGBBuffer()
             //if (!colorBuffer) colorBuffer = new unsigned char[(bufwidth * bufheight) * 4];
             //ccvt_yuyv_bgr32(bufwidth, bufheight, yuyvBuffer, rgb24_buffer);
             //ccvt_bgr32_rgb24(bufwidth, bufheight, colorBuffer, (void*)rgb24_buffer);
-            ccvt_yuyv_rgb24(bufwidth, bufheight, yuyvBuffer, (void *)rgb24_buffer);
+            INDI::yuyvToRGB24(yuyvBuffer, rgb24_buffer, bufwidth, bufheight);
             break;
         case V4L2_PIX_FMT_RGB24:
         case V4L2_PIX_FMT_RGB555:
@@ -0,0 +1,121 @@
+/*******************************************************************************
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Library General Public
+ License version 2 as published by the Free Software Foundation.
+ .
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Library General Public License for more details.
+ .
+ You should have received a copy of the GNU Library General Public License
+ along with this library; see the file COPYING.LIB.  If not, write to
+ the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ Boston, MA 02110-1301, USA.
+*******************************************************************************/
+
+/*
+ * Compare software binning of 16 bit frames with the previous CCDChip::binFrame() implementation.
+ *
+ * Usage: bench_binning [width height [iterations]]
+ */
+
+#include "libs/indibase/indibinning.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+// CCDChip::binFrame() 16 bit path before the binning engine was introduced
+static void legacyBinFrame16(const uint16_t *RawFrame16, uint16_t *bin_buf, uint32_t SubW, uint32_t SubH, int BinX)
+{
+    uint16_t val;
+
+    for (uint32_t i = 0; i < SubH; i += BinX)
+        for (uint32_t j = 0; j < SubW; j += BinX)
+        {
+            for (int k = 0; k < BinX; k++)
+            {
+                for (int l = 0; l < BinX; l++)
+                {
+                    val = *(RawFrame16 + j + (i + k) * SubW + l);
+                    if (val + *bin_buf > UINT16_MAX)
+                        *bin_buf = UINT16_MAX;
+                    else
+                        *bin_buf += val;
+                }
+            }
+            bin_buf++;
+        }
+}
+
+template <typename F>
+static double averageMilliseconds(int iterations, F function)
+{
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i++)
+        function();
+    std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count() / iterations;
+}
+
+int main(int argc, char *argv[])
+{
+    uint32_t width = 9576, height = 6388;
+    int iterations = 5;
+
+    if (argc >= 3)
+    {
+        width  = static_cast<uint32_t>(atoi(argv[1]));
+        height = static_cast<uint32_t>(atoi(argv[2]));
+    }
+    if (argc >= 4)
+        iterations = std::max(1, atoi(argv[3]));
+
+    std::vector<uint16_t> frame(static_cast<size_t>(width) * height);
+    uint32_t seed = 1;
+    for (auto &value : frame)
+    {
+        seed = seed * 1103515245 + 12345;
+        value = 1000 + (seed >> 16) % 4096;
+    }
+
+    std::vector<uint16_t> legacy(frame.size()), binned(frame.size());
+
+    printf("16 bit %ux%u frame, %d iterations\n", width, height, iterations);
+    printf("%-6s %12s %12s %12s %8s\n", "bin", "legacy ms", "1 thread ms", "threads ms", "match");
+
+    for (uint32_t bin = 2; bin <= 4; bin++)
+    {
+        // Legacy code writes past the last output row when the frame size is not a multiple of the binning
+        uint32_t subW = width - width % bin, subH = height - height % bin;
+
+        double legacyTime = averageMilliseconds(iterations, [&]()
+        {
+            memset(legacy.data(), 0, legacy.size() * sizeof(uint16_t));
+            legacyBinFrame16(frame.data(), legacy.data(), subW, subH, bin);
+        });
+
+        double singleTime = averageMilliseconds(iterations, [&]()
+        {
+            INDI::binPixels(reinterpret_cast<const uint8_t *>(frame.data()), reinterpret_cast<uint8_t *>(binned.data()),
+                            subW, subH, bin, bin, 16, false, false, 1);
+        });
+
+        double threadedTime = averageMilliseconds(iterations, [&]()
+        {
+            INDI::binPixels(reinterpret_cast<const uint8_t *>(frame.data()), reinterpret_cast<uint8_t *>(binned.data()),
+                            subW, subH, bin, bin, 16, false);
+        });
+
+        size_t outputSize = static_cast<size_t>(subW / bin) * (subH / bin);
+        bool match = memcmp(legacy.data(), binned.data(), outputSize * sizeof(uint16_t)) == 0;
+
+        printf("%ux%-4u %12.1f %12.1f %12.1f %8s\n", bin, bin, legacyTime, singleTime, threadedTime, match ? "yes" : "NO");
+    }
+
+    return 0;
+}
@@ -0,0 +1,132 @@
+/*******************************************************************************
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Library General Public
+ License version 2 as published by the Free Software Foundation.
+ .
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Library General Public License for more details.
+ .
+ You should have received a copy of the GNU Library General Public License
+ along with this library; see the file COPYING.LIB.  If not, write to
+ the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ Boston, MA 02110-1301, USA.
+*******************************************************************************/
+
+/*
+ * Measure the cost per frame of calibrating 16 bit frames with master bias, dark and flat frames, compared
+ * with a plain scalar loop.
+ *
+ * Usage: bench_calibration [width height [iterations]]
+ */
+
+#include "libs/indibase/indicalibration.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+// Straightforward calibration, as a client would do it
+static void scalarCalibration(uint16_t *frame, const float *bias, const float *dark, const float *flat, double k,
+                              double flatMean, size_t count)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        double value = (frame[i] - bias[i] - k * (dark[i] - bias[i])) * flatMean / flat[i];
+        frame[i] = static_cast<uint16_t>(std::min(std::max(std::floor(value + 0.5), 0.0), 65535.0));
+    }
+}
+
+template <typename F>
+static double averageMilliseconds(int iterations, F function)
+{
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i++)
+        function();
+    std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count() / iterations;
+}
+
+int main(int argc, char *argv[])
+{
+    uint32_t width = 9576, height = 6388;
+    int iterations = 5;
+
+    if (argc >= 3)
+    {
+        width  = static_cast<uint32_t>(atoi(argv[1]));
+        height = static_cast<uint32_t>(atoi(argv[2]));
+    }
+    if (argc >= 4)
+        iterations = std::max(1, atoi(argv[3]));
+
+    size_t count = static_cast<size_t>(width) * height;
+    std::vector<float> bias(count), dark(count), flat(count);
+    std::vector<uint16_t> frame(count);
+    uint32_t seed = 1;
+    for (size_t i = 0; i < count; i++)
+    {
+        seed = seed * 1103515245 + 12345;
+        bias[i]  = 500 + (seed >> 16) % 16;
+        dark[i]  = bias[i] + (seed >> 20) % 32;
+        flat[i]  = 20000 + (seed >> 12) % 2000;
+        frame[i] = 1000 + (seed >> 8) % 4096;
+    }
+
+    double flatMean = 0;
+    for (float value : flat)
+        flatMean += value;
+    flatMean /= count;
+
+    INDI::FrameCalibration calibration;
+    std::string error;
+    calibration.setMaster(INDI::FrameCalibration::MASTER_BIAS, bias.data(), width, height, 0, "bias", error);
+    calibration.setMaster(INDI::FrameCalibration::MASTER_DARK, dark.data(), width, height, 60, "dark", error);
+    calibration.setMaster(INDI::FrameCalibration::MASTER_FLAT, flat.data(), width, height, 0, "flat", error);
+
+    // Frames are calibrated in place, so each iteration works on a fresh copy. The copy is timed separately.
+    std::vector<uint16_t> work(count);
+    double copyTime = averageMilliseconds(iterations, [&]()
+    {
+        work = frame;
+    });
+
+    double scalarTime = averageMilliseconds(iterations, [&]()
+    {
+        work = frame;
+        scalarCalibration(work.data(), bias.data(), dark.data(), flat.data(), 2, flatMean, count);
+    }) - copyTime;
+    std::vector<uint16_t> expected = work;
+
+    // The first call builds the offset for the exposure time, it is not part of the per frame cost
+    work = frame;
+    calibration.apply(reinterpret_cast<uint8_t *>(work.data()), width, height, 16, 0, 0, 120, 1);
+
+    double singleTime = averageMilliseconds(iterations, [&]()
+    {
+        work = frame;
+        calibration.apply(reinterpret_cast<uint8_t *>(work.data()), width, height, 16, 0, 0, 120, 1);
+    }) - copyTime;
+
+    double threadedTime = averageMilliseconds(iterations, [&]()
+    {
+        work = frame;
+        calibration.apply(reinterpret_cast<uint8_t *>(work.data()), width, height, 16, 0, 0, 120);
+    }) - copyTime;
+
+    size_t mismatches = 0;
+    for (size_t i = 0; i < count; i++)
+        if (std::abs(static_cast<int>(work[i]) - static_cast<int>(expected[i])) > 1)
+            mismatches++;
+
+    printf("16 bit %ux%u frame, bias + scaled dark + flat, %d iterations\n", width, height, iterations);
+    printf("%12s %12s %12s %12s\n", "scalar ms", "1 thread ms", "threads ms", "mismatches");
+    printf("%12.1f %12.1f %12.1f %12zu\n", scalarTime, singleTime, threadedTime, mismatches);
+
+    return 0;
+}
@@ -0,0 +1,128 @@
+/*******************************************************************************
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Library General Public
+ License version 2 as published by the Free Software Foundation.
+ .
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Library General Public License for more details.
+ .
+ You should have received a copy of the GNU Library General Public License
+ along with this library; see the file COPYING.LIB.  If not, write to
+ the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ Boston, MA 02110-1301, USA.
+*******************************************************************************/
+
+
+/*
+ * Compare the V4L2 decoder conversions of ccvt with their vectorized versions, on one thread and on all cores.
+ *
+ * Usage: bench_colorconvert [width height [iterations]]
+ */
+
+#include "libs/stream/ccvt.h"
+#include "libs/stream/colorconvert.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <vector>
+
+template <typename F>
+static double averageMilliseconds(int iterations, F function)
+{
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i++)
+        function();
+    std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count() / iterations;
+}
+
+int main(int argc, char *argv[])
+{
+    uint32_t width = 1920, height = 1080;
+    int iterations = 50;
+
+    if (argc >= 3)
+    {
+        width  = static_cast<uint32_t>(atoi(argv[1])) & ~1u;
+        height = static_cast<uint32_t>(atoi(argv[2])) & ~1u;
+    }
+    if (argc >= 4)
+        iterations = std::max(1, atoi(argv[3]));
+
+    const size_t pixels = static_cast<size_t>(width) * height;
+    std::vector<uint8_t> frame(6 * pixels);
+    uint32_t seed = 1;
+    for (auto &value : frame)
+    {
+        seed = seed * 1103515245 + 12345;
+        value = static_cast<uint8_t>(seed >> 16);
+    }
+    uint16_t *frame16 = reinterpret_cast<uint16_t *>(frame.data());
+    std::vector<uint8_t> output(6 * pixels), y(pixels), u(pixels / 4), v(pixels / 4);
+    uint16_t *output16 = reinterpret_cast<uint16_t *>(output.data());
+
+    printf("%ux%u frame, %d iterations\n", width, height, iterations);
+    printf("%-16s %10s %10s %10s\n", "conversion", "ccvt ms", "1 thread", "threads");
+
+    auto report = [&](const char *name, const std::function<void()> &legacy,
+                      const std::function<void(unsigned int)> &vectorized)
+    {
+        double legacyTime = averageMilliseconds(iterations, legacy);
+        double singleTime = averageMilliseconds(iterations, [&]()
+        {
+            vectorized(1);
+        });
+        double threadedTime = averageMilliseconds(iterations, [&]()
+        {
+            vectorized(0);
+        });
+        printf("%-16s %10.2f %10.2f %10.2f\n", name, legacyTime, singleTime, threadedTime);
+    };
+
+    report("YUYV to RGB24", [&]()
+    {
+        ccvt_yuyv_rgb24(width, height, frame.data(), output.data());
+    }, [&](unsigned int threads)
+    {
+        INDI::yuyvToRGB24(frame.data(), output.data(), width, height, threads);
+    });
+
+    report("YUYV to 420p", [&]()
+    {
+        ccvt_yuyv_420p(width, height, frame.data(), y.data(), u.data(), v.data());
+    }, [&](unsigned int threads)
+    {
+        INDI::yuyvToYUV420p(frame.data(), y.data(), u.data(), v.data(), width, height, threads);
+    });
+
+    report("BGGR8 to RGB24", [&]()
+    {
+        bayer2rgb24(output.data(), frame.data(), width, height);
+    }, [&](unsigned int threads)
+    {
+        INDI::bayerToRGB24(frame.data(), output.data(), width, height, INDI::BAYER_BGGR, threads);
+    });
+
+    report("BGGR16 to RGB48", [&]()
+    {
+        bayer16_2_rgb24(output16, frame16, width, height);
+    }, [&](unsigned int threads)
+    {
+        INDI::bayer16ToRGB48(frame16, output16, width, height, INDI::BAYER_BGGR, threads);
+    });
+
+    report("RGB24 to 420p", [&]()
+    {
+        RGB2YUV(width, height, frame.data(), y.data(), u.data(), v.data(), 0);
+    }, [&](unsigned int threads)
+    {
+        INDI::rgb24ToYUV420p(frame.data(), y.data(), u.data(), v.data(), width, height, true, true, threads);
+    });
+
+    return 0;
+}
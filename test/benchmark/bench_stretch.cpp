@@ -0,0 +1,101 @@
+/*******************************************************************************
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Library General Public
+ License version 2 as published by the Free Software Foundation.
+ .
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Library General Public License for more details.
+ .
+ You should have received a copy of the GNU Library General Public License
+ along with this library; see the file COPYING.LIB.  If not, write to
+ the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ Boston, MA 02110-1301, USA.
+*******************************************************************************/
+
+
+/*
+ * Compare the 16 to 8 bit preview downscale of GammaLut16 with the AutoStretch curves.
+ *
+ * Usage: bench_stretch [width height [iterations]]
+ */
+
+#include "libs/stream/gammalut16.h"
+#include "libs/stream/autostretch.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+template <typename F>
+static double averageMilliseconds(int iterations, F function)
+{
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i++)
+        function();
+    std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count() / iterations;
+}
+
+int main(int argc, char *argv[])
+{
+    uint32_t width = 3840, height = 2160;
+    int iterations = 50;
+
+    if (argc >= 3)
+    {
+        width  = static_cast<uint32_t>(atoi(argv[1]));
+        height = static_cast<uint32_t>(atoi(argv[2]));
+    }
+    if (argc >= 4)
+        iterations = std::max(1, atoi(argv[3]));
+
+    std::vector<uint16_t> frame(static_cast<size_t>(width) * height);
+    uint32_t seed = 1;
+    for (auto &value : frame)
+    {
+        seed = seed * 1103515245 + 12345;
+        value = 1000 + (seed >> 16) % 4096;
+    }
+    std::vector<uint8_t> output(frame.size());
+
+    printf("16 bit %ux%u frame, %d iterations\n", width, height, iterations);
+    printf("%-12s %10s %10s\n", "stretch", "ms", "MPix/s");
+
+    auto report = [&](const char *name, double milliseconds)
+    {
+        printf("%-12s %10.2f %10.1f\n", name, milliseconds, frame.size() / milliseconds / 1000);
+    };
+
+    GammaLut16 gammaLut16;
+    report("GammaLut16", averageMilliseconds(iterations, [&]()
+    {
+        gammaLut16.apply(frame.data(), frame.size(), output.data());
+    }));
+
+    const struct
+    {
+        const char *name;
+        INDI::AutoStretch::Curve curve;
+    } curves[] =
+    {
+        {"linear", INDI::AutoStretch::CURVE_LINEAR},
+        {"gamma", INDI::AutoStretch::CURVE_GAMMA},
+        {"asinh", INDI::AutoStretch::CURVE_ASINH},
+    };
+
+    for (const auto &curve : curves)
+    {
+        INDI::AutoStretch stretch;
+        stretch.setCurve(curve.curve);
+        report(curve.name, averageMilliseconds(iterations, [&]()
+        {
+            stretch.apply(frame.data(), frame.size(), output.data());
+        }));
+    }
+
+    return 0;
+}
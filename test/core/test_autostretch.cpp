@@ -0,0 +1,84 @@
+/*******************************************************************************
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Library General Public
+ License version 2 as published by the Free Software Foundation.
+ .
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Library General Public License for more details.
+ .
+ You should have received a copy of the GNU Library General Public License
+ along with this library; see the file COPYING.LIB.  If not, write to
+ the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ Boston, MA 02110-1301, USA.
+*******************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <vector>
+
+#include "libs/stream/autostretch.h"
+
+// 12 bit frame between 200 and 4000, odd size so that the SIMD loops leave a tail
+static std::vector<uint16_t> makeFrame(size_t count)
+{
+    std::vector<uint16_t> frame(count);
+    for (size_t i = 0; i < count; i++)
+        frame[i] = static_cast<uint16_t>(200 + (i * 7919) % 3801);
+    return frame;
+}
+
+TEST(CORE_AUTOSTRETCH, Test_Levels)
+{
+    std::vector<uint16_t> frame = makeFrame(100003);
+    std::vector<uint8_t> output(frame.size());
+
+    INDI::AutoStretch stretch;
+    stretch.setPercentiles(0, 100);
+    stretch.apply(frame.data(), frame.size(), output.data());
+    // Levels are measured on a subsample
+    EXPECT_NEAR(stretch.black(), 200, 10);
+    EXPECT_NEAR(stretch.white(), 4000, 10);
+
+    // The levels use the whole 8 bit range, linearly
+    for (size_t i = 0; i < frame.size(); i++)
+    {
+        double expected = (frame[i] - stretch.black()) * 256 / (stretch.white() - stretch.black() + 1);
+        ASSERT_NEAR(output[i], std::min(255.0, std::max(0.0, expected)), 1.5) << "pixel " << i;
+    }
+
+    // Smoothing moves the levels part of the way to the new frame
+    double black = stretch.black();
+    std::vector<uint16_t> dark(frame.size(), 100);
+    dark[0] = 2100;
+    stretch.setSmoothing(0.5);
+    stretch.apply(dark.data(), dark.size(), output.data());
+    EXPECT_NEAR(stretch.black(), (black + 100) / 2, 1);
+}
+
+TEST(CORE_AUTOSTRETCH, Test_Curves)
+{
+    std::vector<uint16_t> frame = makeFrame(4099);
+    std::vector<uint8_t> output(frame.size());
+
+    for (auto curve : {INDI::AutoStretch::CURVE_LINEAR, INDI::AutoStretch::CURVE_GAMMA, INDI::AutoStretch::CURVE_ASINH})
+    {
+        INDI::AutoStretch stretch;
+        stretch.setCurve(curve);
+        stretch.apply(frame.data(), frame.size(), output.data(), 1000, 3000);
+
+        // Compare with the scalar definition of the curves, pixels are clipped to the levels
+        for (size_t i = 0; i < frame.size(); i++)
+        {
+            double x = std::min(1.0, std::max(0.0, (frame[i] - 1000) / 2001.0));
+            double y = x;
+            if (curve == INDI::AutoStretch::CURVE_GAMMA)
+                y = std::pow(x, 1 / 2.2);
+            else if (curve == INDI::AutoStretch::CURVE_ASINH)
+                y = std::asinh(10 * x) / std::asinh(10);
+            ASSERT_NEAR(output[i], std::min(255.0, y * 256), 2.0) << "curve " << curve << " pixel " << i;
+        }
+    }
+}
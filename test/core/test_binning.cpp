@@ -0,0 +1,142 @@
+/*******************************************************************************
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Library General Public
+ License version 2 as published by the Free Software Foundation.
+ .
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Library General Public License for more details.
+ .
+ You should have received a copy of the GNU Library General Public License
+ along with this library; see the file COPYING.LIB.  If not, write to
+ the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ Boston, MA 02110-1301, USA.
+*******************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include "libs/indibase/indibinning.h"
+
+// Reference binning computed one output pixel at a time
+template <typename T>
+static std::vector<T> referenceBin(const std::vector<T> &pixels, uint32_t width, uint32_t height, uint32_t binX,
+                                   uint32_t binY, bool average, bool bayer)
+{
+    const uint32_t step = bayer ? 2 : 1;
+    const uint32_t outputWidth = width / binX, outputHeight = height / binY;
+    std::vector<T> output(outputWidth * outputHeight);
+
+    for (uint32_t i = 0; i < outputHeight; i++)
+        for (uint32_t j = 0; j < outputWidth; j++)
+        {
+            double sum = 0;
+            uint32_t count = 0;
+            for (uint32_t k = 0; k < binY; k++)
+                for (uint32_t l = 0; l < binX; l++)
+                {
+                    uint32_t y = (i / step) * step * binY + i % step + k * step;
+                    uint32_t x = (j / step) * step * binX + j % step + l * step;
+                    if (x < width && y < height)
+                    {
+                        sum += pixels[y * width + x];
+                        count++;
+                    }
+                }
+
+            if (average)
+                output[i * outputWidth + j] = static_cast<T>(std::floor(sum / count + 0.5));
+            else
+                output[i * outputWidth + j] = static_cast<T>(std::min<double>(sum, std::numeric_limits<T>::max()));
+        }
+
+    return output;
+}
+
+template <typename T>
+static void checkBinning(int bpp, uint32_t maxValue)
+{
+    const uint32_t width = 103, height = 61;
+    std::vector<T> pixels(width * height);
+    uint32_t seed = 1;
+    for (auto &value : pixels)
+    {
+        seed = seed * 1103515245 + 12345;
+        value = static_cast<T>((seed >> 8) % maxValue);
+    }
+
+    for (bool bayer : {false, true})
+        for (bool average : {false, true})
+            for (uint32_t binX = 1; binX <= 4; binX++)
+                for (uint32_t binY = 1; binY <= 4; binY++)
+                    for (unsigned int threads : {1u, 3u})
+                    {
+                        std::vector<T> output((width / binX) * (height / binY));
+                        ASSERT_TRUE(INDI::binPixels(reinterpret_cast<const uint8_t *>(pixels.data()),
+                                                    reinterpret_cast<uint8_t *>(output.data()), width, height, binX, binY,
+                                                    bpp, average, bayer, threads));
+
+                        EXPECT_EQ(output, referenceBin(pixels, width, height, binX, binY, average, bayer))
+                                << "bin " << binX << "x" << binY << (average ? " average" : " sum") << (bayer ? " bayer" : "");
+                    }
+}
+
+TEST(CORE_BINNING, Test_8bit)
+{
+    checkBinning<uint8_t>(8, 256);
+}
+
+TEST(CORE_BINNING, Test_16bit)
+{
+    checkBinning<uint16_t>(16, 65536);
+}
+
+TEST(CORE_BINNING, Test_32bit)
+{
+    checkBinning<uint32_t>(32, 1u << 24);
+}
+
+TEST(CORE_BINNING, Test_Saturation)
+{
+    std::vector<uint16_t> pixels(4 * 4, 40000);
+    std::vector<uint16_t> output(2 * 2);
+
+    ASSERT_TRUE(INDI::binPixels(reinterpret_cast<const uint8_t *>(pixels.data()), reinterpret_cast<uint8_t *>(output.data()),
+                                4, 4, 2, 2, 16, false));
+    for (auto value : output)
+        EXPECT_EQ(value, UINT16_MAX);
+}
+
+TEST(CORE_BINNING, Test_Divisor)
+{
+    // 8 bit frames binned by CCDChip are summed and divided by half the binned pixel count
+    std::vector<uint8_t> pixels(6 * 3);
+    for (size_t i = 0; i < pixels.size(); i++)
+        pixels[i] = static_cast<uint8_t>(40 * (i % 3) + i);
+    std::vector<uint8_t> output(2);
+
+    ASSERT_TRUE(INDI::binPixels(pixels.data(), output.data(), 6, 3, 3, 3, 8, false, false, 1, 4));
+    auto sums = referenceBin(std::vector<uint32_t>(pixels.begin(), pixels.end()), 6, 3, 3, 3, false, false);
+    for (size_t i = 0; i < output.size(); i++)
+        EXPECT_EQ(output[i], std::min<uint32_t>(sums[i] / 4, UINT8_MAX));
+
+    std::fill(pixels.begin(), pixels.end(), 200);
+    ASSERT_TRUE(INDI::binPixels(pixels.data(), output.data(), 6, 3, 3, 3, 8, false, false, 1, 4));
+    EXPECT_EQ(output[0], UINT8_MAX);
+}
+
+TEST(CORE_BINNING, Test_Invalid)
+{
+    std::vector<uint8_t> pixels(16), output(16);
+
+    EXPECT_FALSE(INDI::binPixels(pixels.data(), output.data(), 4, 4, 2, 2, 12, false));
+    EXPECT_FALSE(INDI::binPixels(pixels.data(), output.data(), 4, 4, 5, 1, 8, false));
+    EXPECT_FALSE(INDI::binPixels(pixels.data(), output.data(), 4, 4, 0, 1, 8, false));
+    EXPECT_FALSE(INDI::binPixels(pixels.data(), output.data(), 4, 4, 2, 2, 8, false, false, 0, 0));
+}
@@ -0,0 +1,193 @@
+/*******************************************************************************
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Library General Public
+ License version 2 as published by the Free Software Foundation.
+ .
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Library General Public License for more details.
+ .
+ You should have received a copy of the GNU Library General Public License
+ along with this library; see the file COPYING.LIB.  If not, write to
+ the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ Boston, MA 02110-1301, USA.
+*******************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include "libs/indibase/indicalibration.h"
+#include "libs/indibase/indifitswriter.h"
+
+static std::vector<float> master(uint32_t width, uint32_t height, float base, float spread, uint32_t seed)
+{
+    std::vector<float> pixels(static_cast<size_t>(width) * height);
+    for (auto &value : pixels)
+    {
+        seed = seed * 1103515245 + 12345;
+        value = base + spread * ((seed >> 16) % 1000) / 1000.0f;
+    }
+    return pixels;
+}
+
+template <typename T>
+static void checkCalibration(int bpp, bool bias, bool dark, bool flat)
+{
+    // Odd sizes exercise both the vector and the scalar loops, and subframes the master offsets
+    const uint32_t masterWidth = 67, masterHeight = 23, width = 45, height = 17, x = 13, y = 5;
+    const double darkExposure = 10, exposure = 25;
+    const double maxValue = std::numeric_limits<T>::max();
+
+    std::vector<float> biasPixels = master(masterWidth, masterHeight, maxValue / 100, maxValue / 50, 1);
+    std::vector<float> darkPixels = master(masterWidth, masterHeight, maxValue / 40, maxValue / 20, 2);
+    std::vector<float> flatPixels = master(masterWidth, masterHeight, 5000, 3000, 3);
+
+    INDI::FrameCalibration calibration;
+    std::string error;
+    if (bias)
+    {
+        ASSERT_TRUE(calibration.setMaster(INDI::FrameCalibration::MASTER_BIAS, biasPixels.data(), masterWidth, masterHeight,
+                                          1, 1, 0, "bias.fits", error));
+    }
+    if (dark)
+    {
+        ASSERT_TRUE(calibration.setMaster(INDI::FrameCalibration::MASTER_DARK, darkPixels.data(), masterWidth, masterHeight,
+                                          1, 1, darkExposure, "dark.fits", error));
+    }
+    if (flat)
+    {
+        ASSERT_TRUE(calibration.setMaster(INDI::FrameCalibration::MASTER_FLAT, flatPixels.data(), masterWidth, masterHeight,
+                                          1, 1, 0, "flat.fits", error));
+    }
+
+    double flatMean = 0;
+    for (float value : flatPixels)
+        flatMean += value;
+    flatMean /= flatPixels.size();
+
+    // Darks are only scaled once the bias can be removed from them
+    double k = (bias && dark) ? exposure / darkExposure : 1;
+    EXPECT_DOUBLE_EQ(calibration.darkScale(exposure), dark ? k : 0);
+
+    std::vector<T> frame(width * height);
+    uint32_t seed = 4;
+    for (auto &value : frame)
+    {
+        seed = seed * 1103515245 + 12345;
+        value = static_cast<T>((seed >> 8) % static_cast<uint64_t>(maxValue + 1));
+    }
+    std::vector<T> calibrated = frame;
+
+    ASSERT_TRUE(calibration.apply(reinterpret_cast<uint8_t *>(calibrated.data()), width, height, bpp, x, y, 1, 1, exposure, 3));
+
+    for (uint32_t row = 0; row < height; row++)
+    {
+        for (uint32_t column = 0; column < width; column++)
+        {
+            size_t i = (y + row) * masterWidth + x + column;
+            double value = frame[row * width + column];
+            if (bias && dark)
+                value -= biasPixels[i] + k * (darkPixels[i] - biasPixels[i]);
+            else if (bias)
+                value -= biasPixels[i];
+            else if (dark)
+                value -= darkPixels[i];
+            if (flat)
+                value *= flatMean / flatPixels[i];
+            value = std::min(std::max(std::floor(value + 0.5), 0.0), maxValue);
+
+            // Single precision arithmetic may round differently
+            ASSERT_NEAR(calibrated[row * width + column], value, maxValue > 65535 ? 2048 : 1)
+                    << "bpp " << bpp << " pixel " << column << "," << row;
+        }
+    }
+}
+
+TEST(CORE_CALIBRATION, Test_Apply)
+{
+    for (int masters = 1; masters < 8; masters++)
+    {
+        bool bias = masters & 1, dark = masters & 2, flat = masters & 4;
+        checkCalibration<uint8_t>(8, bias, dark, flat);
+        checkCalibration<uint16_t>(16, bias, dark, flat);
+        checkCalibration<uint32_t>(32, bias, dark, flat);
+    }
+}
+
+TEST(CORE_CALIBRATION, Test_Masters)
+{
+    INDI::FrameCalibration calibration;
+    std::string error;
+    std::vector<float> pixels = master(32, 16, 100, 10, 1);
+    std::vector<uint16_t> frame(32 * 16, 1000);
+
+    EXPECT_TRUE(calibration.isEmpty());
+    EXPECT_FALSE(calibration.apply(reinterpret_cast<uint8_t *>(frame.data()), 32, 16, 16, 0, 0, 1, 1, 1));
+
+    ASSERT_TRUE(calibration.setMaster(INDI::FrameCalibration::MASTER_BIAS, pixels.data(), 32, 16, 1, 1, 0, "bias.fits", error));
+    EXPECT_EQ(calibration.masterName(INDI::FrameCalibration::MASTER_BIAS), "bias.fits");
+
+    // Masters must all have the same size
+    EXPECT_FALSE(calibration.setMaster(INDI::FrameCalibration::MASTER_DARK, pixels.data(), 16, 32, 1, 1, 10, "dark.fits", error));
+    EXPECT_FALSE(error.empty());
+    EXPECT_FALSE(calibration.hasMaster(INDI::FrameCalibration::MASTER_DARK));
+
+    // The frame must fit in the masters
+    EXPECT_FALSE(calibration.apply(reinterpret_cast<uint8_t *>(frame.data()), 32, 16, 16, 1, 0, 1, 1, 1));
+    EXPECT_FALSE(calibration.apply(reinterpret_cast<uint8_t *>(frame.data()), 32, 16, 12, 0, 0, 1, 1, 1));
+
+    // Masters must all have the same binning, and so must the frame
+    EXPECT_FALSE(calibration.setMaster(INDI::FrameCalibration::MASTER_DARK, pixels.data(), 32, 16, 2, 2, 10, "dark.fits", error));
+    EXPECT_FALSE(calibration.hasMaster(INDI::FrameCalibration::MASTER_DARK));
+    EXPECT_FALSE(calibration.apply(reinterpret_cast<uint8_t *>(frame.data()), 16, 8, 16, 0, 0, 2, 2, 1));
+    EXPECT_TRUE(calibration.apply(reinterpret_cast<uint8_t *>(frame.data()), 16, 8, 16, 0, 0, 1, 1, 1));
+
+    // A flat without signal cannot be used
+    std::vector<float> black(32 * 16, 0);
+    EXPECT_FALSE(calibration.setMaster(INDI::FrameCalibration::MASTER_FLAT, black.data(), 32, 16, 1, 1, 0, "flat.fits", error));
+
+    calibration.clearMaster(INDI::FrameCalibration::MASTER_BIAS);
+    EXPECT_TRUE(calibration.isEmpty());
+    EXPECT_TRUE(calibration.masterName(INDI::FrameCalibration::MASTER_BIAS).empty());
+}
+
+TEST(CORE_CALIBRATION, Test_LoadFITS)
+{
+    long naxes[2] = {40, 30};
+    std::vector<uint16_t> dark(naxes[0] * naxes[1]);
+    for (size_t i = 0; i < dark.size(); i++)
+        dark[i] = static_cast<uint16_t>(100 + i % 50);
+
+    std::vector<std::string> cards = {"EXPTIME =                   60 / Total Exposure Time (s)",
+                                      "XBINNING=                    2 / Binning factor in width",
+                                      "YBINNING=                    2 / Binning factor in height"
+                                     };
+    std::vector<uint8_t> fits(INDI::fitsImageSize(cards.size(), 16, 2, naxes));
+    ASSERT_TRUE(INDI::writeFITSImage(cards, reinterpret_cast<const uint8_t *>(dark.data()), 16, 2, naxes, fits.data(),
+                                     fits.size()));
+
+    INDI::FrameCalibration calibration;
+    std::string error;
+    ASSERT_TRUE(calibration.loadMaster(INDI::FrameCalibration::MASTER_DARK, fits.data(), fits.size(), "dark.fits", error))
+            << error;
+
+    std::vector<uint16_t> frame(dark.size());
+    for (size_t i = 0; i < frame.size(); i++)
+        frame[i] = dark[i] + 500;
+    ASSERT_TRUE(calibration.apply(reinterpret_cast<uint8_t *>(frame.data()), naxes[0], naxes[1], 16, 0, 0, 2, 2, 60));
+
+    for (auto value : frame)
+        ASSERT_EQ(value, 500);
+
+    // The master is binned 2x2, so are frames it calibrates
+    EXPECT_FALSE(calibration.apply(reinterpret_cast<uint8_t *>(frame.data()), naxes[0], naxes[1], 16, 0, 0, 1, 1, 60));
+
+    EXPECT_FALSE(calibration.loadMaster(INDI::FrameCalibration::MASTER_BIAS, fits.data(), 100, "broken.fits", error));
+}
@@ -0,0 +1,178 @@
+/*******************************************************************************
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Library General Public
+ License version 2 as published by the Free Software Foundation.
+ .
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Library General Public License for more details.
+ .
+ You should have received a copy of the GNU Library General Public License
+ along with this library; see the file COPYING.LIB.  If not, write to
+ the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ Boston, MA 02110-1301, USA.
+*******************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "libs/stream/ccvt.h"
+#include "libs/stream/colorconvert.h"
+
+// Frame sizes covering SIMD blocks, scalar tails and borders
+static const std::vector<std::pair<uint32_t, uint32_t>> SIZES = {{2, 2}, {6, 4}, {64, 8}, {130, 6}, {642, 10}, {1282, 4}};
+
+template <typename T>
+static std::vector<T> goldenFrame(size_t count, uint32_t maxValue)
+{
+    std::vector<T> pixels(count);
+    uint32_t seed = 1;
+    for (auto &value : pixels)
+    {
+        seed = seed * 1103515245 + 12345;
+        value = static_cast<T>((seed >> 8) % maxValue);
+    }
+    return pixels;
+}
+
+TEST(CORE_COLORCONVERT, Test_PackedYUV)
+{
+    // Offsets of Y0, U, Y1 and V as read by the V4L2 decoder
+    const std::vector<std::pair<INDI::PackedYUVOrder, std::vector<int>>> orders =
+    {
+        {INDI::PACKED_YUYV, {0, 1, 2, 3}}, {INDI::PACKED_UYVY, {1, 0, 3, 2}},
+        {INDI::PACKED_YVYU, {0, 3, 2, 1}}, {INDI::PACKED_VYUY, {1, 2, 3, 0}}
+    };
+
+    for (auto size : SIZES)
+    {
+        const uint32_t width = size.first, height = size.second;
+        // Rows padded as V4L2 buffers may be
+        const size_t stride = 2 * width + 12;
+        auto frame = goldenFrame<uint8_t>(stride * height, 256);
+
+        for (auto &order : orders)
+        {
+            std::vector<uint8_t> expected(2 * width * height);
+            for (uint32_t row = 0; row < height; row++)
+                for (uint32_t i = 0; i < 2 * width; i++)
+                    expected[2 * width * row + i] = frame[stride * row + (i & ~3u) + order.second[i % 4]];
+
+            for (unsigned int threads : {1u, 3u})
+            {
+                std::vector<uint8_t> output(2 * width * height);
+                INDI::packedYUVToYUYV(frame.data(), stride, output.data(), width, height, order.first, threads);
+                EXPECT_EQ(output, expected) << width << "x" << height << " order " << order.first;
+            }
+        }
+    }
+}
+
+TEST(CORE_COLORCONVERT, Test_YUYV)
+{
+    auto sizes = SIZES;
+    sizes.push_back({7, 5});
+
+    for (auto size : sizes)
+    {
+        const uint32_t width = size.first, height = size.second;
+        auto frame = goldenFrame<uint8_t>(2 * width * height, 256);
+
+        std::vector<uint8_t> expectedRGB(3 * width * height);
+        ccvt_yuyv_rgb24(width, height, frame.data(), expectedRGB.data());
+
+        const uint32_t evenWidth = width - width % 2, evenHeight = height - height % 2;
+        std::vector<uint8_t> expectedY(evenWidth * evenHeight), expectedU(evenWidth * evenHeight / 4),
+            expectedV(evenWidth * evenHeight / 4);
+        ccvt_yuyv_420p(width, height, frame.data(), expectedY.data(), expectedU.data(), expectedV.data());
+
+        for (unsigned int threads : {1u, 3u})
+        {
+            std::vector<uint8_t> rgb(3 * width * height);
+            INDI::yuyvToRGB24(frame.data(), rgb.data(), width, height, threads);
+            EXPECT_EQ(rgb, expectedRGB) << width << "x" << height;
+
+            std::vector<uint8_t> y(expectedY.size()), u(expectedU.size()), v(expectedV.size());
+            INDI::yuyvToYUV420p(frame.data(), y.data(), u.data(), v.data(), width, height, threads);
+            EXPECT_EQ(y, expectedY) << width << "x" << height;
+            EXPECT_EQ(u, expectedU) << width << "x" << height;
+            EXPECT_EQ(v, expectedV) << width << "x" << height;
+        }
+    }
+}
+
+TEST(CORE_COLORCONVERT, Test_Bayer8)
+{
+    for (auto size : SIZES)
+    {
+        const uint32_t width = size.first, height = size.second;
+        auto frame = goldenFrame<uint8_t>(width * height, 256);
+
+        std::vector<uint8_t> expectedBGGR(3 * width * height), expectedRGGB(3 * width * height);
+        bayer2rgb24(expectedBGGR.data(), frame.data(), width, height);
+        bayer_rggb_2rgb24(expectedRGGB.data(), frame.data(), width, height);
+
+        for (unsigned int threads : {1u, 3u})
+        {
+            std::vector<uint8_t> rgb(3 * width * height);
+            INDI::bayerToRGB24(frame.data(), rgb.data(), width, height, INDI::BAYER_BGGR, threads);
+            EXPECT_EQ(rgb, expectedBGGR) << width << "x" << height;
+            INDI::bayerToRGB24(frame.data(), rgb.data(), width, height, INDI::BAYER_RGGB, threads);
+            EXPECT_EQ(rgb, expectedRGGB) << width << "x" << height;
+        }
+    }
+}
+
+TEST(CORE_COLORCONVERT, Test_Bayer16)
+{
+    for (auto size : SIZES)
+    {
+        const uint32_t width = size.first, height = size.second;
+        auto frame = goldenFrame<uint16_t>(width * height, 65536);
+
+        std::vector<uint16_t> expected(3 * width * height);
+        bayer16_2_rgb24(expected.data(), frame.data(), width, height);
+
+        for (unsigned int threads : {1u, 3u})
+        {
+            std::vector<uint16_t> rgb(3 * width * height);
+            INDI::bayer16ToRGB48(frame.data(), rgb.data(), width, height, INDI::BAYER_BGGR, threads);
+            EXPECT_EQ(rgb, expected) << width << "x" << height;
+        }
+    }
+}
+
+TEST(CORE_COLORCONVERT, Test_RGB24ToYUV420p)
+{
+    for (auto size : SIZES)
+    {
+        const uint32_t width = size.first, height = size.second;
+        auto frame = goldenFrame<uint8_t>(3 * width * height, 256);
+
+        for (bool bgr : {true, false})
+            for (bool bottomUp : {true, false})
+            {
+                std::vector<uint8_t> expectedY(width * height), expectedU(width * height / 4), expectedV(width * height / 4);
+                auto convert = bgr ? RGB2YUV : BGR2YUV;
+                ASSERT_EQ(convert(width, height, frame.data(), expectedY.data(), expectedU.data(), expectedV.data(),
+                                  bottomUp ? 0 : 1), 0);
+
+                for (unsigned int threads : {1u, 3u})
+                {
+                    std::vector<uint8_t> y(expectedY.size()), u(expectedU.size()), v(expectedV.size());
+                    ASSERT_TRUE(INDI::rgb24ToYUV420p(frame.data(), y.data(), u.data(), v.data(), width, height, bgr,
+                                                     bottomUp, threads));
+                    EXPECT_EQ(y, expectedY) << width << "x" << height;
+                    EXPECT_EQ(u, expectedU) << width << "x" << height;
+                    EXPECT_EQ(v, expectedV) << width << "x" << height;
+                }
+            }
+    }
+
+    std::vector<uint8_t> frame(3 * 5 * 4), y(5 * 4), u(5 * 4), v(5 * 4);
+    EXPECT_FALSE(INDI::rgb24ToYUV420p(frame.data(), y.data(), u.data(), v.data(), 5, 4, true, true));
+}
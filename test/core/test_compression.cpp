@@ -0,0 +1,149 @@
+/*******************************************************************************
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Library General Public
+ License version 2 as published by the Free Software Foundation.
+ .
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Library General Public License for more details.
+ .
+ You should have received a copy of the GNU Library General Public License
+ along with this library; see the file COPYING.LIB.  If not, write to
+ the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ Boston, MA 02110-1301, USA.
+*******************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include <zlib.h>
+
+#include "libs/indibase/indicompression.h"
+#include "libs/indibase/indifitscompression.h"
+
+static std::vector<uint8_t> testData(size_t size)
+{
+    std::vector<uint8_t> data(size);
+    uint32_t seed = 1;
+    for (size_t i = 0; i < size; i++)
+    {
+        seed = seed * 1103515245 + 12345;
+        // Compressible, but not trivially
+        data[i] = static_cast<uint8_t>((i % 4096) / 16 + ((i % 8 == 0) ? (seed >> 28) : 0));
+    }
+    return data;
+}
+
+// A FITS file holding a single image
+static std::vector<uint8_t> testFITS(int bitpix, int width, int height)
+{
+    std::string header;
+    auto card = [&](const std::string & text)
+    {
+        char line[81];
+        snprintf(line, sizeof(line), "%-80s", text.c_str());
+        header += line;
+    };
+
+    char line[81];
+    card("SIMPLE  =                    T");
+    snprintf(line, sizeof(line), "BITPIX  = %20d", bitpix);
+    card(line);
+    card("NAXIS   =                    2");
+    snprintf(line, sizeof(line), "NAXIS1  = %20d", width);
+    card(line);
+    snprintf(line, sizeof(line), "NAXIS2  = %20d", height);
+    card(line);
+    card("EXPTIME =                  1.5 / Total Exposure Time (s)");
+    card("END");
+    header.resize((header.size() + 2879) / 2880 * 2880, ' ');
+
+    std::vector<uint8_t> fits(header.begin(), header.end());
+    std::vector<uint8_t> data = testData(static_cast<size_t>(width) * height * std::abs(bitpix) / 8);
+    fits.insert(fits.end(), data.begin(), data.end());
+    fits.resize((fits.size() + 2879) / 2880 * 2880, 0);
+    return fits;
+}
+
+TEST(CORE_COMPRESSION, Test_RoundTrip)
+{
+    // Several chunks, the last one partial
+    std::vector<uint8_t> data = testData(9 * 1024 * 1024 + 123);
+
+    for (auto codec : {INDI::COMPRESSION_ZLIB, INDI::COMPRESSION_ZSTD, INDI::COMPRESSION_LZ4})
+    {
+        if (INDI::isCompressionSupported(codec) == false)
+            continue;
+
+        std::vector<uint8_t> compressed;
+        ASSERT_TRUE(INDI::compressBuffer(data.data(), data.size(), codec, 3, compressed, 4));
+        EXPECT_LT(compressed.size(), data.size());
+
+        std::vector<uint8_t> decompressed(data.size());
+        ASSERT_TRUE(INDI::decompressBuffer(compressed.data(), compressed.size(), codec, decompressed.data(),
+                                           decompressed.size()));
+        EXPECT_EQ(decompressed, data) << "codec " << codec;
+
+        // Wrong uncompressed size
+        EXPECT_FALSE(INDI::decompressBuffer(compressed.data(), compressed.size(), codec, decompressed.data(),
+                                            decompressed.size() - 1));
+    }
+}
+
+TEST(CORE_COMPRESSION, Test_ZlibStream)
+{
+    // Chunks compressed in parallel must form a single zlib stream
+    std::vector<uint8_t> data = testData(10 * 1024 * 1024);
+    std::vector<uint8_t> compressed;
+    ASSERT_TRUE(INDI::compressBuffer(data.data(), data.size(), INDI::COMPRESSION_ZLIB, 6, compressed, 3));
+
+    std::vector<uint8_t> decompressed(data.size());
+    uLongf size = decompressed.size();
+    ASSERT_EQ(uncompress(decompressed.data(), &size, compressed.data(), compressed.size()), Z_OK);
+    EXPECT_EQ(size, data.size());
+    EXPECT_EQ(decompressed, data);
+}
+
+TEST(CORE_COMPRESSION, Test_Suffix)
+{
+    INDI::CompressionCodec codec;
+
+    ASSERT_TRUE(INDI::findCompression(".fits.z", codec));
+    EXPECT_EQ(codec, INDI::COMPRESSION_ZLIB);
+    ASSERT_TRUE(INDI::findCompression(".fits.zst", codec));
+    EXPECT_EQ(codec, INDI::COMPRESSION_ZSTD);
+    ASSERT_TRUE(INDI::findCompression(".bin.lz4", codec));
+    EXPECT_EQ(codec, INDI::COMPRESSION_LZ4);
+    EXPECT_FALSE(INDI::findCompression(".fits.fz", codec));
+    EXPECT_FALSE(INDI::findCompression(".fits", codec));
+}
+
+TEST(CORE_COMPRESSION, Test_FITSTiles)
+{
+    std::vector<uint8_t> fits = testFITS(16, 301, 97);
+
+    for (auto compression : {INDI::FITS_TILE_RICE, INDI::FITS_TILE_GZIP2})
+    {
+        std::vector<uint8_t> compressed;
+        ASSERT_TRUE(INDI::compressFITSTiles(fits.data(), fits.size(), compression, 1, compressed, 3));
+        ASSERT_EQ(compressed.size() % 2880, 0u);
+
+        std::string header(compressed.begin() + 2880, compressed.begin() + 2 * 2880);
+        EXPECT_EQ(header.compare(0, 20, "XTENSION= 'BINTABLE'"), 0);
+        EXPECT_NE(header.find("NAXIS2  =                   97"), std::string::npos);
+        EXPECT_NE(header.find("ZNAXIS1 =                  301"), std::string::npos);
+        EXPECT_NE(header.find(compression == INDI::FITS_TILE_RICE ? "'RICE_1  '" : "'GZIP_2  '"), std::string::npos);
+        EXPECT_NE(header.find("EXPTIME =                  1.5"), std::string::npos);
+    }
+
+    // Floating point images are not supported
+    std::vector<uint8_t> floatFITS = testFITS(-32, 16, 16);
+    std::vector<uint8_t> compressed;
+    EXPECT_FALSE(INDI::compressFITSTiles(floatFITS.data(), floatFITS.size(), INDI::FITS_TILE_RICE, 1, compressed));
+}
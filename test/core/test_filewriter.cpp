@@ -0,0 +1,143 @@
+/*******************************************************************************
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Library General Public
+ License version 2 as published by the Free Software Foundation.
+ .
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Library General Public License for more details.
+ .
+ You should have received a copy of the GNU Library General Public License
+ along with this library; see the file COPYING.LIB.  If not, write to
+ the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ Boston, MA 02110-1301, USA.
+*******************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+#include "libs/indibase/indifilewriter.h"
+
+static std::vector<uint8_t> readFile(const std::string &path)
+{
+    std::ifstream file(path, std::ios::binary);
+    return std::vector<uint8_t>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+TEST(CORE_FILE_WRITER, Test_Write)
+{
+    char directory[] = "/tmp/indi_filewriter_XXXXXX";
+    ASSERT_NE(mkdtemp(directory), nullptr);
+
+    std::mutex lock;
+    std::vector<std::string> written;
+
+    // Small files, and large ones written with O_DIRECT where supported, with partial last blocks
+    std::vector<size_t> sizes = {0, 1, 4095, 100000, (8 << 20) + 123, (4 << 20) + 4096};
+    std::vector<std::string> paths;
+    std::vector<std::vector<uint8_t>> contents;
+
+    {
+        INDI::AsyncFileWriter writer(2);
+
+        for (size_t i = 0; i < sizes.size(); i++)
+        {
+            std::vector<uint8_t> data(sizes[i]);
+            for (size_t j = 0; j < data.size(); j++)
+                data[j] = static_cast<uint8_t>(j * 7 + i);
+
+            paths.push_back(std::string(directory) + "/file" + std::to_string(i) + ".bin");
+            contents.push_back(data);
+
+            ASSERT_TRUE(writer.write(paths.back(), data.data(), data.size(), [&](const std::string & path, int error)
+            {
+                EXPECT_EQ(error, 0) << path;
+                std::lock_guard<std::mutex> guard(lock);
+                written.push_back(path);
+            }));
+
+            // The data was copied
+            std::fill(data.begin(), data.end(), 0xFF);
+        }
+
+        writer.flush();
+        EXPECT_EQ(writer.pending(), 0u);
+    }
+
+    // In order of queueing
+    EXPECT_EQ(written, paths);
+
+    for (size_t i = 0; i < paths.size(); i++)
+    {
+        EXPECT_EQ(readFile(paths[i]), contents[i]) << paths[i];
+        unlink(paths[i].c_str());
+    }
+    rmdir(directory);
+}
+
+TEST(CORE_FILE_WRITER, Test_Error)
+{
+    int result = -1;
+    {
+        INDI::AsyncFileWriter writer;
+        uint8_t data[16] = {0};
+        ASSERT_TRUE(writer.write("/nonexistent/indi/file.bin", data, sizeof(data), [&](const std::string &, int error)
+        {
+            result = error;
+        }));
+        // Destruction completes pending writes
+    }
+    EXPECT_EQ(result, ENOENT);
+}
+
+TEST(CORE_FILE_WRITER, Test_Stream)
+{
+    char directory[] = "/tmp/indi_streamwriter_XXXXXX";
+    ASSERT_NE(mkdtemp(directory), nullptr);
+    std::string path = std::string(directory) + "/stream.bin";
+
+    // Small blocks, so appends span blocks and the producer waits for the disk
+    INDI::AsyncStreamWriter writer(64 << 10, 2);
+    ASSERT_EQ(writer.open(path, 1 << 20), 0);
+    EXPECT_EQ(writer.open(path), EBUSY);
+
+    std::vector<uint8_t> expected(16, 0);
+    ASSERT_TRUE(writer.write(expected.data(), expected.size()));
+    for (size_t i = 0; i < 500; i++)
+    {
+        std::vector<uint8_t> frame(3001 + i);
+        for (size_t j = 0; j < frame.size(); j++)
+            frame[j] = static_cast<uint8_t>(j * 3 + i);
+        ASSERT_TRUE(writer.write(frame.data(), frame.size()));
+        expected.insert(expected.end(), frame.begin(), frame.end());
+    }
+    EXPECT_EQ(writer.size(), expected.size());
+
+    // The header is updated once everything else is written, the preallocated space is released
+    std::vector<uint8_t> header(16, 0xAB);
+    EXPECT_EQ(writer.close(header.data(), header.size()), 0);
+    std::copy(header.begin(), header.end(), expected.begin());
+    EXPECT_EQ(readFile(path), expected);
+    EXPECT_GT(writer.writeRate(), 0);
+    EXPECT_FALSE(writer.isOpen());
+
+    // Reusable for another file
+    ASSERT_EQ(writer.open(path), 0);
+    ASSERT_TRUE(writer.write(header.data(), 5));
+    EXPECT_EQ(writer.close(), 0);
+    EXPECT_EQ(readFile(path), std::vector<uint8_t>(5, 0xAB));
+
+    unlink(path.c_str());
+    rmdir(directory);
+}
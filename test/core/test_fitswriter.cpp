@@ -0,0 +1,114 @@
+/*******************************************************************************
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Library General Public
+ License version 2 as published by the Free Software Foundation.
+ .
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Library General Public License for more details.
+ .
+ You should have received a copy of the GNU Library General Public License
+ along with this library; see the file COPYING.LIB.  If not, write to
+ the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ Boston, MA 02110-1301, USA.
+*******************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "libs/indibase/indifitswriter.h"
+
+// Read a big endian FITS value and remove the BZERO offset
+static uint32_t fitsValue(const uint8_t *data, int bpp)
+{
+    uint32_t value = 0;
+    for (int i = 0; i < bpp / 8; i++)
+        value = (value << 8) | data[i];
+    if (bpp == 16)
+        value ^= 0x8000;
+    else if (bpp == 32)
+        value ^= 0x80000000;
+    return value;
+}
+
+TEST(CORE_FITS_WRITER, Test_SwapPixels)
+{
+    // Odd counts exercise both the vector and the scalar loops
+    for (size_t count : {1, 7, 33, 1001})
+    {
+        std::vector<uint16_t> pixels16(count);
+        std::vector<uint32_t> pixels32(count);
+        for (size_t i = 0; i < count; i++)
+        {
+            pixels16[i] = static_cast<uint16_t>(i * 2654435761u >> 7);
+            pixels32[i] = static_cast<uint32_t>(i * 2654435761u);
+        }
+
+        std::vector<uint8_t> output(count * 4);
+        INDI::fitsSwapPixels(reinterpret_cast<const uint8_t *>(pixels16.data()), output.data(), count, 16);
+        for (size_t i = 0; i < count; i++)
+            ASSERT_EQ(fitsValue(output.data() + i * 2, 16), pixels16[i]) << "pixel " << i;
+
+        INDI::fitsSwapPixels(reinterpret_cast<const uint8_t *>(pixels32.data()), output.data(), count, 32);
+        for (size_t i = 0; i < count; i++)
+            ASSERT_EQ(fitsValue(output.data() + i * 4, 32), pixels32[i]) << "pixel " << i;
+    }
+}
+
+TEST(CORE_FITS_WRITER, Test_WriteImage)
+{
+    long naxes[3] = {35, 17, 3};
+    std::vector<std::string> cards = {"EXPTIME =                  1.5 / Total Exposure Time (s)",
+                                      "COMMENT Generated by INDI"
+                                     };
+
+    std::vector<uint16_t> pixels(naxes[0] * naxes[1] * naxes[2]);
+    for (size_t i = 0; i < pixels.size(); i++)
+        pixels[i] = static_cast<uint16_t>(i * 97);
+
+    size_t size = INDI::fitsImageSize(cards.size(), 16, 3, naxes);
+    ASSERT_EQ(size, 3u * 2880);
+
+    std::vector<uint8_t> fits(size, 0xFF);
+    EXPECT_FALSE(INDI::writeFITSImage(cards, reinterpret_cast<const uint8_t *>(pixels.data()), 16, 3, naxes,
+                                      fits.data(), size - 1));
+    ASSERT_TRUE(INDI::writeFITSImage(cards, reinterpret_cast<const uint8_t *>(pixels.data()), 16, 3, naxes,
+                                     fits.data(), size));
+
+    std::string header(fits.begin(), fits.begin() + 2880);
+    const char *expected[] =
+    {
+        "SIMPLE  =                    T / file does conform to FITS standard",
+        "BITPIX  =                   16 / number of bits per data pixel",
+        "NAXIS   =                    3 / number of data axes",
+        "NAXIS1  =                   35 / length of data axis 1",
+        "NAXIS2  =                   17 / length of data axis 2",
+        "NAXIS3  =                    3 / length of data axis 3",
+        "EXTEND  =                    T / FITS dataset may contain extensions",
+        "BZERO   =                32768 / offset data range to that of unsigned short",
+        "BSCALE  =                    1 / default scaling factor",
+        cards[0].c_str(),
+        cards[1].c_str(),
+        "END"
+    };
+    for (size_t i = 0; i < sizeof(expected) / sizeof(expected[0]); i++)
+    {
+        std::string card = header.substr(i * 80, 80);
+        EXPECT_EQ(card, std::string(expected[i]) + std::string(80 - strlen(expected[i]), ' '));
+    }
+    EXPECT_EQ(header.find_first_not_of(' ', 12 * 80), std::string::npos);
+
+    for (size_t i = 0; i < pixels.size(); i++)
+        ASSERT_EQ(fitsValue(fits.data() + 2880 + i * 2, 16), pixels[i]);
+    for (size_t i = 2880 + pixels.size() * 2; i < size; i++)
+        ASSERT_EQ(fits[i], 0);
+
+    // Unsupported images
+    EXPECT_EQ(INDI::fitsImageSize(0, 12, 2, naxes), 0u);
+    EXPECT_EQ(INDI::fitsImageSize(0, 16, 1, naxes), 0u);
+}
@@ -0,0 +1,108 @@
+/*******************************************************************************
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Library General Public
+ License version 2 as published by the Free Software Foundation.
+ .
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Library General Public License for more details.
+ .
+ You should have received a copy of the GNU Library General Public License
+ along with this library; see the file COPYING.LIB.  If not, write to
+ the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ Boston, MA 02110-1301, USA.
+*******************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include "libs/indibase/indiframestats.h"
+
+// Reference statistics computed the straightforward way
+template <typename T>
+static void referenceStats(const std::vector<T> &pixels, double &min, double &max, double &mean, double &stddev)
+{
+    min = max = pixels[0];
+    double sum = 0;
+    for (auto value : pixels)
+    {
+        min = std::min<double>(min, value);
+        max = std::max<double>(max, value);
+        sum += value;
+    }
+    mean = sum / pixels.size();
+
+    double variance = 0;
+    for (auto value : pixels)
+        variance += (value - mean) * (value - mean);
+    stddev = std::sqrt(variance / pixels.size());
+}
+
+TEST(CORE_FRAME_STATS, Test_16bit)
+{
+    std::vector<uint16_t> pixels(3000 * 1000);
+    uint32_t seed = 1;
+    for (auto &value : pixels)
+    {
+        seed = seed * 1103515245 + 12345;
+        value = 1000 + (seed >> 16) % 5000;
+    }
+    // A maximum before the minimum must be found as well
+    pixels[10] = 60000;
+    pixels[20] = 3;
+
+    double min, max, mean, stddev;
+    referenceStats(pixels, min, max, mean, stddev);
+
+    std::vector<uint16_t> sorted = pixels;
+    std::nth_element(sorted.begin(), sorted.begin() + (sorted.size() - 1) / 2, sorted.end());
+    double median = sorted[(sorted.size() - 1) / 2];
+
+    for (unsigned int threads : {1u, 4u})
+    {
+        INDI::FrameStats stats;
+        ASSERT_TRUE(INDI::computeFrameStats(reinterpret_cast<uint8_t *>(pixels.data()), pixels.size(), 16, 64, stats, threads));
+
+        EXPECT_EQ(stats.min, 3);
+        EXPECT_EQ(stats.max, 60000);
+        EXPECT_NEAR(stats.mean, mean, 1e-6);
+        EXPECT_NEAR(stats.stddev, stddev, 1e-6);
+        EXPECT_EQ(stats.median, median);
+
+        ASSERT_EQ(stats.histogram.size(), 64u);
+        uint64_t total = 0;
+        for (auto count : stats.histogram)
+            total += count;
+        EXPECT_EQ(total, pixels.size());
+        EXPECT_EQ(stats.histogram[0], 1u);
+        EXPECT_EQ(stats.histogram[63], 1u);
+    }
+}
+
+TEST(CORE_FRAME_STATS, Test_8bit_and_32bit)
+{
+    std::vector<uint8_t> pixels8 = {5, 1, 9, 3, 7};
+    INDI::FrameStats stats;
+    ASSERT_TRUE(INDI::computeFrameStats(pixels8.data(), pixels8.size(), 8, 0, stats));
+    EXPECT_EQ(stats.min, 1);
+    EXPECT_EQ(stats.max, 9);
+    EXPECT_DOUBLE_EQ(stats.mean, 5);
+    EXPECT_EQ(stats.median, 5);
+    EXPECT_TRUE(stats.histogram.empty());
+
+    std::vector<uint32_t> pixels32 = {100000, 4000000000u, 70000, 2000000};
+    double min, max, mean, stddev;
+    referenceStats(pixels32, min, max, mean, stddev);
+    ASSERT_TRUE(INDI::computeFrameStats(reinterpret_cast<uint8_t *>(pixels32.data()), pixels32.size(), 32, 4, stats));
+    EXPECT_EQ(stats.min, min);
+    EXPECT_EQ(stats.max, max);
+    EXPECT_NEAR(stats.mean, mean, 1e-3);
+    EXPECT_NEAR(stats.stddev, stddev, 1);
+
+    EXPECT_FALSE(INDI::computeFrameStats(pixels8.data(), pixels8.size(), 12, 0, stats));
+}
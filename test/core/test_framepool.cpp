@@ -0,0 +1,129 @@
+/*******************************************************************************
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Library General Public
+ License version 2 as published by the Free Software Foundation.
+ .
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Library General Public License for more details.
+ .
+ You should have received a copy of the GNU Library General Public License
+ along with this library; see the file COPYING.LIB.  If not, write to
+ the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ Boston, MA 02110-1301, USA.
+*******************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <thread>
+#include <vector>
+
+#include "libs/stream/framepool.h"
+
+TEST(CORE_FRAMEPOOL, Test_Recycle)
+{
+    INDI::FramePool pool(8 * 1000);
+
+    const uint8_t *data;
+    {
+        INDI::FramePool::Frame frame = pool.acquire(1000);
+        ASSERT_TRUE(frame);
+        EXPECT_EQ(frame->size(), 1000u);
+        data = frame->data();
+
+        // Shared handles keep the buffer in use
+        INDI::FramePool::Frame shared = frame;
+        frame.reset();
+        EXPECT_EQ(pool.used(), 1u);
+    }
+    EXPECT_EQ(pool.used(), 0u);
+
+    // Released buffers are reused for frames of the same size or smaller
+    INDI::FramePool::Frame frame = pool.acquire(600);
+    EXPECT_EQ(frame->data(), data);
+    EXPECT_EQ(frame->size(), 600u);
+    EXPECT_EQ(frame->capacity(), 1000u);
+    EXPECT_EQ(pool.slots(), 1u);
+    EXPECT_EQ(pool.allocated(), 1000u);
+}
+
+TEST(CORE_FRAMEPOOL, Test_Limit)
+{
+    INDI::FramePool pool(6 * 1000);
+
+    std::vector<INDI::FramePool::Frame> frames;
+    for (int i = 0; i < 6; i++)
+    {
+        frames.push_back(pool.acquire(1000));
+        ASSERT_TRUE(frames.back());
+    }
+    EXPECT_FALSE(pool.acquire(1000));
+
+    // A larger frame replaces free buffers that are too small
+    frames.resize(4);
+    INDI::FramePool::Frame large = pool.acquire(2000);
+    ASSERT_TRUE(large);
+    EXPECT_EQ(pool.slots(), 5u);
+    EXPECT_EQ(pool.allocated(), 6000u);
+
+    // The first buffers are allocated whatever the limit
+    frames.clear();
+    large.reset();
+    pool.setLimit(0);
+    EXPECT_EQ(pool.slots(), INDI::FramePool::MIN_SLOTS);
+    for (size_t i = 0; i < INDI::FramePool::MIN_SLOTS; i++)
+        frames.push_back(pool.acquire(10));
+    EXPECT_FALSE(pool.acquire(10));
+}
+
+TEST(CORE_FRAMEPOOL, Test_Release)
+{
+    INDI::FramePool::Frame frame;
+    {
+        INDI::FramePool pool(1000);
+        frame = pool.acquire(1000);
+        ASSERT_TRUE(frame);
+    }
+    // Frames outlive their pool
+    frame->data()[999] = 1;
+    frame.reset();
+
+    INDI::FramePool pool(4 * 1000);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; t++)
+        threads.emplace_back([&pool]()
+    {
+        for (int i = 0; i < 1000; i++)
+        {
+            INDI::FramePool::Frame frame = pool.acquire(1000);
+            ASSERT_TRUE(frame);
+            frame->data()[0] = static_cast<uint8_t>(i);
+        }
+    });
+    for (auto &thread : threads)
+        thread.join();
+    EXPECT_EQ(pool.used(), 0u);
+    EXPECT_LE(pool.slots(), 4u);
+}
+
+TEST(CORE_FRAMEPOOL, Test_Wrap)
+{
+    uint8_t memory[100] = {};
+    int released = 0;
+    {
+        INDI::FramePool::Frame frame = INDI::FramePool::wrap(memory, sizeof(memory), [&released]()
+        {
+            released++;
+        });
+        ASSERT_TRUE(frame);
+        EXPECT_EQ(frame->data(), memory);
+        EXPECT_EQ(frame->size(), sizeof(memory));
+
+        // The memory is handed back once, with the last handle
+        INDI::FramePool::Frame shared = frame;
+        frame.reset();
+        EXPECT_EQ(released, 0);
+    }
+    EXPECT_EQ(released, 1);
+}
@@ -0,0 +1,74 @@
+/*******************************************************************************
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Library General Public
+ License version 2 as published by the Free Software Foundation.
+ .
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Library General Public License for more details.
+ .
+ You should have received a copy of the GNU Library General Public License
+ along with this library; see the file COPYING.LIB.  If not, write to
+ the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ Boston, MA 02110-1301, USA.
+*******************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cmath>
+
+#include "libs/stream/frametiming.h"
+
+using namespace std::chrono;
+
+TEST(CORE_FRAMETIMING, Test_Jitter)
+{
+    INDI::FrameTiming timing;
+    system_clock::time_point timestamp = system_clock::now();
+
+    // 10 ms intervals with every fourth frame 1.5 ms late, then back on schedule
+    for (int i = 0; i <= 100; i++)
+        timing.addTimestamp(timestamp + milliseconds(10 * i) + microseconds(i % 4 == 0 ? 1500 : 0));
+
+    EXPECT_NEAR(timing.interval(), 10, 0.5);
+    EXPECT_GT(timing.jitter(), 0.5);
+    EXPECT_LT(timing.jitter(), 1.5);
+
+    const INDI::FrameTiming::Histogram &histogram = timing.jitterHistogram();
+    uint64_t total = 0, large = 0;
+    for (size_t bin = 0; bin < INDI::FrameTiming::BINS; bin++)
+    {
+        total += histogram[bin];
+        if (INDI::FrameTiming::jitterLimit(bin) > 1)
+            large += histogram[bin];
+    }
+    EXPECT_EQ(total, 100u);
+    // Late frames, and frames following them, deviate by about 1.5 ms
+    EXPECT_GE(large, 45u);
+
+    timing.reset();
+    EXPECT_EQ(timing.jitter(), 0);
+    EXPECT_EQ(timing.jitterHistogram()[0], 0u);
+}
+
+TEST(CORE_FRAMETIMING, Test_Latency)
+{
+    INDI::FrameTiming timing;
+    timing.addLatency(0.5);
+    timing.addLatency(3);
+    timing.addLatency(3);
+    timing.addLatency(1000);
+
+    EXPECT_DOUBLE_EQ(timing.latency(), 251.625);
+    EXPECT_DOUBLE_EQ(timing.maxLatency(), 1000);
+
+    // Bins are [0, 1), [1, 2), [2, 5), ... and everything above the last limit
+    const INDI::FrameTiming::Histogram &histogram = timing.latencyHistogram();
+    EXPECT_EQ(histogram[0], 1u);
+    EXPECT_EQ(histogram[2], 2u);
+    EXPECT_EQ(histogram[INDI::FrameTiming::BINS - 1], 1u);
+    EXPECT_EQ(INDI::FrameTiming::latencyLimit(0), 1);
+    EXPECT_TRUE(std::isinf(INDI::FrameTiming::latencyLimit(INDI::FrameTiming::BINS - 1)));
+}
@@ -0,0 +1,139 @@
+/*******************************************************************************
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Library General Public
+ License version 2 as published by the Free Software Foundation.
+ .
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Library General Public License for more details.
+ .
+ You should have received a copy of the GNU Library General Public License
+ along with this library; see the file COPYING.LIB.  If not, write to
+ the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ Boston, MA 02110-1301, USA.
+*******************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+#include "libs/stream/recorder/losslessrecorder.h"
+
+namespace
+{
+
+std::string tempPath()
+{
+    return std::string("/tmp/test_losslessrecorder_") + std::to_string(getpid()) + ".ilv";
+}
+
+// Smooth 16 bit Bayer frame with noise, a different frame for each seed
+std::vector<uint16_t> bayerFrame(int width, int height, unsigned int seed)
+{
+    std::mt19937 random(seed);
+    std::uniform_int_distribution<int> noise(0, 63);
+    std::vector<uint16_t> frame(width * height);
+    for (int y = 0; y < height; y++)
+        for (int x = 0; x < width; x++)
+            frame[y * width + x] = static_cast<uint16_t>(1000 + 20 * x + 10 * y + ((x ^ y) & 1) * 3000 + noise(random));
+    return frame;
+}
+
+}
+
+TEST(CORE_LOSSLESSRECORDER, Test_Filter)
+{
+    INDI::ILV::Header header;
+    header.width = 37;
+    header.height = 5;
+
+    // Every combination of depth and layout, with random samples covering the whole range
+    std::mt19937 random(1);
+    for (INDI_PIXEL_FORMAT format : {INDI_MONO, INDI_BAYER_RGGB, INDI_RGB})
+        for (uint32_t depth : {8u, 16u})
+        {
+            header.pixelFormat = format;
+            header.pixelDepth = depth;
+            header.planes = format == INDI_RGB ? 3 : 1;
+
+            std::vector<uint8_t> frame(header.frameSize());
+            for (auto &byte : frame)
+                byte = static_cast<uint8_t>(random());
+
+            std::vector<uint8_t> filtered, decoded(frame.size());
+            INDI::ILV::encodeFrame(header, frame.data(), filtered);
+            ASSERT_EQ(filtered.size(), frame.size());
+            INDI::ILV::decodeFrame(header, filtered.data(), decoded.data());
+            EXPECT_EQ(decoded, frame) << "format " << format << " depth " << depth;
+        }
+}
+
+TEST(CORE_LOSSLESSRECORDER, Test_Record)
+{
+    const int width = 64, height = 48, frames = 10;
+    const std::string path = tempPath();
+
+    INDI::LosslessRecorder recorder;
+    EXPECT_FALSE(recorder.setPixelFormat(INDI_JPG, 8));
+    ASSERT_TRUE(recorder.setPixelFormat(INDI_BAYER_GRBG, 12));
+    ASSERT_TRUE(recorder.setSize(width, height));
+    recorder.setExpectedFrames(frames);
+
+    char errmsg[1024];
+    ASSERT_TRUE(recorder.open(path.c_str(), errmsg)) << errmsg;
+    for (int i = 0; i < frames; i++)
+    {
+        std::vector<uint16_t> frame = bayerFrame(width, height, i);
+        ASSERT_TRUE(recorder.writeFrame(reinterpret_cast<const uint8_t *>(frame.data()), frame.size() * 2));
+    }
+    // Frames smaller than the frame size are rejected
+    EXPECT_FALSE(recorder.writeFrame(reinterpret_cast<const uint8_t *>(path.data()), 10));
+    ASSERT_TRUE(recorder.close());
+    EXPECT_GT(recorder.compressionRatio(), 1.5);
+
+    INDI::LosslessReader reader;
+    ASSERT_TRUE(reader.open(path));
+    EXPECT_EQ(reader.header().width, static_cast<uint32_t>(width));
+    EXPECT_EQ(reader.header().pixelFormat, static_cast<uint32_t>(INDI_BAYER_GRBG));
+    EXPECT_EQ(reader.header().pixelDepth, 12u);
+    ASSERT_EQ(reader.frameCount(), static_cast<uint64_t>(frames));
+
+    // Frames are read in any order
+    std::vector<uint8_t> output;
+    for (int i = frames - 1; i >= 0; i -= 3)
+    {
+        std::vector<uint16_t> frame = bayerFrame(width, height, i);
+        ASSERT_TRUE(reader.readFrame(i, output));
+        ASSERT_EQ(output.size(), frame.size() * 2);
+        EXPECT_EQ(std::memcmp(output.data(), frame.data(), output.size()), 0) << "frame " << i;
+    }
+    for (int i = 1; i < frames; i++)
+        EXPECT_GE(reader.timestamp(i), reader.timestamp(i - 1));
+    EXPECT_GE(reader.timestamp(0), reader.header().startTime);
+    EXPECT_FALSE(reader.readFrame(frames, output));
+
+    // Without the index, complete records are found by reading them
+    uint64_t indexOffset = reader.header().indexOffset;
+    reader.close();
+    ASSERT_EQ(truncate(path.c_str(), indexOffset - 100), 0);
+    FILE *file = fopen(path.c_str(), "r+b");
+    ASSERT_NE(file, nullptr);
+    const uint8_t zero[8] = {0};
+    fseek(file, 48, SEEK_SET);
+    fwrite(zero, 1, sizeof(zero), file);
+    fclose(file);
+
+    ASSERT_TRUE(reader.open(path));
+    ASSERT_EQ(reader.frameCount(), static_cast<uint64_t>(frames - 1));
+    ASSERT_TRUE(reader.readFrame(0, output));
+    EXPECT_EQ(std::memcmp(output.data(), bayerFrame(width, height, 0).data(), output.size()), 0);
+
+    reader.close();
+    unlink(path.c_str());
+}
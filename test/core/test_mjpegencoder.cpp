@@ -0,0 +1,87 @@
+/*******************************************************************************
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Library General Public
+ License version 2 as published by the Free Software Foundation.
+ .
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Library General Public License for more details.
+ .
+ You should have received a copy of the GNU Library General Public License
+ along with this library; see the file COPYING.LIB.  If not, write to
+ the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ Boston, MA 02110-1301, USA.
+*******************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <vector>
+#include <jpeglib.h>
+
+#include "libs/stream/encoder/mjpegencoder.h"
+
+static std::vector<uint8_t> decode(const std::vector<uint8_t> &jpeg, uint32_t &width, uint32_t &height, int &components)
+{
+    struct jpeg_decompress_struct cinfo;
+    struct jpeg_error_mgr jerr;
+    cinfo.err = jpeg_std_error(&jerr);
+    jpeg_create_decompress(&cinfo);
+    jpeg_mem_src(&cinfo, const_cast<uint8_t *>(jpeg.data()), jpeg.size());
+    jpeg_read_header(&cinfo, TRUE);
+    jpeg_start_decompress(&cinfo);
+
+    width = cinfo.output_width;
+    height = cinfo.output_height;
+    components = cinfo.output_components;
+    std::vector<uint8_t> pixels(static_cast<size_t>(width) * height * components);
+    while (cinfo.output_scanline < cinfo.output_height)
+    {
+        JSAMPROW row = pixels.data() + static_cast<size_t>(cinfo.output_scanline) * width * components;
+        jpeg_read_scanlines(&cinfo, &row, 1);
+    }
+    jpeg_finish_decompress(&cinfo);
+    jpeg_destroy_decompress(&cinfo);
+    return pixels;
+}
+
+static std::vector<uint8_t> makeFrame(uint16_t width, uint16_t height, int components)
+{
+    std::vector<uint8_t> frame(static_cast<size_t>(width) * height * components);
+    for (size_t i = 0; i < frame.size(); i++)
+        frame[i] = static_cast<uint8_t>((i * 7) ^ (i / (width * components)));
+    return frame;
+}
+
+TEST(CORE_MJPEGENCODER, Test_Stripes)
+{
+    // Heights not multiple of the stripes, nor of the MCUs
+    for (int components : {1, 3})
+    {
+        const uint16_t width = 333, height = 250;
+        std::vector<uint8_t> frame = makeFrame(width, height, components);
+
+        INDI::MJPEGEncoder encoder;
+        ASSERT_TRUE(encoder.compress(frame.data(), width, height, components, 85, 1));
+        uint32_t w, h;
+        int c;
+        std::vector<uint8_t> single = decode(encoder.jpegFrame(), w, h, c);
+
+        // Stripes joined with restart markers decode to the same pixels
+        for (unsigned int threads : {2u, 3u, 7u})
+        {
+            ASSERT_TRUE(encoder.compress(frame.data(), width, height, components, 85, threads));
+            const uint8_t dri[] = {0xFF, 0xDD};
+            const std::vector<uint8_t> &jpeg = encoder.jpegFrame();
+            EXPECT_NE(std::search(jpeg.begin(), jpeg.end(), dri, dri + 2), jpeg.end());
+
+            std::vector<uint8_t> striped = decode(encoder.jpegFrame(), w, h, c);
+            EXPECT_EQ(w, width);
+            EXPECT_EQ(h, height);
+            EXPECT_EQ(c, components);
+            EXPECT_TRUE(striped == single) << "components " << components << " threads " << threads;
+        }
+    }
+}
@@ -0,0 +1,101 @@
+/*******************************************************************************
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Library General Public
+ License version 2 as published by the Free Software Foundation.
+ .
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Library General Public License for more details.
+ .
+ You should have received a copy of the GNU Library General Public License
+ along with this library; see the file COPYING.LIB.  If not, write to
+ the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ Boston, MA 02110-1301, USA.
+*******************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "libs/indibase/indiroi.h"
+
+TEST(CORE_ROI, Test_PackUnpack)
+{
+    // 2x2 binned subframe starting at (100, 50) on the sensor
+    INDI::ROIFrame frame;
+    frame.x = 100;
+    frame.y = 50;
+    frame.width = 200;
+    frame.height = 150;
+    frame.binX = 2;
+    frame.binY = 2;
+    frame.bpp = 16;
+
+    std::vector<uint16_t> pixels(frame.width * frame.height);
+    for (size_t i = 0; i < pixels.size(); i++)
+        pixels[i] = static_cast<uint16_t>(i * 7);
+
+    std::vector<INDI::FrameROI> rois(4);
+    rois[0] = {140, 90, 64, 64};      // Inside
+    rois[1] = {450, 320, 64, 64};     // Clipped by the bottom right corner of the frame
+    rois[2] = {0, 0, 32, 32};         // Outside
+    rois[3] = {100, 50, 2, 2};        // Single binned pixel
+
+    std::vector<uint8_t> packed;
+    ASSERT_TRUE(INDI::packROIs(reinterpret_cast<const uint8_t *>(pixels.data()), frame, rois, 0.25, packed));
+    EXPECT_EQ(memcmp(packed.data(), "IROI", 4), 0);
+    EXPECT_EQ(packed[12] | (packed[13] << 8) | (packed[14] << 16) | (packed[15] << 24), 250000);
+    EXPECT_EQ(packed.size(), 24u + 4 * 20 + (32 * 32 + 25 * 15 + 0 + 1) * 2);
+
+    std::vector<INDI::PackedROI> unpacked;
+    int bpp = 0;
+    ASSERT_TRUE(INDI::unpackROIs(packed.data(), packed.size(), unpacked, bpp));
+    EXPECT_EQ(bpp, 16);
+    ASSERT_EQ(unpacked.size(), 4u);
+
+    struct Expected
+    {
+        uint32_t x, y, width, height, left, top;
+    } expected[4] =
+    {
+        {140, 90, 32, 32, 20, 20},
+        {450, 320, 25, 15, 175, 135},
+        {0, 0, 0, 0, 0, 0},
+        {100, 50, 1, 1, 0, 0}
+    };
+
+    for (size_t r = 0; r < 4; r++)
+    {
+        const auto &roi = unpacked[r];
+        EXPECT_EQ(roi.roi.x, expected[r].x) << "roi " << r;
+        EXPECT_EQ(roi.roi.y, expected[r].y) << "roi " << r;
+        ASSERT_EQ(roi.roi.width, expected[r].width) << "roi " << r;
+        ASSERT_EQ(roi.roi.height, expected[r].height) << "roi " << r;
+        const uint16_t *data = reinterpret_cast<const uint16_t *>(roi.pixels.data());
+        for (uint32_t y = 0; y < roi.roi.height; y++)
+            for (uint32_t x = 0; x < roi.roi.width; x++)
+                ASSERT_EQ(data[y * roi.roi.width + x], pixels[(expected[r].top + y) * frame.width + expected[r].left + x]);
+    }
+}
+
+TEST(CORE_ROI, Test_Invalid)
+{
+    INDI::ROIFrame frame;
+    frame.width = 16;
+    frame.height = 16;
+    frame.bpp = 12;
+    std::vector<uint8_t> pixels(16 * 16 * 2), packed;
+    EXPECT_FALSE(INDI::packROIs(pixels.data(), frame, {}, 1, packed));
+
+    frame.bpp = 8;
+    ASSERT_TRUE(INDI::packROIs(pixels.data(), frame, {{0, 0, 8, 8}}, 1, packed));
+
+    std::vector<INDI::PackedROI> unpacked;
+    int bpp = 0;
+    EXPECT_FALSE(INDI::unpackROIs(packed.data(), packed.size() - 1, unpacked, bpp));
+    packed[0] = 'X';
+    EXPECT_FALSE(INDI::unpackROIs(packed.data(), packed.size(), unpacked, bpp));
+}
@@ -0,0 +1,209 @@
+/*******************************************************************************
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Library General Public
+ License version 2 as published by the Free Software Foundation.
+ .
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Library General Public License for more details.
+ .
+ You should have received a copy of the GNU Library General Public License
+ along with this library; see the file COPYING.LIB.  If not, write to
+ the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ Boston, MA 02110-1301, USA.
+*******************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include "libs/indibase/indistacker.h"
+
+static const uint8_t *bytes(const std::vector<uint16_t> &frame)
+{
+    return reinterpret_cast<const uint8_t *>(frame.data());
+}
+
+// Background of 100 with gaussian stars of decreasing brightness, shifted by dx, dy
+static std::vector<uint16_t> starField(uint32_t width, uint32_t height, double dx, double dy)
+{
+    std::vector<uint16_t> frame(width * height, 100);
+    uint32_t seed = 12345;
+    for (int s = 0; s < 20; s++)
+    {
+        seed = seed * 1664525u + 1013904223u;
+        double cx = 16 + (seed >> 8) % (width - 32) + dx;
+        seed = seed * 1664525u + 1013904223u;
+        double cy = 16 + (seed >> 8) % (height - 32) + dy;
+        double peak = 20000 - s * 800;
+        for (int y = static_cast<int>(cy) - 6; y <= static_cast<int>(cy) + 6; y++)
+            for (int x = static_cast<int>(cx) - 6; x <= static_cast<int>(cx) + 6; x++)
+            {
+                if (x < 0 || y < 0 || x >= static_cast<int>(width) || y >= static_cast<int>(height))
+                    continue;
+                double r2 = (x - cx) * (x - cx) + (y - cy) * (y - cy);
+                frame[y * width + x] += static_cast<uint16_t>(peak * std::exp(-r2 / 4.5));
+            }
+    }
+    return frame;
+}
+
+TEST(CORE_STACKER, Test_Mean)
+{
+    INDI::FrameStacker stacker;
+    stacker.setDepth(4);
+
+    std::vector<uint16_t> frame(64 * 32);
+    for (uint16_t n = 0; n < 4; n++)
+    {
+        for (size_t i = 0; i < frame.size(); i++)
+            frame[i] = static_cast<uint16_t>(i * 16 + n * 2);
+        EXPECT_EQ(stacker.add(bytes(frame), 64, 32, 16, 0.5), n == 3 ? INDI::FrameStacker::STACK_COMPLETE :
+                  INDI::FrameStacker::FRAME_STACKED);
+    }
+    EXPECT_EQ(stacker.count(), 4u);
+    EXPECT_DOUBLE_EQ(stacker.exposure(), 2.0);
+    EXPECT_EQ(stacker.outputBPP(), 16);
+
+    std::vector<uint8_t> output;
+    ASSERT_TRUE(stacker.result(output));
+    ASSERT_EQ(output.size(), frame.size() * 2);
+    const uint16_t *stacked = reinterpret_cast<const uint16_t *>(output.data());
+    for (size_t i = 0; i < frame.size(); i++)
+        ASSERT_EQ(stacked[i], static_cast<uint16_t>(i * 16 + 3)) << "pixel " << i;
+
+    // The next frame starts a new stack
+    EXPECT_EQ(stacker.count(), 0u);
+    EXPECT_FALSE(stacker.result(output));
+}
+
+TEST(CORE_STACKER, Test_Sum)
+{
+    INDI::FrameStacker stacker;
+    stacker.setMode(INDI::FrameStacker::STACK_SUM);
+    stacker.setDepth(3);
+
+    std::vector<uint8_t> frame(40 * 30, 250);
+    for (int n = 0; n < 3; n++)
+        stacker.add(frame.data(), 40, 30, 8, 1);
+    EXPECT_EQ(stacker.outputBPP(), 32);
+
+    std::vector<uint8_t> output;
+    ASSERT_TRUE(stacker.result(output));
+    ASSERT_EQ(output.size(), frame.size() * 4);
+    const uint32_t *stacked = reinterpret_cast<const uint32_t *>(output.data());
+    for (size_t i = 0; i < frame.size(); i++)
+        ASSERT_EQ(stacked[i], 750u);
+
+    // A frame of another size restarts the stack
+    stacker.add(frame.data(), 40, 30, 8, 1);
+    stacker.add(frame.data(), 30, 40, 8, 1);
+    EXPECT_EQ(stacker.count(), 1u);
+}
+
+TEST(CORE_STACKER, Test_LargeSum)
+{
+    INDI::FrameStacker stacker;
+    stacker.setMode(INDI::FrameStacker::STACK_SUM);
+    stacker.setDepth(300);
+
+    // Sums above 2^24 are exact, and saturate at 32 bits
+    std::vector<uint32_t> frame(16 * 8);
+    for (size_t i = 0; i < frame.size(); i++)
+        frame[i] = 65535 + static_cast<uint32_t>(i) * 1000003u;
+    for (int n = 0; n < 300; n++)
+        stacker.add(reinterpret_cast<const uint8_t *>(frame.data()), 16, 8, 32, 1);
+
+    std::vector<uint8_t> output;
+    ASSERT_TRUE(stacker.result(output));
+    const uint32_t *stacked = reinterpret_cast<const uint32_t *>(output.data());
+    for (size_t i = 0; i < frame.size(); i++)
+        ASSERT_EQ(stacked[i], static_cast<uint32_t>(std::min<uint64_t>(300ull * frame[i], 0xFFFFFFFF))) << "pixel " << i;
+
+    // Odd 16 bit values whose mean needs every unit of the sum
+    stacker.setMode(INDI::FrameStacker::STACK_MEAN);
+    stacker.setDepth(1001);
+    std::vector<uint16_t> frame16(16 * 8, 65535);
+    for (int n = 0; n < 1001; n++)
+    {
+        frame16[0] = n % 2 ? 65535 : 65534;
+        stacker.add(bytes(frame16), 16, 8, 16, 1);
+    }
+    ASSERT_TRUE(stacker.result(output));
+    const uint16_t *mean = reinterpret_cast<const uint16_t *>(output.data());
+    EXPECT_EQ(mean[0], 65534);
+    EXPECT_EQ(mean[1], 65535);
+}
+
+TEST(CORE_STACKER, Test_SigmaClip)
+{
+    INDI::FrameStacker stacker;
+    stacker.setMode(INDI::FrameStacker::STACK_SIGMA_CLIP);
+    stacker.setDepth(10);
+    stacker.setSigma(3);
+
+    std::vector<uint16_t> frame(32 * 32);
+    for (int n = 0; n < 10; n++)
+    {
+        for (size_t i = 0; i < frame.size(); i++)
+            frame[i] = static_cast<uint16_t>(1000 + ((i + n) % 2 ? 2 : -2));
+        // Cosmic ray and satellite trail in one frame
+        if (n == 6)
+        {
+            frame[100] = 60000;
+            for (int x = 0; x < 32; x++)
+                frame[20 * 32 + x] = 30000;
+        }
+        stacker.add(bytes(frame), 32, 32, 16, 1);
+    }
+
+    std::vector<uint8_t> output;
+    ASSERT_TRUE(stacker.result(output));
+    const uint16_t *stacked = reinterpret_cast<const uint16_t *>(output.data());
+    for (size_t i = 0; i < frame.size(); i++)
+        ASSERT_NEAR(stacked[i], 1000, 1) << "pixel " << i;
+
+    // The mean keeps outliers
+    stacker.setMode(INDI::FrameStacker::STACK_MEAN);
+    stacker.setDepth(2);
+    frame.assign(frame.size(), 1000);
+    stacker.add(bytes(frame), 32, 32, 16, 1);
+    frame[100] = 3000;
+    stacker.add(bytes(frame), 32, 32, 16, 1);
+    ASSERT_TRUE(stacker.result(output));
+    EXPECT_EQ(reinterpret_cast<const uint16_t *>(output.data())[100], 2000);
+}
+
+TEST(CORE_STACKER, Test_Align)
+{
+    const uint32_t width = 256, height = 192;
+    INDI::FrameStacker stacker;
+    stacker.setAlignment(true);
+    stacker.setDepth(3);
+
+    auto reference = starField(width, height, 0, 0);
+    EXPECT_EQ(stacker.add(bytes(reference), width, height, 16, 1), INDI::FrameStacker::FRAME_STACKED);
+
+    // Frames without stars cannot be aligned
+    std::vector<uint16_t> empty(width * height, 100);
+    EXPECT_EQ(stacker.add(bytes(empty), width, height, 16, 1), INDI::FrameStacker::FRAME_REJECTED);
+    EXPECT_EQ(stacker.rejected(), 1u);
+
+    auto shifted = starField(width, height, 5, -3);
+    EXPECT_EQ(stacker.add(bytes(shifted), width, height, 16, 1), INDI::FrameStacker::FRAME_STACKED);
+    shifted = starField(width, height, -7, 4);
+    EXPECT_EQ(stacker.add(bytes(shifted), width, height, 16, 1), INDI::FrameStacker::STACK_COMPLETE);
+
+    std::vector<uint8_t> output;
+    ASSERT_TRUE(stacker.result(output));
+    const uint16_t *stacked = reinterpret_cast<const uint16_t *>(output.data());
+
+    // Away from the borders, aligned frames line up with the reference
+    for (uint32_t y = 16; y < height - 16; y++)
+        for (uint32_t x = 16; x < width - 16; x++)
+            ASSERT_NEAR(stacked[y * width + x], reference[y * width + x], 1) << x << "," << y;
+}
@@ -0,0 +1,114 @@
+/*******************************************************************************
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Library General Public
+ License version 2 as published by the Free Software Foundation.
+ .
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Library General Public License for more details.
+ .
+ You should have received a copy of the GNU Library General Public License
+ along with this library; see the file COPYING.LIB.  If not, write to
+ the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ Boston, MA 02110-1301, USA.
+*******************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include "libs/indibase/indistardetection.h"
+
+// Add a gaussian star of standard deviations sx, sy at cx, cy
+static void addStar(std::vector<uint16_t> &frame, uint32_t width, double cx, double cy, double peak, double sx,
+                    double sy)
+{
+    uint32_t height = frame.size() / width;
+    for (uint32_t y = 0; y < height; y++)
+        for (uint32_t x = 0; x < width; x++)
+        {
+            double dx = (x - cx) / sx, dy = (y - cy) / sy;
+            double value = peak * std::exp(-(dx * dx + dy * dy) / 2);
+            if (value >= 0.5)
+                frame[y * width + x] += static_cast<uint16_t>(std::lround(value));
+        }
+}
+
+// Background gradient from 100 to 140 with +-2 of noise
+static std::vector<uint16_t> background(uint32_t width, uint32_t height)
+{
+    std::vector<uint16_t> frame(width * height);
+    uint32_t seed = 12345;
+    for (uint32_t y = 0; y < height; y++)
+        for (uint32_t x = 0; x < width; x++)
+        {
+            seed = seed * 1664525u + 1013904223u;
+            frame[y * width + x] = static_cast<uint16_t>(100 + 40 * x / width + (seed >> 24) % 5);
+        }
+    return frame;
+}
+
+TEST(CORE_STARDETECTION, Test_Metrics)
+{
+    const uint32_t width = 320, height = 240;
+    auto frame = background(width, height);
+    addStar(frame, width, 60.3, 50.7, 4000, 2, 2);
+    addStar(frame, width, 200.5, 120.2, 2000, 2, 2);
+    addStar(frame, width, 270, 200, 1000, 2, 2);
+
+    INDI::StarDetection detection;
+    ASSERT_TRUE(INDI::detectStars(reinterpret_cast<const uint8_t *>(frame.data()), width, height, 16, detection));
+    ASSERT_EQ(detection.stars.size(), 3u);
+    EXPECT_NEAR(detection.stars[0].x, 60.3, 0.05);
+    EXPECT_NEAR(detection.stars[0].y, 50.7, 0.05);
+    EXPECT_NEAR(detection.stars[1].x, 200.5, 0.05);
+    EXPECT_NEAR(detection.stars[2].y, 200, 0.05);
+
+    // FWHM of a gaussian is 2.355 sigma, its half flux radius is 1.25 sigma
+    for (const auto &star : detection.stars)
+    {
+        EXPECT_NEAR(star.fwhm, 4.71, 0.47);
+        EXPECT_NEAR(star.hfr, 2.5, 0.25);
+        EXPECT_LT(star.eccentricity, 0.3);
+    }
+    EXPECT_NEAR(detection.fwhm, 4.71, 0.47);
+    EXPECT_NEAR(detection.hfr, 2.5, 0.25);
+    EXPECT_NEAR(detection.background, 122, 2);
+    EXPECT_LT(detection.noise, 4);
+
+    // Stars split across the rows of different threads are found once
+    INDI::StarDetection threaded;
+    ASSERT_TRUE(INDI::detectStars(reinterpret_cast<const uint8_t *>(frame.data()), width, height, 16, threaded, 5, 7));
+    ASSERT_EQ(threaded.stars.size(), 3u);
+    EXPECT_DOUBLE_EQ(threaded.stars[1].x, detection.stars[1].x);
+    EXPECT_DOUBLE_EQ(threaded.fwhm, detection.fwhm);
+}
+
+TEST(CORE_STARDETECTION, Test_Elongated)
+{
+    const uint32_t width = 128, height = 128;
+    auto frame = background(width, height);
+    addStar(frame, width, 64, 64, 3000, 4, 2);
+
+    INDI::StarDetection detection;
+    ASSERT_TRUE(INDI::detectStars(reinterpret_cast<const uint8_t *>(frame.data()), width, height, 16, detection));
+    ASSERT_EQ(detection.stars.size(), 1u);
+    // sqrt(1 - 2^2 / 4^2)
+    EXPECT_NEAR(detection.eccentricity, 0.866, 0.05);
+}
+
+TEST(CORE_STARDETECTION, Test_Empty)
+{
+    auto frame = background(256, 192);
+    frame[1000] = 60000;
+
+    INDI::StarDetection detection;
+    ASSERT_TRUE(INDI::detectStars(reinterpret_cast<const uint8_t *>(frame.data()), 256, 192, 16, detection));
+    EXPECT_TRUE(detection.stars.empty());
+    EXPECT_EQ(detection.hfr, 0);
+
+    EXPECT_FALSE(INDI::detectStars(reinterpret_cast<const uint8_t *>(frame.data()), 256, 192, 12, detection));
+}
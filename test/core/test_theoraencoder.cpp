@@ -0,0 +1,279 @@
+/*******************************************************************************
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Library General Public
+ License version 2 as published by the Free Software Foundation.
+ .
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Library General Public License for more details.
+ .
+ You should have received a copy of the GNU Library General Public License
+ along with this library; see the file COPYING.LIB.  If not, write to
+ the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ Boston, MA 02110-1301, USA.
+*******************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include <ogg/ogg.h>
+#include <theora/theoradec.h>
+
+#include "libs/stream/encoder/theoraencoder.h"
+#include "libs/stream/theorautils.h"
+
+namespace
+{
+
+// Gradient with a square moving by n pixels, so consecutive frames differ
+std::vector<uint8_t> makeFrame(uint16_t width, uint16_t height, int components, int n)
+{
+    std::vector<uint8_t> frame(static_cast<size_t>(width) * height * components);
+    for (uint16_t y = 0; y < height; y++)
+        for (uint16_t x = 0; x < width; x++)
+        {
+            bool square = x >= 10 + n && x < 30 + n && y >= 10 && y < 30;
+            for (int c = 0; c < components; c++)
+                frame[(static_cast<size_t>(y) * width + x) * components + c] =
+                    static_cast<uint8_t>(square ? 230 : 2 * x + y + 20 * c);
+        }
+    return frame;
+}
+
+// Decodes the Ogg pages of the BLOBs as a client would
+class StreamDecoder
+{
+    public:
+        StreamDecoder()
+        {
+            ogg_sync_init(&sync);
+            th_info_init(&info);
+            th_comment_init(&comment);
+        }
+
+        ~StreamDecoder()
+        {
+            clear();
+            ogg_sync_clear(&sync);
+        }
+
+        // Feed a BLOB, decoded luma planes of its frames are appended to frames
+        void feed(const IBLOB &blob)
+        {
+            char *buffer = ogg_sync_buffer(&sync, blob.bloblen);
+            memcpy(buffer, blob.blob, blob.bloblen);
+            ogg_sync_wrote(&sync, blob.bloblen);
+
+            ogg_page page;
+            while (ogg_sync_pageout(&sync, &page) == 1)
+            {
+                if (ogg_page_bos(&page))
+                {
+                    // A chained stream starts, the previous one must have ended
+                    EXPECT_TRUE(hasStream == false || ended);
+                    clear();
+                    serial = ogg_page_serialno(&page);
+                    ogg_stream_init(&stream, serial);
+                    hasStream = true;
+                    streams++;
+                }
+                else if (hasStream == false)
+                {
+                    // Joined in the middle of a stream, wait for the next one
+                    skipped++;
+                    continue;
+                }
+                EXPECT_EQ(ogg_page_serialno(&page), serial);
+                EXPECT_FALSE(ended);
+                ended = ogg_page_eos(&page) != 0;
+                ASSERT_EQ(ogg_stream_pagein(&stream, &page), 0);
+
+                ogg_packet packet;
+                while (ogg_stream_packetout(&stream, &packet) == 1)
+                {
+                    if (headers < 3)
+                    {
+                        ASSERT_GT(th_decode_headerin(&info, &comment, &setup, &packet), 0) << "header " << headers;
+                        headers++;
+                        continue;
+                    }
+
+                    if (decoder == nullptr)
+                    {
+                        decoder = th_decode_alloc(&info, setup);
+                        ASSERT_NE(decoder, nullptr);
+                        // The first frame of a stream must be decodable on its own
+                        EXPECT_EQ(th_packet_iskeyframe(&packet), 1);
+                    }
+                    EXPECT_EQ(th_packet_isheader(&packet), 0);
+                    ASSERT_EQ(th_decode_packetin(decoder, &packet, nullptr), 0);
+
+                    th_ycbcr_buffer ycbcr;
+                    ASSERT_EQ(th_decode_ycbcr_out(decoder, ycbcr), 0);
+                    std::vector<uint8_t> luma(static_cast<size_t>(info.pic_width) * info.pic_height);
+                    for (uint32_t y = 0; y < info.pic_height; y++)
+                        memcpy(luma.data() + y * info.pic_width, ycbcr[0].data + (info.pic_y + y) * ycbcr[0].stride + info.pic_x,
+                               info.pic_width);
+                    frames.push_back(luma);
+                }
+            }
+        }
+
+        void clear()
+        {
+            if (decoder)
+                th_decode_free(decoder);
+            decoder = nullptr;
+            th_setup_free(setup);
+            setup = nullptr;
+            th_comment_clear(&comment);
+            th_info_clear(&info);
+            th_info_init(&info);
+            th_comment_init(&comment);
+            if (hasStream)
+                ogg_stream_clear(&stream);
+            hasStream = false;
+            ended = false;
+            headers = 0;
+        }
+
+        ogg_sync_state sync;
+        ogg_stream_state stream;
+        bool hasStream {false};
+        bool ended {false};
+        int serial {0};
+        int streams {0};
+        int skipped {0};
+        th_info info;
+        th_comment comment;
+        th_setup_info *setup {nullptr};
+        th_dec_ctx *decoder {nullptr};
+        int headers {0};
+        std::vector<std::vector<uint8_t>> frames;
+};
+
+double meanError(const std::vector<uint8_t> &a, const std::vector<uint8_t> &b)
+{
+    double sum = 0;
+    for (size_t i = 0; i < a.size(); i++)
+        sum += std::abs(a[i] - b[i]);
+    return sum / a.size();
+}
+
+}
+
+TEST(CORE_THEORAENCODER, Test_GranuleShift)
+{
+    EXPECT_EQ(INDI::theoraGranuleShift(1), 0);
+    EXPECT_EQ(INDI::theoraGranuleShift(2), 1);
+    EXPECT_EQ(INDI::theoraGranuleShift(4), 2);
+    EXPECT_EQ(INDI::theoraGranuleShift(5), 3);
+    EXPECT_EQ(INDI::theoraGranuleShift(64), 6);
+}
+
+TEST(CORE_THEORAENCODER, Test_Stream)
+{
+    // Not a multiple of the 16 pixel macro blocks
+    const uint16_t width = 100, height = 60;
+    INDI::TheoraEncoder encoder;
+    ASSERT_TRUE(encoder.setPixelFormat(INDI_MONO, 8));
+    ASSERT_TRUE(encoder.setSize(width, height));
+    encoder.setKeyframeInterval(4);
+
+    StreamDecoder stream;
+    std::vector<std::vector<uint8_t>> sent;
+    for (int n = 0; n < 6; n++)
+    {
+        sent.push_back(makeFrame(width, height, 1, n));
+        IBLOB blob;
+        memset(&blob, 0, sizeof(blob));
+        ASSERT_TRUE(encoder.upload(&blob, sent.back().data(), sent.back().size()));
+        EXPECT_STREQ(blob.format, ".stream_ogv");
+
+        // Every BLOB holds whole pages, and the pages of its frame
+        ASSERT_GE(blob.bloblen, 27);
+        EXPECT_EQ(memcmp(blob.blob, "OggS", 4), 0);
+        stream.feed(blob);
+        ASSERT_EQ(stream.frames.size(), static_cast<size_t>(n + 1));
+    }
+
+    // Frames 0 to 3 and 4 to 5 are two chained streams, each with its headers
+    EXPECT_EQ(stream.streams, 2);
+    EXPECT_EQ(stream.headers, 3);
+    EXPECT_EQ(stream.skipped, 0);
+    EXPECT_EQ(stream.info.pic_width, width);
+    EXPECT_EQ(stream.info.pic_height, height);
+    EXPECT_EQ(stream.info.frame_width, 112u);
+    EXPECT_EQ(stream.info.frame_height, 64u);
+    EXPECT_EQ(stream.info.pixel_fmt, TH_PF_420);
+    EXPECT_EQ(stream.info.keyframe_granule_shift, 2);
+
+    for (size_t i = 0; i < sent.size(); i++)
+        EXPECT_LT(meanError(stream.frames[i], sent[i]), 4.0) << "frame " << i;
+}
+
+TEST(CORE_THEORAENCODER, Test_Join)
+{
+    const uint16_t width = 64, height = 48;
+    INDI::TheoraEncoder encoder;
+    ASSERT_TRUE(encoder.setPixelFormat(INDI_MONO, 8));
+    ASSERT_TRUE(encoder.setSize(width, height));
+    encoder.setKeyframeInterval(4);
+
+    // The client receives BLOBs from the third frame on
+    StreamDecoder stream;
+    std::vector<std::vector<uint8_t>> sent;
+    for (int n = 0; n < 10; n++)
+    {
+        sent.push_back(makeFrame(width, height, 1, n));
+        IBLOB blob;
+        memset(&blob, 0, sizeof(blob));
+        ASSERT_TRUE(encoder.upload(&blob, sent.back().data(), sent.back().size()));
+        if (n >= 2)
+            stream.feed(blob);
+    }
+
+    // Frames 2 and 3 cannot be decoded, the stream of frames 4 to 7 and 8 to 9 can
+    EXPECT_GT(stream.skipped, 0);
+    EXPECT_EQ(stream.streams, 2);
+    ASSERT_EQ(stream.frames.size(), 6u);
+    for (size_t i = 0; i < stream.frames.size(); i++)
+        EXPECT_LT(meanError(stream.frames[i], sent[i + 4]), 4.0) << "frame " << i + 4;
+}
+
+TEST(CORE_THEORAENCODER, Test_Restart)
+{
+    INDI::TheoraEncoder encoder;
+    ASSERT_TRUE(encoder.setPixelFormat(INDI_RGB, 8));
+    ASSERT_TRUE(encoder.setSize(64, 48));
+
+    int serial = 0;
+    for (int n = 0; n < 3; n++)
+    {
+        // The last frame is smaller, it starts a new stream with its own headers
+        uint16_t width = n < 2 ? 64 : 32;
+        ASSERT_TRUE(encoder.setSize(width, 48));
+        std::vector<uint8_t> frame = makeFrame(width, 48, 3, n);
+        IBLOB blob;
+        memset(&blob, 0, sizeof(blob));
+        ASSERT_TRUE(encoder.upload(&blob, frame.data(), frame.size()));
+
+        ogg_sync_state sync;
+        ogg_sync_init(&sync);
+        char *buffer = ogg_sync_buffer(&sync, blob.bloblen);
+        memcpy(buffer, blob.blob, blob.bloblen);
+        ogg_sync_wrote(&sync, blob.bloblen);
+        ogg_page page;
+        ASSERT_EQ(ogg_sync_pageout(&sync, &page), 1);
+        EXPECT_EQ(ogg_page_bos(&page) != 0, n != 1) << "frame " << n;
+        if (n == 1)
+        {
+            EXPECT_EQ(ogg_page_serialno(&page), serial);
+        }
+        serial = ogg_page_serialno(&page);
+        ogg_sync_clear(&sync);
+    }
+}
@@ -0,0 +1,103 @@
+/*******************************************************************************
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Library General Public
+ License version 2 as published by the Free Software Foundation.
+ .
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Library General Public License for more details.
+ .
+ You should have received a copy of the GNU Library General Public License
+ along with this library; see the file COPYING.LIB.  If not, write to
+ the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ Boston, MA 02110-1301, USA.
+*******************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <vector>
+
+#include "libs/indibase/indiworkerpool.h"
+
+TEST(CORE_WORKERPOOL, Test_Run)
+{
+    INDI::WorkerPool pool(4);
+    EXPECT_EQ(pool.concurrency(), 4u);
+
+    for (unsigned int count : {0u, 1u, 3u, 4u, 100u})
+    {
+        std::vector<std::atomic<int>> runs(count);
+        for (auto &run : runs)
+            run = 0;
+
+        pool.run(count, [&](unsigned int index)
+        {
+            runs[index]++;
+        });
+
+        for (unsigned int i = 0; i < count; i++)
+            EXPECT_EQ(runs[i], 1) << "task " << i << " of " << count;
+    }
+}
+
+TEST(CORE_WORKERPOOL, Test_Parallel)
+{
+    // Tasks wait for each other, so they only complete if all run at once
+    INDI::WorkerPool pool(4);
+    std::atomic<unsigned int> started {0};
+    pool.run(4, [&](unsigned int)
+    {
+        started++;
+        while (started < 4)
+            std::this_thread::yield();
+    });
+    EXPECT_EQ(started, 4u);
+}
+
+TEST(CORE_WORKERPOOL, Test_Concurrent)
+{
+    INDI::WorkerPool pool(3);
+    std::atomic<unsigned int> total {0};
+
+    // Callers share the pool, and tasks may run() themselves
+    auto nested = [&](unsigned int)
+    {
+        pool.run(3, [&](unsigned int)
+        {
+            total++;
+        });
+    };
+    std::vector<std::thread> callers;
+    for (int caller = 0; caller < 4; caller++)
+    {
+        callers.emplace_back([&]()
+        {
+            for (int i = 0; i < 50; i++)
+                pool.run(5, nested);
+        });
+    }
+    for (auto &caller : callers)
+        caller.join();
+
+    EXPECT_EQ(total, 4u * 50 * 5 * 3);
+}
+
+TEST(CORE_WORKERPOOL, Test_Instance)
+{
+    EXPECT_EQ(&INDI::WorkerPool::instance(), &INDI::WorkerPool::instance());
+    EXPECT_GE(INDI::WorkerPool::instance().concurrency(), 1u);
+
+    std::set<std::thread::id> threads;
+    std::mutex lock;
+    INDI::WorkerPool::instance().run(8, [&](unsigned int)
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        threads.insert(std::this_thread::get_id());
+    });
+    EXPECT_LE(threads.size(), INDI::WorkerPool::instance().concurrency());
+}